@@ -45,6 +45,13 @@ extern "C" {
 #define F_WRLCK ((short)1)
 #define F_UNLCK ((short)2)
 
+#define POSIX_FADV_DONTNEED 1
+#define POSIX_FADV_NOREUSE 2
+#define POSIX_FADV_NORMAL 3
+#define POSIX_FADV_RANDOM 4
+#define POSIX_FADV_SEQUENTIAL 5
+#define POSIX_FADV_WILLNEED 6
+
 #define AT_FDCWD -100
 #define AT_SYMLINK_NOFOLLOW 0x100
 #define AT_REMOVEDIR 0x200
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <Kernel/API/POSIX/fcntl.h>
+#include <Kernel/API/POSIX/sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IO_RING_OP_NOP 0
+#define IO_RING_OP_READ 1
+#define IO_RING_OP_WRITE 2
+#define IO_RING_OP_PREAD 3
+#define IO_RING_OP_PWRITE 4
+#define IO_RING_OP_FSYNC 5
+#define IO_RING_OP_ACCEPT 6
+#define IO_RING_OP_RECV 7
+#define IO_RING_OP_SEND 8
+#define IO_RING_OP_POLL 9
+
+// Flags for io_ring_setup()
+#define IO_RING_SETUP_SQPOLL (1u << 0)
+#define IO_RING_SETUP_CLOEXEC O_CLOEXEC
+
+// Flags for io_ring_enter()
+#define IO_RING_ENTER_GETEVENTS (1u << 0)
+#define IO_RING_ENTER_SQ_WAKEUP (1u << 1)
+
+// Set in sq_flags while the submission polling thread is asleep, and needs IO_RING_ENTER_SQ_WAKEUP to notice new entries.
+#define IO_RING_SQ_NEED_WAKEUP (1u << 0)
+
+#define IO_RING_MAX_ENTRIES 4096
+
+struct io_ring_sqe {
+    uint8_t opcode;
+    uint8_t reserved;
+    // The poll events to wait for with IO_RING_OP_POLL.
+    uint16_t poll_events;
+    int32_t fd;
+    // The file offset for IO_RING_OP_PREAD and IO_RING_OP_PWRITE.
+    uint64_t offset;
+    // The buffer to transfer from or to.
+    uint64_t addr;
+    uint32_t len;
+    // MSG_* flags for IO_RING_OP_RECV and IO_RING_OP_SEND, SOCK_* flags for IO_RING_OP_ACCEPT.
+    uint32_t op_flags;
+    // Handed back untouched in the completion.
+    uint64_t user_data;
+};
+
+struct io_ring_cqe {
+    uint64_t user_data;
+    // What the equivalent syscall would have returned, or a negated errno on failure.
+    int32_t result;
+    uint32_t flags;
+};
+
+// The ring header sits at the start of the mapping. Userspace only advances sq_tail and cq_head,
+// the kernel only advances sq_head and cq_tail. The indices are free-running, and wrap with the mask.
+struct io_ring_header {
+    uint32_t sq_head;
+    uint32_t sq_tail;
+    uint32_t sq_mask;
+    uint32_t sq_flags;
+    uint32_t cq_head;
+    uint32_t cq_tail;
+    uint32_t cq_mask;
+    uint32_t reserved;
+};
+
+struct io_ring_params {
+    // Filled in by the caller. The entry counts are rounded up to a power of two, and a zero
+    // completion queue size means twice as many as there are submission queue entries.
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t flags;
+    uint32_t sq_thread_idle_ms;
+    // Filled in by the kernel: the size to mmap() the ring fd with, and where the entries live in it.
+    uint32_t mapping_size;
+    uint32_t sqes_offset;
+    uint32_t cqes_offset;
+};
+
+#ifdef __cplusplus
+}
+#endif
@@ -62,6 +62,7 @@ extern "C" {
 #define MSG_DONTWAIT 0x40
 #define MSG_NOSIGNAL 0x80
 #define MSG_EOR 0x100
+#define MSG_WAITFORONE 0x200
 
 typedef uint16_t sa_family_t;
 
@@ -81,6 +82,11 @@ struct msghdr {
     int msg_flags;
 };
 
+struct mmsghdr {
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+};
+
 struct sockaddr {
     sa_family_t sa_family;
     char sa_data[14];
@@ -120,6 +126,7 @@ enum {
     SO_OOBINLINE,
     SO_SNDLOWAT,
     SO_RCVLOWAT,
+    SO_REUSEPORT,
 };
 #define SO_RCVTIMEO SO_RCVTIMEO
 #define SO_SNDTIMEO SO_SNDTIMEO
@@ -140,6 +147,7 @@ enum {
 #define SO_OOBINLINE SO_OOBINLINE
 #define SO_SNDLOWAT SO_SNDLOWAT
 #define SO_RCVLOWAT SO_RCVLOWAT
+#define SO_REUSEPORT SO_REUSEPORT
 
 enum {
     SCM_TIMESTAMP,
@@ -14,6 +14,8 @@ constexpr int syscall_vector = 0x82;
 
 extern "C" {
 struct pollfd;
+struct epoll_event;
+struct io_ring_params;
 struct timeval;
 struct timespec;
 struct sockaddr;
@@ -65,6 +67,9 @@ enum class NeedsBigProcessLock {
     S(dump_backtrace, NeedsBigProcessLock::No)              \
     S(dup2, NeedsBigProcessLock::No)                        \
     S(emuctl, NeedsBigProcessLock::No)                      \
+    S(epoll_create, NeedsBigProcessLock::No)                \
+    S(epoll_ctl, NeedsBigProcessLock::No)                   \
+    S(epoll_wait, NeedsBigProcessLock::No)                  \
     S(execve, NeedsBigProcessLock::Yes)                     \
     S(exit, NeedsBigProcessLock::Yes)                       \
     S(exit_thread, NeedsBigProcessLock::Yes)                \
@@ -105,6 +110,8 @@ enum class NeedsBigProcessLock {
     S(getuid, NeedsBigProcessLock::No)                      \
     S(inode_watcher_add_watch, NeedsBigProcessLock::Yes)    \
     S(inode_watcher_remove_watch, NeedsBigProcessLock::Yes) \
+    S(io_ring_enter, NeedsBigProcessLock::Yes)              \
+    S(io_ring_setup, NeedsBigProcessLock::No)               \
     S(ioctl, NeedsBigProcessLock::Yes)                      \
     S(join_thread, NeedsBigProcessLock::Yes)                \
     S(jail_create, NeedsBigProcessLock::No)                 \
@@ -132,6 +139,7 @@ enum class NeedsBigProcessLock {
     S(pipe, NeedsBigProcessLock::No)                        \
     S(pledge, NeedsBigProcessLock::Yes)                     \
     S(poll, NeedsBigProcessLock::Yes)                       \
+    S(posix_fadvise, NeedsBigProcessLock::No)               \
     S(posix_fallocate, NeedsBigProcessLock::No)             \
     S(prctl, NeedsBigProcessLock::Yes)                      \
     S(profiling_disable, NeedsBigProcessLock::Yes)          \
@@ -141,16 +149,20 @@ enum class NeedsBigProcessLock {
     S(purge, NeedsBigProcessLock::Yes)                      \
     S(read, NeedsBigProcessLock::Yes)                       \
     S(pread, NeedsBigProcessLock::Yes)                      \
+    S(preadv, NeedsBigProcessLock::Yes)                     \
     S(readlink, NeedsBigProcessLock::No)                    \
     S(readv, NeedsBigProcessLock::Yes)                      \
     S(realpath, NeedsBigProcessLock::No)                    \
     S(recvfd, NeedsBigProcessLock::No)                      \
+    S(recvmmsg, NeedsBigProcessLock::Yes)                   \
     S(recvmsg, NeedsBigProcessLock::Yes)                    \
     S(rename, NeedsBigProcessLock::No)                      \
     S(rmdir, NeedsBigProcessLock::No)                       \
     S(scheduler_get_parameters, NeedsBigProcessLock::No)    \
     S(scheduler_set_parameters, NeedsBigProcessLock::No)    \
     S(sendfd, NeedsBigProcessLock::No)                      \
+    S(sendfile, NeedsBigProcessLock::Yes)                   \
+    S(sendmmsg, NeedsBigProcessLock::Yes)                   \
     S(sendmsg, NeedsBigProcessLock::Yes)                    \
     S(set_coredump_metadata, NeedsBigProcessLock::No)       \
     S(set_mmap_name, NeedsBigProcessLock::Yes)              \
@@ -194,7 +206,9 @@ enum class NeedsBigProcessLock {
     S(utimensat, NeedsBigProcessLock::No)                   \
     S(waitid, NeedsBigProcessLock::Yes)                     \
     S(write, NeedsBigProcessLock::Yes)                      \
+    S(pwrite, NeedsBigProcessLock::Yes)                     \
     S(writev, NeedsBigProcessLock::Yes)                     \
+    S(pwritev, NeedsBigProcessLock::Yes)                    \
     S(yield, NeedsBigProcessLock::No)
 
 namespace Syscall {
@@ -256,6 +270,21 @@ struct SC_poll_params {
     u32 const* sigmask;
 };
 
+struct SC_epoll_ctl_params {
+    int epoll_fd;
+    int op;
+    int fd;
+    struct epoll_event const* event;
+};
+
+struct SC_epoll_wait_params {
+    int epoll_fd;
+    struct epoll_event* events;
+    int max_events;
+    int timeout_ms;
+    u32 const* sigmask;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -275,6 +304,14 @@ struct SC_accept4_params {
     int flags;
 };
 
+struct SC_recvmmsg_params {
+    int sockfd;
+    struct mmsghdr* msgvec;
+    unsigned int vlen;
+    int flags;
+    struct timespec const* timeout;
+};
+
 struct SC_getsockopt_params {
     int sockfd;
     int level;
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Function.h>
 #include <AK/NonnullOwnPtr.h>
 #include <AK/OwnPtr.h>
@@ -15,6 +16,7 @@
 #include <Kernel/Firmware/ACPI/Definitions.h>
 #include <Kernel/Interrupts/GenericInterruptHandler.h>
 #include <Kernel/Library/LockRefPtr.h>
+#include <Kernel/Locking/Spinlock.h>
 
 namespace Kernel {
 
@@ -59,6 +61,11 @@ public:
     u8 get_mapped_interrupt_vector(u8 original_irq);
     u8 get_irq_vector(u8 mapped_interrupt_vector);
 
+    // Reserves an interrupt number that is not routed through any IRQ controller, for use by a message signalled interrupt.
+    // Message signalled interrupts are handed out from the range between the highest interrupt any
+    // IRQ controller might route to us and the vectors used by the local APIC itself.
+    ErrorOr<u8> allocate_message_signalled_interrupt_number();
+
     void enumerate_interrupt_handlers(Function<void(GenericInterruptHandler&)>);
     IRQController& get_interrupt_controller(size_t index);
 
@@ -73,6 +80,10 @@ private:
     Vector<ISAInterruptOverrideMetadata> m_isa_interrupt_overrides;
     Vector<PCIInterruptOverrideMetadata> m_pci_interrupt_overrides;
     PhysicalAddress m_madt;
+    static constexpr u8 first_message_signalled_interrupt_number = 0x90 - IRQ_VECTOR_BASE;
+    static constexpr u8 last_message_signalled_interrupt_number = 0xfb - IRQ_VECTOR_BASE;
+    Spinlock m_message_signalled_interrupts_lock { LockRank::None };
+    Array<bool, last_message_signalled_interrupt_number - first_message_signalled_interrupt_number + 1> m_allocated_message_signalled_interrupts {};
 };
 
 }
@@ -62,6 +62,23 @@ void InterruptManagement::enumerate_interrupt_handlers(Function<void(GenericInte
     }
 }
 
+ErrorOr<u8> InterruptManagement::allocate_message_signalled_interrupt_number()
+{
+    SpinlockLocker locker(m_message_signalled_interrupts_lock);
+    for (size_t i = 0; i < m_allocated_message_signalled_interrupts.size(); ++i) {
+        u8 interrupt_number = first_message_signalled_interrupt_number + i;
+        if (m_allocated_message_signalled_interrupts[i])
+            continue;
+        if (interrupt_number + IRQ_VECTOR_BASE == syscall_vector)
+            continue;
+        if (get_interrupt_handler(interrupt_number).type() != HandlerType::UnhandledInterruptHandler)
+            continue;
+        m_allocated_message_signalled_interrupts[i] = true;
+        return interrupt_number;
+    }
+    return ENOSPC;
+}
+
 IRQController& InterruptManagement::get_interrupt_controller(size_t index)
 {
     return *m_interrupt_controllers[index];
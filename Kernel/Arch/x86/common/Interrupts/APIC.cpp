@@ -230,6 +230,23 @@ void APIC::eoi()
     write_register(APIC_REG_EOI, 0x0);
 }
 
+ErrorOr<u64> APIC::message_signalled_interrupt_address(u32 cpu) const
+{
+    VERIFY(cpu < Processor::count());
+    // NOTE: Without interrupt remapping, there are only 8 bits for the destination in the message address.
+    auto destination = m_physical_apic_ids[cpu];
+    if (destination > 0xff)
+        return ENOTSUP;
+    // Physical destination mode, no redirection hint. See Intel SDM Vol. 3, section 10.11.1
+    return 0xfee00000 | (destination << 12);
+}
+
+u32 APIC::message_signalled_interrupt_data(u8 interrupt_number)
+{
+    // Fixed delivery mode, edge triggered. See Intel SDM Vol. 3, section 10.11.2
+    return interrupt_number + IRQ_VECTOR_BASE;
+}
+
 u8 APIC::spurious_interrupt_vector()
 {
     return IRQ_APIC_SPURIOUS;
@@ -482,6 +499,7 @@ UNMAP_AFTER_INIT void APIC::enable(u32 cpu)
 
     dbgln_if(APIC_DEBUG, "CPU #{} apic id: {}", cpu, apic_id);
     Processor::current().info().set_apic_id(apic_id);
+    m_physical_apic_ids[cpu] = m_is_x2 ? apic_id : read_register(APIC_REG_ID) >> 24;
 
     dbgln_if(APIC_DEBUG, "Enabling local APIC for CPU #{}, logical APIC ID: {}", cpu, apic_id);
 
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Types.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Time/HardwareTimer.h>
@@ -33,6 +34,11 @@ public:
     void broadcast_ipi();
     void send_ipi(u32 cpu);
     static u8 spurious_interrupt_vector();
+
+    // Message address and data for a message signalled interrupt (MSI or MSI-X)
+    // that should be delivered to the given processor.
+    ErrorOr<u64> message_signalled_interrupt_address(u32 cpu) const;
+    static u32 message_signalled_interrupt_data(u8 interrupt_number);
     Thread* get_idle_thread(u32 cpu) const;
     u32 enabled_processor_count() const { return m_processor_enabled_cnt; }
 
@@ -98,6 +104,7 @@ private:
     Atomic<u8> m_apic_ap_continue { 0 };
     u32 m_processor_cnt { 0 };
     u32 m_processor_enabled_cnt { 0 };
+    Array<u32, MAX_CPU_COUNT> m_physical_apic_ids {};
     APICTimer* m_apic_timer { nullptr };
     bool m_is_x2 { false };
 
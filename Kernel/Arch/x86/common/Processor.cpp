@@ -834,7 +834,9 @@ ErrorOr<Vector<FlatPtr, 32>> Processor::capture_stack_trace(Thread& thread, size
         // cause any problems as the stack won't change below this frame.
         lock.unlock();
         TRY(capture_current_thread());
-    } else if (thread.is_active()) {
+    } else if (thread.state() == Thread::State::Running) {
+        // NOTE: Don't go by is_active() here. Threads are marked active as soon as
+        // a processor picks them, which happens before it takes the scheduler lock.
         VERIFY(thread.cpu() != Processor::current_id());
         // If this is the case, the thread is currently running
         // on another processor. We can't trust the kernel stack as
@@ -56,7 +56,7 @@
 #include <Kernel/TTY/PTYMultiplexer.h>
 #include <Kernel/TTY/VirtualConsole.h>
 #include <Kernel/Tasks/FinalizerTask.h>
-#include <Kernel/Tasks/SyncTask.h>
+#include <Kernel/Tasks/WritebackTask.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/WorkQueue.h>
 #include <Kernel/kstdio.h>
@@ -330,7 +330,7 @@ void init_stage2(void*)
     GraphicsManagement::the().initialize();
     ConsoleManagement::the().initialize();
 
-    SyncTask::spawn();
+    WritebackTask::spawn();
     FinalizerTask::spawn();
 
     auto boot_profiling = kernel_command_line().is_boot_profiling_enabled();
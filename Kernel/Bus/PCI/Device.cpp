@@ -7,6 +7,7 @@
 #include <AK/AnyOf.h>
 #include <Kernel/Bus/PCI/API.h>
 #include <Kernel/Bus/PCI/Device.h>
+#include <Kernel/Memory/TypedMapping.h>
 
 namespace Kernel::PCI {
 
@@ -15,6 +16,8 @@ Device::Device(Address address)
 {
 }
 
+Device::~Device() = default;
+
 bool Device::is_msi_capable() const
 {
     return AK::any_of(
@@ -45,13 +48,117 @@ void Device::disable_message_signalled_interrupts()
 {
     TODO();
 }
-void Device::enable_extended_message_signalled_interrupts()
+// MSI-X capability structure, see PCI Local Bus Specification 3.0, section 6.8.2
+static constexpr u32 msix_message_control_offset = 0x2;
+static constexpr u32 msix_table_offset_offset = 0x4;
+static constexpr u16 msix_message_control_table_size_mask = 0x7ff;
+static constexpr u16 msix_message_control_function_mask = 1 << 14;
+static constexpr u16 msix_message_control_enable = 1 << 15;
+static constexpr u32 msix_table_bir_mask = 0x7;
+
+struct [[gnu::packed]] MSIXTableEntry {
+    u32 message_address_low;
+    u32 message_address_high;
+    u32 message_data;
+    u32 vector_control;
+};
+static constexpr u32 msix_vector_control_masked = 1 << 0;
+
+Optional<Capability> Device::msix_capability() const
 {
-    TODO();
+    for (auto const& capability : PCI::get_device_identifier(pci_address()).capabilities()) {
+        if (capability.id().value() == PCI::Capabilities::ID::MSIX)
+            return capability;
+    }
+    return {};
+}
+
+size_t Device::msix_table_entry_count() const
+{
+    auto capability = msix_capability();
+    if (!capability.has_value())
+        return 0;
+    // The table size is encoded as N - 1.
+    return (capability->read16(msix_message_control_offset) & msix_message_control_table_size_mask) + 1;
+}
+
+ErrorOr<PhysicalAddress> Device::msix_table_address() const
+{
+    auto capability = msix_capability();
+    if (!capability.has_value())
+        return EINVAL;
+
+    auto table_offset_and_bir = capability->read32(msix_table_offset_offset);
+    auto bar_index = static_cast<HeaderType0BaseRegister>(table_offset_and_bir & msix_table_bir_mask);
+    auto bar = PCI::get_BAR(pci_address(), bar_index);
+    u64 bar_address = 0;
+    switch (PCI::get_BAR_space_type(bar)) {
+    case BARSpaceType::Memory32BitSpace:
+        bar_address = bar & 0xfffffff0;
+        break;
+    case BARSpaceType::Memory64BitSpace:
+        // The upper half of the address lives in the BAR right after this one.
+        if (to_underlying(bar_index) == 5)
+            return EINVAL;
+        bar_address = (static_cast<u64>(PCI::get_BAR(pci_address(), static_cast<HeaderType0BaseRegister>(to_underlying(bar_index) + 1))) << 32) | (bar & 0xfffffff0);
+        break;
+    default:
+        return ENOTSUP;
+    }
+    return PhysicalAddress(bar_address + (table_offset_and_bir & ~msix_table_bir_mask));
+}
+
+ErrorOr<MSIXTableEntry volatile*> Device::msix_table_entry(size_t index)
+{
+    // The table is mapped when MSI-X gets enabled.
+    VERIFY(m_msix_table);
+    if (index >= msix_table_entry_count())
+        return EINVAL;
+    return m_msix_table->ptr() + index;
+}
+
+ErrorOr<void> Device::set_msix_table_entry(size_t index, u64 message_address, u32 message_data)
+{
+    auto* entry = TRY(msix_table_entry(index));
+    // Keep the entry masked while it is being changed, the device may otherwise send a half-written message.
+    entry->vector_control = entry->vector_control | msix_vector_control_masked;
+    entry->message_address_low = message_address & 0xffffffff;
+    entry->message_address_high = message_address >> 32;
+    entry->message_data = message_data;
+    return {};
+}
+
+ErrorOr<void> Device::set_msix_table_entry_masked(size_t index, bool masked)
+{
+    auto* entry = TRY(msix_table_entry(index));
+    if (masked)
+        entry->vector_control = entry->vector_control | msix_vector_control_masked;
+    else
+        entry->vector_control = entry->vector_control & ~msix_vector_control_masked;
+    return {};
+}
+
+ErrorOr<void> Device::enable_extended_message_signalled_interrupts()
+{
+    auto capability = msix_capability();
+    VERIFY(capability.has_value());
+    if (!m_msix_table)
+        m_msix_table = TRY(Memory::adopt_new_nonnull_own_typed_mapping<MSIXTableEntry volatile>(TRY(msix_table_address()), msix_table_entry_count() * sizeof(MSIXTableEntry), Memory::Region::Access::ReadWrite));
+    // NOTE: Pin-based interrupts are implicitly disabled by the device as long as MSI-X is enabled,
+    //       but we disable them explicitly as well to be on the safe side.
+    disable_pin_based_interrupts();
+    auto message_control = capability->read16(msix_message_control_offset);
+    message_control |= msix_message_control_enable;
+    message_control &= ~msix_message_control_function_mask;
+    capability->write16(msix_message_control_offset, message_control);
+    return {};
 }
 void Device::disable_extended_message_signalled_interrupts()
 {
-    TODO();
+    auto capability = msix_capability();
+    VERIFY(capability.has_value());
+    capability->write16(msix_message_control_offset, capability->read16(msix_message_control_offset) & ~msix_message_control_enable);
+    enable_pin_based_interrupts();
 }
 
 }
@@ -6,16 +6,25 @@
 
 #pragma once
 
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
 #include <AK/Types.h>
 #include <Kernel/Bus/PCI/Definitions.h>
 
+namespace Kernel::Memory {
+template<typename T>
+struct TypedMapping;
+}
+
 namespace Kernel::PCI {
 
+struct MSIXTableEntry;
+
 class Device {
 public:
     Address pci_address() const { return m_pci_address; };
 
-    virtual ~Device() = default;
+    virtual ~Device();
     void enable_pin_based_interrupts() const;
     void disable_pin_based_interrupts() const;
 
@@ -25,14 +34,26 @@ public:
     void enable_message_signalled_interrupts();
     void disable_message_signalled_interrupts();
 
-    void enable_extended_message_signalled_interrupts();
+    // Maps the MSI-X table, which stays mapped from then on, so that the table entries
+    // can be set up and masked without having to map them each time.
+    ErrorOr<void> enable_extended_message_signalled_interrupts();
     void disable_extended_message_signalled_interrupts();
 
+    // Returns the number of entries in the MSI-X table, or zero if the device isn't MSI-X capable.
+    size_t msix_table_entry_count() const;
+    ErrorOr<void> set_msix_table_entry(size_t index, u64 message_address, u32 message_data);
+    ErrorOr<void> set_msix_table_entry_masked(size_t index, bool masked);
+
 protected:
     explicit Device(Address pci_address);
 
 private:
+    Optional<Capability> msix_capability() const;
+    ErrorOr<PhysicalAddress> msix_table_address() const;
+    ErrorOr<MSIXTableEntry volatile*> msix_table_entry(size_t index);
+
     Address m_pci_address;
+    OwnPtr<Memory::TypedMapping<MSIXTableEntry volatile>> m_msix_table;
 };
 
 }
@@ -39,6 +39,10 @@ UNMAP_AFTER_INIT void detect()
             // This should have been initialized by the graphics subsystem
             break;
         }
+        case PCI::DeviceID::VirtIONetAdapter: {
+            // This should have been initialized by the networking subsystem
+            break;
+        }
         default:
             dbgln_if(VIRTIO_DEBUG, "VirtIO: Unknown VirtIO device with ID: {}", device_identifier.hardware_id().device_id);
             break;
@@ -420,13 +424,16 @@ bool Device::handle_irq(RegisterState const&)
     }
     if (isr_type & QUEUE_INTERRUPT) {
         dbgln_if(VIRTIO_DEBUG, "{}: VirtIO Queue interrupt!", class_name());
+        // The interrupt is shared by all queues, so more than one of them may have been updated.
+        bool any_queue_updated = false;
         for (size_t i = 0; i < m_queues.size(); i++) {
             if (get_queue(i).new_data_available()) {
                 handle_queue_update(i);
-                return true;
+                any_queue_updated = true;
             }
         }
-        dbgln_if(VIRTIO_DEBUG, "{}: Got queue interrupt but all queues are up to date!", class_name());
+        if (!any_queue_updated)
+            dbgln_if(VIRTIO_DEBUG, "{}: Got queue interrupt but all queues are up to date!", class_name());
     }
     return true;
 }
@@ -441,4 +448,11 @@ void Device::supply_chain_and_notify(u16 queue_index, QueueChain& chain)
         notify_queue(queue_index);
 }
 
+void Device::notify_queue_if_needed(u16 queue_index)
+{
+    VERIFY(get_queue(queue_index).lock().is_locked());
+    if (get_queue(queue_index).should_notify())
+        notify_queue(queue_index);
+}
+
 }
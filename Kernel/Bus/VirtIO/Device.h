@@ -174,6 +174,8 @@ protected:
     }
 
     void supply_chain_and_notify(u16 queue_index, QueueChain& chain);
+    // For drivers that submit a batch of chains with QueueChain::submit_to_queue() and notify the device once.
+    void notify_queue_if_needed(u16 queue_index);
 
     virtual bool handle_device_config_change() = 0;
     virtual void handle_queue_update(u16 queue_index) = 0;
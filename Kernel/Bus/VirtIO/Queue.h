@@ -32,6 +32,7 @@ public:
 
     ~Queue();
 
+    u16 size() const { return m_queue_size; }
     u16 notify_offset() const { return m_notify_offset; }
 
     void enable_interrupts();
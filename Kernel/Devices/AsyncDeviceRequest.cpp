@@ -6,6 +6,7 @@
 
 #include <Kernel/Devices/AsyncDeviceRequest.h>
 #include <Kernel/Devices/Device.h>
+#include <Kernel/Scheduler.h>
 
 namespace Kernel {
 
@@ -61,6 +62,17 @@ auto AsyncDeviceRequest::wait(Time* timeout) -> RequestWaitResult
     return { get_request_result(), wait_result };
 }
 
+auto AsyncDeviceRequest::wait_until_completed() -> RequestResult
+{
+    for (;;) {
+        auto result = wait();
+        if (is_completed_result(result.request_result()))
+            return result.request_result();
+        // NOTE: With a signal pending, every wait returns right away, so let others run in the meantime.
+        Scheduler::yield();
+    }
+}
+
 auto AsyncDeviceRequest::get_request_result() const -> RequestResult
 {
     SpinlockLocker lock(m_lock);
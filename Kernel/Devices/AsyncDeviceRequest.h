@@ -61,6 +61,9 @@ public:
     void add_sub_request(NonnullLockRefPtr<AsyncDeviceRequest>);
 
     [[nodiscard]] RequestWaitResult wait(Time* = nullptr);
+    // Like wait(), but doesn't give up when the thread is interrupted. This is for callers that
+    // must not return while the device may still be accessing the request's buffer.
+    [[nodiscard]] RequestResult wait_until_completed();
 
     void do_start(SpinlockLocker<Spinlock>&& requests_lock)
     {
@@ -72,8 +75,25 @@ public:
         start();
     }
 
+    // For devices that hand every request to the driver right away, instead of keeping a list of them.
+    void do_start()
+    {
+        SpinlockLocker lock(m_lock);
+        do_start(move(lock));
+    }
+
+    // Marks the request as started without starting it, for when the driver is going
+    // to carry it out as part of another request that was started instead.
+    void mark_started_as_part_of_other_request()
+    {
+        VERIFY(m_result == Pending);
+        m_result = Started;
+    }
+
     void complete(RequestResult result);
 
+    Process const& process() const { return *m_process; }
+
     void set_private(void* priv)
     {
         VERIFY(!m_private || !priv);
@@ -17,6 +17,7 @@ AsyncBlockDeviceRequest::AsyncBlockDeviceRequest(Device& block_device, RequestTy
     , m_block_count(block_count)
     , m_buffer(buffer)
     , m_buffer_size(buffer_size)
+    , m_total_block_count(block_count)
 {
 }
 
@@ -25,6 +26,41 @@ void AsyncBlockDeviceRequest::start()
     m_block_device.start_request(*this);
 }
 
+ErrorOr<void> AsyncBlockDeviceRequest::scatter_into_buffers(u8 const* data)
+{
+    TRY(write_to_buffer(m_buffer, data, m_block_count * block_size()));
+    data += m_block_count * block_size();
+    for (auto& merged_request : m_merged_requests) {
+        auto length = merged_request.block_count() * block_size();
+        TRY(merged_request.write_to_buffer(merged_request.buffer(), data, length));
+        data += length;
+    }
+    return {};
+}
+
+ErrorOr<void> AsyncBlockDeviceRequest::gather_from_buffers(u8* data)
+{
+    TRY(read_from_buffer(m_buffer, data, m_block_count * block_size()));
+    data += m_block_count * block_size();
+    for (auto& merged_request : m_merged_requests) {
+        auto length = merged_request.block_count() * block_size();
+        TRY(merged_request.read_from_buffer(merged_request.buffer(), data, length));
+        data += length;
+    }
+    return {};
+}
+
+void AsyncBlockDeviceRequest::complete_merged_requests()
+{
+    auto result = get_request_result();
+    if (result != Success && result != MemoryFault)
+        result = Failure;
+    while (!m_merged_requests.is_empty()) {
+        auto merged_request = m_merged_requests.take_first();
+        merged_request->complete(result);
+    }
+}
+
 BlockDevice::~BlockDevice() = default;
 
 void BlockDevice::after_inserting_add_symlink_to_device_identifier_directory()
@@ -21,6 +21,7 @@ public:
     size_t block_size() const { return m_block_size; }
     u8 block_size_log() const { return m_block_size_log; }
     virtual bool is_seekable() const override { return true; }
+    virtual bool is_storage_device() const { return false; }
 
     bool read_block(u64 index, UserOrKernelBuffer&);
     bool write_block(u64 index, UserOrKernelBuffer const&);
@@ -54,6 +55,8 @@ private:
 };
 
 class AsyncBlockDeviceRequest final : public AsyncDeviceRequest {
+    friend class BlockRequestQueue;
+
 public:
     enum RequestType {
         Read,
@@ -70,6 +73,15 @@ public:
     UserOrKernelBuffer const& buffer() const { return m_buffer; }
     size_t buffer_size() const { return m_buffer_size; }
 
+    // A request queue may merge requests for the blocks directly following this one
+    // into it, so that the driver can transfer all of them with a single command.
+    // Drivers that allow this (see StorageDevice::max_blocks_per_merged_request())
+    // have to move the data with scatter_into_buffers() and gather_from_buffers()
+    // instead of accessing buffer() directly.
+    u32 total_block_count() const { return m_total_block_count; }
+    ErrorOr<void> scatter_into_buffers(u8 const* data);
+    ErrorOr<void> gather_from_buffers(u8* data);
+
     virtual void start() override;
     virtual StringView name() const override
     {
@@ -84,12 +96,24 @@ public:
     }
 
 private:
+    void complete_merged_requests();
+
     BlockDevice& m_block_device;
     const RequestType m_request_type;
     const u64 m_block_index;
     const u32 m_block_count;
     UserOrKernelBuffer m_buffer;
     const size_t m_buffer_size;
+
+    u32 m_total_block_count { 0 };
+    u64 m_deadline_ms { 0 };
+    IntrusiveListNode<AsyncBlockDeviceRequest, LockRefPtr<AsyncBlockDeviceRequest>> m_queue_list_node;
+
+public:
+    using QueueList = IntrusiveList<&AsyncBlockDeviceRequest::m_queue_list_node>;
+
+private:
+    QueueList m_merged_requests;
 };
 
 }
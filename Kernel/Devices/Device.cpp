@@ -58,7 +58,17 @@ ErrorOr<NonnullOwnPtr<KString>> Device::pseudo_path(OpenFileDescription const&)
     return KString::formatted("device:{},{}", major(), minor());
 }
 
-void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceRequest const& completed_request)
+ErrorOr<void> Device::queue_request(NonnullLockRefPtr<AsyncDeviceRequest> request)
+{
+    SpinlockLocker lock(m_requests_lock);
+    bool was_empty = m_requests.is_empty();
+    TRY(m_requests.try_append(request));
+    if (was_empty)
+        request->do_start(move(lock));
+    return {};
+}
+
+void Device::start_next_queued_request(AsyncDeviceRequest const& completed_request)
 {
     SpinlockLocker lock(m_requests_lock);
     VERIFY(!m_requests.is_empty());
@@ -68,7 +78,11 @@ void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceR
         auto* next_request = m_requests.first().ptr();
         next_request->do_start(move(lock));
     }
+}
 
+void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceRequest const& completed_request)
+{
+    start_next_queued_request(completed_request);
     evaluate_block_conditions();
 }
 
@@ -4,108 +4,471 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
+#include <AK/FixedArray.h>
+#include <AK/HashFunctions.h>
+#include <AK/HashTable.h>
 #include <AK/IntrusiveList.h>
+#include <AK/QuickSort.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Process.h>
+#include <Kernel/Tasks/WritebackTask.h>
+#include <Kernel/Time/TimeManagement.h>
+#include <Kernel/WorkQueue.h>
 
 namespace Kernel {
 
 struct CacheEntry {
+    enum class Queue : u8 {
+        Free,
+        Recent,
+        Frequent,
+    };
+
     IntrusiveListNode<CacheEntry> list_node;
     BlockBasedFileSystem::BlockIndex block_index { 0 };
     u8* data { nullptr };
     bool has_data { false };
+    bool is_dirty { false };
+    Queue queue { Queue::Free };
+    u64 dirtied_at_ms { 0 };
 };
 
-class DiskCache {
+// The cache grows and shrinks one chunk of entries at a time.
+struct DiskCacheChunk {
+    static constexpr size_t EntryCount = 64;
+
+    NonnullOwnPtr<KBuffer> block_data;
+    FixedArray<CacheEntry> entries;
+};
+
+struct DiskCacheCounters {
+    Atomic<size_t> entry_count { 0 };
+    Atomic<size_t> dirty_count { 0 };
+};
+
+static constexpr size_t max_blocks_per_write_back = 64;
+
+// Caching is spread over a number of shards keyed by block index, so that accesses
+// to unrelated blocks don't serialize on a single lock.
+//
+// Each shard is managed with the 2Q replacement policy: a block that is not in the
+// cache enters the "recent" FIFO, and only blocks that are asked for again after
+// having fallen out of it (we remember a number of evicted block indices as "ghosts")
+// make it into the "frequent" LRU. Eviction takes from the recent FIFO as long as it
+// holds more than its share of the shard, so a long sequential scan can only cycle
+// through the recent queue and never pushes hot metadata blocks out of the cache.
+class DiskCacheShard {
+    AK_MAKE_NONCOPYABLE(DiskCacheShard);
+    AK_MAKE_NONMOVABLE(DiskCacheShard);
+
 public:
-    static constexpr size_t EntryCount = 10000;
-    explicit DiskCache(BlockBasedFileSystem& fs, NonnullOwnPtr<KBuffer> cached_block_data, NonnullOwnPtr<KBuffer> entries_buffer)
+    DiskCacheShard(BlockBasedFileSystem& fs, DiskCacheCounters& counters, size_t max_chunk_count)
         : m_fs(fs)
-        , m_cached_block_data(move(cached_block_data))
-        , m_entries(move(entries_buffer))
+        , m_counters(counters)
+        , m_max_chunk_count(max_chunk_count)
     {
-        for (size_t i = 0; i < EntryCount; ++i) {
-            entries()[i].data = m_cached_block_data->data() + i * m_fs->block_size();
-            m_clean_list.append(entries()[i]);
-        }
     }
 
-    ~DiskCache() = default;
+    Mutex& lock() const { return m_lock; }
 
+    size_t entry_count() const { return m_chunks.size() * DiskCacheChunk::EntryCount; }
+    size_t chunk_count() const { return m_chunks.size(); }
     bool is_dirty() const { return !m_dirty_list.is_empty(); }
-    bool entry_is_dirty(CacheEntry const& entry) const { return m_dirty_list.contains(entry); }
 
-    void mark_all_clean()
+    // Bumped whenever one of our dirty blocks goes to the device. Entries are only ever evicted once
+    // they are clean, so a block can't drop out of the cache with newer data than the disk had before.
+    u64 write_back_generation() const { return m_write_back_generation.load(); }
+
+    ErrorOr<void> grow()
     {
-        while (auto* entry = m_dirty_list.first())
-            m_clean_list.prepend(*entry);
+        VERIFY(m_lock.is_locked());
+        auto block_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache blocks"sv, DiskCacheChunk::EntryCount * m_fs.block_size()));
+        auto entries = TRY(FixedArray<CacheEntry>::try_create(DiskCacheChunk::EntryCount));
+        auto chunk = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCacheChunk { move(block_data), move(entries) }));
+        TRY(m_hash.try_ensure_capacity((m_chunks.size() + 1) * DiskCacheChunk::EntryCount));
+        TRY(m_chunks.try_append(move(chunk)));
+
+        auto& new_chunk = *m_chunks.last();
+        for (size_t i = 0; i < DiskCacheChunk::EntryCount; ++i) {
+            auto& entry = new_chunk.entries[i];
+            entry.data = new_chunk.block_data->data() + i * m_fs.block_size();
+            m_free_list.append(entry);
+        }
+        m_counters.entry_count.fetch_add(DiskCacheChunk::EntryCount);
+        return {};
+    }
+
+    CacheEntry* get(BlockBasedFileSystem::BlockIndex block_index) const
+    {
+        VERIFY(m_lock.is_locked());
+        auto it = m_hash.find(block_index);
+        if (it == m_hash.end())
+            return nullptr;
+        auto& entry = *it->value;
+        VERIFY(entry.block_index == block_index);
+        return &entry;
+    }
+
+    ErrorOr<CacheEntry*> ensure(BlockBasedFileSystem::BlockIndex block_index)
+    {
+        VERIFY(m_lock.is_locked());
+        if (auto* entry = get(block_index)) {
+            did_hit(*entry);
+            return entry;
+        }
+
+        auto* new_entry = take_reusable_entry();
+        if (!new_entry) {
+            // Not a single clean entry! Writer throttling should make this rare, but if
+            // it happens anyway, write back the oldest dirty blocks and try again.
+            Vector<BlockBasedFileSystem::BlockIndex> blocks;
+            collect_dirty_blocks(blocks, 0, max_blocks_per_write_back);
+            quick_sort(blocks);
+            if (write_back(blocks) == 0)
+                flush();
+            new_entry = take_reusable_entry();
+            VERIFY(new_entry);
+        }
+
+        TRY(m_hash.try_set(block_index, new_entry));
+        new_entry->block_index = block_index;
+        new_entry->has_data = false;
+
+        // Blocks that we evicted not too long ago have proven to be worth keeping around.
+        if (m_ghosts.remove(block_index))
+            set_queue(*new_entry, CacheEntry::Queue::Frequent);
+        else
+            set_queue(*new_entry, CacheEntry::Queue::Recent);
+        return new_entry;
     }
 
     void mark_dirty(CacheEntry& entry)
     {
+        if (entry.is_dirty)
+            return;
+        entry.is_dirty = true;
+        entry.dirtied_at_ms = TimeManagement::the().uptime_ms();
         m_dirty_list.prepend(entry);
+        ++m_dirty_count;
+        m_counters.dirty_count.fetch_add(1);
+    }
+
+    void invalidate(BlockBasedFileSystem::BlockIndex block_index)
+    {
+        if (auto* entry = get(block_index); entry && !entry->is_dirty)
+            entry->has_data = false;
+    }
+
+    void flush_entry_if_dirty(BlockBasedFileSystem::BlockIndex block_index)
+    {
+        VERIFY(m_lock.is_locked());
+        auto* entry = get(block_index);
+        if (!entry || !entry->is_dirty)
+            return;
+        write_entry(*entry);
+        mark_clean(*entry);
+    }
+
+    size_t flush()
+    {
+        VERIFY(m_lock.is_locked());
+        Vector<BlockBasedFileSystem::BlockIndex> blocks;
+        collect_dirty_blocks(blocks, NumericLimits<u64>::max(), m_dirty_count);
+        quick_sort(blocks);
+        auto count = write_back(blocks);
+
+        // If we couldn't even put the list of blocks together, write them out one by one.
+        while (auto* entry = m_dirty_list.first()) {
+            write_entry(*entry);
+            mark_clean(*entry);
+            ++count;
+        }
+        return count;
+    }
+
+    // Collects the blocks that became dirty before `dirtied_before_ms`, as well as however
+    // many of the oldest remaining dirty blocks it takes to collect at least `minimum_count`.
+    void collect_dirty_blocks(Vector<BlockBasedFileSystem::BlockIndex>& blocks, u64 dirtied_before_ms, size_t minimum_count)
+    {
+        VERIFY(m_lock.is_locked());
+        size_t collected = 0;
+        // NOTE: The dirty list is ordered by the time its blocks became dirty, newest first.
+        for (auto it = m_dirty_list.rbegin(); it != m_dirty_list.rend(); ++it) {
+            if (collected >= minimum_count && it->dirtied_at_ms >= dirtied_before_ms)
+                break;
+            if (blocks.try_append(it->block_index).is_error())
+                break;
+            ++collected;
+        }
+    }
+
+    // Writes back those of the given (sorted) blocks that are still dirty,
+    // merging physically contiguous blocks into a single device write.
+    size_t write_back(Span<BlockBasedFileSystem::BlockIndex const> blocks)
+    {
+        VERIFY(m_lock.is_locked());
+        if (blocks.is_empty())
+            return 0;
+
+        auto block_size = m_fs.block_size();
+        auto bounce_buffer_or_error = ByteBuffer::create_uninitialized(min(blocks.size(), max_blocks_per_write_back) * block_size);
+        size_t count = 0;
+        size_t i = 0;
+        while (i < blocks.size()) {
+            auto* first_entry = get(blocks[i]);
+            if (!first_entry || !first_entry->is_dirty) {
+                ++i;
+                continue;
+            }
+            if (bounce_buffer_or_error.is_error()) {
+                write_entry(*first_entry);
+                mark_clean(*first_entry);
+                ++count;
+                ++i;
+                continue;
+            }
+
+            auto& bounce_buffer = bounce_buffer_or_error.value();
+            size_t run_length = 0;
+            while (i + run_length < blocks.size() && run_length * block_size < bounce_buffer.size()) {
+                auto index = blocks[i + run_length];
+                if (index.value() != blocks[i].value() + run_length)
+                    break;
+                auto* entry = get(index);
+                if (!entry || !entry->is_dirty)
+                    break;
+                memcpy(bounce_buffer.data() + run_length * block_size, entry->data, block_size);
+                ++run_length;
+            }
+
+            auto buffer = UserOrKernelBuffer::for_kernel_buffer(bounce_buffer.data());
+            [[maybe_unused]] auto rc = m_fs.file_description().write(blocks[i].value() * block_size, buffer, run_length * block_size);
+            for (size_t j = 0; j < run_length; ++j)
+                mark_clean(*get(blocks[i + j]));
+            count += run_length;
+            i += run_length;
+        }
+        return count;
+    }
+
+    // Gives the most recently added chunk back to the system, dropping whatever it had cached.
+    bool shrink()
+    {
+        VERIFY(m_lock.is_locked());
+        if (m_chunks.size() <= 1)
+            return false;
+
+        auto& chunk = *m_chunks.last();
+        for (auto& entry : chunk.entries) {
+            if (entry.is_dirty) {
+                flush();
+                break;
+            }
+        }
+        for (auto& entry : chunk.entries) {
+            if (entry.queue != CacheEntry::Queue::Free)
+                m_hash.remove(entry.block_index);
+            set_queue(entry, CacheEntry::Queue::Free);
+            entry.list_node.remove();
+        }
+        (void)m_chunks.take_last();
+        m_counters.entry_count.fetch_sub(DiskCacheChunk::EntryCount);
+        return true;
+    }
+
+private:
+    IntrusiveList<&CacheEntry::list_node>& list_for(CacheEntry::Queue queue)
+    {
+        switch (queue) {
+        case CacheEntry::Queue::Free:
+            return m_free_list;
+        case CacheEntry::Queue::Recent:
+            return m_recent_list;
+        case CacheEntry::Queue::Frequent:
+            return m_frequent_list;
+        }
+        VERIFY_NOT_REACHED();
+    }
+
+    void set_queue(CacheEntry& entry, CacheEntry::Queue queue)
+    {
+        if (entry.queue == CacheEntry::Queue::Recent)
+            --m_recent_count;
+        if (queue == CacheEntry::Queue::Recent)
+            ++m_recent_count;
+        entry.queue = queue;
+        if (!entry.is_dirty)
+            list_for(queue).prepend(entry);
     }
 
     void mark_clean(CacheEntry& entry)
     {
-        m_clean_list.prepend(entry);
+        VERIFY(entry.is_dirty);
+        entry.is_dirty = false;
+        m_write_back_generation.fetch_add(1);
+        list_for(entry.queue).prepend(entry);
+        --m_dirty_count;
+        m_counters.dirty_count.fetch_sub(1);
     }
 
-    CacheEntry* get(BlockBasedFileSystem::BlockIndex block_index) const
+    void did_hit(CacheEntry& entry)
     {
-        auto it = m_hash.find(block_index);
-        if (it == m_hash.end())
-            return nullptr;
-        auto& entry = const_cast<CacheEntry&>(*it->value);
-        VERIFY(entry.block_index == block_index);
-        return &entry;
+        // NOTE: Hits in the recent queue are deliberately ignored, they are usually
+        //       just the same reader coming back for the rest of a block.
+        if (entry.queue == CacheEntry::Queue::Frequent && !entry.is_dirty)
+            m_frequent_list.prepend(entry);
     }
 
-    ErrorOr<CacheEntry*> ensure(BlockBasedFileSystem::BlockIndex block_index) const
+    void write_entry(CacheEntry& entry)
     {
-        if (auto* entry = get(block_index))
-            return entry;
+        auto base_offset = entry.block_index.value() * m_fs.block_size();
+        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
+        [[maybe_unused]] auto rc = m_fs.file_description().write(base_offset, entry_data_buffer, m_fs.block_size());
+    }
 
-        if (m_clean_list.is_empty()) {
-            // Not a single clean entry! Flush writes and try again.
-            // NOTE: We want to make sure we only call FileBackedFileSystem flush here,
-            //       not some FileBackedFileSystem subclass flush!
-            m_fs->flush_writes_impl();
-            return ensure(block_index);
+    void remember_ghost(BlockBasedFileSystem::BlockIndex block_index)
+    {
+        auto ghost_capacity = max(m_max_chunk_count * DiskCacheChunk::EntryCount / 2, 1);
+        if (m_ghost_queue.size() < ghost_capacity) {
+            if (m_ghost_queue.try_append(block_index).is_error())
+                return;
+        } else {
+            m_ghosts.remove(m_ghost_queue[m_ghost_queue_head]);
+            m_ghost_queue[m_ghost_queue_head] = block_index;
+            m_ghost_queue_head = (m_ghost_queue_head + 1) % m_ghost_queue.size();
         }
+        (void)m_ghosts.try_set(block_index);
+    }
 
-        VERIFY(m_clean_list.last());
-        auto& new_entry = *m_clean_list.last();
-        m_clean_list.prepend(new_entry);
+    CacheEntry* take_reusable_entry()
+    {
+        if (m_free_list.is_empty() && m_chunks.size() < m_max_chunk_count && !MM.is_low_on_physical_memory())
+            (void)grow();
+
+        CacheEntry* victim = m_free_list.first();
+        if (!victim) {
+            auto recent_target = max(entry_count() / 4, 1);
+            if (m_recent_count > recent_target || m_frequent_list.is_empty())
+                victim = m_recent_list.last();
+            if (!victim)
+                victim = m_frequent_list.last();
+            if (!victim)
+                victim = m_recent_list.last();
+            if (!victim)
+                return nullptr;
+
+            m_hash.remove(victim->block_index);
+            if (victim->queue == CacheEntry::Queue::Recent)
+                remember_ghost(victim->block_index);
+        }
+        set_queue(*victim, CacheEntry::Queue::Free);
+        return victim;
+    }
+
+    BlockBasedFileSystem& m_fs;
+    DiskCacheCounters& m_counters;
+    mutable Mutex m_lock { "DiskCacheShard"sv };
+    Vector<NonnullOwnPtr<DiskCacheChunk>> m_chunks;
+    size_t m_max_chunk_count { 1 };
+
+    HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
+    IntrusiveList<&CacheEntry::list_node> m_free_list;
+    IntrusiveList<&CacheEntry::list_node> m_recent_list;
+    IntrusiveList<&CacheEntry::list_node> m_frequent_list;
+    IntrusiveList<&CacheEntry::list_node> m_dirty_list;
+    size_t m_recent_count { 0 };
+    size_t m_dirty_count { 0 };
+    Atomic<u64> m_write_back_generation { 0 };
+
+    HashTable<BlockBasedFileSystem::BlockIndex> m_ghosts;
+    Vector<BlockBasedFileSystem::BlockIndex> m_ghost_queue;
+    size_t m_ghost_queue_head { 0 };
+};
 
-        m_hash.remove(new_entry.block_index);
-        TRY(m_hash.try_set(block_index, &new_entry));
+class DiskCache {
+public:
+    static constexpr size_t ShardCount = 16;
+
+    // Runs of this many consecutive blocks always end up in the same shard,
+    // so that readahead and writeback can merge them into a single request.
+    static constexpr size_t BlocksPerStripe = max_blocks_per_write_back;
 
-        new_entry.block_index = block_index;
-        new_entry.has_data = false;
+    // The cache may grow to this fraction of physical memory, as long as the system isn't short on memory.
+    static constexpr size_t PhysicalMemoryFraction = 8;
 
-        return &new_entry;
+    static ErrorOr<NonnullOwnPtr<DiskCache>> try_create(BlockBasedFileSystem& fs)
+    {
+        auto physical_memory_size = MM.get_system_memory_info().physical_pages * PAGE_SIZE;
+        auto max_entry_count = physical_memory_size / PhysicalMemoryFraction / fs.block_size();
+        auto max_chunks_per_shard = max(ceil_div(max_entry_count, ShardCount * DiskCacheChunk::EntryCount), 1);
+
+        auto cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(fs)));
+        for (auto& shard : cache->m_shards) {
+            shard = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCacheShard(fs, cache->m_counters, max_chunks_per_shard)));
+            MutexLocker locker(shard->lock());
+            TRY(shard->grow());
+        }
+        return cache;
     }
 
-    CacheEntry const* entries() const { return (CacheEntry const*)m_entries->data(); }
-    CacheEntry* entries() { return (CacheEntry*)m_entries->data(); }
+    DiskCacheShard& shard_for(BlockBasedFileSystem::BlockIndex block_index)
+    {
+        return *m_shards[shard_index_for(block_index)];
+    }
+
+    size_t entry_count() const { return m_counters.entry_count.load(); }
+    size_t dirty_count() const { return m_counters.dirty_count.load(); }
 
     template<typename Callback>
-    void for_each_dirty_entry(Callback callback)
+    void for_each_shard(Callback callback)
     {
-        for (auto& entry : m_dirty_list)
-            callback(entry);
+        for (auto& shard : m_shards)
+            callback(*shard);
+    }
+
+    void did_uncached_write() { m_uncached_write_generation.fetch_add(1); }
+
+    // Changes whenever something may have reached the device for the given run of blocks: a write that
+    // bypassed the cache, or a write back from one of the shards the run maps to. Readers that go to the
+    // device without holding a shard lock use this to tell whether their data might have gone stale.
+    // NOTE: Compare it with the lock of a block's shard held, so that the block can't be written back
+    //       and evicted between the check and putting the data into the cache.
+    u64 write_generation_for(BlockBasedFileSystem::BlockIndex first_block, size_t count) const
+    {
+        VERIFY(count > 0);
+        u64 generation = m_uncached_write_generation.load();
+        u32 seen_shards = 0;
+        for (auto stripe = first_block.value() / BlocksPerStripe; stripe <= (first_block.value() + count - 1) / BlocksPerStripe; ++stripe) {
+            auto shard_index = shard_index_for(BlockBasedFileSystem::BlockIndex { stripe * BlocksPerStripe });
+            if (seen_shards & (1u << shard_index))
+                continue;
+            seen_shards |= 1u << shard_index;
+            // All of these only ever go up, so their sum changes as soon as one of them does.
+            generation += m_shards[shard_index]->write_back_generation();
+            if (seen_shards == (1u << ShardCount) - 1)
+                break;
+        }
+        return generation;
     }
 
 private:
-    mutable NonnullRefPtr<BlockBasedFileSystem> m_fs;
-    mutable IntrusiveList<&CacheEntry::list_node> m_dirty_list;
-    mutable IntrusiveList<&CacheEntry::list_node> m_clean_list;
-    mutable HashMap<BlockBasedFileSystem::BlockIndex, CacheEntry*> m_hash;
-    NonnullOwnPtr<KBuffer> m_cached_block_data;
-    NonnullOwnPtr<KBuffer> m_entries;
+    static size_t shard_index_for(BlockBasedFileSystem::BlockIndex block_index)
+    {
+        return u64_hash(block_index.value() / BlocksPerStripe) % ShardCount;
+    }
+
+    explicit DiskCache(BlockBasedFileSystem& fs)
+        : m_fs(fs)
+    {
+    }
+
+    NonnullRefPtr<BlockBasedFileSystem> m_fs;
+    DiskCacheCounters m_counters;
+    Array<OwnPtr<DiskCacheShard>, ShardCount> m_shards;
+    Atomic<u64> m_uncached_write_generation { 0 };
 };
 
 BlockBasedFileSystem::BlockBasedFileSystem(OpenFileDescription& file_description)
@@ -129,9 +492,7 @@ ErrorOr<void> BlockBasedFileSystem::initialize_while_locked()
     VERIFY(m_lock.is_locked());
     VERIFY(!is_initialized_while_locked());
     VERIFY(block_size() != 0);
-    auto cached_block_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache blocks"sv, DiskCache::EntryCount * block_size()));
-    auto entries_data = TRY(KBuffer::try_create_with_size("BlockBasedFS: Cache entries"sv, DiskCache::EntryCount * sizeof(CacheEntry)));
-    auto disk_cache = TRY(adopt_nonnull_own_or_enomem(new (nothrow) DiskCache(*this, move(cached_block_data), move(entries_data))));
+    auto disk_cache = TRY(DiskCache::try_create(*this));
 
     m_cache.with_exclusive([&](auto& cache) {
         cache = move(disk_cache);
@@ -152,23 +513,29 @@ ErrorOr<void> BlockBasedFileSystem::write_block(BlockIndex index, UserOrKernelBu
 
     TRY(data.read(buffered_data.bytes()));
 
-    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+    return m_cache.with_shared([&](auto const& cache) -> ErrorOr<void> {
+        auto& shard = cache->shard_for(index);
+        MutexLocker locker(shard.lock());
+
         if (!allow_cache) {
-            flush_specific_block_if_needed(index);
+            shard.flush_entry_if_dirty(index);
+            cache->did_uncached_write();
             u64 base_offset = index.value() * block_size() + offset;
             auto nwritten = TRY(file_description().write(base_offset, data, count));
             VERIFY(nwritten == count);
+            // Make sure we don't keep serving the old contents from the cache.
+            shard.invalidate(index);
             return {};
         }
 
-        auto entry = TRY(cache->ensure(index));
+        auto entry = TRY(shard.ensure(index));
         if (count < block_size()) {
             // Fill the cache first.
             TRY(read_block(index, nullptr, block_size()));
         }
         memcpy(entry->data + offset, buffered_data.data(), count);
 
-        cache->mark_dirty(*entry);
+        shard.mark_dirty(*entry);
         entry->has_data = true;
         return {};
     });
@@ -214,6 +581,26 @@ ErrorOr<void> BlockBasedFileSystem::write_blocks(BlockIndex index, unsigned coun
 {
     VERIFY(m_logical_block_size);
     dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::write_blocks {}, count={}", index, count);
+    if (!allow_cache && count > 1) {
+        // Go around the cache with a single device write for the whole run.
+        return m_cache.with_shared([&](auto const& cache) -> ErrorOr<void> {
+            for (unsigned i = 0; i < count; ++i) {
+                auto& shard = cache->shard_for(BlockIndex { index.value() + i });
+                MutexLocker locker(shard.lock());
+                shard.flush_entry_if_dirty(BlockIndex { index.value() + i });
+            }
+            cache->did_uncached_write();
+            auto nwritten = TRY(file_description().write(index.value() * block_size(), data, count * block_size()));
+            VERIFY(nwritten == count * block_size());
+            // Make sure we don't keep serving the old contents from the cache.
+            for (unsigned i = 0; i < count; ++i) {
+                auto& shard = cache->shard_for(BlockIndex { index.value() + i });
+                MutexLocker locker(shard.lock());
+                shard.invalidate(BlockIndex { index.value() + i });
+            }
+            return {};
+        });
+    }
     for (unsigned i = 0; i < count; ++i) {
         TRY(write_block(BlockIndex { index.value() + i }, data.offset(i * block_size()), block_size(), 0, allow_cache));
     }
@@ -226,16 +613,19 @@ ErrorOr<void> BlockBasedFileSystem::read_block(BlockIndex index, UserOrKernelBuf
     VERIFY(offset + count <= block_size());
     dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_block {}", index);
 
-    return m_cache.with_exclusive([&](auto& cache) -> ErrorOr<void> {
+    return m_cache.with_shared([&](auto const& cache) -> ErrorOr<void> {
+        auto& shard = cache->shard_for(index);
+        MutexLocker locker(shard.lock());
+
         if (!allow_cache) {
-            const_cast<BlockBasedFileSystem*>(this)->flush_specific_block_if_needed(index);
+            shard.flush_entry_if_dirty(index);
             u64 base_offset = index.value() * block_size() + offset;
             auto nread = TRY(file_description().read(*buffer, base_offset, count));
             VERIFY(nread == count);
             return {};
         }
 
-        auto* entry = TRY(cache->ensure(index));
+        auto* entry = TRY(shard.ensure(index));
         if (!entry->has_data) {
             auto base_offset = index.value() * block_size();
             auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
@@ -256,46 +646,279 @@ ErrorOr<void> BlockBasedFileSystem::read_blocks(BlockIndex index, unsigned count
         return EINVAL;
     if (count == 1)
         return read_block(index, &buffer, block_size(), 0, allow_cache);
-    auto out = buffer;
-    for (unsigned i = 0; i < count; ++i) {
-        TRY(read_block(BlockIndex { index.value() + i }, &out, block_size(), 0, allow_cache));
-        out = out.offset(block_size());
+    dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_blocks {}, count={}", index, count);
+
+    return m_cache.with_shared([&](auto const& cache) -> ErrorOr<void> {
+        auto is_cached = [&](BlockIndex block) {
+            auto& shard = cache->shard_for(block);
+            MutexLocker locker(shard.lock());
+            auto* entry = shard.get(block);
+            return entry && entry->has_data;
+        };
+
+        unsigned i = 0;
+        while (i < count) {
+            BlockIndex block { index.value() + i };
+            auto out = buffer.offset(i * block_size());
+            if (allow_cache && is_cached(block)) {
+                TRY(read_block(block, &out, block_size()));
+                ++i;
+                continue;
+            }
+
+            // Read every block that we can't serve from the cache with a single device read.
+            unsigned run_length = 1;
+            while (i + run_length < count && (!allow_cache || !is_cached(BlockIndex { block.value() + run_length })))
+                ++run_length;
+
+            // Writes that are still sitting in the cache have to reach the device before we read around it.
+            if (!allow_cache) {
+                for (unsigned j = 0; j < run_length; ++j) {
+                    auto& shard = cache->shard_for(BlockIndex { block.value() + j });
+                    MutexLocker locker(shard.lock());
+                    shard.flush_entry_if_dirty(BlockIndex { block.value() + j });
+                }
+            }
+
+            // NOTE: We don't hold any shard lock during the device read so that everyone else can keep
+            //       using the cache. Anything that reached the device meanwhile makes our data suspect.
+            auto generation = cache->write_generation_for(block, run_length);
+            auto nread = TRY(file_description().read(out, block.value() * block_size(), run_length * block_size()));
+            VERIFY(nread == run_length * block_size());
+
+            if (allow_cache) {
+                for (unsigned j = 0; j < run_length; ++j) {
+                    BlockIndex run_block { block.value() + j };
+                    auto run_out = out.offset(j * block_size());
+                    auto& shard = cache->shard_for(run_block);
+                    MutexLocker locker(shard.lock());
+                    if (generation != cache->write_generation_for(block, run_length))
+                        break;
+                    auto* entry = TRY(shard.ensure(run_block));
+                    if (entry->has_data) {
+                        // Someone got to this block while we were reading, and the cache is never older than the disk.
+                        TRY(run_out.write(entry->data, block_size()));
+                        continue;
+                    }
+                    TRY(run_out.read(entry->data, block_size()));
+                    entry->has_data = true;
+                }
+            }
+            i += run_length;
+        }
+        return {};
+    });
+}
+
+// Blocks that have been dirty for this long are written back on the next writeback pass.
+static constexpr u64 dirty_expire_ms = 5000;
+
+static constexpr u64 max_dirty_throttle_pause_ms = 100;
+static constexpr size_t max_dirty_throttle_attempts = 20;
+
+// Readahead is only worth doing as long as it doesn't turn into a backlog of its own.
+static constexpr u32 max_prefetches_in_flight = 8;
+static constexpr size_t max_blocks_per_prefetch_read = 32;
+
+void BlockBasedFileSystem::prefetch_blocks(Vector<BlockIndex>&& blocks)
+{
+    if (blocks.is_empty())
+        return;
+
+    if (m_prefetches_in_flight.fetch_add(1) >= max_prefetches_in_flight) {
+        m_prefetches_in_flight.fetch_sub(1);
+        return;
     }
 
-    return {};
+    auto result = g_readahead_work->try_queue([fs = NonnullRefPtr<BlockBasedFileSystem>(*this), blocks = move(blocks)]() {
+        fs->read_blocks_into_cache(blocks.span());
+        fs->m_prefetches_in_flight.fetch_sub(1);
+    });
+    if (result.is_error())
+        m_prefetches_in_flight.fetch_sub(1);
 }
 
-void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
+void BlockBasedFileSystem::read_blocks_into_cache(Span<BlockIndex const> blocks)
 {
-    m_cache.with_exclusive([&](auto& cache) {
-        if (!cache->is_dirty())
-            return;
-        auto* entry = cache->get(index);
-        if (!entry)
-            return;
-        if (!cache->entry_is_dirty(*entry))
+    VERIFY(m_logical_block_size);
+    auto buffer_or_error = ByteBuffer::create_uninitialized(max_blocks_per_prefetch_read * block_size());
+    if (buffer_or_error.is_error())
+        return;
+    auto buffer = buffer_or_error.release_value();
+
+    m_cache.with_shared([&](auto const& cache) {
+        // The file system may have been unmounted while this request was queued.
+        if (!cache)
             return;
-        size_t base_offset = entry->block_index.value() * block_size();
-        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry->data);
-        (void)file_description().write(base_offset, entry_data_buffer, block_size());
+
+        auto is_cached = [&](BlockIndex index) {
+            auto& shard = cache->shard_for(index);
+            MutexLocker locker(shard.lock());
+            auto* entry = shard.get(index);
+            return entry && entry->has_data;
+        };
+
+        size_t i = 0;
+        while (i < blocks.size()) {
+            if (is_cached(blocks[i])) {
+                ++i;
+                continue;
+            }
+
+            // Coalesce physically contiguous blocks that are missing from the cache into a single device read.
+            size_t run_length = 1;
+            while (i + run_length < blocks.size()
+                && run_length < max_blocks_per_prefetch_read
+                && blocks[i + run_length].value() == blocks[i].value() + run_length
+                && !is_cached(blocks[i + run_length])) {
+                ++run_length;
+            }
+
+            // NOTE: We don't hold any shard lock during the device read so that everyone else can keep
+            //       using the cache. Anything that reached the device meanwhile makes our data suspect.
+            auto generation = cache->write_generation_for(blocks[i], run_length);
+            dbgln_if(BBFS_DEBUG, "BlockBasedFileSystem::read_blocks_into_cache {}, count={}", blocks[i], run_length);
+            auto run_buffer = UserOrKernelBuffer::for_kernel_buffer(buffer.data());
+            auto nread_or_error = file_description().read(run_buffer, blocks[i].value() * block_size(), run_length * block_size());
+            if (nread_or_error.is_error() || nread_or_error.value() != run_length * block_size())
+                return;
+
+            for (size_t j = 0; j < run_length; ++j) {
+                auto& shard = cache->shard_for(blocks[i + j]);
+                MutexLocker locker(shard.lock());
+                if (generation != cache->write_generation_for(blocks[i], run_length))
+                    return;
+                auto entry_or_error = shard.ensure(blocks[i + j]);
+                if (entry_or_error.is_error())
+                    return;
+                auto* entry = entry_or_error.release_value();
+                if (entry->has_data)
+                    continue;
+                memcpy(entry->data, buffer.data() + j * block_size(), block_size());
+                entry->has_data = true;
+            }
+            i += run_length;
+        }
     });
 }
 
 void BlockBasedFileSystem::flush_writes_impl()
 {
     size_t count = 0;
-    m_cache.with_exclusive([&](auto& cache) {
-        if (!cache->is_dirty())
+    m_cache.with_shared([&](auto const& cache) {
+        if (!cache)
             return;
-        cache->for_each_dirty_entry([&](CacheEntry& entry) {
-            auto base_offset = entry.block_index.value() * block_size();
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-            [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, block_size());
-            ++count;
+        cache->for_each_shard([&](DiskCacheShard& shard) {
+            MutexLocker locker(shard.lock());
+            if (shard.is_dirty())
+                count += shard.flush();
         });
-        cache->mark_all_clean();
+    });
+    if (count)
         dbgln("{}: Flushed {} blocks to disk", class_name(), count);
+}
+
+size_t BlockBasedFileSystem::write_back()
+{
+    size_t count = 0;
+    m_cache.with_shared([&](auto const& cache) {
+        if (!cache || cache->dirty_count() == 0)
+            return;
+
+        // Anything that has been dirty for long enough is written back no matter what. On top of that,
+        // we write back the oldest dirty blocks until we're below the background threshold again.
+        auto now_ms = TimeManagement::the().uptime_ms();
+        auto dirtied_before_ms = now_ms > dirty_expire_ms ? now_ms - dirty_expire_ms : 0;
+        auto background_limit = cache->entry_count() * g_dirty_background_ratio.load() / 100;
+        auto dirty_count = cache->dirty_count();
+        auto excess = dirty_count > background_limit ? dirty_count - background_limit : 0;
+        auto minimum_count_per_shard = ceil_div(excess, DiskCache::ShardCount);
+
+        cache->for_each_shard([&](DiskCacheShard& shard) {
+            Vector<BlockIndex> blocks;
+            {
+                MutexLocker locker(shard.lock());
+                shard.collect_dirty_blocks(blocks, dirtied_before_ms, minimum_count_per_shard);
+            }
+            quick_sort(blocks);
+
+            // NOTE: We let go of the shard between batches, so readers don't have to wait for all of it.
+            for (size_t i = 0; i < blocks.size(); i += max_blocks_per_write_back) {
+                MutexLocker locker(shard.lock());
+                count += shard.write_back(blocks.span().slice(i, min(max_blocks_per_write_back, blocks.size() - i)));
+            }
+        });
+    });
+    dbgln_if(BBFS_DEBUG, "{}: Wrote back {} blocks", class_name(), count);
+    return count;
+}
+
+void BlockBasedFileSystem::throttle_dirtying_writer()
+{
+    // NOTE: Writeback must never end up waiting for itself.
+    if (WritebackTask::is_current_thread())
+        return;
+
+    auto background_ratio = g_dirty_background_ratio.load();
+    auto dirty_ratio = max(g_dirty_ratio.load(), background_ratio);
+
+    struct Counts {
+        size_t dirty { 0 };
+        size_t background_limit { 0 };
+        size_t limit { 0 };
+    };
+    auto current_counts = [&] {
+        return m_cache.with_shared([&](auto const& cache) -> Counts {
+            if (!cache)
+                return {};
+            auto entry_count = cache->entry_count();
+            return { cache->dirty_count(), entry_count * background_ratio / 100, entry_count * dirty_ratio / 100 };
+        });
+    };
+
+    auto counts = current_counts();
+    if (counts.dirty == 0 || counts.dirty < counts.background_limit)
+        return;
+
+    WritebackTask::wake();
+
+    if (counts.dirty < counts.limit) {
+        // Between the two thresholds, writers are slowed down more and more the
+        // closer we get to the limit, which gives writeback a chance to catch up.
+        u64 distance = counts.limit - counts.background_limit;
+        u64 over = counts.dirty - counts.background_limit;
+        auto pause_ms = max_dirty_throttle_pause_ms * over * over / (distance * distance);
+        if (pause_ms > 0)
+            (void)Thread::current()->sleep(Time::from_milliseconds(pause_ms));
+        return;
+    }
+
+    // We're at the limit, wait for writeback to make room. We don't wait forever though,
+    // a device that has stopped making progress shouldn't hang every writer in the system.
+    for (size_t attempt = 0; attempt < max_dirty_throttle_attempts; ++attempt) {
+        WritebackTask::wait_for_progress(Time::from_milliseconds(max_dirty_throttle_pause_ms));
+        counts = current_counts();
+        if (counts.dirty < counts.limit)
+            return;
+    }
+}
+
+void BlockBasedFileSystem::release_cached_memory()
+{
+    size_t released_chunk_count = 0;
+    m_cache.with_shared([&](auto const& cache) {
+        if (!cache)
+            return;
+        cache->for_each_shard([&](DiskCacheShard& shard) {
+            MutexLocker locker(shard.lock());
+            // Only give back a quarter of each shard per call, a short spike shouldn't cost us the whole cache.
+            auto chunks_to_release = max(shard.chunk_count() / 4, 1);
+            for (size_t i = 0; i < chunks_to_release && shard.shrink(); ++i)
+                ++released_chunk_count;
+        });
     });
+    if (released_chunk_count)
+        dbgln("{}: Released {} KiB of cached blocks", class_name(), released_chunk_count * DiskCacheChunk::EntryCount * block_size() / KiB);
 }
 
 void BlockBasedFileSystem::flush_writes()
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
+#include <AK/Vector.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/Locking/MutexProtected.h>
 
@@ -22,6 +24,10 @@ public:
     virtual void flush_writes() override;
     void flush_writes_impl();
 
+    virtual size_t write_back() override;
+    virtual void throttle_dirtying_writer() override;
+    virtual void release_cached_memory() override;
+
 protected:
     explicit BlockBasedFileSystem(OpenFileDescription&);
 
@@ -39,15 +45,19 @@ protected:
     ErrorOr<void> write_block(BlockIndex, UserOrKernelBuffer const&, size_t count, u64 offset = 0, bool allow_cache = true);
     ErrorOr<void> write_blocks(BlockIndex, unsigned count, UserOrKernelBuffer const&, bool allow_cache = true);
 
+    // Starts reading the given blocks into the cache in the background.
+    void prefetch_blocks(Vector<BlockIndex>&&);
+
     u64 m_logical_block_size { 512 };
 
     void remove_disk_cache_before_last_unmount();
 
 private:
     DiskCache& cache() const;
-    void flush_specific_block_if_needed(BlockIndex index);
+    void read_blocks_into_cache(Span<BlockIndex const>);
 
     mutable MutexProtected<OwnPtr<DiskCache>> m_cache;
+    Atomic<u32> m_prefetches_in_flight { 0 };
 };
 
 }
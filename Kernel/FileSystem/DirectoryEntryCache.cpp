@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Singleton.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
+#include <Kernel/FileSystem/Inode.h>
+
+namespace Kernel {
+
+static Singleton<DirectoryEntryCache> s_the;
+
+DirectoryEntryCache& DirectoryEntryCache::the()
+{
+    return *s_the;
+}
+
+DirectoryEntryCache::Shard& DirectoryEntryCache::shard_for(InodeIdentifier parent)
+{
+    return m_shards[Traits<InodeIdentifier>::hash(parent) % shard_count];
+}
+
+ErrorOr<NonnullLockRefPtr<Inode>> DirectoryEntryCache::lookup(Inode& parent, StringView name)
+{
+    if (!parent.fs().supports_directory_entry_cache())
+        return parent.lookup(name);
+
+    auto& shard = shard_for(parent.identifier());
+    u64 invalidation_count = 0;
+    {
+        SpinlockLocker locker(shard.lock);
+        if (auto it = shard.entries.find(Key { parent.identifier(), name }); it != shard.entries.end()) {
+            auto& entry = *it->value;
+            shard.lru_list.remove(entry);
+            shard.lru_list.prepend(entry);
+            if (!entry.inode)
+                return ENOENT;
+            return NonnullLockRefPtr<Inode> { *entry.inode };
+        }
+        invalidation_count = shard.invalidation_count;
+    }
+
+    auto child_or_error = parent.lookup(name);
+    if (child_or_error.is_error()) {
+        if (child_or_error.error().code() == ENOENT)
+            add(shard, invalidation_count, parent, name, nullptr);
+        return child_or_error.release_error();
+    }
+    add(shard, invalidation_count, parent, name, child_or_error.value());
+    return child_or_error.release_value();
+}
+
+void DirectoryEntryCache::add(Shard& shard, u64 invalidation_count, Inode& parent, StringView name, LockRefPtr<Inode> child)
+{
+    // NOTE: Failing to cache something is not an error, the next lookup will simply go to the file system again.
+    auto name_or_error = KString::try_create(name);
+    if (name_or_error.is_error())
+        return;
+    auto* entry = new (nothrow) Entry(parent.identifier(), name_or_error.release_value(), move(child));
+    if (!entry)
+        return;
+
+    EntryList removed_entries;
+    {
+        SpinlockLocker locker(shard.lock);
+        if (shard.invalidation_count != invalidation_count || shard.entries.contains(entry->key())) {
+            removed_entries.append(*entry);
+        } else if (shard.entries.try_set(entry->key(), entry).is_error()) {
+            removed_entries.append(*entry);
+        } else {
+            shard.lru_list.prepend(*entry);
+            parent.m_has_cached_directory_entries = true;
+            if (shard.entries.size() > max_entries_per_shard)
+                remove_entry(shard, *shard.lru_list.last(), removed_entries);
+        }
+    }
+    free_entries(removed_entries);
+}
+
+void DirectoryEntryCache::remove_entry(Shard& shard, Entry& entry, EntryList& removed_entries)
+{
+    shard.entries.remove(entry.key());
+    shard.lru_list.remove(entry);
+    removed_entries.append(entry);
+}
+
+void DirectoryEntryCache::free_entries(EntryList& entries)
+{
+    // NOTE: This may drop the last reference to an inode, so it must not happen with a shard lock held.
+    while (auto* entry = entries.take_first())
+        delete entry;
+}
+
+void DirectoryEntryCache::invalidate(InodeIdentifier parent, StringView name)
+{
+    auto& shard = shard_for(parent);
+    EntryList removed_entries;
+    {
+        SpinlockLocker locker(shard.lock);
+        ++shard.invalidation_count;
+        if (auto it = shard.entries.find(Key { parent, name }); it != shard.entries.end())
+            remove_entry(shard, *it->value, removed_entries);
+    }
+    free_entries(removed_entries);
+}
+
+void DirectoryEntryCache::invalidate_directory(InodeIdentifier parent)
+{
+    auto& shard = shard_for(parent);
+    EntryList removed_entries;
+    {
+        SpinlockLocker locker(shard.lock);
+        ++shard.invalidation_count;
+        shard.entries.remove_all_matching([&](auto& key, auto* entry) {
+            if (key.parent != parent)
+                return false;
+            shard.lru_list.remove(*entry);
+            removed_entries.append(*entry);
+            return true;
+        });
+    }
+    free_entries(removed_entries);
+}
+
+void DirectoryEntryCache::invalidate_file_system(FileSystemID fsid)
+{
+    for (auto& shard : m_shards) {
+        EntryList removed_entries;
+        {
+            SpinlockLocker locker(shard.lock);
+            ++shard.invalidation_count;
+            shard.entries.remove_all_matching([&](auto& key, auto* entry) {
+                if (key.parent.fsid() != fsid)
+                    return false;
+                shard.lru_list.remove(*entry);
+                removed_entries.append(*entry);
+                return true;
+            });
+        }
+        free_entries(removed_entries);
+    }
+}
+
+void DirectoryEntryCache::release_all()
+{
+    for (auto& shard : m_shards) {
+        EntryList removed_entries;
+        {
+            SpinlockLocker locker(shard.lock);
+            ++shard.invalidation_count;
+            while (auto* entry = shard.lru_list.take_first())
+                removed_entries.append(*entry);
+            shard.entries.clear();
+        }
+        free_entries(removed_entries);
+    }
+}
+
+}
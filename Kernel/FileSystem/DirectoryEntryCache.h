@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Error.h>
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/StringView.h>
+#include <Kernel/FileSystem/FileSystem.h>
+#include <Kernel/KString.h>
+#include <Kernel/Library/NonnullLockRefPtr.h>
+#include <Kernel/Locking/Spinlock.h>
+
+namespace Kernel {
+
+// Remembers the results of looking up names in directories, including the names that
+// don't exist, so that resolving a hot path doesn't have to go down to the file system
+// for every component. Entries are keyed on (parent inode, name), and are dropped when
+// the parent reports a child being added or removed. Only file systems that reliably
+// report those changes take part.
+class DirectoryEntryCache {
+public:
+    static DirectoryEntryCache& the();
+
+    struct Key {
+        InodeIdentifier parent;
+        StringView name;
+
+        bool operator==(Key const&) const = default;
+    };
+
+    // Looks up `name` in `parent`, going to the file system only if the answer isn't cached yet.
+    ErrorOr<NonnullLockRefPtr<Inode>> lookup(Inode& parent, StringView name);
+
+    void invalidate(InodeIdentifier parent, StringView name);
+    void invalidate_directory(InodeIdentifier parent);
+    void invalidate_file_system(FileSystemID);
+
+    // Drops every entry, which lets go of the inodes they keep in memory.
+    void release_all();
+
+private:
+    static constexpr size_t shard_count = 16;
+    static constexpr size_t max_entries_per_shard = 512;
+
+    struct Entry {
+        Entry(InodeIdentifier parent, NonnullOwnPtr<KString> name, LockRefPtr<Inode> inode)
+            : parent(parent)
+            , name(move(name))
+            , inode(move(inode))
+        {
+        }
+
+        Key key() const { return { parent, name->view() }; }
+
+        InodeIdentifier parent;
+        NonnullOwnPtr<KString> name;
+        // A null inode is a negative entry: the name is known not to exist.
+        LockRefPtr<Inode> inode;
+        IntrusiveListNode<Entry> list_node;
+    };
+
+    using EntryList = IntrusiveList<&Entry::list_node>;
+
+    struct Shard {
+        mutable Spinlock lock { LockRank::None };
+        HashMap<Key, Entry*> entries;
+        // Most recently used entries come first.
+        EntryList lru_list;
+        // Bumped on every invalidation, so a lookup racing with one knows not to cache what it found.
+        u64 invalidation_count { 0 };
+    };
+
+    Shard& shard_for(InodeIdentifier parent);
+    void add(Shard&, u64 invalidation_count, Inode& parent, StringView name, LockRefPtr<Inode> child);
+
+    // Unlinks the entry from its shard; it has to be freed with free_entries() once the shard lock is dropped.
+    static void remove_entry(Shard&, Entry&, EntryList& removed_entries);
+    static void free_entries(EntryList&);
+
+    Array<Shard, shard_count> m_shards;
+};
+
+}
+
+namespace AK {
+
+template<>
+struct Traits<Kernel::DirectoryEntryCache::Key> : public GenericTraits<Kernel::DirectoryEntryCache::Key> {
+    static unsigned hash(Kernel::DirectoryEntryCache::Key const& key) { return pair_int_hash(Traits<Kernel::InodeIdentifier>::hash(key.parent), key.name.hash()); }
+};
+
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KString.h>
+
+namespace Kernel {
+
+static u32 ready_events_for(OpenFileDescription const& description, u32 events)
+{
+    using BlockFlags = Thread::FileBlocker::BlockFlags;
+    BlockFlags block_flags = BlockFlags::None;
+    if (events & EPOLLIN)
+        block_flags |= BlockFlags::Read;
+    if (events & EPOLLPRI)
+        block_flags |= BlockFlags::ReadPriority;
+    if (events & EPOLLOUT)
+        block_flags |= BlockFlags::Write;
+
+    auto unblocked_flags = description.should_unblock(block_flags);
+    u32 ready_events = 0;
+    if (has_flag(unblocked_flags, BlockFlags::Read))
+        ready_events |= EPOLLIN;
+    if (has_flag(unblocked_flags, BlockFlags::ReadPriority))
+        ready_events |= EPOLLPRI;
+    if (has_flag(unblocked_flags, BlockFlags::Write))
+        ready_events |= EPOLLOUT;
+    return ready_events;
+}
+
+EventPoll::Watch::Watch(EventPoll& event_poll, int fd, OpenFileDescription& description, LockWeakPtr<OpenFileDescription> weak_description, epoll_event const& event)
+    : event_poll(event_poll)
+    , fd(fd)
+    , description(move(weak_description))
+    , file(description.file())
+    , events(event.events)
+    , data(event.data.u64)
+{
+    description.file().blocker_set().add_observer(*this, description);
+}
+
+EventPoll::Watch::~Watch()
+{
+    // Note: The description may be going away right now, in which case it removes us itself.
+    if (auto file = this->file)
+        file->blocker_set().remove_observer(*this);
+
+    SpinlockLocker lock(event_poll.m_ready_lock);
+    event_poll.m_ready_watches.remove(*this);
+}
+
+void EventPoll::Watch::file_state_changed()
+{
+    // Note: We can't look at the description here, as we might be holding the last reference
+    //       to it by the time we're done. Whoever collects the ready events checks whether
+    //       this change actually made the file ready for any of the events we care about.
+    {
+        SpinlockLocker lock(event_poll.m_ready_lock);
+        if (ready_list_node.is_in_list())
+            return;
+        event_poll.m_ready_watches.append(*this);
+    }
+    event_poll.evaluate_block_conditions();
+}
+
+void EventPoll::Watch::observed_description_closed()
+{
+    // Note: The description still holds on to the file, so this can't be the last reference to it.
+    file.clear();
+    // Get the watch looked at, so it's dropped without waiting for someone to touch its fd.
+    file_state_changed();
+}
+
+ErrorOr<NonnullLockRefPtr<EventPoll>> EventPoll::try_create()
+{
+    return adopt_nonnull_lock_ref_or_enomem(new (nothrow) EventPoll);
+}
+
+EventPoll::~EventPoll()
+{
+    MutexLocker locker(m_lock);
+    m_watches.clear();
+}
+
+bool EventPoll::can_read(OpenFileDescription const&, u64) const
+{
+    SpinlockLocker lock(m_ready_lock);
+    return !m_ready_watches.is_empty();
+}
+
+ErrorOr<NonnullOwnPtr<KString>> EventPoll::pseudo_path(OpenFileDescription const&) const
+{
+    MutexLocker locker(m_lock);
+    return KString::formatted("EventPoll:({})", m_watches.size());
+}
+
+auto EventPoll::find_watch(int fd, OpenFileDescription& description) -> Watch*
+{
+    VERIFY(m_lock.is_locked());
+    auto it = m_watches.find(fd);
+    if (it == m_watches.end())
+        return nullptr;
+    if (it->value->description.strong_ref().ptr() != &description)
+        return nullptr;
+    return it->value.ptr();
+}
+
+ErrorOr<void> EventPoll::add_watch(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    // Watching an event poll from another one could have their observers call each other.
+    if (description.is_event_poll())
+        return EINVAL;
+
+    MutexLocker locker(m_lock);
+    if (find_watch(fd, description))
+        return EEXIST;
+    // Whatever else is still here for this fd was watching a description that has since been closed.
+    m_watches.remove(fd);
+
+    auto weak_description = TRY(description.try_make_weak_ptr());
+    auto watch = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Watch(*this, fd, description, move(weak_description), event)));
+    auto& new_watch = *watch;
+    TRY(m_watches.try_set(fd, move(watch)));
+
+    // The file may well be ready already, in which case there won't be a state change to tell us.
+    new_watch.file_state_changed();
+    return {};
+}
+
+ErrorOr<void> EventPoll::modify_watch(int fd, OpenFileDescription& description, epoll_event const& event)
+{
+    MutexLocker locker(m_lock);
+    auto* watch = find_watch(fd, description);
+    if (!watch)
+        return ENOENT;
+
+    watch->events = event.events;
+    watch->data = event.data.u64;
+    watch->is_disabled = false;
+    watch->file_state_changed();
+    return {};
+}
+
+ErrorOr<void> EventPoll::remove_watch(int fd, OpenFileDescription& description)
+{
+    MutexLocker locker(m_lock);
+    if (!find_watch(fd, description))
+        return ENOENT;
+    m_watches.remove(fd);
+    return {};
+}
+
+size_t EventPoll::collect_ready_events(Span<epoll_event> events)
+{
+    MutexLocker locker(m_lock);
+
+    // Take everything that is on the ready list right now, so the level-triggered watches
+    // we put back on it below don't get looked at twice.
+    Watch::List candidates;
+    Watch::List still_ready;
+    {
+        SpinlockLocker lock(m_ready_lock);
+        while (auto* watch = m_ready_watches.first())
+            candidates.append(*watch);
+    }
+
+    size_t event_count = 0;
+    while (event_count < events.size()) {
+        Watch* watch = nullptr;
+        {
+            // Note: The watch has to be off all lists before we check its state, so that any
+            //       change after that puts it back on the ready list instead of being lost.
+            SpinlockLocker lock(m_ready_lock);
+            watch = candidates.take_first();
+        }
+        if (!watch)
+            break;
+
+        auto description = watch->description.strong_ref();
+        if (!description) {
+            m_watches.remove(watch->fd);
+            continue;
+        }
+        if (watch->is_disabled)
+            continue;
+
+        auto ready_events = ready_events_for(*description, watch->events);
+        if (ready_events == 0)
+            continue;
+
+        auto& event = events[event_count++];
+        event.events = ready_events;
+        event.data.u64 = watch->data;
+
+        if (watch->events & EPOLLONESHOT) {
+            watch->is_disabled = true;
+        } else if (!(watch->events & EPOLLET)) {
+            // Level-triggered watches keep being reported for as long as the file stays ready.
+            SpinlockLocker lock(m_ready_lock);
+            if (!watch->ready_list_node.is_in_list())
+                still_ready.append(*watch);
+        }
+    }
+
+    SpinlockLocker lock(m_ready_lock);
+    while (auto* watch = candidates.take_last())
+        m_ready_watches.prepend(*watch);
+    while (auto* watch = still_ready.take_first())
+        m_ready_watches.append(*watch);
+    return event_count;
+}
+
+}
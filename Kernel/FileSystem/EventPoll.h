@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Span.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/UnixTypes.h>
+
+namespace Kernel {
+
+// A persistent set of file descriptions that a process waits on. Unlike with poll(),
+// the set isn't handed to the kernel on every wait. Instead, every watched file gets
+// an observer on its blocker set, which puts the watch on the ready list whenever the
+// state of the file changes, so waiting only has to look at the watches on that list.
+class EventPoll final : public File {
+public:
+    static ErrorOr<NonnullLockRefPtr<EventPoll>> try_create();
+    virtual ~EventPoll() override;
+
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    // Can't write to an event poll.
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const&) const override;
+    virtual StringView class_name() const override { return "EventPoll"sv; }
+    virtual bool is_event_poll() const override { return true; }
+
+    ErrorOr<void> add_watch(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> modify_watch(int fd, OpenFileDescription&, epoll_event const&);
+    ErrorOr<void> remove_watch(int fd, OpenFileDescription&);
+
+    // Fills `events` with the events of the watches that are ready, and returns how many there were.
+    size_t collect_ready_events(Span<epoll_event> events);
+
+private:
+    EventPoll() = default;
+
+    struct Watch final : public FileBlockerSet::Observer {
+        Watch(EventPoll&, int fd, OpenFileDescription&, LockWeakPtr<OpenFileDescription>, epoll_event const&);
+        virtual ~Watch() override;
+
+        virtual void file_state_changed() override;
+        virtual void observed_description_closed() override;
+
+        EventPoll& event_poll;
+        int fd { -1 };
+        // Note: The watch must not keep the description open, so a closed fd just leaves a
+        //       stale watch behind, which is dropped the next time we come across it.
+        LockWeakPtr<OpenFileDescription> description;
+        // Keeps the blocker set we are observing alive. This is let go of as soon as the description
+        // is gone, so a closed fd doesn't keep its file around until we come across the watch again.
+        LockRefPtr<File> file;
+        u32 events { 0 };
+        u64 data { 0 };
+        // Set once a one-shot watch has reported an event, until it is modified again.
+        bool is_disabled { false };
+        IntrusiveListNode<Watch> ready_list_node;
+
+        using List = IntrusiveList<&Watch::ready_list_node>;
+    };
+
+    Watch* find_watch(int fd, OpenFileDescription&);
+
+    mutable Mutex m_lock;
+    HashMap<int, NonnullOwnPtr<Watch>> m_watches;
+
+    // Note: This is taken by the observers, which are called with a blocker set locked.
+    mutable Spinlock m_ready_lock { LockRank::None };
+    Watch::List m_ready_watches;
+};
+
+}
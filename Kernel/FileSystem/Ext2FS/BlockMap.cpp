@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/Ext2FS/BlockMap.h>
+#include <Kernel/FileSystem/Ext2FS/Definitions.h>
+
+namespace Kernel {
+
+static bool extends(Ext2FSBlockMap::Extent const& extent, u64 physical_block)
+{
+    if (extent.is_hole())
+        return physical_block == 0;
+    return physical_block == extent.physical_start.value() + extent.length;
+}
+
+static bool can_merge(Ext2FSBlockMap::Extent const& first, Ext2FSBlockMap::Extent const& second)
+{
+    if (first.logical_end() != second.logical_start)
+        return false;
+    if (first.is_hole() || second.is_hole())
+        return first.is_hole() && second.is_hole();
+    return extends(first, second.physical_start.value());
+}
+
+static u64 block_value(u32 block) { return block; }
+static u64 block_value(Ext2FSBlockMap::BlockIndex block) { return block.value(); }
+
+// Splits a list of block pointers into runs of contiguous blocks, calling back with one extent per run.
+template<typename T, typename Callback>
+static void for_each_run(u64 logical_start, Span<T const> blocks, Callback callback)
+{
+    size_t i = 0;
+    while (i < blocks.size()) {
+        Ext2FSBlockMap::Extent extent { logical_start + i, 1, block_value(blocks[i]) };
+        while (i + extent.length < blocks.size() && extends(extent, block_value(blocks[i + extent.length])))
+            ++extent.length;
+        callback(extent);
+        i += extent.length;
+    }
+}
+
+Ext2FSBlockMap::BlockIndex Ext2FSBlockMap::Extent::physical_block(u64 logical_block) const
+{
+    VERIFY(logical_block >= logical_start && logical_block < logical_end());
+    if (is_hole())
+        return 0;
+    return physical_start.value() + (logical_block - logical_start);
+}
+
+ErrorOr<void> Ext2FSBlockMap::initialize(u64 block_count, u64 entries_per_indirect_block)
+{
+    VERIFY(!m_initialized);
+    VERIFY(entries_per_indirect_block > 0);
+    m_entries_per_indirect_block = entries_per_indirect_block;
+    TRY(m_chunk_loaded.try_resize(chunk_count_for(block_count)));
+    for (auto& loaded : m_chunk_loaded)
+        loaded = false;
+    m_block_count = block_count;
+    m_initialized = true;
+    return {};
+}
+
+size_t Ext2FSBlockMap::chunk_count_for(u64 block_count) const
+{
+    if (block_count == 0)
+        return 0;
+    if (block_count <= EXT2_NDIR_BLOCKS)
+        return 1;
+    return 1 + ceil_div(block_count - EXT2_NDIR_BLOCKS, m_entries_per_indirect_block);
+}
+
+size_t Ext2FSBlockMap::chunk_index_for(u64 logical_block) const
+{
+    if (logical_block < EXT2_NDIR_BLOCKS)
+        return 0;
+    return 1 + (logical_block - EXT2_NDIR_BLOCKS) / m_entries_per_indirect_block;
+}
+
+u64 Ext2FSBlockMap::chunk_start(size_t chunk_index) const
+{
+    if (chunk_index == 0)
+        return 0;
+    return EXT2_NDIR_BLOCKS + (chunk_index - 1) * m_entries_per_indirect_block;
+}
+
+u64 Ext2FSBlockMap::chunk_length(size_t chunk_index) const
+{
+    VERIFY(chunk_index < chunk_count());
+    auto start = chunk_start(chunk_index);
+    auto end = chunk_index == 0 ? EXT2_NDIR_BLOCKS : start + m_entries_per_indirect_block;
+    return min(end, m_block_count) - start;
+}
+
+ErrorOr<void> Ext2FSBlockMap::add_chunk(size_t chunk_index, Span<u32 const> blocks)
+{
+    VERIFY(!is_chunk_loaded(chunk_index));
+    VERIFY(blocks.size() == chunk_length(chunk_index));
+
+    // Make room up front, so that we never end up with half a chunk in the map.
+    size_t run_count = 0;
+    for_each_run(chunk_start(chunk_index), blocks, [&](auto const&) { ++run_count; });
+    TRY(m_extents.try_ensure_capacity(m_extents.size() + run_count));
+
+    for_each_run(chunk_start(chunk_index), blocks, [&](auto const& extent) { insert_extent(extent); });
+    m_chunk_loaded[chunk_index] = true;
+    return {};
+}
+
+size_t Ext2FSBlockMap::extents_starting_at_or_before(u64 logical_block) const
+{
+    size_t low = 0;
+    size_t high = m_extents.size();
+    while (low < high) {
+        auto middle = low + (high - low) / 2;
+        if (m_extents[middle].logical_start <= logical_block)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+size_t Ext2FSBlockMap::extent_index_for(u64 logical_block) const
+{
+    VERIFY(logical_block < m_block_count);
+    VERIFY(is_chunk_loaded(chunk_index_for(logical_block)));
+    auto index = extents_starting_at_or_before(logical_block);
+    VERIFY(index > 0);
+    VERIFY(logical_block < m_extents[index - 1].logical_end());
+    return index - 1;
+}
+
+void Ext2FSBlockMap::insert_extent(Extent extent)
+{
+    auto index = extents_starting_at_or_before(extent.logical_start);
+    if (index > 0 && can_merge(m_extents[index - 1], extent)) {
+        auto& previous = m_extents[index - 1];
+        previous.length += extent.length;
+        if (index < m_extents.size() && can_merge(previous, m_extents[index])) {
+            previous.length += m_extents[index].length;
+            m_extents.remove(index);
+        }
+        return;
+    }
+    if (index < m_extents.size() && can_merge(extent, m_extents[index])) {
+        auto& next = m_extents[index];
+        next.logical_start = extent.logical_start;
+        next.physical_start = extent.physical_start;
+        next.length += extent.length;
+        return;
+    }
+    // NOTE: Callers make sure there is enough capacity for this.
+    MUST(m_extents.try_insert(index, extent));
+}
+
+Ext2FSBlockMap::BlockIndex Ext2FSBlockMap::block_at(u64 logical_block) const
+{
+    return m_extents[extent_index_for(logical_block)].physical_block(logical_block);
+}
+
+ErrorOr<Vector<Ext2FSBlockMap::Extent>> Ext2FSBlockMap::extents_in_range(u64 first_block, u64 count) const
+{
+    Vector<Extent> extents;
+    if (count == 0 || first_block >= m_block_count)
+        return extents;
+    auto end = first_block + min(count, m_block_count - first_block);
+
+    for (auto index = extent_index_for(first_block); index < m_extents.size() && m_extents[index].logical_start < end; ++index) {
+        auto extent = m_extents[index];
+        auto start = max(extent.logical_start, first_block);
+        // Every block in the range has to be mapped, or we'd silently hand out holes.
+        VERIFY(extents.is_empty() || extents.last().logical_end() == start);
+        extent.physical_start = extent.physical_block(start);
+        extent.length = min(extent.logical_end(), end) - start;
+        extent.logical_start = start;
+        TRY(extents.try_append(extent));
+    }
+    VERIFY(!extents.is_empty() && extents.last().logical_end() == end);
+    return extents;
+}
+
+ErrorOr<Vector<Ext2FSBlockMap::BlockIndex>> Ext2FSBlockMap::blocks_in_range(u64 first_block, u64 count) const
+{
+    Vector<BlockIndex> blocks;
+    TRY(blocks.try_ensure_capacity(count));
+    for (auto const& extent : TRY(extents_in_range(first_block, count))) {
+        for (u64 block = extent.logical_start; block < extent.logical_end(); ++block)
+            blocks.unchecked_append(extent.physical_block(block));
+    }
+    return blocks;
+}
+
+ErrorOr<void> Ext2FSBlockMap::append(Span<BlockIndex const> blocks)
+{
+    if (blocks.is_empty())
+        return {};
+    VERIFY(m_block_count == 0 || is_chunk_loaded(chunk_count() - 1));
+
+    size_t run_count = 0;
+    for_each_run(m_block_count, blocks, [&](auto const&) { ++run_count; });
+    TRY(m_extents.try_ensure_capacity(m_extents.size() + run_count));
+
+    auto old_chunk_count = chunk_count();
+    TRY(m_chunk_loaded.try_resize(chunk_count_for(m_block_count + blocks.size())));
+    // The new blocks are all in memory, so the chunks they make up are as good as loaded.
+    for (auto i = old_chunk_count; i < chunk_count(); ++i)
+        m_chunk_loaded[i] = true;
+
+    for_each_run(m_block_count, blocks, [&](auto const& extent) { insert_extent(extent); });
+    m_block_count += blocks.size();
+    return {};
+}
+
+Ext2FSBlockMap::BlockIndex Ext2FSBlockMap::take_last()
+{
+    VERIFY(m_block_count > 0);
+    VERIFY(is_chunk_loaded(chunk_count() - 1));
+
+    auto& last = m_extents.last();
+    VERIFY(last.logical_end() == m_block_count);
+    auto block = last.physical_block(m_block_count - 1);
+    if (--last.length == 0)
+        m_extents.take_last();
+
+    --m_block_count;
+    m_chunk_loaded.shrink(chunk_count_for(m_block_count));
+    return block;
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/Span.h>
+#include <AK/Vector.h>
+#include <Kernel/FileSystem/BlockBasedFileSystem.h>
+
+namespace Kernel {
+
+// Maps the logical blocks of an inode to blocks on disk. Instead of keeping one entry per
+// block, runs of physically contiguous blocks (and runs of holes) are kept as a single
+// extent, so that a mostly contiguous file costs a handful of entries no matter its size.
+//
+// The on-disk block list is split into chunks: one for the direct blocks, and one for
+// every leaf indirect block after that. Chunks are only added once someone needs a block
+// from them, so a large file doesn't have to be mapped in full before it can be read.
+class Ext2FSBlockMap {
+public:
+    using BlockIndex = BlockBasedFileSystem::BlockIndex;
+
+    struct Extent {
+        u64 logical_start { 0 };
+        u64 length { 0 };
+        // A physical start of zero makes this a hole.
+        BlockIndex physical_start { 0 };
+
+        u64 logical_end() const { return logical_start + length; }
+        bool is_hole() const { return physical_start.value() == 0; }
+        BlockIndex physical_block(u64 logical_block) const;
+    };
+
+    bool is_initialized() const { return m_initialized; }
+    ErrorOr<void> initialize(u64 block_count, u64 entries_per_indirect_block);
+
+    u64 block_count() const { return m_block_count; }
+    Vector<Extent> const& extents() const { return m_extents; }
+
+    size_t chunk_count() const { return m_chunk_loaded.size(); }
+    size_t chunk_index_for(u64 logical_block) const;
+    u64 chunk_start(size_t chunk_index) const;
+    u64 chunk_length(size_t chunk_index) const;
+    bool is_chunk_loaded(size_t chunk_index) const { return m_chunk_loaded[chunk_index]; }
+
+    // Adds the block pointers of a chunk that has just been read from disk.
+    ErrorOr<void> add_chunk(size_t chunk_index, Span<u32 const> blocks);
+
+    // These may only look at blocks in chunks that have been added.
+    BlockIndex block_at(u64 logical_block) const;
+    ErrorOr<Vector<Extent>> extents_in_range(u64 first_block, u64 count) const;
+    ErrorOr<Vector<BlockIndex>> blocks_in_range(u64 first_block, u64 count) const;
+
+    // Growing and shrinking happen at the end, and need the last chunk to be added.
+    ErrorOr<void> append(Span<BlockIndex const>);
+    BlockIndex take_last();
+
+private:
+    size_t chunk_count_for(u64 block_count) const;
+    size_t extent_index_for(u64 logical_block) const;
+    size_t extents_starting_at_or_before(u64 logical_block) const;
+    void insert_extent(Extent);
+
+    Vector<Extent> m_extents;
+    Vector<bool> m_chunk_loaded;
+    u64 m_block_count { 0 };
+    u64 m_entries_per_indirect_block { 0 };
+    bool m_initialized { false };
+};
+
+}
@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/Ext2FS/FileSystem.h>
 #include <Kernel/FileSystem/Ext2FS/Inode.h>
@@ -223,6 +224,228 @@ ErrorOr<void> Ext2FS::write_ext2_inode(InodeIndex inode, ext2_inode const& e2ino
     return write_block(block_index, buffer, inode_size(), offset);
 }
 
+// How many blocks past the end of a growing file we hold on to, so that the next append can continue right after it.
+static constexpr size_t block_reservation_size = 64;
+
+Optional<size_t> Ext2FS::FreeBlockRuns::find_run_containing(BlockIndex block) const
+{
+    size_t low = 0;
+    size_t high = runs.size();
+    while (low < high) {
+        auto middle = low + (high - low) / 2;
+        if (runs[middle].start <= block)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low == 0 || block >= runs[low - 1].end())
+        return {};
+    return low - 1;
+}
+
+ErrorOr<void> Ext2FS::FreeBlockRuns::add(BlockRun run)
+{
+    size_t index = 0;
+    size_t end = runs.size();
+    while (index < end) {
+        auto middle = index + (end - index) / 2;
+        if (runs[middle].start < run.start)
+            index = middle + 1;
+        else
+            end = middle;
+    }
+    VERIFY(index == 0 || runs[index - 1].end() <= run.start);
+    VERIFY(index == runs.size() || run.end() <= runs[index].start);
+
+    bool joins_previous = index > 0 && runs[index - 1].end() == run.start;
+    bool joins_next = index < runs.size() && run.end() == runs[index].start;
+    if (joins_previous && joins_next) {
+        runs[index - 1].length += run.length + runs[index].length;
+        runs.remove(index);
+    } else if (joins_previous) {
+        runs[index - 1].length += run.length;
+    } else if (joins_next) {
+        runs[index].start = run.start;
+        runs[index].length += run.length;
+    } else {
+        TRY(runs.try_insert(index, run));
+    }
+    return {};
+}
+
+ErrorOr<void> Ext2FS::FreeBlockRuns::remove(size_t run_index, BlockRun taken)
+{
+    auto run = runs[run_index];
+    VERIFY(taken.start >= run.start && taken.end() <= run.end());
+
+    if (taken.start != run.start && taken.end() != run.end()) {
+        // Taking blocks out of the middle splits the run in two.
+        TRY(runs.try_insert(run_index + 1, { taken.end(), run.end().value() - taken.end().value() }));
+        runs[run_index].length = taken.start.value() - run.start.value();
+        return {};
+    }
+
+    if (taken.start == run.start)
+        runs[run_index].start = taken.end();
+    runs[run_index].length -= taken.length;
+    if (runs[run_index].length == 0)
+        runs.remove(run_index);
+    return {};
+}
+
+ErrorOr<Ext2FS::FreeBlockRuns*> Ext2FS::free_block_runs(GroupIndex group_index)
+{
+    VERIFY(m_lock.is_locked());
+    if (m_free_block_runs.is_empty())
+        TRY(m_free_block_runs.try_resize(m_block_group_count));
+
+    auto& free_runs = m_free_block_runs[group_index.value() - 1];
+    if (free_runs.is_built)
+        return &free_runs;
+
+    auto const& bgd = group_descriptor(group_index);
+    auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+    auto block_bitmap = cached_bitmap->bitmap(blocks_in_group(group_index));
+    auto first_block = first_block_in_group(group_index).value();
+
+    Vector<BlockRun> runs;
+    for (size_t bit = 0; bit < block_bitmap.size();) {
+        if (block_bitmap.get(bit)) {
+            ++bit;
+            continue;
+        }
+        auto start = bit;
+        while (bit < block_bitmap.size() && !block_bitmap.get(bit))
+            ++bit;
+        TRY(runs.try_append({ first_block + start, bit - start }));
+    }
+    free_runs.runs = move(runs);
+
+    // Reserved blocks are still free in the bitmap, but they aren't up for grabs.
+    for (auto& it : m_block_reservations) {
+        if (group_index_from_block_index(it.value.start) != group_index)
+            continue;
+        auto run_index = free_runs.find_run_containing(it.value.start);
+        VERIFY(run_index.has_value());
+        if (auto result = free_runs.remove(run_index.value(), it.value); result.is_error()) {
+            free_runs.runs.clear();
+            return result.release_error();
+        }
+    }
+
+    free_runs.is_built = true;
+    return &free_runs;
+}
+
+void Ext2FS::forget_free_runs(GroupIndex group_index)
+{
+    // We'll rebuild the runs from the bitmap the next time we need them.
+    auto& free_runs = m_free_block_runs[group_index.value() - 1];
+    free_runs.is_built = false;
+    free_runs.runs.clear();
+}
+
+void Ext2FS::add_free_run(BlockRun run)
+{
+    VERIFY(m_lock.is_locked());
+    auto group_index = group_index_from_block_index(run.start);
+    if (m_free_block_runs.is_empty() || !m_free_block_runs[group_index.value() - 1].is_built)
+        return;
+    if (m_free_block_runs[group_index.value() - 1].add(run).is_error())
+        forget_free_runs(group_index);
+}
+
+auto Ext2FS::take_free_run(GroupIndex preferred_group_index, BlockIndex goal, size_t max_length) -> ErrorOr<Optional<BlockRun>>
+{
+    VERIFY(m_lock.is_locked());
+    VERIFY(max_length > 0);
+
+    // Continuing exactly at the goal keeps a growing file in one piece.
+    if (goal.value() >= first_block_index().value() && goal.value() < super_block().s_blocks_count) {
+        auto group_index = group_index_from_block_index(goal);
+        auto* free_runs = TRY(free_block_runs(group_index));
+        if (auto run_index = free_runs->find_run_containing(goal); run_index.has_value()) {
+            BlockRun taken { goal, min(max_length, free_runs->runs[run_index.value()].end().value() - goal.value()) };
+            TRY(free_runs->remove(run_index.value(), taken));
+            return taken;
+        }
+        // Failing that, stay close to it.
+        preferred_group_index = group_index;
+    }
+
+    // Otherwise take the first run that's long enough, or the longest one if none is, trying the preferred group first.
+    for (u64 i = 0; i < m_block_group_count; ++i) {
+        GroupIndex group_index = (preferred_group_index.value() - 1 + i) % m_block_group_count + 1;
+        if (!group_descriptor(group_index).bg_free_blocks_count)
+            continue;
+        auto* free_runs = TRY(free_block_runs(group_index));
+
+        Optional<size_t> best_run_index;
+        for (size_t run_index = 0; run_index < free_runs->runs.size(); ++run_index) {
+            auto length = free_runs->runs[run_index].length;
+            if (!best_run_index.has_value() || length > free_runs->runs[best_run_index.value()].length)
+                best_run_index = run_index;
+            if (length >= max_length)
+                break;
+        }
+        if (!best_run_index.has_value())
+            continue;
+
+        auto const& run = free_runs->runs[best_run_index.value()];
+        BlockRun taken { run.start, min(max_length, run.length) };
+        TRY(free_runs->remove(best_run_index.value(), taken));
+        return taken;
+    }
+    return Optional<BlockRun> {};
+}
+
+ErrorOr<void> Ext2FS::mark_run_allocated(BlockRun run)
+{
+    VERIFY(m_lock.is_locked());
+    auto group_index = group_index_from_block_index(run.start);
+    auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index));
+    auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+    auto block_bitmap = cached_bitmap->bitmap(blocks_per_group());
+    auto first_bit = run.start.value() - first_block_in_group(group_index).value();
+    VERIFY(first_bit + run.length <= blocks_in_group(group_index));
+
+    if (block_bitmap.count_in_range(first_bit, run.length, true) != 0) {
+        dbgln("Ext2FS: Blocks {}-{} in bitmap block {} are unexpectedly in use", run.start, run.end().value() - 1, bgd.bg_block_bitmap);
+        // The free runs of the group don't agree with the bitmap, so they can't be trusted anymore.
+        forget_free_runs(group_index);
+        return EIO;
+    }
+    block_bitmap.set_range(first_bit, run.length, true);
+    cached_bitmap->dirty = true;
+
+    m_super_block.s_free_blocks_count -= run.length;
+    bgd.bg_free_blocks_count -= run.length;
+    m_super_block_dirty = true;
+    m_block_group_descriptors_dirty = true;
+    return {};
+}
+
+bool Ext2FS::discard_all_block_reservations()
+{
+    VERIFY(m_lock.is_locked());
+    if (m_block_reservations.is_empty())
+        return false;
+    for (auto& it : m_block_reservations)
+        add_free_run(it.value);
+    m_block_reservations.clear();
+    return true;
+}
+
+void Ext2FS::discard_block_reservation(InodeIndex inode_index)
+{
+    MutexLocker locker(m_lock);
+    auto reservation = m_block_reservations.get(inode_index);
+    if (!reservation.has_value())
+        return;
+    m_block_reservations.remove(inode_index);
+    add_free_run(reservation.value());
+}
+
 auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) -> ErrorOr<Vector<BlockIndex>>
 {
     dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_blocks(preferred group: {}, count {})", preferred_group_index, count);
@@ -233,49 +456,90 @@ auto Ext2FS::allocate_blocks(GroupIndex preferred_group_index, size_t count) ->
     TRY(blocks.try_ensure_capacity(count));
 
     MutexLocker locker(m_lock);
-    auto group_index = preferred_group_index;
-
-    if (!group_descriptor(preferred_group_index).bg_free_blocks_count) {
-        group_index = 1;
-    }
+    ArmedScopeGuard free_blocks_on_failure([&] {
+        for (auto block_index : blocks)
+            (void)set_block_allocation_state(block_index, false);
+    });
 
+    BlockIndex goal = 0;
     while (blocks.size() < count) {
-        bool found_a_group = false;
-        if (group_descriptor(group_index).bg_free_blocks_count) {
-            found_a_group = true;
-        } else {
-            if (group_index == preferred_group_index)
-                group_index = 1;
-            for (; group_index <= m_block_group_count; group_index = GroupIndex { group_index.value() + 1 }) {
-                if (group_descriptor(group_index).bg_free_blocks_count) {
-                    found_a_group = true;
-                    break;
-                }
-            }
+        auto run = TRY(take_free_run(preferred_group_index, goal, count - blocks.size()));
+        if (!run.has_value()) {
+            // The last free blocks may be held in reserve for some inode.
+            if (discard_all_block_reservations())
+                continue;
+            return ENOSPC;
         }
+        if (auto result = mark_run_allocated(run.value()); result.is_error()) {
+            // Note: If the bitmap said the run is in use, the free runs of its group are gone, and this does nothing.
+            add_free_run(run.value());
+            return result.release_error();
+        }
+        dbgln_if(EXT2_DEBUG, "Ext2FS: allocated {} block(s) at {}", run->length, run->start);
+        for (size_t i = 0; i < run->length; ++i)
+            blocks.unchecked_append(run->start.value() + i);
+        goal = run->end();
+    }
 
-        VERIFY(found_a_group);
-        auto const& bgd = group_descriptor(group_index);
+    free_blocks_on_failure.disarm();
+    return blocks;
+}
 
-        auto* cached_bitmap = TRY(get_bitmap_block(bgd.bg_block_bitmap));
+auto Ext2FS::allocate_data_blocks(InodeIndex inode_index, BlockIndex goal, size_t count) -> ErrorOr<Vector<BlockIndex>>
+{
+    dbgln_if(EXT2_DEBUG, "Ext2FS: allocate_data_blocks(inode: {}, goal: {}, count {})", inode_index, goal, count);
+    if (count == 0)
+        return Vector<BlockIndex> {};
 
-        int blocks_in_group = min(blocks_per_group(), super_block().s_blocks_count);
-        auto block_bitmap = cached_bitmap->bitmap(blocks_in_group);
+    Vector<BlockIndex> blocks;
+    TRY(blocks.try_ensure_capacity(count));
 
-        BlockIndex first_block_in_group = (group_index.value() - 1) * blocks_per_group() + first_block_index().value();
-        size_t free_region_size = 0;
-        auto first_unset_bit_index = block_bitmap.find_longest_range_of_unset_bits(count - blocks.size(), free_region_size);
-        VERIFY(first_unset_bit_index.has_value());
-        dbgln_if(EXT2_DEBUG, "Ext2FS: allocating free region of size: {} [{}]", free_region_size, group_index);
-        for (size_t i = 0; i < free_region_size; ++i) {
-            BlockIndex block_index = (first_unset_bit_index.value() + i) + first_block_in_group.value();
-            TRY(set_block_allocation_state(block_index, true));
-            blocks.unchecked_append(block_index);
-            dbgln_if(EXT2_DEBUG, "  allocated > {}", block_index);
+    MutexLocker locker(m_lock);
+    ArmedScopeGuard free_blocks_on_failure([&] {
+        for (auto block_index : blocks)
+            (void)set_block_allocation_state(block_index, false);
+    });
+
+    // Takes blocks from the front of the run, and keeps whatever is left of it for the inode.
+    auto use_run = [&](BlockRun run) -> ErrorOr<void> {
+        BlockRun taken { run.start, min(count - blocks.size(), run.length) };
+        if (auto result = mark_run_allocated(taken); result.is_error()) {
+            // Note: If the bitmap said the run is in use, the free runs of its group are gone, and this does nothing.
+            add_free_run(run);
+            return result.release_error();
         }
+        for (size_t i = 0; i < taken.length; ++i)
+            blocks.unchecked_append(taken.start.value() + i);
+        if (taken.length < run.length) {
+            BlockRun rest { taken.end(), run.length - taken.length };
+            if (m_block_reservations.try_set(inode_index, rest).is_error())
+                add_free_run(rest);
+        }
+        goal = taken.end();
+        return {};
+    };
+
+    if (auto reservation = m_block_reservations.get(inode_index); reservation.has_value()) {
+        auto run = reservation.value();
+        m_block_reservations.remove(inode_index);
+        // A reservation is only any good if the file still ends right before it.
+        if (goal.value() == 0 || run.start == goal)
+            TRY(use_run(run));
+        else
+            add_free_run(run);
     }
 
-    VERIFY(blocks.size() == count);
+    while (blocks.size() < count) {
+        auto run = TRY(take_free_run(group_index_from_inode(inode_index), goal, count - blocks.size() + block_reservation_size));
+        if (!run.has_value()) {
+            if (discard_all_block_reservations())
+                continue;
+            return ENOSPC;
+        }
+        TRY(use_run(run.value()));
+    }
+
+    free_blocks_on_failure.disarm();
     return blocks;
 }
 
@@ -343,7 +607,17 @@ Ext2FS::GroupIndex Ext2FS::group_index_from_block_index(BlockIndex block_index)
 {
     if (!block_index)
         return 0;
-    return (block_index.value() - 1) / blocks_per_group() + 1;
+    return (block_index.value() - first_block_index().value()) / blocks_per_group() + 1;
+}
+
+Ext2FS::BlockIndex Ext2FS::first_block_in_group(GroupIndex group_index) const
+{
+    return (group_index.value() - 1) * blocks_per_group() + first_block_index().value();
+}
+
+size_t Ext2FS::blocks_in_group(GroupIndex group_index) const
+{
+    return min(blocks_per_group(), super_block().s_blocks_count - first_block_in_group(group_index).value());
 }
 
 auto Ext2FS::group_index_from_inode(InodeIndex inode) const -> GroupIndex
@@ -434,7 +708,20 @@ ErrorOr<void> Ext2FS::set_block_allocation_state(BlockIndex block_index, bool ne
     auto& bgd = const_cast<ext2_group_desc&>(group_descriptor(group_index));
 
     dbgln_if(EXT2_DEBUG, "Ext2FS: Block {} state -> {} (in bitmap block {})", block_index, new_state, bgd.bg_block_bitmap);
-    return update_bitmap_block(bgd.bg_block_bitmap, bit_index, new_state, m_super_block.s_free_blocks_count, bgd.bg_free_blocks_count);
+    TRY(update_bitmap_block(bgd.bg_block_bitmap, bit_index, new_state, m_super_block.s_free_blocks_count, bgd.bg_free_blocks_count));
+
+    if (m_free_block_runs.is_empty() || !m_free_block_runs[group_index.value() - 1].is_built)
+        return {};
+    if (!new_state) {
+        add_free_run({ block_index, 1 });
+        return {};
+    }
+    auto& free_runs = m_free_block_runs[group_index.value() - 1];
+    if (auto run_index = free_runs.find_run_containing(block_index); run_index.has_value()) {
+        if (free_runs.remove(run_index.value(), { block_index, 1 }).is_error())
+            forget_free_runs(group_index);
+    }
+    return {};
 }
 
 ErrorOr<NonnullLockRefPtr<Inode>> Ext2FS::create_directory(Ext2FSInode& parent_inode, StringView name, mode_t mode, UserID uid, GroupID gid)
@@ -591,55 +878,63 @@ void Ext2FS::flush_block_group_descriptor_table()
         dbgln("Ext2FS[{}]::flush_block_group_descriptor_table(): Failed to write blocks: {}", fsid(), result.error());
 }
 
-void Ext2FS::flush_writes()
+void Ext2FS::flush_cached_metadata()
 {
-    {
-        MutexLocker locker(m_lock);
-        if (m_super_block_dirty) {
-            auto result = flush_super_block();
-            if (result.is_error()) {
-                dbgln("Ext2FS[{}]::flush_writes(): Failed to write superblock: {}", fsid(), result.error());
-                // FIXME: We should handle this error.
-                VERIFY_NOT_REACHED();
-            }
-            m_super_block_dirty = false;
-        }
-        if (m_block_group_descriptors_dirty) {
-            flush_block_group_descriptor_table();
-            m_block_group_descriptors_dirty = false;
+    MutexLocker locker(m_lock);
+    if (m_super_block_dirty) {
+        auto result = flush_super_block();
+        if (result.is_error()) {
+            dbgln("Ext2FS[{}]::flush_cached_metadata(): Failed to write superblock: {}", fsid(), result.error());
+            // FIXME: We should handle this error.
+            VERIFY_NOT_REACHED();
         }
-        for (auto& cached_bitmap : m_cached_bitmaps) {
-            if (cached_bitmap->dirty) {
-                auto buffer = UserOrKernelBuffer::for_kernel_buffer(cached_bitmap->buffer->data());
-                if (auto result = write_block(cached_bitmap->bitmap_block_index, buffer, block_size()); result.is_error()) {
-                    dbgln("Ext2FS[{}]::flush_writes(): Failed to write blocks: {}", fsid(), result.error());
-                }
-                cached_bitmap->dirty = false;
-                dbgln_if(EXT2_DEBUG, "Ext2FS[{}]::flush_writes(): Flushed bitmap block {}", fsid(), cached_bitmap->bitmap_block_index);
+        m_super_block_dirty = false;
+    }
+    if (m_block_group_descriptors_dirty) {
+        flush_block_group_descriptor_table();
+        m_block_group_descriptors_dirty = false;
+    }
+    for (auto& cached_bitmap : m_cached_bitmaps) {
+        if (cached_bitmap->dirty) {
+            auto buffer = UserOrKernelBuffer::for_kernel_buffer(cached_bitmap->buffer->data());
+            if (auto result = write_block(cached_bitmap->bitmap_block_index, buffer, block_size()); result.is_error()) {
+                dbgln("Ext2FS[{}]::flush_cached_metadata(): Failed to write blocks: {}", fsid(), result.error());
             }
+            cached_bitmap->dirty = false;
+            dbgln_if(EXT2_DEBUG, "Ext2FS[{}]::flush_cached_metadata(): Flushed bitmap block {}", fsid(), cached_bitmap->bitmap_block_index);
         }
+    }
 
-        // Uncache Inodes that are only kept alive by the index-to-inode lookup cache.
-        // We don't uncache Inodes that are being watched by at least one InodeWatcher.
+    // Uncache Inodes that are only kept alive by the index-to-inode lookup cache.
+    // We don't uncache Inodes that are being watched by at least one InodeWatcher.
 
-        // FIXME: It would be better to keep a capped number of Inodes around.
-        //        The problem is that they are quite heavy objects, and use a lot of heap memory
-        //        for their (child name lookup) and (block list) caches.
+    // FIXME: It would be better to keep a capped number of Inodes around.
+    //        The problem is that they are quite heavy objects, and use a lot of heap memory
+    //        for their (child name lookup) and (block list) caches.
 
-        m_inode_cache.remove_all_matching([](InodeIndex, LockRefPtr<Ext2FSInode> const& cached_inode) {
-            // NOTE: If we're asked to look up an inode by number (via get_inode) and it turns out
-            //       to not exist, we remember the fact that it doesn't exist by caching a nullptr.
-            //       This seems like a reasonable time to uncache ideas about unknown inodes, so do that.
-            if (cached_inode == nullptr)
-                return true;
+    m_inode_cache.remove_all_matching([](InodeIndex, LockRefPtr<Ext2FSInode> const& cached_inode) {
+        // NOTE: If we're asked to look up an inode by number (via get_inode) and it turns out
+        //       to not exist, we remember the fact that it doesn't exist by caching a nullptr.
+        //       This seems like a reasonable time to uncache ideas about unknown inodes, so do that.
+        if (cached_inode == nullptr)
+            return true;
 
-            return cached_inode->ref_count() == 1 && !cached_inode->has_watchers();
-        });
-    }
+        return cached_inode->ref_count() == 1 && !cached_inode->has_watchers();
+    });
+}
 
+void Ext2FS::flush_writes()
+{
+    flush_cached_metadata();
     BlockBasedFileSystem::flush_writes();
 }
 
+size_t Ext2FS::write_back()
+{
+    flush_cached_metadata();
+    return BlockBasedFileSystem::write_back();
+}
+
 ErrorOr<NonnullLockRefPtr<Ext2FSInode>> Ext2FS::build_root_inode() const
 {
     MutexLocker locker(m_lock);
@@ -37,6 +37,7 @@ public:
     virtual unsigned free_inode_count() const override;
 
     virtual bool supports_watchers() const override { return true; }
+    virtual bool supports_directory_entry_cache() const override { return true; }
 
     virtual u8 internal_file_type_to_directory_entry_type(DirectoryEntryView const& entry) const override;
 
@@ -75,17 +76,27 @@ private:
     ErrorOr<NonnullLockRefPtr<Inode>> create_inode(Ext2FSInode& parent_inode, StringView name, mode_t, dev_t, UserID, GroupID);
     ErrorOr<NonnullLockRefPtr<Inode>> create_directory(Ext2FSInode& parent_inode, StringView name, mode_t, UserID, GroupID);
     virtual void flush_writes() override;
+    virtual size_t write_back() override;
 
     BlockIndex first_block_index() const;
     ErrorOr<InodeIndex> allocate_inode(GroupIndex preferred_group = 0);
     ErrorOr<Vector<BlockIndex>> allocate_blocks(GroupIndex preferred_group_index, size_t count);
+    // Allocates data blocks for an inode, starting at `goal` if possible. Whatever is left of the run the
+    // blocks came from stays reserved for the inode, so the next allocation can continue right after them.
+    ErrorOr<Vector<BlockIndex>> allocate_data_blocks(InodeIndex, BlockIndex goal, size_t count);
+    void discard_block_reservation(InodeIndex);
     GroupIndex group_index_from_inode(InodeIndex) const;
     GroupIndex group_index_from_block_index(BlockIndex) const;
+    BlockIndex first_block_in_group(GroupIndex) const;
+    size_t blocks_in_group(GroupIndex) const;
 
     ErrorOr<bool> get_inode_allocation_state(InodeIndex) const;
     ErrorOr<void> set_inode_allocation_state(InodeIndex, bool);
     ErrorOr<void> set_block_allocation_state(BlockIndex, bool);
 
+    // Writes the superblock, group descriptors and bitmaps into the block cache.
+    void flush_cached_metadata();
+
     void uncache_inode(InodeIndex);
     ErrorOr<void> free_inode(Ext2FSInode&);
 
@@ -125,6 +136,35 @@ private:
     ErrorOr<void> update_bitmap_block(BlockIndex bitmap_block, size_t bit_index, bool new_state, u32& super_block_counter, u16& group_descriptor_counter);
 
     Vector<OwnPtr<CachedBitmap>> m_cached_bitmaps;
+
+    struct BlockRun {
+        BlockIndex start { 0 };
+        size_t length { 0 };
+
+        BlockIndex end() const { return start.value() + length; }
+    };
+
+    // The free blocks of a group as sorted runs. This is built from the block bitmap the first time
+    // we allocate from the group, and kept up to date from then on, so that allocating doesn't have
+    // to rescan bitmaps. Blocks that are reserved for an inode are left out.
+    struct FreeBlockRuns {
+        bool is_built { false };
+        Vector<BlockRun> runs;
+
+        Optional<size_t> find_run_containing(BlockIndex) const;
+        ErrorOr<void> add(BlockRun);
+        ErrorOr<void> remove(size_t run_index, BlockRun);
+    };
+
+    ErrorOr<FreeBlockRuns*> free_block_runs(GroupIndex);
+    ErrorOr<Optional<BlockRun>> take_free_run(GroupIndex preferred_group_index, BlockIndex goal, size_t max_length);
+    void add_free_run(BlockRun);
+    void forget_free_runs(GroupIndex);
+    ErrorOr<void> mark_run_allocated(BlockRun);
+    bool discard_all_block_reservations();
+
+    Vector<FreeBlockRuns> m_free_block_runs;
+    HashMap<InodeIndex, BlockRun> m_block_reservations;
     LockRefPtr<Ext2FSInode> m_root_inode;
 };
 
@@ -35,10 +35,13 @@ static u8 to_ext2_file_type(mode_t mode)
     return EXT2_FT_UNKNOWN;
 }
 
-ErrorOr<void> Ext2FSInode::write_indirect_block(BlockBasedFileSystem::BlockIndex block, Span<BlockBasedFileSystem::BlockIndex> blocks_indices)
+ErrorOr<void> Ext2FSInode::write_indirect_block(BlockBasedFileSystem::BlockIndex block, u64 first_logical_block, size_t count)
 {
     auto const entries_per_block = EXT2_ADDR_PER_BLOCK(&fs().super_block());
-    VERIFY(blocks_indices.size() <= entries_per_block);
+    VERIFY(count <= entries_per_block);
+
+    auto blocks_indices = TRY(m_block_map.blocks_in_range(first_logical_block, count));
+    VERIFY(blocks_indices.size() == count);
 
     auto block_contents = TRY(ByteBuffer::create_uninitialized(fs().block_size()));
     OutputMemoryStream stream { block_contents };
@@ -52,15 +55,15 @@ ErrorOr<void> Ext2FSInode::write_indirect_block(BlockBasedFileSystem::BlockIndex
     return fs().write_block(block, buffer, stream.size());
 }
 
-ErrorOr<void> Ext2FSInode::grow_doubly_indirect_block(BlockBasedFileSystem::BlockIndex block, size_t old_blocks_length, Span<BlockBasedFileSystem::BlockIndex> blocks_indices, Vector<Ext2FS::BlockIndex>& new_meta_blocks, unsigned& meta_blocks)
+ErrorOr<void> Ext2FSInode::grow_doubly_indirect_block(BlockBasedFileSystem::BlockIndex block, size_t old_blocks_length, u64 first_logical_block, size_t blocks_length, Vector<Ext2FS::BlockIndex>& new_meta_blocks, unsigned& meta_blocks)
 {
     auto const entries_per_block = EXT2_ADDR_PER_BLOCK(&fs().super_block());
     auto const entries_per_doubly_indirect_block = entries_per_block * entries_per_block;
     auto const old_indirect_blocks_length = ceil_div(old_blocks_length, entries_per_block);
-    auto const new_indirect_blocks_length = ceil_div(blocks_indices.size(), entries_per_block);
-    VERIFY(blocks_indices.size() > 0);
-    VERIFY(blocks_indices.size() > old_blocks_length);
-    VERIFY(blocks_indices.size() <= entries_per_doubly_indirect_block);
+    auto const new_indirect_blocks_length = ceil_div(blocks_length, entries_per_block);
+    VERIFY(blocks_length > 0);
+    VERIFY(blocks_length > old_blocks_length);
+    VERIFY(blocks_length <= entries_per_doubly_indirect_block);
 
     auto block_contents = TRY(ByteBuffer::create_uninitialized(fs().block_size()));
     auto* block_as_pointers = (unsigned*)block_contents.data();
@@ -85,7 +88,7 @@ ErrorOr<void> Ext2FSInode::grow_doubly_indirect_block(BlockBasedFileSystem::Bloc
     // Write out the indirect blocks.
     for (unsigned i = old_blocks_length / entries_per_block; i < new_indirect_blocks_length; i++) {
         auto const offset_block = i * entries_per_block;
-        TRY(write_indirect_block(block_as_pointers[i], blocks_indices.slice(offset_block, min(blocks_indices.size() - offset_block, entries_per_block))));
+        TRY(write_indirect_block(block_as_pointers[i], first_logical_block + offset_block, min(blocks_length - offset_block, entries_per_block)));
     }
 
     // Write out the doubly indirect block.
@@ -124,16 +127,16 @@ ErrorOr<void> Ext2FSInode::shrink_doubly_indirect_block(BlockBasedFileSystem::Bl
     return {};
 }
 
-ErrorOr<void> Ext2FSInode::grow_triply_indirect_block(BlockBasedFileSystem::BlockIndex block, size_t old_blocks_length, Span<BlockBasedFileSystem::BlockIndex> blocks_indices, Vector<Ext2FS::BlockIndex>& new_meta_blocks, unsigned& meta_blocks)
+ErrorOr<void> Ext2FSInode::grow_triply_indirect_block(BlockBasedFileSystem::BlockIndex block, size_t old_blocks_length, u64 first_logical_block, size_t blocks_length, Vector<Ext2FS::BlockIndex>& new_meta_blocks, unsigned& meta_blocks)
 {
     auto const entries_per_block = EXT2_ADDR_PER_BLOCK(&fs().super_block());
     auto const entries_per_doubly_indirect_block = entries_per_block * entries_per_block;
     auto const entries_per_triply_indirect_block = entries_per_block * entries_per_block;
     auto const old_doubly_indirect_blocks_length = ceil_div(old_blocks_length, entries_per_doubly_indirect_block);
-    auto const new_doubly_indirect_blocks_length = ceil_div(blocks_indices.size(), entries_per_doubly_indirect_block);
-    VERIFY(blocks_indices.size() > 0);
-    VERIFY(blocks_indices.size() > old_blocks_length);
-    VERIFY(blocks_indices.size() <= entries_per_triply_indirect_block);
+    auto const new_doubly_indirect_blocks_length = ceil_div(blocks_length, entries_per_doubly_indirect_block);
+    VERIFY(blocks_length > 0);
+    VERIFY(blocks_length > old_blocks_length);
+    VERIFY(blocks_length <= entries_per_triply_indirect_block);
 
     auto block_contents = TRY(ByteBuffer::create_uninitialized(fs().block_size()));
     auto* block_as_pointers = (unsigned*)block_contents.data();
@@ -159,8 +162,8 @@ ErrorOr<void> Ext2FSInode::grow_triply_indirect_block(BlockBasedFileSystem::Bloc
     for (unsigned i = old_blocks_length / entries_per_doubly_indirect_block; i < new_doubly_indirect_blocks_length; i++) {
         auto const processed_blocks = i * entries_per_doubly_indirect_block;
         auto const old_doubly_indirect_blocks_length = min(old_blocks_length > processed_blocks ? old_blocks_length - processed_blocks : 0, entries_per_doubly_indirect_block);
-        auto const new_doubly_indirect_blocks_length = min(blocks_indices.size() > processed_blocks ? blocks_indices.size() - processed_blocks : 0, entries_per_doubly_indirect_block);
-        TRY(grow_doubly_indirect_block(block_as_pointers[i], old_doubly_indirect_blocks_length, blocks_indices.slice(processed_blocks, new_doubly_indirect_blocks_length), new_meta_blocks, meta_blocks));
+        auto const new_doubly_indirect_blocks_length = min(blocks_length > processed_blocks ? blocks_length - processed_blocks : 0, entries_per_doubly_indirect_block);
+        TRY(grow_doubly_indirect_block(block_as_pointers[i], old_doubly_indirect_blocks_length, first_logical_block + processed_blocks, new_doubly_indirect_blocks_length, new_meta_blocks, meta_blocks));
     }
 
     // Write out the triply indirect block.
@@ -205,8 +208,9 @@ ErrorOr<void> Ext2FSInode::shrink_triply_indirect_block(BlockBasedFileSystem::Bl
 ErrorOr<void> Ext2FSInode::flush_block_list()
 {
     MutexLocker locker(m_inode_lock);
+    VERIFY(m_block_map.is_initialized());
 
-    if (m_block_list.is_empty()) {
+    if (m_block_map.block_count() == 0) {
         m_raw_inode.i_blocks = 0;
         memset(m_raw_inode.i_block, 0, sizeof(m_raw_inode.i_block));
         set_metadata_dirty(true);
@@ -217,26 +221,27 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
     auto const old_block_count = ceil_div(size(), static_cast<u64>(fs().block_size()));
 
     auto old_shape = fs().compute_block_list_shape(old_block_count);
-    auto const new_shape = fs().compute_block_list_shape(m_block_list.size());
+    auto const new_shape = fs().compute_block_list_shape(m_block_map.block_count());
 
     Vector<Ext2FS::BlockIndex> new_meta_blocks;
     if (new_shape.meta_blocks > old_shape.meta_blocks) {
         new_meta_blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), new_shape.meta_blocks - old_shape.meta_blocks));
     }
 
-    m_raw_inode.i_blocks = (m_block_list.size() + new_shape.meta_blocks) * (fs().block_size() / 512);
+    m_raw_inode.i_blocks = (m_block_map.block_count() + new_shape.meta_blocks) * (fs().block_size() / 512);
     dbgln_if(EXT2_BLOCKLIST_DEBUG, "Ext2FSInode[{}]::flush_block_list(): Old shape=({};{};{};{}:{}), new shape=({};{};{};{}:{})", identifier(), old_shape.direct_blocks, old_shape.indirect_blocks, old_shape.doubly_indirect_blocks, old_shape.triply_indirect_blocks, old_shape.meta_blocks, new_shape.direct_blocks, new_shape.indirect_blocks, new_shape.doubly_indirect_blocks, new_shape.triply_indirect_blocks, new_shape.meta_blocks);
 
     unsigned output_block_index = 0;
-    unsigned remaining_blocks = m_block_list.size();
+    unsigned remaining_blocks = m_block_map.block_count();
 
     // Deal with direct blocks.
     bool inode_dirty = false;
     VERIFY(new_shape.direct_blocks <= EXT2_NDIR_BLOCKS);
     for (unsigned i = 0; i < new_shape.direct_blocks; ++i) {
-        if (BlockBasedFileSystem::BlockIndex(m_raw_inode.i_block[i]) != m_block_list[output_block_index])
+        auto block_index = m_block_map.block_at(output_block_index);
+        if (BlockBasedFileSystem::BlockIndex(m_raw_inode.i_block[i]) != block_index)
             inode_dirty = true;
-        m_raw_inode.i_block[i] = m_block_list[output_block_index].value();
+        m_raw_inode.i_block[i] = block_index.value();
         ++output_block_index;
         --remaining_blocks;
     }
@@ -251,9 +256,9 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
     }
     if (inode_dirty) {
         if constexpr (EXT2_DEBUG) {
-            dbgln("Ext2FSInode[{}]::flush_block_list(): Writing {} direct block(s) to i_block array of inode {}", identifier(), min((size_t)EXT2_NDIR_BLOCKS, m_block_list.size()), index());
-            for (size_t i = 0; i < min((size_t)EXT2_NDIR_BLOCKS, m_block_list.size()); ++i)
-                dbgln("   + {}", m_block_list[i]);
+            dbgln("Ext2FSInode[{}]::flush_block_list(): Writing {} direct block(s) to i_block array of inode {}", identifier(), new_shape.direct_blocks, index());
+            for (size_t i = 0; i < new_shape.direct_blocks; ++i)
+                dbgln("   + {}", m_raw_inode.i_block[i]);
         }
         set_metadata_dirty(true);
     }
@@ -270,7 +275,7 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
                 old_shape.meta_blocks++;
             }
 
-            TRY(write_indirect_block(m_raw_inode.i_block[EXT2_IND_BLOCK], m_block_list.span().slice(output_block_index, new_shape.indirect_blocks)));
+            TRY(write_indirect_block(m_raw_inode.i_block[EXT2_IND_BLOCK], output_block_index, new_shape.indirect_blocks));
         } else if ((new_shape.indirect_blocks == 0) && (old_shape.indirect_blocks != 0)) {
             dbgln_if(EXT2_BLOCKLIST_DEBUG, "Ext2FSInode[{}]::flush_block_list(): Freeing indirect block: {}", identifier(), m_raw_inode.i_block[EXT2_IND_BLOCK]);
             TRY(fs().set_block_allocation_state(m_raw_inode.i_block[EXT2_IND_BLOCK], false));
@@ -292,7 +297,7 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
                 set_metadata_dirty(true);
                 old_shape.meta_blocks++;
             }
-            TRY(grow_doubly_indirect_block(m_raw_inode.i_block[EXT2_DIND_BLOCK], old_shape.doubly_indirect_blocks, m_block_list.span().slice(output_block_index, new_shape.doubly_indirect_blocks), new_meta_blocks, old_shape.meta_blocks));
+            TRY(grow_doubly_indirect_block(m_raw_inode.i_block[EXT2_DIND_BLOCK], old_shape.doubly_indirect_blocks, output_block_index, new_shape.doubly_indirect_blocks, new_meta_blocks, old_shape.meta_blocks));
         } else {
             TRY(shrink_doubly_indirect_block(m_raw_inode.i_block[EXT2_DIND_BLOCK], old_shape.doubly_indirect_blocks, new_shape.doubly_indirect_blocks, old_shape.meta_blocks));
             if (new_shape.doubly_indirect_blocks == 0)
@@ -313,7 +318,7 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
                 set_metadata_dirty(true);
                 old_shape.meta_blocks++;
             }
-            TRY(grow_triply_indirect_block(m_raw_inode.i_block[EXT2_TIND_BLOCK], old_shape.triply_indirect_blocks, m_block_list.span().slice(output_block_index, new_shape.triply_indirect_blocks), new_meta_blocks, old_shape.meta_blocks));
+            TRY(grow_triply_indirect_block(m_raw_inode.i_block[EXT2_TIND_BLOCK], old_shape.triply_indirect_blocks, output_block_index, new_shape.triply_indirect_blocks, new_meta_blocks, old_shape.meta_blocks));
         } else {
             TRY(shrink_triply_indirect_block(m_raw_inode.i_block[EXT2_TIND_BLOCK], old_shape.triply_indirect_blocks, new_shape.triply_indirect_blocks, old_shape.meta_blocks));
             if (new_shape.triply_indirect_blocks == 0)
@@ -334,11 +339,6 @@ ErrorOr<void> Ext2FSInode::flush_block_list()
     VERIFY_NOT_REACHED();
 }
 
-ErrorOr<Vector<Ext2FS::BlockIndex>> Ext2FSInode::compute_block_list() const
-{
-    return compute_block_list_impl(false);
-}
-
 ErrorOr<Vector<Ext2FS::BlockIndex>> Ext2FSInode::compute_block_list_with_meta_blocks() const
 {
     return compute_block_list_impl(true);
@@ -454,6 +454,7 @@ Ext2FSInode::Ext2FSInode(Ext2FS& fs, InodeIndex index)
 
 Ext2FSInode::~Ext2FSInode()
 {
+    fs().discard_block_reservation(index());
     if (m_raw_inode.i_links_count == 0) {
         // Alas, we have nowhere to propagate any errors that occur here.
         (void)fs().free_inode(*this);
@@ -510,17 +511,92 @@ ErrorOr<void> Ext2FSInode::flush_metadata()
     return {};
 }
 
-ErrorOr<void> Ext2FSInode::compute_block_list_with_exclusive_locking()
+u64 Ext2FSInode::data_block_count() const
+{
+    // Short symbolic links live inside the i_block array, and have no blocks of their own.
+    if (Kernel::is_symlink(m_raw_inode.i_mode) && m_raw_inode.i_blocks == 0)
+        return 0;
+    return ceil_div(size(), static_cast<u64>(fs().block_size()));
+}
+
+ErrorOr<u32> Ext2FSInode::read_block_pointer(u32 block, u64 index) const
+{
+    if (block == 0)
+        return 0;
+    u32 pointer = 0;
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(reinterpret_cast<u8*>(&pointer));
+    TRY(fs().read_block(block, &buffer, sizeof(pointer), index * sizeof(pointer)));
+    return pointer;
+}
+
+ErrorOr<Vector<u32>> Ext2FSInode::read_block_map_chunk(size_t chunk_index) const
+{
+    auto const entries_per_block = EXT2_ADDR_PER_BLOCK(&fs().super_block());
+
+    Vector<u32> blocks;
+    TRY(blocks.try_resize(m_block_map.chunk_length(chunk_index)));
+
+    if (chunk_index == 0) {
+        for (size_t i = 0; i < blocks.size(); ++i)
+            blocks[i] = m_raw_inode.i_block[i];
+        return blocks;
+    }
+
+    // Every other chunk is the contents of one leaf indirect block, which we find by walking down from the inode.
+    u64 leaf_index = chunk_index - 1;
+    u32 leaf_block = 0;
+    if (leaf_index == 0) {
+        leaf_block = m_raw_inode.i_block[EXT2_IND_BLOCK];
+    } else if (leaf_index - 1 < entries_per_block) {
+        leaf_block = TRY(read_block_pointer(m_raw_inode.i_block[EXT2_DIND_BLOCK], leaf_index - 1));
+    } else {
+        auto index = leaf_index - 1 - entries_per_block;
+        if (index >= static_cast<u64>(entries_per_block) * entries_per_block)
+            return EIO;
+        auto doubly_indirect_block = TRY(read_block_pointer(m_raw_inode.i_block[EXT2_TIND_BLOCK], index / entries_per_block));
+        leaf_block = TRY(read_block_pointer(doubly_indirect_block, index % entries_per_block));
+    }
+
+    // Without an indirect block, the whole chunk is a hole.
+    if (leaf_block == 0)
+        return blocks;
+
+    auto buffer = UserOrKernelBuffer::for_kernel_buffer(reinterpret_cast<u8*>(blocks.data()));
+    TRY(fs().read_block(leaf_block, &buffer, blocks.size() * sizeof(u32), 0));
+    return blocks;
+}
+
+ErrorOr<void> Ext2FSInode::load_block_map(u64 first_block, u64 count)
+{
+    if (!m_block_map.is_initialized())
+        TRY(m_block_map.initialize(data_block_count(), EXT2_ADDR_PER_BLOCK(&fs().super_block())));
+
+    if (first_block >= m_block_map.block_count())
+        return {};
+    count = min(count, m_block_map.block_count() - first_block);
+    if (count == 0)
+        return {};
+
+    auto last_chunk = m_block_map.chunk_index_for(first_block + count - 1);
+    for (auto chunk = m_block_map.chunk_index_for(first_block); chunk <= last_chunk; ++chunk) {
+        if (m_block_map.is_chunk_loaded(chunk))
+            continue;
+        auto blocks = TRY(read_block_map_chunk(chunk));
+        TRY(m_block_map.add_chunk(chunk, blocks.span()));
+    }
+    return {};
+}
+
+ErrorOr<Vector<Ext2FSBlockMap::Extent>> Ext2FSInode::block_map_extents_with_exclusive_locking(u64 first_block, u64 count)
 {
     // Note: We verify that the inode mutex is being held locked. Because only the read_bytes_locked()
     // method uses this method and the mutex can be locked in shared mode when reading the Inode if
     // it is an ext2 regular file, but also in exclusive mode, when the Inode is an ext2 directory and being
-    // traversed, we use another exclusive lock to ensure we always mutate the block list safely.
+    // traversed, we use another exclusive lock to ensure we always mutate the block map safely.
     VERIFY(m_inode_lock.is_locked());
     MutexLocker block_list_locker(m_block_list_lock);
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
-    return {};
+    TRY(load_block_map(first_block, count));
+    return m_block_map.extents_in_range(first_block, count);
 }
 
 ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserOrKernelBuffer& buffer, OpenFileDescription* description) const
@@ -542,55 +618,96 @@ ErrorOr<size_t> Ext2FSInode::read_bytes_locked(off_t offset, size_t count, UserO
         return nread;
     }
 
+    bool allow_cache = !description || !description->is_direct();
+
+    u64 const block_size = fs().block_size();
+
+    u64 position = offset;
+    u64 remaining_count = min(static_cast<u64>(count), size() - position);
+    u64 first_block_logical_index = position / block_size;
+    u64 end_block_logical_index = ceil_div(position + remaining_count, block_size);
+
     // Note: We bypass the const declaration of this method, but this is a strong
     // requirement to be able to accomplish the read operation successfully.
     // We call this special method because it locks a separate mutex to ensure we
-    // update the block list of the inode safely, as the m_inode_lock is locked in
+    // update the block map of the inode safely, as the m_inode_lock is locked in
     // shared mode.
-    TRY(const_cast<Ext2FSInode&>(*this).compute_block_list_with_exclusive_locking());
+    auto extents = TRY(const_cast<Ext2FSInode&>(*this).block_map_extents_with_exclusive_locking(first_block_logical_index, end_block_logical_index - first_block_logical_index));
 
-    if (m_block_list.is_empty()) {
+    if (extents.is_empty()) {
         dmesgln("Ext2FSInode[{}]::read_bytes(): Empty block list", identifier());
         return EIO;
     }
 
-    bool allow_cache = !description || !description->is_direct();
-
-    int const block_size = fs().block_size();
-
-    BlockBasedFileSystem::BlockIndex first_block_logical_index = offset / block_size;
-    BlockBasedFileSystem::BlockIndex last_block_logical_index = (offset + count) / block_size;
-    if (last_block_logical_index >= m_block_list.size())
-        last_block_logical_index = m_block_list.size() - 1;
-
-    int offset_into_first_block = offset % block_size;
-
     size_t nread = 0;
-    auto remaining_count = min((off_t)count, (off_t)size() - offset);
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::read_bytes(): Reading up to {} bytes, {} bytes into inode to {}", identifier(), count, offset, buffer.user_or_kernel_ptr());
 
-    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
-        auto block_index = m_block_list[bi.value()];
-        size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
-        size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
-        auto buffer_offset = buffer.offset(nread);
-        if (block_index.value() == 0) {
-            // This is a hole, act as if it's filled with zeroes.
-            TRY(buffer_offset.memset(0, num_bytes_to_copy));
-        } else {
-            if (auto result = fs().read_block(block_index, &buffer_offset, num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
-                dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read block {} (index {})", identifier(), block_index.value(), bi);
-                return result.release_error();
+    for (auto const& extent : extents) {
+        u64 extent_end = extent.logical_end() * block_size;
+        while (remaining_count && position < extent_end) {
+            u64 logical_block = position / block_size;
+            size_t offset_into_block = position % block_size;
+            size_t num_bytes_to_copy = 0;
+            auto buffer_offset = buffer.offset(nread);
+            if (extent.is_hole()) {
+                // This is a hole, act as if it's filled with zeroes.
+                num_bytes_to_copy = min(extent_end - position, remaining_count);
+                TRY(buffer_offset.memset(0, num_bytes_to_copy));
+            } else if (offset_into_block == 0 && remaining_count >= block_size) {
+                // The blocks of an extent are contiguous on disk, so read as many whole ones as we can in one go.
+                auto block_count = min(extent.logical_end() - logical_block, remaining_count / block_size);
+                auto block_index = extent.physical_block(logical_block);
+                num_bytes_to_copy = block_count * block_size;
+                if (auto result = fs().read_blocks(block_index, block_count, buffer_offset, allow_cache); result.is_error()) {
+                    dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read {} blocks at {} (index {})", identifier(), block_count, block_index.value(), logical_block);
+                    return result.release_error();
+                }
+            } else {
+                auto block_index = extent.physical_block(logical_block);
+                num_bytes_to_copy = min(block_size - offset_into_block, remaining_count);
+                if (auto result = fs().read_block(block_index, &buffer_offset, num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
+                    dmesgln("Ext2FSInode[{}]::read_bytes(): Failed to read block {} (index {})", identifier(), block_index.value(), logical_block);
+                    return result.release_error();
+                }
             }
+            position += num_bytes_to_copy;
+            remaining_count -= num_bytes_to_copy;
+            nread += num_bytes_to_copy;
         }
-        remaining_count -= num_bytes_to_copy;
-        nread += num_bytes_to_copy;
     }
 
     return nread;
 }
 
+void Ext2FSInode::prefetch_locked(u64 offset, u64 length)
+{
+    VERIFY(m_inode_lock.is_locked());
+    if (!Kernel::is_regular_file(m_raw_inode.i_mode) || offset >= size())
+        return;
+
+    u64 const block_size = fs().block_size();
+    auto end = offset + min(length, size() - offset);
+    u64 first_block_logical_index = offset / block_size;
+    u64 end_block_logical_index = ceil_div(end, block_size);
+
+    auto extents_or_error = block_map_extents_with_exclusive_locking(first_block_logical_index, end_block_logical_index - first_block_logical_index);
+    if (extents_or_error.is_error())
+        return;
+
+    Vector<BlockBasedFileSystem::BlockIndex> blocks;
+    for (auto const& extent : extents_or_error.value()) {
+        // Holes read back as zeroes, there is nothing to fetch for them.
+        if (extent.is_hole())
+            continue;
+        if (blocks.try_ensure_capacity(blocks.size() + extent.length).is_error())
+            break;
+        for (auto block = extent.logical_start; block < extent.logical_end(); ++block)
+            blocks.unchecked_append(extent.physical_block(block));
+    }
+    fs().prefetch_blocks(move(blocks));
+}
+
 ErrorOr<void> Ext2FSInode::resize(u64 new_size)
 {
     auto old_size = size();
@@ -615,21 +732,36 @@ ErrorOr<void> Ext2FSInode::resize(u64 new_size)
             return ENOSPC;
     }
 
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+    // Growing or shrinking only touches the direct blocks and the tail of the block map,
+    // so there is no need to bring in the rest of it.
+    TRY(load_block_map(0, EXT2_NDIR_BLOCKS));
+    auto current_block_count = m_block_map.block_count();
+    if (current_block_count > 0) {
+        auto first_changed_block = min(blocks_needed_after, current_block_count - 1);
+        TRY(load_block_map(first_changed_block, current_block_count - first_changed_block));
+    }
 
-    if (blocks_needed_after > blocks_needed_before) {
-        auto blocks = TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - blocks_needed_before));
-        TRY(m_block_list.try_extend(move(blocks)));
-    } else if (blocks_needed_after < blocks_needed_before) {
+    if (blocks_needed_after > current_block_count) {
+        // Try to carry on right after the last block of the file.
+        BlockBasedFileSystem::BlockIndex goal = 0;
+        if (current_block_count > 0) {
+            if (auto last_block = m_block_map.block_at(current_block_count - 1); last_block.value() != 0)
+                goal = last_block.value() + 1;
+        }
+        auto blocks = Kernel::is_regular_file(m_raw_inode.i_mode)
+            ? TRY(fs().allocate_data_blocks(index(), goal, blocks_needed_after - current_block_count))
+            : TRY(fs().allocate_blocks(fs().group_index_from_inode(index()), blocks_needed_after - current_block_count));
+        TRY(m_block_map.append(blocks.span()));
+    } else if (blocks_needed_after < current_block_count) {
+        fs().discard_block_reservation(index());
         if constexpr (EXT2_VERY_DEBUG) {
-            dbgln("Ext2FSInode[{}]::resize(): Shrinking inode, old block list is {} entries:", identifier(), m_block_list.size());
-            for (auto block_index : m_block_list) {
-                dbgln("    # {}", block_index);
+            dbgln("Ext2FSInode[{}]::resize(): Shrinking inode, old block map has {} extents:", identifier(), m_block_map.extents().size());
+            for (auto const& extent : m_block_map.extents()) {
+                dbgln("    # {}+{} at {}", extent.logical_start, extent.length, extent.physical_start);
             }
         }
-        while (m_block_list.size() != blocks_needed_after) {
-            auto block_index = m_block_list.take_last();
+        while (m_block_map.block_count() != blocks_needed_after) {
+            auto block_index = m_block_map.take_last();
             if (block_index.value()) {
                 if (auto result = fs().set_block_allocation_state(block_index, false); result.is_error()) {
                     dbgln("Ext2FSInode[{}]::resize(): Failed to free block {}: {}", identifier(), block_index, result.error());
@@ -686,46 +818,66 @@ ErrorOr<size_t> Ext2FSInode::write_bytes_locked(off_t offset, size_t count, User
 
     bool allow_cache = !description || !description->is_direct();
 
-    auto const block_size = fs().block_size();
+    u64 const block_size = fs().block_size();
     auto new_size = max(static_cast<u64>(offset) + count, size());
 
     TRY(resize(new_size));
 
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+    u64 position = offset;
+    u64 remaining_count = min(static_cast<u64>(count), new_size - position);
+    u64 first_block_logical_index = position / block_size;
+    u64 end_block_logical_index = ceil_div(position + remaining_count, block_size);
+
+    TRY(load_block_map(first_block_logical_index, end_block_logical_index - first_block_logical_index));
+    auto extents = TRY(m_block_map.extents_in_range(first_block_logical_index, end_block_logical_index - first_block_logical_index));
 
-    if (m_block_list.is_empty()) {
+    if (extents.is_empty()) {
         dbgln("Ext2FSInode[{}]::write_bytes(): Empty block list", identifier());
         return EIO;
     }
 
-    BlockBasedFileSystem::BlockIndex first_block_logical_index = offset / block_size;
-    BlockBasedFileSystem::BlockIndex last_block_logical_index = (offset + count) / block_size;
-    if (last_block_logical_index >= m_block_list.size())
-        last_block_logical_index = m_block_list.size() - 1;
-
-    size_t offset_into_first_block = offset % block_size;
-
     size_t nwritten = 0;
-    auto remaining_count = min((off_t)count, (off_t)new_size - offset);
 
     dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): Writing {} bytes, {} bytes into inode from {}", identifier(), count, offset, data.user_or_kernel_ptr());
 
-    for (auto bi = first_block_logical_index; remaining_count && bi <= last_block_logical_index; bi = bi.value() + 1) {
-        size_t offset_into_block = (bi == first_block_logical_index) ? offset_into_first_block : 0;
-        size_t num_bytes_to_copy = min((size_t)block_size - offset_into_block, (size_t)remaining_count);
-        dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): Writing block {} (offset_into_block: {})", identifier(), m_block_list[bi.value()], offset_into_block);
-        if (auto result = fs().write_block(m_block_list[bi.value()], data.offset(nwritten), num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
-            dbgln("Ext2FSInode[{}]::write_bytes_locked(): Failed to write block {} (index {})", identifier(), m_block_list[bi.value()], bi);
-            return result.release_error();
+    for (auto const& extent : extents) {
+        if (extent.is_hole()) {
+            // FIXME: Allocate blocks for holes instead of refusing to write into them.
+            dbgln("Ext2FSInode[{}]::write_bytes_locked(): Can't write into hole at index {}", identifier(), extent.logical_start);
+            return EIO;
+        }
+        u64 extent_end = extent.logical_end() * block_size;
+        while (remaining_count && position < extent_end) {
+            u64 logical_block = position / block_size;
+            size_t offset_into_block = position % block_size;
+            auto block_index = extent.physical_block(logical_block);
+            size_t num_bytes_to_copy = 0;
+            if (offset_into_block == 0 && remaining_count >= block_size) {
+                // The blocks of an extent are contiguous on disk, so write as many whole ones as we can in one go.
+                auto block_count = min(extent.logical_end() - logical_block, remaining_count / block_size);
+                num_bytes_to_copy = block_count * block_size;
+                dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): Writing {} blocks at {}", identifier(), block_count, block_index);
+                if (auto result = fs().write_blocks(block_index, block_count, data.offset(nwritten), allow_cache); result.is_error()) {
+                    dbgln("Ext2FSInode[{}]::write_bytes_locked(): Failed to write {} blocks at {} (index {})", identifier(), block_count, block_index, logical_block);
+                    return result.release_error();
+                }
+            } else {
+                num_bytes_to_copy = min(block_size - offset_into_block, remaining_count);
+                dbgln_if(EXT2_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): Writing block {} (offset_into_block: {})", identifier(), block_index, offset_into_block);
+                if (auto result = fs().write_block(block_index, data.offset(nwritten), num_bytes_to_copy, offset_into_block, allow_cache); result.is_error()) {
+                    dbgln("Ext2FSInode[{}]::write_bytes_locked(): Failed to write block {} (index {})", identifier(), block_index, logical_block);
+                    return result.release_error();
+                }
+            }
+            position += num_bytes_to_copy;
+            remaining_count -= num_bytes_to_copy;
+            nwritten += num_bytes_to_copy;
         }
-        remaining_count -= num_bytes_to_copy;
-        nwritten += num_bytes_to_copy;
     }
 
     did_modify_contents();
 
-    dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): After write, i_size={}, i_blocks={} ({} blocks in list)", identifier(), size(), m_raw_inode.i_blocks, m_block_list.size());
+    dbgln_if(EXT2_VERY_DEBUG, "Ext2FSInode[{}]::write_bytes_locked(): After write, i_size={}, i_blocks={} ({} blocks in map)", identifier(), size(), m_raw_inode.i_blocks, m_block_map.block_count());
     return nwritten;
 }
 
@@ -1074,13 +1226,14 @@ ErrorOr<int> Ext2FSInode::get_block_address(int index)
 {
     MutexLocker locker(m_inode_lock);
 
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+    if (index < 0)
+        return 0;
 
-    if (index < 0 || (size_t)index >= m_block_list.size())
+    TRY(load_block_map(index, 1));
+    if (static_cast<u64>(index) >= m_block_map.block_count())
         return 0;
 
-    return m_block_list[index].value();
+    return m_block_map.block_at(index).value();
 }
 
 }
@@ -8,6 +8,7 @@
 
 #include <AK/AtomicRefCounted.h>
 #include <AK/Error.h>
+#include <AK/IntrusiveList.h>
 #include <AK/StringView.h>
 #include <AK/Types.h>
 #include <Kernel/Forward.h>
@@ -23,7 +24,55 @@ class File;
 
 class FileBlockerSet final : public Thread::BlockerSet {
 public:
+    // Gets told about every change in the state of a file, without a thread having to
+    // block on it. This is called with the blocker set locked, so it must not block,
+    // and it can't rely on the file's descriptions still being alive.
+    class Observer {
+    public:
+        virtual ~Observer() = default;
+        virtual void file_state_changed() = 0;
+
+        // Called with the blocker set locked once the description the observer was added for goes
+        // away. The observer has been removed already, and won't hear about the file again.
+        virtual void observed_description_closed() = 0;
+
+    private:
+        friend class FileBlockerSet;
+        IntrusiveListNode<Observer> m_list_node;
+        OpenFileDescription const* m_description { nullptr };
+    };
+
     FileBlockerSet() { }
+    virtual ~FileBlockerSet() override { VERIFY(m_observers.is_empty()); }
+
+    // Observers watch a file through one of its descriptions, and only for as long as it's alive.
+    void add_observer(Observer& observer, OpenFileDescription const& description)
+    {
+        SpinlockLocker lock(m_lock);
+        observer.m_description = &description;
+        m_observers.append(observer);
+    }
+
+    // Note: Once this returns, the observer is guaranteed to not be in the middle of a callback.
+    void remove_observer(Observer& observer)
+    {
+        SpinlockLocker lock(m_lock);
+        if (m_observers.contains(observer))
+            m_observers.remove(observer);
+    }
+
+    void description_closed(OpenFileDescription const& description)
+    {
+        SpinlockLocker lock(m_lock);
+        for (auto it = m_observers.begin(); it != m_observers.end();) {
+            auto& observer = *it;
+            ++it;
+            if (observer.m_description != &description)
+                continue;
+            m_observers.remove(observer);
+            observer.observed_description_closed();
+        }
+    }
 
     virtual bool should_add_blocker(Thread::Blocker& b, void* data) override
     {
@@ -35,12 +84,24 @@ public:
     void unblock_all_blockers_whose_conditions_are_met()
     {
         SpinlockLocker lock(m_lock);
+        bool did_unblock_exclusive_blocker = false;
         BlockerSet::unblock_all_blockers_whose_conditions_are_met_locked([&](auto& b, void* data, bool&) {
             VERIFY(b.blocker_type() == Thread::Blocker::Type::File);
             auto& blocker = static_cast<Thread::FileBlocker&>(b);
-            return blocker.unblock_if_conditions_are_met(false, data);
+            if (blocker.is_exclusive() && did_unblock_exclusive_blocker)
+                return false;
+            if (!blocker.unblock_if_conditions_are_met(false, data))
+                return false;
+            if (blocker.is_exclusive())
+                did_unblock_exclusive_blocker = true;
+            return true;
         });
+        for (auto& observer : m_observers)
+            observer.file_state_changed();
     }
+
+private:
+    IntrusiveList<&Observer::m_list_node> m_observers;
 };
 
 // File is the base class for anything that can be referenced by a OpenFileDescription.
@@ -114,6 +175,8 @@ public:
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
     virtual bool is_inode_watcher() const { return false; }
+    virtual bool is_event_poll() const { return false; }
+    virtual bool is_io_ring() const { return false; }
 
     virtual bool is_regular_file() const { return false; }
 
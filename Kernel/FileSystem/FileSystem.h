@@ -33,6 +33,9 @@ public:
     virtual StringView class_name() const = 0;
     virtual Inode& root_inode() = 0;
     virtual bool supports_watchers() const { return false; }
+    // Whether lookups can be remembered in the DirectoryEntryCache, which requires every change to a
+    // directory's entries to be reported through Inode::did_add_child() and Inode::did_remove_child().
+    virtual bool supports_directory_entry_cache() const { return false; }
 
     bool is_readonly() const { return m_readonly; }
 
@@ -53,6 +56,15 @@ public:
 
     virtual void flush_writes() { }
 
+    // Writes back some of the cached dirty data in the background, without waiting for all of it.
+    // Returns how many blocks were written.
+    virtual size_t write_back() { return 0; }
+
+    // Called before a writer dirties more cached data, so it can be slowed down if there's too much of it already.
+    virtual void throttle_dirtying_writer() { }
+
+    virtual void release_cached_memory() { }
+
     u64 block_size() const { return m_block_size; }
     size_t fragment_size() const { return m_fragment_size; }
 
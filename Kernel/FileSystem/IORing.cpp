@@ -0,0 +1,514 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KString.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/ScopedAddressSpaceSwitcher.h>
+#include <Kernel/Net/Socket.h>
+#include <Kernel/Process.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+using BlockFlags = Thread::FileBlocker::BlockFlags;
+
+static constexpr size_t sqes_offset = 64;
+static_assert(sizeof(io_ring_header) <= sqes_offset);
+
+static u32 round_up_to_power_of_two(u32 value)
+{
+    u32 result = 1;
+    while (result < value)
+        result <<= 1;
+    return result;
+}
+
+static BlockFlags block_flags_for_poll_events(u16 events)
+{
+    BlockFlags block_flags = BlockFlags::None;
+    if (events & POLLIN)
+        block_flags |= BlockFlags::Read;
+    if (events & POLLPRI)
+        block_flags |= BlockFlags::ReadPriority;
+    if (events & POLLOUT)
+        block_flags |= BlockFlags::Write;
+    return block_flags;
+}
+
+static u16 poll_events_for_block_flags(BlockFlags block_flags)
+{
+    u16 events = 0;
+    if (has_flag(block_flags, BlockFlags::Read))
+        events |= POLLIN;
+    if (has_flag(block_flags, BlockFlags::ReadPriority))
+        events |= POLLPRI;
+    if (has_flag(block_flags, BlockFlags::Write))
+        events |= POLLOUT;
+    return events;
+}
+
+IORing::ParkedOperation::ParkedOperation(IORing& ring, io_ring_sqe const& sqe, NonnullLockRefPtr<OpenFileDescription> description, BlockFlags wait_for)
+    : ring(ring)
+    , sqe(sqe)
+    , description(move(description))
+    , wait_for(wait_for)
+{
+    this->description->blocker_set().add_observer(*this);
+}
+
+IORing::ParkedOperation::~ParkedOperation()
+{
+    description->blocker_set().remove_observer(*this);
+}
+
+void IORing::ParkedOperation::file_state_changed()
+{
+    // Note: We're called with the file's blocker set locked, so all we can do is have whoever
+    //       runs the ring next try again.
+    is_ready = true;
+    ring.m_has_ready_operations = true;
+    ring.m_completion_queue.wake_all();
+    ring.m_submission_poller_queue.wake_one();
+    ring.evaluate_block_conditions();
+}
+
+ErrorOr<NonnullLockRefPtr<IORing>> IORing::try_create(Process& process, io_ring_params& params)
+{
+    if (params.sq_entries == 0 || params.sq_entries > IO_RING_MAX_ENTRIES)
+        return EINVAL;
+    if (params.cq_entries > 2 * IO_RING_MAX_ENTRIES)
+        return EINVAL;
+    if ((params.flags & ~(IO_RING_SETUP_SQPOLL | IO_RING_SETUP_CLOEXEC)) != 0)
+        return EINVAL;
+
+    u32 sq_entries = round_up_to_power_of_two(params.sq_entries);
+    u32 cq_entries = round_up_to_power_of_two(params.cq_entries ? max(params.cq_entries, sq_entries) : 2 * sq_entries);
+    size_t cqes_offset = sqes_offset + sq_entries * sizeof(io_ring_sqe);
+    auto mapping_size = TRY(Memory::page_round_up(cqes_offset + cq_entries * sizeof(io_ring_cqe)));
+
+    Optional<u32> submission_poller_idle_ms;
+    if (params.flags & IO_RING_SETUP_SQPOLL)
+        submission_poller_idle_ms = params.sq_thread_idle_ms ? params.sq_thread_idle_ms : 1000;
+
+    // Note: The pages have to be there right away, as the process' mapping and ours wouldn't agree on lazily allocated ones.
+    auto vmobject = TRY(Memory::AnonymousVMObject::try_create_with_size(mapping_size, AllocationStrategy::AllocateNow));
+    auto region = TRY(MM.allocate_kernel_region_with_vmobject(*vmobject, mapping_size, "IORing"sv, Memory::Region::Access::ReadWrite));
+    auto ring = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) IORing(process, move(vmobject), move(region), sq_entries, cq_entries, submission_poller_idle_ms)));
+
+    if (ring->has_submission_poller()) {
+        auto name = TRY(KString::formatted("IORing SQ Poller ({})", process.pid().value()));
+        LockRefPtr<Thread> submission_poller;
+        if (!Process::create_kernel_process(submission_poller, move(name), [ring]() mutable { ring->submission_poller_main(); }))
+            return ENOMEM;
+    }
+
+    params.sq_entries = sq_entries;
+    params.cq_entries = cq_entries;
+    params.mapping_size = mapping_size;
+    params.sqes_offset = sqes_offset;
+    params.cqes_offset = cqes_offset;
+    return ring;
+}
+
+IORing::IORing(Process& process, NonnullLockRefPtr<Memory::AnonymousVMObject> vmobject, NonnullOwnPtr<Memory::Region> region, u32 sq_entries, u32 cq_entries, Optional<u32> submission_poller_idle_ms)
+    : m_process(process)
+    , m_vmobject(move(vmobject))
+    , m_region(move(region))
+    , m_sq_entries(sq_entries)
+    , m_cq_entries(cq_entries)
+    , m_submission_poller_idle_ms(submission_poller_idle_ms)
+{
+    auto& header = this->header();
+    header.sq_mask = sq_entries - 1;
+    header.cq_mask = cq_entries - 1;
+}
+
+IORing::~IORing()
+{
+    MutexLocker locker(m_lock);
+    m_parked_operations.clear();
+}
+
+ErrorOr<void> IORing::close()
+{
+    m_submission_poller_should_exit = true;
+    m_submission_poller_queue.wake_one();
+
+    // Nobody is going to pick up what the parked requests come to anymore.
+    MutexLocker locker(m_lock);
+    m_in_flight -= m_parked_operations.size();
+    m_parked_operations.clear();
+    return {};
+}
+
+bool IORing::can_read(OpenFileDescription const&, u64) const
+{
+    return completions_waiting() > 0 || m_has_ready_operations;
+}
+
+ErrorOr<NonnullLockRefPtr<Memory::VMObject>> IORing::vmobject_for_mmap(Process&, Memory::VirtualRange const& range, u64& offset, bool shared)
+{
+    // A private copy of the rings would be of no use to anyone.
+    if (!shared)
+        return EINVAL;
+    if (offset != 0 || range.size() > m_region->size())
+        return EINVAL;
+    return m_vmobject;
+}
+
+ErrorOr<NonnullOwnPtr<KString>> IORing::pseudo_path(OpenFileDescription const&) const
+{
+    return KString::formatted("IORing:({}/{})", m_sq_entries, m_cq_entries);
+}
+
+bool IORing::belongs_to(Process const& process) const
+{
+    auto owner = m_process.strong_ref();
+    return owner.ptr() == &process;
+}
+
+io_ring_sqe const* IORing::submission_entries() const
+{
+    return reinterpret_cast<io_ring_sqe const*>(m_region->vaddr().offset(sqes_offset).as_ptr());
+}
+
+io_ring_cqe* IORing::completion_entries() const
+{
+    return reinterpret_cast<io_ring_cqe*>(m_region->vaddr().offset(sqes_offset + m_sq_entries * sizeof(io_ring_sqe)).as_ptr());
+}
+
+size_t IORing::submissions_waiting() const
+{
+    u32 tail = AK::atomic_load(&header().sq_tail, AK::memory_order_acquire);
+    return min(tail - m_sq_head, m_sq_entries);
+}
+
+size_t IORing::completions_waiting() const
+{
+    // Note: Userspace owns the head, so we can't trust it to be anywhere sensible.
+    u32 head = AK::atomic_load(&header().cq_head, AK::memory_order_acquire);
+    return min(m_cq_tail.load() - head, m_cq_entries);
+}
+
+size_t IORing::free_completion_slots() const
+{
+    VERIFY(m_lock.is_locked());
+    auto used = completions_waiting() + m_in_flight;
+    return used < m_cq_entries ? m_cq_entries - used : 0;
+}
+
+void IORing::post_completion(u64 user_data, ErrorOr<size_t> result)
+{
+    VERIFY(m_lock.is_locked());
+    VERIFY(m_in_flight > 0);
+    --m_in_flight;
+
+    io_ring_cqe completion {};
+    completion.user_data = user_data;
+    completion.result = result.is_error() ? -result.error().code() : static_cast<i32>(min(result.value(), static_cast<size_t>(NumericLimits<i32>::max())));
+
+    auto tail = m_cq_tail.load();
+    completion_entries()[tail & (m_cq_entries - 1)] = completion;
+    m_cq_tail = tail + 1;
+    AK::atomic_store(&header().cq_tail, tail + 1, AK::memory_order_release);
+
+    m_completion_queue.wake_all();
+    evaluate_block_conditions();
+}
+
+ErrorOr<void> IORing::park(io_ring_sqe const& sqe, NonnullLockRefPtr<OpenFileDescription> description, BlockFlags wait_for)
+{
+    VERIFY(m_lock.is_locked());
+    auto operation = TRY(adopt_nonnull_own_or_enomem(new (nothrow) ParkedOperation(*this, sqe, move(description), wait_for)));
+    // The file might have become ready before the observer was in place, so have it looked at once more.
+    operation->is_ready = true;
+    m_has_ready_operations = true;
+    TRY(m_parked_operations.try_append(move(operation)));
+    return {};
+}
+
+auto IORing::perform(Process& process, io_ring_sqe const& sqe) -> ErrorOr<Outcome>
+{
+    if (sqe.opcode == IO_RING_OP_NOP)
+        return Outcome {};
+
+    auto description = TRY(process.open_file_description(sqe.fd));
+    // Parked operations evaluate the ring's blockers with the target's blocker set locked, so targets
+    // that do the same with their own observers could end up taking a lock they already hold.
+    if (description->is_io_ring() || description->is_event_poll())
+        return EINVAL;
+    auto would_block = [&](BlockFlags wait_for) {
+        return Outcome { Outcome::Type::WouldBlock, 0, description, wait_for, {} };
+    };
+
+    auto transfer_buffer = [&]() -> ErrorOr<UserOrKernelBuffer> {
+        if (sqe.len > NumericLimits<ssize_t>::max())
+            return EINVAL;
+        return UserOrKernelBuffer::for_user_buffer(Userspace<u8*>(sqe.addr), sqe.len);
+    };
+
+    // Storage devices get to work on all of the batch's transfers at once, but only if the requests
+    // are made by the process itself, as that's the address space they'll move the data in.
+    auto start_block_transfer = [&](AsyncBlockDeviceRequest::RequestType type, UserOrKernelBuffer const& buffer) -> Optional<Outcome> {
+        if (&process != &Process::current() || !description->file().is_block_device())
+            return {};
+        auto& block_device = static_cast<BlockDevice&>(description->file());
+        if (!block_device.is_storage_device())
+            return {};
+        auto& storage_device = static_cast<StorageDevice&>(block_device);
+        auto requests_or_error = storage_device.start_transfer(type, sqe.offset, buffer, sqe.len);
+        if (requests_or_error.is_error())
+            return {};
+        return Outcome { Outcome::Type::Transferring, 0, {}, BlockFlags::None, BlockTransfer { sqe.user_data, storage_device, requests_or_error.release_value() } };
+    };
+
+    auto completed = [](size_t result) {
+        return Outcome { Outcome::Type::Completed, result, {}, BlockFlags::None, {} };
+    };
+
+    switch (sqe.opcode) {
+    case IO_RING_OP_READ:
+    case IO_RING_OP_PREAD: {
+        if (!description->is_readable())
+            return EBADF;
+        if (description->is_directory())
+            return EISDIR;
+        auto buffer = TRY(transfer_buffer());
+        if (sqe.opcode == IO_RING_OP_PREAD) {
+            if (!description->file().is_seekable() || sqe.offset > static_cast<u64>(NumericLimits<off_t>::max()))
+                return EINVAL;
+            if (auto outcome = start_block_transfer(AsyncBlockDeviceRequest::Read, buffer); outcome.has_value())
+                return outcome.release_value();
+            return completed(TRY(description->read(buffer, sqe.offset, sqe.len)));
+        }
+        if (!description->can_read())
+            return would_block(BlockFlags::Read);
+        return completed(TRY(description->read(buffer, sqe.len)));
+    }
+    case IO_RING_OP_WRITE:
+    case IO_RING_OP_PWRITE: {
+        if (!description->is_writable())
+            return EBADF;
+        auto buffer = TRY(transfer_buffer());
+        if (sqe.opcode == IO_RING_OP_PWRITE) {
+            if (!description->file().is_seekable() || sqe.offset > static_cast<u64>(NumericLimits<off_t>::max()))
+                return EINVAL;
+            if (auto outcome = start_block_transfer(AsyncBlockDeviceRequest::Write, buffer); outcome.has_value())
+                return outcome.release_value();
+            return completed(TRY(description->write(sqe.offset, buffer, sqe.len)));
+        }
+        if (!description->can_write())
+            return would_block(BlockFlags::Write);
+        if (description->should_append() && description->file().is_seekable())
+            TRY(description->seek(0, SEEK_END));
+        return completed(TRY(description->write(buffer, sqe.len)));
+    }
+    case IO_RING_OP_FSYNC:
+        TRY(description->sync());
+        return completed(0);
+    case IO_RING_OP_ACCEPT: {
+        // Note: Unlike accept(), this fails instead of counting as a promise violation, as there
+        //       may be no thread of the process around to take the blame.
+        if (process.has_promises() && !process.has_promised(Pledge::accept))
+            return EPERM;
+        if (!description->is_socket())
+            return ENOTSOCK;
+        // Nothing will ever show up to be accepted otherwise, and the operation would stay parked forever.
+        if (description->socket()->role(*description) != Socket::Role::Listener)
+            return EINVAL;
+        auto fd_allocation = TRY(process.fds().with_exclusive([](auto& fds) { return fds.allocate(); }));
+        auto accepted_socket = description->socket()->accept();
+        if (!accepted_socket)
+            return would_block(BlockFlags::Accept);
+        auto accepted_description = TRY(OpenFileDescription::try_create(*accepted_socket));
+        accepted_description->set_readable(true);
+        accepted_description->set_writable(true);
+        if (sqe.op_flags & SOCK_NONBLOCK)
+            accepted_description->set_blocking(false);
+        u32 fd_flags = (sqe.op_flags & SOCK_CLOEXEC) ? FD_CLOEXEC : 0;
+        process.fds().with_exclusive([&](auto& fds) {
+            fds[fd_allocation.fd].set(move(accepted_description), fd_flags);
+        });
+        return completed(fd_allocation.fd);
+    }
+    case IO_RING_OP_RECV: {
+        if (!description->is_socket())
+            return ENOTSOCK;
+        auto& socket = *description->socket();
+        if (socket.is_shut_down_for_reading())
+            return completed(0);
+        auto buffer = TRY(transfer_buffer());
+        Time timestamp {};
+        auto nreceived_or_error = socket.recvfrom(*description, buffer, sqe.len, sqe.op_flags, {}, {}, timestamp, false);
+        if (nreceived_or_error.is_error() && nreceived_or_error.error().code() == EAGAIN)
+            return would_block(BlockFlags::Read);
+        return completed(TRY(nreceived_or_error));
+    }
+    case IO_RING_OP_SEND: {
+        if (!description->is_socket())
+            return ENOTSOCK;
+        auto& socket = *description->socket();
+        // Note: There is no SIGPIPE for a request made through the ring.
+        if (socket.is_shut_down_for_writing())
+            return EPIPE;
+        if (!description->can_write())
+            return would_block(BlockFlags::Write);
+        auto buffer = TRY(transfer_buffer());
+        auto nsent_or_error = socket.sendto(*description, buffer, sqe.len, sqe.op_flags, {}, 0);
+        if ((nsent_or_error.is_error() && nsent_or_error.error().code() == EAGAIN) || (!nsent_or_error.is_error() && nsent_or_error.value() == 0))
+            return would_block(BlockFlags::Write);
+        return completed(TRY(nsent_or_error));
+    }
+    case IO_RING_OP_POLL: {
+        auto block_flags = block_flags_for_poll_events(sqe.poll_events);
+        if (block_flags == BlockFlags::None)
+            return EINVAL;
+        auto unblocked_flags = description->should_unblock(block_flags);
+        if (unblocked_flags == BlockFlags::None)
+            return would_block(block_flags);
+        return completed(poll_events_for_block_flags(unblocked_flags));
+    }
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<size_t> IORing::submit(Process& process, size_t count)
+{
+    MutexLocker locker(m_lock);
+    count = min(count, submissions_waiting());
+    if (count == 0)
+        return 0;
+
+    Vector<BlockTransfer> transfers;
+    size_t submitted = 0;
+    for (; submitted < count && free_completion_slots() > 0; ++submitted) {
+        // Note: Userspace may scribble over the entry while we look at it, so it's copied out first.
+        auto sqe = submission_entries()[m_sq_head & (m_sq_entries - 1)];
+        ++m_sq_head;
+        ++m_in_flight;
+
+        auto outcome_or_error = perform(process, sqe);
+        if (outcome_or_error.is_error()) {
+            post_completion(sqe.user_data, outcome_or_error.release_error());
+            continue;
+        }
+        auto outcome = outcome_or_error.release_value();
+        switch (outcome.type) {
+        case Outcome::Type::Completed:
+            post_completion(sqe.user_data, outcome.result);
+            break;
+        case Outcome::Type::WouldBlock:
+            if (auto result = park(sqe, outcome.description.release_nonnull(), outcome.wait_for); result.is_error())
+                post_completion(sqe.user_data, result.release_error());
+            break;
+        case Outcome::Type::Transferring:
+            if (auto result = transfers.try_append(outcome.transfer.release_value()); result.is_error()) {
+                auto& transfer = outcome.transfer.value();
+                post_completion(transfer.user_data, transfer.device->finish_transfer(transfer.requests));
+            }
+            break;
+        }
+    }
+    AK::atomic_store(&header().sq_head, m_sq_head, AK::memory_order_release);
+
+    for (auto& transfer : transfers)
+        post_completion(transfer.user_data, transfer.device->finish_transfer(transfer.requests));
+
+    // Like with a full pipe, tell the caller to pick up completions before submitting more.
+    if (submitted == 0)
+        return EBUSY;
+    return submitted;
+}
+
+size_t IORing::run_ready_operations(Process& process)
+{
+    if (!m_has_ready_operations.exchange(false))
+        return 0;
+
+    MutexLocker locker(m_lock);
+    size_t completed = 0;
+    for (size_t i = 0; i < m_parked_operations.size();) {
+        auto& operation = *m_parked_operations[i];
+        if (!operation.is_ready.exchange(false)) {
+            ++i;
+            continue;
+        }
+
+        auto outcome_or_error = perform(process, operation.sqe);
+        if (!outcome_or_error.is_error() && outcome_or_error.value().type == Outcome::Type::WouldBlock) {
+            ++i;
+            continue;
+        }
+
+        auto user_data = operation.sqe.user_data;
+        m_parked_operations.remove(i);
+        if (outcome_or_error.is_error()) {
+            post_completion(user_data, outcome_or_error.release_error());
+        } else {
+            auto outcome = outcome_or_error.release_value();
+            if (outcome.type == Outcome::Type::Transferring)
+                post_completion(user_data, outcome.transfer->device->finish_transfer(outcome.transfer->requests));
+            else
+                post_completion(user_data, outcome.result);
+        }
+        ++completed;
+    }
+    return completed;
+}
+
+ErrorOr<void> IORing::wait_for_completions(Process& process, size_t count)
+{
+    count = min(count, m_cq_entries);
+    for (;;) {
+        run_ready_operations(process);
+        if (completions_waiting() >= count)
+            return {};
+        if (m_completion_queue.wait_on({}, "IORing"sv).was_interrupted())
+            return EINTR;
+    }
+}
+
+void IORing::submission_poller_main()
+{
+    auto last_busy_ms = TimeManagement::the().uptime_ms();
+    while (!m_submission_poller_should_exit) {
+        auto process = m_process.strong_ref();
+        if (!process)
+            break;
+
+        bool was_busy = false;
+        {
+            // Note: The requests refer to the process' memory, so they have to be carried out in its address space.
+            ScopedAddressSpaceSwitcher switcher(*process);
+            auto submitted_or_error = submit(*process, m_sq_entries);
+            was_busy = !submitted_or_error.is_error() && submitted_or_error.value() > 0;
+            was_busy |= run_ready_operations(*process) > 0;
+        }
+        process = nullptr;
+
+        auto now_ms = TimeManagement::the().uptime_ms();
+        if (was_busy || now_ms - last_busy_ms < m_submission_poller_idle_ms.value()) {
+            if (was_busy)
+                last_busy_ms = now_ms;
+            Scheduler::yield();
+            continue;
+        }
+
+        // We've been idle for long enough, so go to sleep until userspace tells us there's more.
+        AK::atomic_fetch_or(&header().sq_flags, static_cast<u32>(IO_RING_SQ_NEED_WAKEUP), AK::memory_order_seq_cst);
+        // Note: Userspace might have added an entry just before it could see the flag.
+        if (submissions_waiting() == 0 && !m_has_ready_operations)
+            m_submission_poller_queue.wait_forever("IORing"sv);
+        AK::atomic_fetch_and(&header().sq_flags, static_cast<u32>(~IO_RING_SQ_NEED_WAKEUP), AK::memory_order_seq_cst);
+        last_busy_ms = TimeManagement::the().uptime_ms();
+    }
+}
+
+}
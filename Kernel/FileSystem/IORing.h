@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Library/LockWeakPtr.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/Region.h>
+#include <Kernel/Storage/StorageDevice.h>
+#include <Kernel/UnixTypes.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+// A pair of rings shared with a process: it puts I/O requests into the submission queue, and
+// picks up their results from the completion queue, so that a whole batch of I/O only costs a
+// single io_ring_enter(), or none at all if the ring has its own submission polling thread.
+//
+// Requests that can't be carried out right away (like a recv() on a socket without data) are
+// parked with an observer on the blocker set of their file, and are retried once that reports
+// a change. Reads and writes of whole blocks on storage devices are started all together, and
+// only waited for once the whole batch has been submitted.
+class IORing final : public File {
+public:
+    static ErrorOr<NonnullLockRefPtr<IORing>> try_create(Process&, io_ring_params&);
+    virtual ~IORing() override;
+
+    // Readable once there are completions to pick up.
+    virtual bool can_read(OpenFileDescription const&, u64) const override;
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+    virtual ErrorOr<NonnullLockRefPtr<Memory::VMObject>> vmobject_for_mmap(Process&, Memory::VirtualRange const&, u64& offset, bool shared) override;
+    virtual ErrorOr<void> close() override;
+
+    virtual ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const&) const override;
+    virtual StringView class_name() const override { return "IORing"sv; }
+    virtual bool is_io_ring() const override { return true; }
+
+    bool belongs_to(Process const&) const;
+    bool has_submission_poller() const { return m_submission_poller_idle_ms.has_value(); }
+    void wake_submission_poller() { m_submission_poller_queue.wake_one(); }
+
+    // Takes up to `count` entries off the submission queue, carries them out where possible,
+    // and returns how many were taken. Has to be called in the address space of the process.
+    ErrorOr<size_t> submit(Process&, size_t count);
+    // Retries the parked requests whose files have changed their state, and returns how many completed.
+    size_t run_ready_operations(Process&);
+
+    // Waits until at least `count` completions are there to be picked up.
+    ErrorOr<void> wait_for_completions(Process&, size_t count);
+
+private:
+    IORing(Process&, NonnullLockRefPtr<Memory::AnonymousVMObject>, NonnullOwnPtr<Memory::Region>, u32 sq_entries, u32 cq_entries, Optional<u32> submission_poller_idle_ms);
+
+    struct ParkedOperation final : public FileBlockerSet::Observer {
+        ParkedOperation(IORing&, io_ring_sqe const&, NonnullLockRefPtr<OpenFileDescription>, Thread::FileBlocker::BlockFlags);
+        virtual ~ParkedOperation() override;
+
+        virtual void file_state_changed() override;
+
+        IORing& ring;
+        io_ring_sqe sqe;
+        NonnullLockRefPtr<OpenFileDescription> description;
+        Thread::FileBlocker::BlockFlags wait_for;
+        Atomic<bool> is_ready { false };
+    };
+
+    struct BlockTransfer {
+        u64 user_data { 0 };
+        NonnullLockRefPtr<StorageDevice> device;
+        StorageDevice::PendingTransfer requests;
+    };
+
+    // What carrying out a request came to, if it didn't fail outright.
+    struct Outcome {
+        enum class Type {
+            Completed,
+            // The file isn't ready for it yet, so it has to be parked.
+            WouldBlock,
+            // A transfer on a storage device has been started, and has to be waited for.
+            Transferring,
+        };
+        Type type { Type::Completed };
+        size_t result { 0 };
+        LockRefPtr<OpenFileDescription> description;
+        Thread::FileBlocker::BlockFlags wait_for { Thread::FileBlocker::BlockFlags::None };
+        Optional<BlockTransfer> transfer;
+    };
+
+    io_ring_header& header() const { return *reinterpret_cast<io_ring_header*>(m_region->vaddr().as_ptr()); }
+    io_ring_sqe const* submission_entries() const;
+    io_ring_cqe* completion_entries() const;
+
+    size_t submissions_waiting() const;
+    size_t completions_waiting() const;
+    size_t free_completion_slots() const;
+    void post_completion(u64 user_data, ErrorOr<size_t> result);
+    ErrorOr<void> park(io_ring_sqe const&, NonnullLockRefPtr<OpenFileDescription>, Thread::FileBlocker::BlockFlags);
+
+    ErrorOr<Outcome> perform(Process&, io_ring_sqe const&);
+
+    void submission_poller_main();
+
+    LockWeakPtr<Process> m_process;
+    NonnullLockRefPtr<Memory::AnonymousVMObject> m_vmobject;
+    NonnullOwnPtr<Memory::Region> m_region;
+    u32 const m_sq_entries { 0 };
+    u32 const m_cq_entries { 0 };
+
+    // Serializes submitting and retrying requests.
+    mutable Mutex m_lock { "IORing"sv };
+    // The kernel's own copy of the indices it advances; the ones in the header are only ever written.
+    u32 m_sq_head { 0 };
+    Atomic<u32> m_cq_tail { 0 };
+    // Requests that have been taken off the submission queue, but haven't completed yet. A
+    // completion slot is held back for each of them, so the completion queue never overflows.
+    size_t m_in_flight { 0 };
+    Vector<NonnullOwnPtr<ParkedOperation>> m_parked_operations;
+    Atomic<bool> m_has_ready_operations { false };
+    WaitQueue m_completion_queue;
+
+    Optional<u32> m_submission_poller_idle_ms;
+    WaitQueue m_submission_poller_queue;
+    Atomic<bool> m_submission_poller_should_exit { false };
+};
+
+}
@@ -33,6 +33,8 @@ public:
 
     virtual ~ISO9660FS() override;
     virtual StringView class_name() const override { return "ISO9660FS"sv; }
+    // NOTE: ISO 9660 images are read-only, so their directories never change.
+    virtual bool supports_directory_entry_cache() const override { return true; }
     virtual Inode& root_inode() override;
 
     virtual unsigned total_block_count() const override;
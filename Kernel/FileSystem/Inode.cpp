@@ -10,6 +10,7 @@
 #include <AK/StringView.h>
 #include <Kernel/API/InodeWatcherEvent.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -101,6 +102,10 @@ Inode::~Inode()
 
 void Inode::will_be_destroyed()
 {
+    // NOTE: The identifier may be reused by a new inode once we're gone, so our entries can't outlive us.
+    if (m_has_cached_directory_entries)
+        DirectoryEntryCache::the().invalidate_directory(identifier());
+
     MutexLocker locker(m_inode_lock);
     if (m_metadata_dirty)
         (void)flush_metadata();
@@ -108,6 +113,9 @@ void Inode::will_be_destroyed()
 
 ErrorOr<size_t> Inode::write_bytes(off_t offset, size_t length, UserOrKernelBuffer const& target_buffer, OpenFileDescription* open_description)
 {
+    // NOTE: This may block for a while, so make sure we don't hold the inode lock while it does.
+    fs().throttle_dirtying_writer();
+
     MutexLocker locker(m_inode_lock);
     TRY(prepare_to_write_data());
     return write_bytes_locked(offset, length, target_buffer, open_description);
@@ -119,6 +127,19 @@ ErrorOr<size_t> Inode::read_bytes(off_t offset, size_t length, UserOrKernelBuffe
     return read_bytes_locked(offset, length, buffer, open_description);
 }
 
+// Prefetching is only a hint, so a single request doesn't get to make the file system
+// look up (and the block cache hold) more than this much at once.
+static constexpr u64 max_prefetch_length = 4 * MiB;
+
+void Inode::prefetch(u64 offset, u64 length)
+{
+    if (length == 0)
+        return;
+    length = min(length, max_prefetch_length);
+    MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
+    prefetch_locked(offset, length);
+}
+
 ErrorOr<void> Inode::update_timestamps([[maybe_unused]] Optional<Time> atime, [[maybe_unused]] Optional<Time> ctime, [[maybe_unused]] Optional<Time> mtime)
 {
     return ENOTIMPL;
@@ -217,6 +238,9 @@ void Inode::set_metadata_dirty(bool metadata_dirty)
 
 void Inode::did_add_child(InodeIdentifier, StringView name)
 {
+    if (fs().supports_directory_entry_cache())
+        DirectoryEntryCache::the().invalidate(identifier(), name);
+
     m_watchers.for_each([&](auto& watcher) {
         watcher->notify_inode_event({}, identifier(), InodeWatcherEvent::Type::ChildCreated, name);
     });
@@ -224,6 +248,9 @@ void Inode::did_add_child(InodeIdentifier, StringView name)
 
 void Inode::did_remove_child(InodeIdentifier, StringView name)
 {
+    if (fs().supports_directory_entry_cache())
+        DirectoryEntryCache::the().invalidate(identifier(), name);
+
     if (name == "." || name == "..") {
         // These are just aliases and are not interesting to userspace.
         return;
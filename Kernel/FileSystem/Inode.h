@@ -33,6 +33,7 @@ class Inode : public ListedRefCounted<Inode, LockType::Spinlock>
     friend class VirtualFileSystem;
     friend class FileSystem;
     friend class InodeFile;
+    friend class DirectoryEntryCache;
 
 public:
     virtual ~Inode();
@@ -58,6 +59,10 @@ public:
     ErrorOr<size_t> write_bytes(off_t, size_t, UserOrKernelBuffer const& data, OpenFileDescription*);
     ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const;
 
+    // Hints that [offset, offset + length) will be read soon. File systems that
+    // support it start pulling the data into their caches without waiting for it.
+    void prefetch(u64 offset, u64 length);
+
     virtual ErrorOr<void> attach(OpenFileDescription&) { return {}; }
     virtual void detach(OpenFileDescription&) { }
     virtual void did_seek(OpenFileDescription&, off_t) { }
@@ -124,6 +129,7 @@ protected:
 
     virtual ErrorOr<size_t> write_bytes_locked(off_t, size_t, UserOrKernelBuffer const& data, OpenFileDescription*) = 0;
     virtual ErrorOr<size_t> read_bytes_locked(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const = 0;
+    virtual void prefetch_locked(u64, u64) { }
 
 private:
     ErrorOr<bool> try_apply_flock(Process const&, OpenFileDescription const&, flock const&);
@@ -133,6 +139,7 @@ private:
     LockWeakPtr<Memory::SharedInodeVMObject> m_shared_vmobject;
     LockRefPtr<LocalSocket> m_bound_socket;
     SpinlockProtected<HashTable<InodeWatcher*>> m_watchers { LockRank::None };
+    bool m_has_cached_directory_entries { false };
     bool m_metadata_dirty { false };
     LockRefPtr<FIFO> m_fifo;
     IntrusiveListNode<Inode> m_inode_list_node;
@@ -9,7 +9,9 @@
 #include <Kernel/API/POSIX/errno.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/EventPoll.h>
 #include <Kernel/FileSystem/FIFO.h>
+#include <Kernel/FileSystem/IORing.h>
 #include <Kernel/FileSystem/InodeFile.h>
 #include <Kernel/FileSystem/InodeWatcher.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -62,6 +64,11 @@ OpenFileDescription::~OpenFileDescription()
 
     if (m_inode)
         m_inode->remove_flocks_for_description(*this);
+
+    // Let the observers of the file (like an EventPoll watching this description) know that it's gone,
+    // so that they stop observing the file through it, and let go of the file.
+    m_file->blocker_set().description_closed(*this);
+    m_file->blocker_set().unblock_all_blockers_whose_conditions_are_met();
 }
 
 ErrorOr<void> OpenFileDescription::attach()
@@ -152,7 +159,23 @@ ErrorOr<size_t> OpenFileDescription::read(UserOrKernelBuffer& buffer, u64 offset
 {
     if (Checked<u64>::addition_would_overflow(offset, count))
         return EOVERFLOW;
-    return m_file->read(*this, offset, buffer, count);
+    auto nread = TRY(m_file->read(*this, offset, buffer, count));
+    did_read(offset, nread);
+    return nread;
+}
+
+void OpenFileDescription::did_read(u64 offset, size_t nread)
+{
+    if (nread == 0 || !m_file->is_regular_file() || is_direct())
+        return;
+    auto range = m_state.with([&](auto& state) { return state.readahead.did_access(offset, nread); });
+    if (range.has_value())
+        m_inode->prefetch(range->offset, range->length);
+}
+
+void OpenFileDescription::set_readahead_mode(ReadaheadState::Mode mode)
+{
+    m_state.with([&](auto& state) { state.readahead.set_mode(mode); });
 }
 
 ErrorOr<size_t> OpenFileDescription::write(u64 offset, UserOrKernelBuffer const& data, size_t data_size)
@@ -162,6 +185,128 @@ ErrorOr<size_t> OpenFileDescription::write(u64 offset, UserOrKernelBuffer const&
     return m_file->write(*this, offset, data, data_size);
 }
 
+ErrorOr<Vector<iovec, 32>> OpenFileDescription::copy_iovecs_from_user(Userspace<iovec const*> iov, int iov_count)
+{
+    if (iov_count < 0)
+        return EINVAL;
+
+    if (iov_count > IOV_MAX)
+        return EFAULT;
+
+    u64 total_length = 0;
+    Vector<iovec, 32> vecs;
+    TRY(vecs.try_resize(iov_count));
+    TRY(copy_n_from_user(vecs.data(), iov, iov_count));
+    for (auto& vec : vecs) {
+        total_length += vec.iov_len;
+        if (total_length > NumericLimits<i32>::max())
+            return EINVAL;
+    }
+    return vecs;
+}
+
+// Scatter/gather lists up to this size are staged in a kernel buffer, so that an inode sees
+// the whole transfer as one contiguous request instead of one request per iovec.
+static constexpr size_t max_gathered_vectored_io_size = 64 * KiB;
+
+static bool should_gather_vectored_io(File const& file, Span<iovec const> vecs, size_t total_length)
+{
+    return file.is_inode() && vecs.size() > 1 && total_length <= max_gathered_vectored_io_size;
+}
+
+template<typename Callback>
+static ErrorOr<size_t> with_gather_buffer(size_t size, Callback callback)
+{
+    if (size <= PAGE_SIZE) {
+        u8 buffer[PAGE_SIZE];
+        return callback(Bytes { buffer, size });
+    }
+    auto buffer = TRY(KBuffer::try_create_with_size("OpenFileDescription: Vectored I/O"sv, size, Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow));
+    return callback(buffer->bytes());
+}
+
+static size_t total_vectored_io_length(Span<iovec const> vecs)
+{
+    size_t total_length = 0;
+    for (auto& vec : vecs)
+        total_length += vec.iov_len;
+    return total_length;
+}
+
+ErrorOr<size_t> OpenFileDescription::read_vectored(u64 offset, Span<iovec const> vecs)
+{
+    auto total_length = total_vectored_io_length(vecs);
+    if (Checked<u64>::addition_would_overflow(offset, total_length))
+        return EOVERFLOW;
+
+    if (should_gather_vectored_io(*m_file, vecs, total_length)) {
+        auto nread = TRY(with_gather_buffer(total_length, [&](Bytes gathered) -> ErrorOr<size_t> {
+            auto buffer = UserOrKernelBuffer::for_kernel_buffer(gathered.data());
+            auto nread = TRY(m_file->read(*this, offset, buffer, gathered.size()));
+            size_t nscattered = 0;
+            for (auto& vec : vecs) {
+                if (nscattered == nread)
+                    break;
+                auto length = min(vec.iov_len, nread - nscattered);
+                TRY(copy_to_user(vec.iov_base, gathered.offset_pointer(nscattered), length));
+                nscattered += length;
+            }
+            return nread;
+        }));
+        did_read(offset, nread);
+        return nread;
+    }
+
+    size_t nread = 0;
+    for (auto& vec : vecs) {
+        auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(static_cast<u8*>(vec.iov_base), vec.iov_len));
+        auto nread_here_or_error = m_file->read(*this, offset + nread, buffer, vec.iov_len);
+        if (nread_here_or_error.is_error()) {
+            if (nread == 0)
+                return nread_here_or_error.release_error();
+            break;
+        }
+        nread += nread_here_or_error.value();
+        if (nread_here_or_error.value() < vec.iov_len)
+            break;
+    }
+    did_read(offset, nread);
+    return nread;
+}
+
+ErrorOr<size_t> OpenFileDescription::write_vectored(u64 offset, Span<iovec const> vecs)
+{
+    auto total_length = total_vectored_io_length(vecs);
+    if (Checked<u64>::addition_would_overflow(offset, total_length))
+        return EOVERFLOW;
+
+    if (should_gather_vectored_io(*m_file, vecs, total_length)) {
+        return with_gather_buffer(total_length, [&](Bytes gathered) -> ErrorOr<size_t> {
+            size_t ngathered = 0;
+            for (auto& vec : vecs) {
+                TRY(copy_from_user(gathered.offset_pointer(ngathered), vec.iov_base, vec.iov_len));
+                ngathered += vec.iov_len;
+            }
+            return m_file->write(*this, offset, UserOrKernelBuffer::for_kernel_buffer(gathered.data()), gathered.size());
+        });
+    }
+
+    size_t nwritten = 0;
+    for (auto& vec : vecs) {
+        auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(static_cast<u8*>(vec.iov_base), vec.iov_len));
+        auto nwritten_here_or_error = m_file->write(*this, offset + nwritten, buffer, vec.iov_len);
+        if (nwritten_here_or_error.is_error()) {
+            if (nwritten == 0)
+                return nwritten_here_or_error.release_error();
+            break;
+        }
+        nwritten += nwritten_here_or_error.value();
+        if (nwritten_here_or_error.value() < vec.iov_len)
+            break;
+    }
+    return nwritten;
+}
+
 ErrorOr<size_t> OpenFileDescription::read(UserOrKernelBuffer& buffer, size_t count)
 {
     auto offset = TRY(m_state.with([&](auto& state) -> ErrorOr<off_t> {
@@ -172,6 +317,7 @@ ErrorOr<size_t> OpenFileDescription::read(UserOrKernelBuffer& buffer, size_t cou
     auto nread = TRY(m_file->read(*this, offset, buffer, count));
     if (m_file->is_seekable())
         m_state.with([&](auto& state) { state.current_offset = offset + nread; });
+    did_read(offset, nread);
     evaluate_block_conditions();
     return nread;
 }
@@ -328,6 +474,37 @@ InodeWatcher* OpenFileDescription::inode_watcher()
     return static_cast<InodeWatcher*>(m_file.ptr());
 }
 
+bool OpenFileDescription::is_event_poll() const
+{
+    return m_file->is_event_poll();
+}
+
+EventPoll const* OpenFileDescription::event_poll() const
+{
+    if (!is_event_poll())
+        return nullptr;
+    return static_cast<EventPoll const*>(m_file.ptr());
+}
+
+EventPoll* OpenFileDescription::event_poll()
+{
+    if (!is_event_poll())
+        return nullptr;
+    return static_cast<EventPoll*>(m_file.ptr());
+}
+
+bool OpenFileDescription::is_io_ring() const
+{
+    return m_file->is_io_ring();
+}
+
+IORing* OpenFileDescription::io_ring()
+{
+    if (!is_io_ring())
+        return nullptr;
+    return static_cast<IORing*>(m_file.ptr());
+}
+
 bool OpenFileDescription::is_master_pty() const
 {
     return m_file->is_master_pty();
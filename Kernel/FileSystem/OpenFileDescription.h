@@ -13,8 +13,10 @@
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
+#include <Kernel/FileSystem/ReadaheadState.h>
 #include <Kernel/Forward.h>
 #include <Kernel/KBuffer.h>
+#include <Kernel/Library/LockWeakable.h>
 #include <Kernel/VirtualAddress.h>
 
 namespace Kernel {
@@ -24,7 +26,9 @@ public:
     virtual ~OpenFileDescriptionData() = default;
 };
 
-class OpenFileDescription final : public AtomicRefCounted<OpenFileDescription> {
+class OpenFileDescription final
+    : public AtomicRefCounted<OpenFileDescription>
+    , public LockWeakable<OpenFileDescription> {
 public:
     static ErrorOr<NonnullLockRefPtr<OpenFileDescription>> try_create(Custody&);
     static ErrorOr<NonnullLockRefPtr<OpenFileDescription>> try_create(File&);
@@ -50,6 +54,10 @@ public:
     // NOTE: These ignore the current offset of this file description.
     ErrorOr<size_t> read(UserOrKernelBuffer&, u64 offset, size_t);
     ErrorOr<size_t> write(u64 offset, UserOrKernelBuffer const&, size_t);
+    // Copies in and validates the iovec array of a readv()-style syscall.
+    static ErrorOr<Vector<iovec, 32>> copy_iovecs_from_user(Userspace<iovec const*>, int iov_count);
+    ErrorOr<size_t> read_vectored(u64 offset, Span<iovec const>);
+    ErrorOr<size_t> write_vectored(u64 offset, Span<iovec const>);
 
     ErrorOr<void> chmod(Credentials const& credentials, mode_t);
 
@@ -82,6 +90,13 @@ public:
     InodeWatcher const* inode_watcher() const;
     InodeWatcher* inode_watcher();
 
+    bool is_event_poll() const;
+    EventPoll const* event_poll() const;
+    EventPoll* event_poll();
+
+    bool is_io_ring() const;
+    IORing* io_ring();
+
     bool is_master_pty() const;
     MasterPTY const* master_pty() const;
     MasterPTY* master_pty();
@@ -129,12 +144,16 @@ public:
     ErrorOr<void> apply_flock(Process const&, Userspace<flock const*>, ShouldBlock);
     ErrorOr<void> get_flock(Userspace<flock*>) const;
 
+    void set_readahead_mode(ReadaheadState::Mode);
+
 private:
     friend class VirtualFileSystem;
     explicit OpenFileDescription(File&);
 
     ErrorOr<void> attach();
 
+    void did_read(u64 offset, size_t nread);
+
     void evaluate_block_conditions()
     {
         blocker_set().unblock_all_blockers_whose_conditions_are_met();
@@ -155,6 +174,7 @@ private:
         bool should_append : 1 { false };
         bool direct : 1 { false };
         FIFO::Direction fifo_direction : 2 { FIFO::Direction::Neither };
+        ReadaheadState readahead;
     };
 
     SpinlockProtected<State> m_state { LockRank::None };
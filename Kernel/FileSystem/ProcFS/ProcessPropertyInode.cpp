@@ -200,6 +200,8 @@ ErrorOr<void> ProcFSProcessPropertyInode::try_to_acquire_data(Process& process,
         return process.procfs_get_virtual_memory_stats(builder);
     case SegmentedProcFSIndex::MainProcessProperty::CommandLine:
         return process.procfs_get_command_line(builder);
+    case SegmentedProcFSIndex::MainProcessProperty::NetworkStats:
+        return process.procfs_get_network_stats(builder);
     default:
         VERIFY_NOT_REACHED();
     }
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Checked.h>
+#include <AK/StdLibExtras.h>
+#include <Kernel/FileSystem/ReadaheadState.h>
+
+namespace Kernel {
+
+void ReadaheadState::set_mode(Mode mode)
+{
+    m_mode = mode;
+    reset();
+}
+
+void ReadaheadState::reset()
+{
+    m_window_size = 0;
+    m_readahead_end = 0;
+}
+
+Optional<ReadaheadState::Range> ReadaheadState::did_access(u64 offset, u64 length)
+{
+    if (m_mode == Mode::Random || length == 0)
+        return {};
+    if (Checked<u64>::addition_would_overflow(offset, length))
+        return {};
+
+    auto end = offset + length;
+    bool is_sequential = offset == m_next_expected_offset;
+    m_next_expected_offset = end;
+
+    if (!is_sequential) {
+        // A reader that told us it is sequential gets to keep its window across
+        // the occasional seek; everyone else has to prove themselves again.
+        if (m_mode != Mode::Sequential) {
+            reset();
+            return {};
+        }
+        m_readahead_end = 0;
+    }
+
+    auto window_limit = m_mode == Mode::Sequential ? max_sequential_window_size : max_window_size;
+    if (m_window_size == 0)
+        m_window_size = m_mode == Mode::Sequential ? window_limit : initial_window_size;
+    else
+        m_window_size = min(m_window_size * 2, window_limit);
+
+    if (Checked<u64>::addition_would_overflow(end, m_window_size))
+        return {};
+    auto start = max(end, m_readahead_end);
+    auto target_end = end + m_window_size;
+
+    // Don't bother issuing tiny requests when most of the window is already on its way.
+    if (target_end <= start || target_end - start < m_window_size / 2)
+        return {};
+
+    m_readahead_end = target_end;
+    return Range { start, target_end - start };
+}
+
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// Tracks the access pattern of a single stream of reads (an open file description
+// or a file-backed memory region) and decides how much of the file should be read
+// ahead of the reader. The window starts small and doubles for every sequential
+// access, and collapses as soon as the reader starts jumping around.
+class ReadaheadState {
+public:
+    enum class Mode {
+        Normal,
+        Sequential,
+        Random,
+    };
+
+    struct Range {
+        u64 offset { 0 };
+        u64 length { 0 };
+    };
+
+    Mode mode() const { return m_mode; }
+    void set_mode(Mode);
+
+    // Records a read of [offset, offset + length) and returns the part of the file
+    // that should be prefetched as a result, if any.
+    Optional<Range> did_access(u64 offset, u64 length);
+
+private:
+    static constexpr u64 initial_window_size = 16 * KiB;
+    static constexpr u64 max_window_size = 128 * KiB;
+    static constexpr u64 max_sequential_window_size = 512 * KiB;
+
+    void reset();
+
+    Mode m_mode { Mode::Normal };
+    u64 m_next_expected_offset { 0 };
+    u64 m_window_size { 0 };
+    u64 m_readahead_end { 0 };
+};
+
+}
@@ -8,7 +8,9 @@
 #include <Kernel/Bus/PCI/Access.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Devices/Storage/DeviceAttribute.h>
+#include <Kernel/Process.h>
 #include <Kernel/Sections.h>
+#include <Kernel/Storage/StorageDevice.h>
 
 namespace Kernel {
 
@@ -21,6 +23,8 @@ StringView StorageDeviceAttributeSysFSComponent::name() const
         return "sector_size"sv;
     case Type::CommandSet:
         return "command_set"sv;
+    case Type::Scheduler:
+        return "scheduler"sv;
     default:
         VERIFY_NOT_REACHED();
     }
@@ -50,6 +54,42 @@ ErrorOr<size_t> StorageDeviceAttributeSysFSComponent::read_bytes(off_t offset, s
     return nread;
 }
 
+ErrorOr<size_t> StorageDeviceAttributeSysFSComponent::write_bytes(off_t, size_t count, UserOrKernelBuffer const& buffer, OpenFileDescription*)
+{
+    if (m_type != Type::Scheduler)
+        return EROFS;
+
+    char name[16] {};
+    if (count == 0 || count > sizeof(name))
+        return EINVAL;
+    TRY(buffer.read(name, count));
+
+    return Process::current().jail().with([&](auto& my_jail) -> ErrorOr<size_t> {
+        // Note: If we are in a jail, don't let the current process change the scheduler.
+        if (my_jail)
+            return EPERM;
+        auto policy = BlockRequestQueue::policy_from_string_view(StringView { name, count }.trim_whitespace());
+        if (!policy.has_value())
+            return EINVAL;
+        m_device->request_queue().set_policy(policy.value());
+        return count;
+    });
+}
+
+ErrorOr<void> StorageDeviceAttributeSysFSComponent::truncate(u64 size)
+{
+    if (m_type != Type::Scheduler || size != 0)
+        return EPERM;
+    return {};
+}
+
+mode_t StorageDeviceAttributeSysFSComponent::permissions() const
+{
+    if (m_type == Type::Scheduler)
+        return 0644;
+    return SysFSComponent::permissions();
+}
+
 ErrorOr<NonnullOwnPtr<KBuffer>> StorageDeviceAttributeSysFSComponent::try_to_generate_buffer() const
 {
     OwnPtr<KString> value;
@@ -63,6 +103,9 @@ ErrorOr<NonnullOwnPtr<KBuffer>> StorageDeviceAttributeSysFSComponent::try_to_gen
     case Type::CommandSet:
         value = TRY(KString::formatted("{}", m_device->command_set_to_string_view()));
         break;
+    case Type::Scheduler:
+        value = TRY(KString::formatted("{}", BlockRequestQueue::policy_to_string_view(m_device->request_queue().policy())));
+        break;
     default:
         VERIFY_NOT_REACHED();
     }
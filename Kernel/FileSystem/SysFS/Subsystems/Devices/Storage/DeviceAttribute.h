@@ -18,12 +18,16 @@ public:
         EndLBA,
         SectorSize,
         CommandSet,
+        Scheduler,
     };
 
 public:
     static NonnullLockRefPtr<StorageDeviceAttributeSysFSComponent> must_create(StorageDeviceSysFSDirectory const& device_directory, Type);
 
     virtual ErrorOr<size_t> read_bytes(off_t, size_t, UserOrKernelBuffer&, OpenFileDescription*) const override;
+    virtual ErrorOr<size_t> write_bytes(off_t, size_t, UserOrKernelBuffer const&, OpenFileDescription*) override;
+    virtual ErrorOr<void> truncate(u64) override;
+    virtual mode_t permissions() const override;
     virtual ~StorageDeviceAttributeSysFSComponent() {};
 
     virtual StringView name() const override;
@@ -37,6 +37,23 @@ ErrorOr<void> SysFSMemoryStatus::try_generate(KBufferBuilder& builder)
     TRY(json.add("physical_uncommitted"sv, system_memory.physical_pages_uncommitted));
     TRY(json.add("kmalloc_call_count"sv, stats.kmalloc_call_count));
     TRY(json.add("kfree_call_count"sv, stats.kfree_call_count));
+
+    auto processors_array = TRY(json.add_array("kmalloc_processors"sv));
+    for (u32 processor_id = 0; processor_id < MAX_CPU_COUNT; ++processor_id) {
+        kmalloc_processor_stats processor_stats;
+        if (!get_kmalloc_processor_stats(processor_id, processor_stats))
+            continue;
+        auto processor_object = TRY(processors_array.add_object());
+        TRY(processor_object.add("processor"sv, processor_id));
+        TRY(processor_object.add("kmalloc_call_count"sv, processor_stats.kmalloc_call_count));
+        TRY(processor_object.add("kfree_call_count"sv, processor_stats.kfree_call_count));
+        TRY(processor_object.add("refill_count"sv, processor_stats.refill_count));
+        TRY(processor_object.add("drain_count"sv, processor_stats.drain_count));
+        TRY(processor_object.add("cached_bytes"sv, processor_stats.cached_bytes));
+        TRY(processor_object.finish());
+    }
+    TRY(processors_array.finish());
+
     TRY(json.finish());
     return {};
 }
@@ -38,8 +38,14 @@ ErrorOr<void> SysFSNetworkAdaptersStats::try_generate(KBufferBuilder& builder)
         }
         TRY(obj.add("packets_in"sv, adapter.packets_in()));
         TRY(obj.add("bytes_in"sv, adapter.bytes_in()));
+        TRY(obj.add("packets_dropped"sv, adapter.packets_dropped()));
+        TRY(obj.add("polls"sv, adapter.polls()));
         TRY(obj.add("packets_out"sv, adapter.packets_out()));
         TRY(obj.add("bytes_out"sv, adapter.bytes_out()));
+        TRY(obj.add("packets_segmented"sv, adapter.packets_segmented()));
+        TRY(obj.add("tx_checksum_offload"sv, adapter.has_offload(NetworkAdapter::Offload::TransmitChecksum)));
+        TRY(obj.add("rx_checksum_offload"sv, adapter.has_offload(NetworkAdapter::Offload::ReceiveChecksum)));
+        TRY(obj.add("tcp_segmentation_offload"sv, adapter.has_offload(NetworkAdapter::Offload::TCPSegmentation)));
         TRY(obj.add("link_up"sv, adapter.link_up()));
         TRY(obj.add("link_speed"sv, adapter.link_speed()));
         TRY(obj.add("link_full_duplex"sv, adapter.link_full_duplex()));
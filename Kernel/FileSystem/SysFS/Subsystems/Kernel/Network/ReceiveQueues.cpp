@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/ReceiveQueues.h>
+#include <Kernel/Net/NetworkTask.h>
+#include <Kernel/Net/NetworkingManagement.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSNetworkReceiveQueuesStats::SysFSNetworkReceiveQueuesStats(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSNetworkReceiveQueuesStats> SysFSNetworkReceiveQueuesStats::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSNetworkReceiveQueuesStats(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSNetworkReceiveQueuesStats::try_generate(KBufferBuilder& builder)
+{
+    auto array = TRY(JsonArraySerializer<>::try_create(builder));
+    for (size_t queue_index = 0; queue_index < NetworkTask::receive_queue_count(); ++queue_index) {
+        size_t queue_depth = 0;
+        u64 dropped = 0;
+        NetworkingManagement::the().for_each([&](auto& adapter) {
+            queue_depth += adapter.receive_queue_depth(queue_index);
+            dropped += adapter.receive_queue_drops(queue_index);
+        });
+        auto statistics = NetworkTask::receive_queue_statistics(queue_index);
+
+        auto obj = TRY(array.add_object());
+        TRY(obj.add("queue"sv, queue_index));
+        TRY(obj.add("packets"sv, statistics.packets));
+        TRY(obj.add("batches"sv, statistics.batches));
+        TRY(obj.add("largest_batch"sv, statistics.largest_batch));
+        TRY(obj.add("queue_depth"sv, queue_depth));
+        TRY(obj.add("dropped"sv, dropped));
+        TRY(obj.finish());
+    }
+    TRY(array.finish());
+    return {};
+}
+
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/GlobalInformation.h>
+#include <Kernel/KBufferBuilder.h>
+#include <Kernel/Library/LockRefPtr.h>
+#include <Kernel/UserOrKernelBuffer.h>
+
+namespace Kernel {
+
+class SysFSNetworkReceiveQueuesStats final : public SysFSGlobalInformation {
+public:
+    virtual StringView name() const override { return "receive_queues"sv; }
+    static NonnullLockRefPtr<SysFSNetworkReceiveQueuesStats> must_create(SysFSDirectory const&);
+
+private:
+    explicit SysFSNetworkReceiveQueuesStats(SysFSDirectory const&);
+    virtual ErrorOr<void> try_generate(KBufferBuilder& builder) override;
+};
+
+}
@@ -28,19 +28,7 @@ ErrorOr<void> SysFSNetworkTCPStats::try_generate(KBufferBuilder& builder)
     auto array = TRY(JsonArraySerializer<>::try_create(builder));
     TRY(TCPSocket::try_for_each([&array](auto& socket) -> ErrorOr<void> {
         auto obj = TRY(array.add_object());
-        auto local_address = TRY(socket.local_address().to_string());
-        TRY(obj.add("local_address"sv, local_address->view()));
-        TRY(obj.add("local_port"sv, socket.local_port()));
-        auto peer_address = TRY(socket.peer_address().to_string());
-        TRY(obj.add("peer_address"sv, peer_address->view()));
-        TRY(obj.add("peer_port"sv, socket.peer_port()));
-        TRY(obj.add("state"sv, TCPSocket::to_string(socket.state())));
-        TRY(obj.add("ack_number"sv, socket.ack_number()));
-        TRY(obj.add("sequence_number"sv, socket.sequence_number()));
-        TRY(obj.add("packets_in"sv, socket.packets_in()));
-        TRY(obj.add("bytes_in"sv, socket.bytes_in()));
-        TRY(obj.add("packets_out"sv, socket.packets_out()));
-        TRY(obj.add("bytes_out"sv, socket.bytes_out()));
+        TRY(socket.try_add_statistics(obj));
         auto current_process_credentials = Process::current().credentials();
         if (current_process_credentials->is_superuser() || current_process_credentials->uid() == socket.origin_uid()) {
             TRY(obj.add("origin_pid"sv, socket.origin_pid().value()));
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/DirtyBackgroundRatio.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/WritebackTask.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSDirtyBackgroundRatio::SysFSDirtyBackgroundRatio(SysFSDirectory const& parent_directory)
+    : SysFSSystemUnsignedInteger(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSDirtyBackgroundRatio> SysFSDirtyBackgroundRatio::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSDirtyBackgroundRatio(parent_directory)).release_nonnull();
+}
+
+u32 SysFSDirtyBackgroundRatio::value() const
+{
+    return g_dirty_background_ratio.load();
+}
+
+void SysFSDirtyBackgroundRatio::set_value(u32 new_value)
+{
+    g_dirty_background_ratio.store(new_value);
+}
+
+}
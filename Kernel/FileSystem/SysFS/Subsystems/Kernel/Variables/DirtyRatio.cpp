@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/DirtyRatio.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/WritebackTask.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSDirtyRatio::SysFSDirtyRatio(SysFSDirectory const& parent_directory)
+    : SysFSSystemUnsignedInteger(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSDirtyRatio> SysFSDirtyRatio::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSDirtyRatio(parent_directory)).release_nonnull();
+}
+
+u32 SysFSDirtyRatio::value() const
+{
+    return g_dirty_ratio.load();
+}
+
+void SysFSDirtyRatio::set_value(u32 new_value)
+{
+    g_dirty_ratio.store(new_value);
+}
+
+}
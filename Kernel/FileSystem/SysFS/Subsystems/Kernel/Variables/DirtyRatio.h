@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/UnsignedIntegerVariable.h>
+#include <Kernel/Library/LockRefPtr.h>
+
+namespace Kernel {
+
+class SysFSDirtyRatio final : public SysFSSystemUnsignedInteger {
+public:
+    virtual StringView name() const override { return "dirty_ratio"sv; }
+    static NonnullLockRefPtr<SysFSDirtyRatio> must_create(SysFSDirectory const&);
+
+private:
+    virtual u32 value() const override;
+    virtual u32 min_value() const override { return 1; }
+    virtual u32 max_value() const override { return 100; }
+    virtual void set_value(u32 new_value) override;
+
+    explicit SysFSDirtyRatio(SysFSDirectory const&);
+};
+
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/TCPCongestionControl.h>
+#include <Kernel/Net/TCPCongestionControl.h>
+#include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSTCPCongestionControl::SysFSTCPCongestionControl(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<SysFSTCPCongestionControl> SysFSTCPCongestionControl::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_lock_ref_if_nonnull(new (nothrow) SysFSTCPCongestionControl(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSTCPCongestionControl::try_generate(KBufferBuilder& builder)
+{
+    return builder.appendff("{}\n", TCPCongestionControl::algorithm_to_string_view(TCPCongestionControl::default_algorithm()));
+}
+
+ErrorOr<size_t> SysFSTCPCongestionControl::write_bytes(off_t, size_t count, UserOrKernelBuffer const& buffer, OpenFileDescription*)
+{
+    MutexLocker locker(m_refresh_lock);
+    char name[16] {};
+    if (count == 0 || count > sizeof(name))
+        return EINVAL;
+    TRY(buffer.read(name, count));
+
+    return Process::current().jail().with([&](auto& my_jail) -> ErrorOr<size_t> {
+        // Note: If we are in a jail, don't let the current process change the algorithm.
+        if (my_jail)
+            return EPERM;
+        auto algorithm = TCPCongestionControl::algorithm_from_string_view(StringView { name, count }.trim_whitespace());
+        if (!algorithm.has_value())
+            return EINVAL;
+        TCPCongestionControl::set_default_algorithm(algorithm.value());
+        return count;
+    });
+}
+
+ErrorOr<void> SysFSTCPCongestionControl::truncate(u64 size)
+{
+    if (size != 0)
+        return EPERM;
+    return {};
+}
+
+}
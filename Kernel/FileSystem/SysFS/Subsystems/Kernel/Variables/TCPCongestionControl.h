@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/GlobalInformation.h>
+#include <Kernel/Library/LockRefPtr.h>
+
+namespace Kernel {
+
+class SysFSTCPCongestionControl final : public SysFSGlobalInformation {
+public:
+    virtual StringView name() const override { return "tcp_congestion_control"sv; }
+    static NonnullLockRefPtr<SysFSTCPCongestionControl> must_create(SysFSDirectory const&);
+
+private:
+    explicit SysFSTCPCongestionControl(SysFSDirectory const&);
+
+    // ^SysFSGlobalInformation
+    virtual ErrorOr<void> try_generate(KBufferBuilder&) override;
+
+    // ^SysFSExposedComponent
+    virtual ErrorOr<size_t> write_bytes(off_t, size_t, UserOrKernelBuffer const&, OpenFileDescription*) override;
+    virtual mode_t permissions() const override { return 0644; }
+    virtual ErrorOr<void> truncate(u64) override;
+};
+
+}
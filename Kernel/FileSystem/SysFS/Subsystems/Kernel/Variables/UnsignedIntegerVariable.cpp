@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/StringView.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Variables/UnsignedIntegerVariable.h>
+#include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+ErrorOr<void> SysFSSystemUnsignedInteger::try_generate(KBufferBuilder& builder)
+{
+    return builder.appendff("{}\n", value());
+}
+
+ErrorOr<size_t> SysFSSystemUnsignedInteger::write_bytes(off_t, size_t count, UserOrKernelBuffer const& buffer, OpenFileDescription*)
+{
+    MutexLocker locker(m_refresh_lock);
+    // Note: We do all of this code before taking the spinlock because then we disable
+    // interrupts so page faults will not work.
+    char digits[11] {};
+    if (count == 0 || count > sizeof(digits))
+        return Error::from_errno(EINVAL);
+    TRY(buffer.read(digits, count));
+
+    return Process::current().jail().with([&](auto& my_jail) -> ErrorOr<size_t> {
+        // Note: If we are in a jail, don't let the current process to change the variable.
+        if (my_jail)
+            return Error::from_errno(EPERM);
+        auto new_value = StringView { digits, count }.trim_whitespace().to_uint();
+        if (!new_value.has_value() || new_value.value() < min_value() || new_value.value() > max_value())
+            return Error::from_errno(EINVAL);
+        set_value(new_value.value());
+        return count;
+    });
+}
+
+ErrorOr<void> SysFSSystemUnsignedInteger::truncate(u64 size)
+{
+    if (size != 0)
+        return EPERM;
+    return {};
+}
+
+}
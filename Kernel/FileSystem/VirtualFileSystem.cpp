@@ -14,6 +14,7 @@
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Devices/DeviceManagement.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/DirectoryEntryCache.h>
 #include <Kernel/FileSystem/FileBackedFileSystem.h>
 #include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -123,6 +124,34 @@ void VirtualFileSystem::sync_filesystems()
         fs.flush_writes();
 }
 
+size_t VirtualFileSystem::write_back_filesystems()
+{
+    NonnullLockRefPtrVector<FileSystem, 32> file_systems;
+    m_file_systems_list.with([&](auto const& list) {
+        for (auto& fs : list)
+            file_systems.append(fs);
+    });
+
+    size_t count = 0;
+    for (auto& fs : file_systems)
+        count += fs.write_back();
+    return count;
+}
+
+void VirtualFileSystem::release_cached_memory_of_filesystems()
+{
+    NonnullLockRefPtrVector<FileSystem, 32> file_systems;
+    m_file_systems_list.with([&](auto const& list) {
+        for (auto& fs : list)
+            file_systems.append(fs);
+    });
+
+    for (auto& fs : file_systems)
+        fs.release_cached_memory();
+
+    DirectoryEntryCache::the().release_all();
+}
+
 void VirtualFileSystem::lock_all_filesystems()
 {
     NonnullLockRefPtrVector<FileSystem, 32> file_systems;
@@ -141,6 +170,9 @@ ErrorOr<void> VirtualFileSystem::unmount(Custody& mountpoint_custody)
     auto custody_path = TRY(mountpoint_custody.try_serialize_absolute_path());
     dbgln("VirtualFileSystem: unmount called with inode {} on mountpoint {}", guest_inode.identifier(), custody_path->view());
 
+    // NOTE: Cached directory entries keep inodes of the file system in memory, which would make it look busy.
+    DirectoryEntryCache::the().invalidate_file_system(guest_inode.fsid());
+
     return m_mounts.with([&](auto& mounts) -> ErrorOr<void> {
         for (size_t i = 0; i < mounts.size(); ++i) {
             auto& mount = mounts[i];
@@ -1027,7 +1059,7 @@ ErrorOr<NonnullRefPtr<Custody>> VirtualFileSystem::resolve_path_without_veil(Cre
         }
 
         // Okay, let's look up this part.
-        auto child_or_error = parent.inode().lookup(part);
+        auto child_or_error = DirectoryEntryCache::the().lookup(parent.inode(), part);
         if (child_or_error.is_error()) {
             if (out_parent) {
                 // ENOENT with a non-null parent custody signals to caller that
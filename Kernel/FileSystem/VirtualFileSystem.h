@@ -78,6 +78,8 @@ public:
     InodeIdentifier root_inode_id() const;
 
     void sync_filesystems();
+    size_t write_back_filesystems();
+    void release_cached_memory_of_filesystems();
     void lock_all_filesystems();
 
     static void sync();
@@ -23,12 +23,14 @@ class File;
 class FATInode;
 class OpenFileDescription;
 class DisplayConnector;
+class EventPoll;
 class FileSystem;
 class FutexQueue;
 class IPv4Socket;
 class Inode;
 class InodeIdentifier;
 class InodeWatcher;
+class IORing;
 class Jail;
 class KBuffer;
 class KString;
@@ -7,9 +7,11 @@
 #include <AK/Assertions.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/PageDirectory.h>
+#include <Kernel/Arch/Processor.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Heap/Heap.h>
 #include <Kernel/Heap/kmalloc.h>
+#include <Kernel/InterruptDisabler.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/MemoryManager.h>
@@ -204,6 +206,62 @@ private:
     KmallocSlabBlock::List m_full_blocks;
 };
 
+// A magazine is a small stack of free slabs of a single size class that a
+// processor can allocate from and free to without taking the global heap lock.
+class KmallocMagazine {
+public:
+    static constexpr size_t capacity = 32;
+
+    bool is_empty() const { return m_count == 0; }
+    bool is_full() const { return m_count == capacity; }
+    size_t count() const { return m_count; }
+
+    void push(void* ptr)
+    {
+        VERIFY(!is_full());
+        m_slots[m_count++] = ptr;
+    }
+
+    void* pop()
+    {
+        VERIFY(!is_empty());
+        return m_slots[--m_count];
+    }
+
+private:
+    size_t m_count { 0 };
+    void* m_slots[capacity];
+};
+
+static constexpr size_t slabheap_count = 6;
+
+// Every processor keeps a "loaded" and a "previous" magazine per slabheap size class,
+// the previous magazine is always either completely full or completely empty.
+// Allocations pop from the loaded magazine and frees push onto it, swapping the
+// two when the loaded one runs dry (or overflows). Only when both are empty (or full)
+// do we take the global lock to refill (or drain) an entire magazine at once.
+struct KmallocPerProcessorData {
+    static ProcessorSpecificDataID processor_specific_data_id() { return ProcessorSpecificDataID::Kmalloc; }
+
+    struct SizeClassCache {
+        KmallocMagazine loaded;
+        KmallocMagazine previous;
+    };
+    SizeClassCache caches[slabheap_count];
+
+    // Set while this processor is in the middle of updating its magazines, so that
+    // any allocation that nests inside (e.g. while growing a slabheap) takes the slow path.
+    bool in_magazine_operation { false };
+    size_t nested_kfree_calls { 0 };
+
+    // These are only ever written by the owning processor, but read by anyone collecting stats.
+    Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> kmalloc_call_count { 0 };
+    Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> kfree_call_count { 0 };
+    Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> refill_count { 0 };
+    Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> drain_count { 0 };
+    Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> cached_bytes { 0 };
+};
+
 struct KmallocGlobalData {
     static constexpr size_t minimum_subheap_size = 1 * MiB;
 
@@ -236,6 +294,10 @@ struct KmallocGlobalData {
 
         // NOTE: This size calculation is a mirror of kmalloc_aligned(KmallocSlabBlock)
         if (size <= KmallocSlabBlock::block_size * 2 + sizeof(ptrdiff_t) + sizeof(size_t)) {
+            // Slabs sitting in any processor's magazines keep their blocks from being purged.
+            if (drain_all_processor_magazines())
+                dbgln_if(KMALLOC_DEBUG, "Kmalloc drained processor magazines to avoid expansion");
+
             // FIXME: We should propagate a freed pointer, to find the specific subheap it belonged to
             //        This would save us iterating over them in the next step and remove a recursion
             bool did_purge = false;
@@ -392,7 +454,36 @@ struct KmallocGlobalData {
 
     KmallocSubheap::List subheaps;
 
-    KmallocSlabheap slabheaps[6] = { 16, 32, 64, 128, 256, 512 };
+    KmallocSlabheap slabheaps[slabheap_count] = { 16, 32, 64, 128, 256, 512 };
+
+    Optional<size_t> slabheap_index_for_size(size_t size) const
+    {
+        for (size_t i = 0; i < slabheap_count; ++i) {
+            if (size <= slabheaps[i].slab_size())
+                return i;
+        }
+        return {};
+    }
+
+    void refill_magazine(size_t slabheap_index, KmallocMagazine& magazine)
+    {
+        VERIFY(s_lock.is_locked_by_current_processor());
+        auto& slabheap = slabheaps[slabheap_index];
+        while (!magazine.is_full())
+            magazine.push(slabheap.allocate());
+    }
+
+    void drain_magazine(size_t slabheap_index, KmallocMagazine& magazine)
+    {
+        // NOTE: Another processor may be draining on our behalf, see drain_all_processor_magazines().
+        VERIFY(s_lock.is_locked());
+        auto& slabheap = slabheaps[slabheap_index];
+        while (!magazine.is_empty())
+            slabheap.deallocate(magazine.pop());
+    }
+
+    bool drain_processor_magazines(KmallocPerProcessorData&);
+    bool drain_all_processor_magazines();
 
     bool expansion_in_progress { false };
 };
@@ -405,6 +496,130 @@ static size_t g_kfree_call_count;
 static size_t g_nested_kfree_calls;
 bool g_dump_kmalloc_stacks;
 
+static Array<KmallocPerProcessorData*, MAX_CPU_COUNT> s_per_processor_data;
+static Atomic<bool> s_per_processor_caches_enabled { false };
+
+static KmallocPerProcessorData* current_processor_data()
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    if (!s_per_processor_caches_enabled.load(AK::MemoryOrder::memory_order_relaxed))
+        return nullptr;
+    // NOTE: APs allocate a little before they set up their own magazines.
+    auto* data = Processor::current().get_specific<KmallocPerProcessorData>();
+    if (!data || data->in_magazine_operation)
+        return nullptr;
+    return data;
+}
+
+bool KmallocGlobalData::drain_processor_magazines(KmallocPerProcessorData& data)
+{
+    TemporaryChange change(data.in_magazine_operation, true);
+    bool did_drain = false;
+    for (size_t i = 0; i < slabheap_count; ++i) {
+        auto& cache = data.caches[i];
+        did_drain |= !cache.loaded.is_empty() || !cache.previous.is_empty();
+        drain_magazine(i, cache.loaded);
+        drain_magazine(i, cache.previous);
+    }
+    data.cached_bytes = 0;
+    return did_drain;
+}
+
+bool KmallocGlobalData::drain_all_processor_magazines()
+{
+    VERIFY(s_lock.is_locked_by_current_processor());
+
+    bool did_drain = false;
+    if (auto* data = current_processor_data())
+        did_drain = drain_processor_magazines(*data);
+
+#if ARCH(I386) || ARCH(X86_64)
+    if (!Processor::is_smp_enabled())
+        return did_drain;
+
+    // Magazines are only touched by their owner with interrupts disabled, so ask each
+    // processor to drain its own while we hold the lock and wait. It can only pick up the
+    // message with interrupts enabled or while spinning on a lock, and neither happens
+    // in the middle of a magazine update.
+    auto current_id = Processor::current_id();
+    for (u32 processor_id = 0; processor_id < Processor::count(); ++processor_id) {
+        if (processor_id == current_id)
+            continue;
+        auto* data = s_per_processor_data[processor_id];
+        if (!data || data->cached_bytes.load() == 0)
+            continue;
+        Processor::smp_unicast(
+            processor_id,
+            [&] {
+                if (!data->in_magazine_operation && drain_processor_magazines(*data))
+                    did_drain = true;
+            },
+            false);
+    }
+#endif
+
+    return did_drain;
+}
+
+static void* allocate_from_magazine(KmallocPerProcessorData& data, size_t slabheap_index)
+{
+    auto& cache = data.caches[slabheap_index];
+    auto slab_size = g_kmalloc_global->slabheaps[slabheap_index].slab_size();
+
+    if (cache.loaded.is_empty()) {
+        if (cache.previous.is_empty()) {
+            SpinlockLocker lock(s_lock);
+            TemporaryChange change(data.in_magazine_operation, true);
+            g_kmalloc_global->refill_magazine(slabheap_index, cache.loaded);
+            data.cached_bytes += cache.loaded.count() * slab_size;
+            ++data.refill_count;
+        } else {
+            swap(cache.loaded, cache.previous);
+        }
+    }
+
+    auto* ptr = cache.loaded.pop();
+    data.cached_bytes -= slab_size;
+    ++data.kmalloc_call_count;
+    memset(ptr, KMALLOC_SCRUB_BYTE, slab_size);
+    return ptr;
+}
+
+static void deallocate_to_magazine(KmallocPerProcessorData& data, size_t slabheap_index, void* ptr)
+{
+    VERIFY(g_kmalloc_global->is_valid_kmalloc_address(VirtualAddress { ptr }));
+
+    auto& cache = data.caches[slabheap_index];
+    auto slab_size = g_kmalloc_global->slabheaps[slabheap_index].slab_size();
+
+    if (cache.loaded.is_full()) {
+        if (cache.previous.is_full()) {
+            SpinlockLocker lock(s_lock);
+            TemporaryChange change(data.in_magazine_operation, true);
+            data.cached_bytes -= cache.previous.count() * slab_size;
+            g_kmalloc_global->drain_magazine(slabheap_index, cache.previous);
+            ++data.drain_count;
+        }
+        swap(cache.loaded, cache.previous);
+    }
+
+    memset(ptr, KFREE_SCRUB_BYTE, slab_size);
+    cache.loaded.push(ptr);
+    data.cached_bytes += slab_size;
+    ++data.kfree_call_count;
+}
+
+void kmalloc_enable_per_processor_caches()
+{
+    auto processor_id = Processor::current_id();
+    VERIFY(processor_id < MAX_CPU_COUNT);
+    VERIFY(!s_per_processor_data[processor_id]);
+
+    ProcessorSpecific<KmallocPerProcessorData>::initialize();
+    s_per_processor_data[processor_id] = Processor::current().get_specific<KmallocPerProcessorData>();
+    s_per_processor_caches_enabled.store(true, AK::MemoryOrder::memory_order_release);
+}
+
 void kmalloc_enable_expand()
 {
     g_kmalloc_global->enable_expansion();
@@ -426,15 +641,26 @@ void* kmalloc(size_t size)
         Processor::verify_no_spinlocks_held();
     }
 
-    SpinlockLocker lock(s_lock);
-    ++g_kmalloc_call_count;
-
-    if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
-        dbgln("kmalloc({})", size);
-        Kernel::dump_backtrace();
+    void* ptr = nullptr;
+    if (!g_dump_kmalloc_stacks) {
+        InterruptDisabler disabler;
+        auto* data = current_processor_data();
+        auto slabheap_index = g_kmalloc_global->slabheap_index_for_size(size);
+        if (data && slabheap_index.has_value())
+            ptr = allocate_from_magazine(*data, *slabheap_index);
     }
 
-    void* ptr = g_kmalloc_global->allocate(size);
+    if (!ptr) {
+        SpinlockLocker lock(s_lock);
+        ++g_kmalloc_call_count;
+
+        if (g_dump_kmalloc_stacks && Kernel::g_kernel_symbols_available) {
+            dbgln("kmalloc({})", size);
+            Kernel::dump_backtrace();
+        }
+
+        ptr = g_kmalloc_global->allocate(size);
+    }
 
     Thread* current_thread = Thread::current();
     if (!current_thread)
@@ -473,11 +699,7 @@ void kfree_sized(void* ptr, size_t size)
         Processor::verify_no_spinlocks_held();
     }
 
-    SpinlockLocker lock(s_lock);
-    ++g_kfree_call_count;
-    ++g_nested_kfree_calls;
-
-    if (g_nested_kfree_calls == 1) {
+    auto add_kfree_perf_event = [ptr] {
         Thread* current_thread = Thread::current();
         if (!current_thread)
             current_thread = Processor::idle_thread();
@@ -485,8 +707,28 @@ void kfree_sized(void* ptr, size_t size)
             VERIFY(current_thread->is_allocation_enabled());
             PerformanceManager::add_kfree_perf_event(*current_thread, 0, (FlatPtr)ptr);
         }
+    };
+
+    {
+        InterruptDisabler disabler;
+        auto* data = current_processor_data();
+        auto slabheap_index = g_kmalloc_global->slabheap_index_for_size(size);
+        if (data && slabheap_index.has_value()) {
+            if (++data->nested_kfree_calls == 1)
+                add_kfree_perf_event();
+            deallocate_to_magazine(*data, *slabheap_index, ptr);
+            --data->nested_kfree_calls;
+            return;
+        }
     }
 
+    SpinlockLocker lock(s_lock);
+    ++g_kfree_call_count;
+    ++g_nested_kfree_calls;
+
+    if (g_nested_kfree_calls == 1)
+        add_kfree_perf_event();
+
     g_kmalloc_global->deallocate(ptr, size);
     --g_nested_kfree_calls;
 }
@@ -587,4 +829,30 @@ void get_kmalloc_stats(kmalloc_stats& stats)
     stats.bytes_free = g_kmalloc_global->free_bytes();
     stats.kmalloc_call_count = g_kmalloc_call_count;
     stats.kfree_call_count = g_kfree_call_count;
+
+    // Slabs cached in per-processor magazines look allocated to the slabheaps, but are really free.
+    for (auto* data : s_per_processor_data) {
+        if (!data)
+            continue;
+        auto cached_bytes = min(data->cached_bytes.load(), stats.bytes_allocated);
+        stats.bytes_allocated -= cached_bytes;
+        stats.bytes_free += cached_bytes;
+        stats.kmalloc_call_count += data->kmalloc_call_count.load();
+        stats.kfree_call_count += data->kfree_call_count.load();
+    }
+}
+
+bool get_kmalloc_processor_stats(u32 processor_id, kmalloc_processor_stats& stats)
+{
+    if (processor_id >= MAX_CPU_COUNT)
+        return false;
+    auto* data = s_per_processor_data[processor_id];
+    if (!data)
+        return false;
+    stats.kmalloc_call_count = data->kmalloc_call_count.load();
+    stats.kfree_call_count = data->kfree_call_count.load();
+    stats.refill_count = data->refill_count.load();
+    stats.drain_count = data->drain_count.load();
+    stats.cached_bytes = data->cached_bytes.load();
+    return true;
 }
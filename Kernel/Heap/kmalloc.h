@@ -50,6 +50,17 @@ struct kmalloc_stats {
 };
 void get_kmalloc_stats(kmalloc_stats&);
 
+// Counters for the allocations served by a single processor's magazine caches,
+// these are already accounted for in the totals reported by get_kmalloc_stats().
+struct kmalloc_processor_stats {
+    size_t kmalloc_call_count;
+    size_t kfree_call_count;
+    size_t refill_count;
+    size_t drain_count;
+    size_t cached_bytes;
+};
+bool get_kmalloc_processor_stats(u32 processor_id, kmalloc_processor_stats&);
+
 extern bool g_dump_kmalloc_stacks;
 
 inline void* operator new(size_t, void* p) { return p; }
@@ -86,3 +97,4 @@ inline void kfree_aligned(void* ptr)
 size_t kmalloc_good_size(size_t);
 
 void kmalloc_enable_expand();
+void kmalloc_enable_per_processor_caches();
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Platform.h>
+#include <Kernel/Arch/InterruptManagement.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Interrupts/PCIIRQHandler.h>
+#if ARCH(I386) || ARCH(X86_64)
+#    include <Kernel/Arch/x86/common/Interrupts/APIC.h>
+#endif
+
+namespace Kernel {
+
+PCIIRQHandler::PCIIRQHandler(PCI::Device& device, u8 irq, Optional<u16> msix_table_entry)
+    : GenericInterruptHandler(irq, msix_table_entry.has_value())
+    , m_device(device)
+    , m_msix_table_entry(msix_table_entry)
+{
+    if (!is_message_signalled())
+        m_responsible_irq_controller = InterruptManagement::the().get_responsible_irq_controller(irq);
+    if (is_registered())
+        disable_irq();
+}
+
+PCIIRQHandler::~PCIIRQHandler() = default;
+
+StringView PCIIRQHandler::controller() const
+{
+    if (is_message_signalled())
+        return "MSI-X"sv;
+    return m_responsible_irq_controller->model();
+}
+
+bool PCIIRQHandler::eoi()
+{
+    dbgln_if(IRQ_DEBUG, "EOI IRQ {}", interrupt_number());
+    if (is_message_signalled()) {
+#if ARCH(I386) || ARCH(X86_64)
+        APIC::the().eoi();
+#else
+        TODO_AARCH64();
+#endif
+        return true;
+    }
+    m_responsible_irq_controller->eoi(*this);
+    return true;
+}
+
+void PCIIRQHandler::enable_irq()
+{
+    dbgln_if(IRQ_DEBUG, "Enable IRQ {}", interrupt_number());
+    if (!is_registered())
+        register_interrupt_handler();
+    if (is_message_signalled()) {
+        if (auto result = m_device.set_msix_table_entry_masked(m_msix_table_entry.value(), false); result.is_error())
+            dbgln("PCIIRQHandler: Failed to unmask MSI-X table entry {}: {}", m_msix_table_entry.value(), result.error());
+        return;
+    }
+    m_responsible_irq_controller->enable(*this);
+}
+
+void PCIIRQHandler::disable_irq()
+{
+    dbgln_if(IRQ_DEBUG, "Disable IRQ {}", interrupt_number());
+    if (is_message_signalled()) {
+        if (auto result = m_device.set_msix_table_entry_masked(m_msix_table_entry.value(), true); result.is_error())
+            dbgln("PCIIRQHandler: Failed to mask MSI-X table entry {}: {}", m_msix_table_entry.value(), result.error());
+        return;
+    }
+    m_responsible_irq_controller->disable(*this);
+}
+
+}
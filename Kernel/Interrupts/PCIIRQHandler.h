@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/Types.h>
+#include <Kernel/Arch/IRQController.h>
+#include <Kernel/Bus/PCI/Device.h>
+#include <Kernel/Interrupts/GenericInterruptHandler.h>
+#include <Kernel/Library/LockRefPtr.h>
+
+namespace Kernel {
+
+// An interrupt handler for a PCI device, which can either use the device's interrupt
+// pin (through whichever IRQ controller it is routed to) or one of its MSI-X vectors.
+class PCIIRQHandler : public GenericInterruptHandler {
+public:
+    virtual ~PCIIRQHandler();
+
+    virtual bool handle_interrupt(RegisterState const& regs) override { return handle_irq(regs); }
+    virtual bool handle_irq(RegisterState const&) = 0;
+
+    void enable_irq();
+    void disable_irq();
+
+    virtual bool eoi() override;
+
+    virtual HandlerType type() const override { return HandlerType::IRQHandler; }
+    virtual StringView purpose() const override { return "PCI IRQ Handler"sv; }
+    virtual StringView controller() const override;
+
+    virtual size_t sharing_devices_count() const override { return 0; }
+    virtual bool is_shared_handler() const override { return false; }
+    virtual bool is_sharing_with_others() const override { return false; }
+
+    bool is_message_signalled() const { return m_msix_table_entry.has_value(); }
+
+protected:
+    // If an MSI-X table entry is given, the interrupt number has to come from InterruptManagement::allocate_message_signalled_interrupt_number().
+    PCIIRQHandler(PCI::Device&, u8 irq, Optional<u16> msix_table_entry = {});
+
+private:
+    PCI::Device& m_device;
+    Optional<u16> m_msix_table_entry;
+    LockRefPtr<IRQController> m_responsible_irq_controller;
+};
+
+}
@@ -276,6 +276,18 @@ NonnullRefPtr<PhysicalPage> AnonymousVMObject::allocate_committed_page(Badge<Reg
     return m_unused_committed_pages->take_one();
 }
 
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> AnonymousVMObject::allocate_committed_huge_page(Badge<Region>)
+{
+    if (m_unused_committed_pages->page_count() < huge_page_size / PAGE_SIZE)
+        return ENOMEM;
+    return m_unused_committed_pages->take_huge_page();
+}
+
+void AnonymousVMObject::return_committed_huge_page(Badge<Region>, NonnullRefPtrVector<PhysicalPage>&& physical_pages)
+{
+    m_unused_committed_pages->return_huge_page(move(physical_pages));
+}
+
 ErrorOr<void> AnonymousVMObject::ensure_cow_map()
 {
     if (m_cow_map.is_null())
@@ -26,6 +26,8 @@ public:
     virtual ErrorOr<NonnullLockRefPtr<VMObject>> try_clone() override;
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> allocate_committed_page(Badge<Region>);
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_committed_huge_page(Badge<Region>);
+    void return_committed_huge_page(Badge<Region>, NonnullRefPtrVector<PhysicalPage>&&);
     PageFaultResponse handle_cow_fault(size_t, VirtualAddress);
     size_t cow_pages() const;
     bool should_cow(size_t page_index, bool) const;
@@ -551,6 +551,16 @@ PhysicalAddress MemoryManager::get_physical_address(PhysicalPage const& physical
     return PhysicalAddress((PhysicalPtr)physical_page_entry_index * PAGE_SIZE);
 }
 
+static bool is_huge_page_mapping(PageDirectoryEntry const& pde)
+{
+#if ARCH(I386) || ARCH(X86_64)
+    return pde.is_present() && pde.is_huge();
+#else
+    (void)pde;
+    return false;
+#endif
+}
+
 PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress vaddr)
 {
     VERIFY_INTERRUPTS_DISABLED();
@@ -561,7 +571,7 @@ PageTableEntry* MemoryManager::pte(PageDirectory& page_directory, VirtualAddress
 
     auto* pd = quickmap_pd(const_cast<PageDirectory&>(page_directory), page_directory_table_index);
     PageDirectoryEntry const& pde = pd[page_directory_index];
-    if (!pde.is_present())
+    if (!pde.is_present() || is_huge_page_mapping(pde))
         return nullptr;
 
     return &quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()))[page_table_index];
@@ -577,9 +587,10 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     auto& pde = pd[page_directory_index];
-    if (pde.is_present())
+    if (pde.is_present() && !is_huge_page_mapping(pde))
         return &quickmap_pt(PhysicalAddress(pde.page_table_base()))[page_table_index];
 
+    auto original_pde_value = pde.raw();
     bool did_purge = false;
     auto page_table_or_error = allocate_physical_page(ShouldZeroFill::Yes, &did_purge);
     if (page_table_or_error.is_error()) {
@@ -594,7 +605,24 @@ PageTableEntry* MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
         pd = quickmap_pd(page_directory, page_directory_table_index);
         VERIFY(&pde == &pd[page_directory_index]); // Sanity check
 
-        VERIFY(!pde.is_present()); // Should have not changed
+        VERIFY(pde.raw() == original_pde_value); // Should have not changed
+    }
+    if (is_huge_page_mapping(pde)) {
+        // Someone wants to change the mapping of a single page inside a huge page, so we have
+        // to split it up into a page table that maps the same physical pages in the same way.
+        auto huge_page_base = pde.page_table_base();
+        auto* page_table_entries = quickmap_pt(page_table->paddr());
+        for (size_t i = 0; i < huge_page_size / PAGE_SIZE; ++i) {
+            auto& pte = page_table_entries[i];
+            pte.set_physical_page_base(huge_page_base + i * PAGE_SIZE);
+            pte.set_cache_disabled(pde.is_cache_disabled());
+            pte.set_writable(pde.is_writable());
+            pte.set_execute_disabled(pde.is_execute_disabled());
+            pte.set_user_allowed(pde.is_user_allowed());
+            pte.set_present(true);
+        }
+        pde.clear();
+        flush_tlb(&page_directory, VirtualAddress(vaddr.get() & ~(huge_page_size - 1)), huge_page_size / PAGE_SIZE);
     }
     pde.set_page_table_base(page_table->paddr().get());
     pde.set_user_allowed(true);
@@ -618,6 +646,13 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
 
     auto* pd = quickmap_pd(page_directory, page_directory_table_index);
     PageDirectoryEntry& pde = pd[page_directory_index];
+    if (is_huge_page_mapping(pde)) {
+        // A huge page is only ever mapped by a region that covers all of it, so releasing
+        // any one of its pages means the whole huge page is going away. Its physical pages
+        // are owned by the VMObject, so there is no page table to free here.
+        pde.clear();
+        return;
+    }
     if (pde.is_present()) {
         auto* page_table = quickmap_pt(PhysicalAddress((FlatPtr)pde.page_table_base()));
         auto& pte = page_table[page_table_index];
@@ -641,6 +676,25 @@ void MemoryManager::release_pte(PageDirectory& page_directory, VirtualAddress va
     }
 }
 
+PageDirectoryEntry* MemoryManager::pde_for_huge_page(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    VERIFY_INTERRUPTS_DISABLED();
+    VERIFY(page_directory.get_lock().is_locked_by_current_processor());
+    VERIFY(!(vaddr.get() & (huge_page_size - 1)));
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x1ff;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    auto* pd = quickmap_pd(page_directory, page_directory_table_index);
+    auto& pde = pd[page_directory_index];
+    if (pde.is_present() && !is_huge_page_mapping(pde)) {
+        // The page table can only contain mappings of the region that is about to map the
+        // huge page over it, so it's safe to throw it away.
+        get_physical_page_entry(PhysicalAddress { pde.page_table_base() }).allocated.physical_page.unref();
+    }
+    pde.clear();
+    return &pde;
+}
+
 UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
 {
     ProcessorSpecific<MemoryManagerData>::initialize();
@@ -649,6 +703,8 @@ UNMAP_AFTER_INIT void MemoryManager::initialize(u32 cpu)
         new MemoryManager;
         kmalloc_enable_expand();
     }
+
+    kmalloc_enable_per_processor_caches();
 }
 
 Region* MemoryManager::kernel_region_from_vaddr(VirtualAddress address)
@@ -939,6 +995,45 @@ NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_physical_page(Badg
     return page.release_nonnull();
 }
 
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> MemoryManager::allocate_committed_huge_page(Badge<CommittedPhysicalPageSet>)
+{
+    size_t page_count = huge_page_size / PAGE_SIZE;
+    auto physical_pages = TRY(m_global_data.with([&](auto& global_data) -> ErrorOr<NonnullRefPtrVector<PhysicalPage>> {
+        VERIFY(global_data.system_memory_info.physical_pages_committed >= page_count);
+        for (auto& physical_region : global_data.physical_regions) {
+            auto physical_pages = physical_region.take_aligned_contiguous_free_pages(page_count);
+            if (!physical_pages.is_empty()) {
+                global_data.system_memory_info.physical_pages_committed -= page_count;
+                global_data.system_memory_info.physical_pages_used += page_count;
+                return physical_pages;
+            }
+        }
+        // Physical memory is too fragmented, the caller will fall back to regular pages.
+        return ENOMEM;
+    }));
+
+    for (auto& physical_page : physical_pages) {
+        InterruptDisabler disabler;
+        auto* ptr = quickmap_page(physical_page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+    }
+    return physical_pages;
+}
+
+void MemoryManager::deallocate_committed_huge_page(Badge<CommittedPhysicalPageSet>, NonnullRefPtrVector<PhysicalPage>&& physical_pages)
+{
+    size_t page_count = physical_pages.size();
+    m_global_data.with([&](auto& global_data) {
+        // Freeing the pages returns them to the uncommitted pool, so take them right back
+        // out of it before anyone else gets a chance to commit them.
+        physical_pages.clear();
+        VERIFY(global_data.system_memory_info.physical_pages_uncommitted >= page_count);
+        global_data.system_memory_info.physical_pages_uncommitted -= page_count;
+        global_data.system_memory_info.physical_pages_committed += page_count;
+    });
+}
+
 ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
     return m_global_data.with([&](auto&) -> ErrorOr<NonnullRefPtr<PhysicalPage>> {
@@ -1185,6 +1280,21 @@ NonnullRefPtr<PhysicalPage> CommittedPhysicalPageSet::take_one()
     return MM.allocate_committed_physical_page({}, MemoryManager::ShouldZeroFill::Yes);
 }
 
+ErrorOr<NonnullRefPtrVector<PhysicalPage>> CommittedPhysicalPageSet::take_huge_page()
+{
+    VERIFY(m_page_count >= huge_page_size / PAGE_SIZE);
+    auto physical_pages = TRY(MM.allocate_committed_huge_page({}));
+    m_page_count -= huge_page_size / PAGE_SIZE;
+    return physical_pages;
+}
+
+void CommittedPhysicalPageSet::return_huge_page(NonnullRefPtrVector<PhysicalPage>&& physical_pages)
+{
+    VERIFY(physical_pages.size() == huge_page_size / PAGE_SIZE);
+    MM.deallocate_committed_huge_page({}, move(physical_pages));
+    m_page_count += huge_page_size / PAGE_SIZE;
+}
+
 void CommittedPhysicalPageSet::uncommit_one()
 {
     VERIFY(m_page_count > 0);
@@ -1224,4 +1334,10 @@ MemoryManager::SystemMemoryInfo MemoryManager::get_system_memory_info()
         return global_data.system_memory_info;
     });
 }
+
+bool MemoryManager::is_low_on_physical_memory()
+{
+    auto info = get_system_memory_info();
+    return info.physical_pages_uncommitted < info.physical_pages / 16;
+}
 }
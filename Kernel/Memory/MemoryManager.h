@@ -32,6 +32,9 @@ namespace Kernel::Memory {
 
 ErrorOr<FlatPtr> page_round_up(FlatPtr x);
 
+// The size of the pages that can be mapped with a single page directory entry.
+inline constexpr size_t huge_page_size = 2 * MiB;
+
 constexpr FlatPtr page_round_down(FlatPtr x)
 {
     return ((FlatPtr)(x)) & ~(PAGE_SIZE - 1);
@@ -117,6 +120,11 @@ public:
     size_t page_count() const { return m_page_count; }
 
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
+    // Takes a physically contiguous, naturally aligned run of pages that can be mapped as one huge page.
+    // This may fail if physical memory is too fragmented, in which case no pages are taken.
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> take_huge_page();
+    // Frees a huge page that was taken but never used, and puts its pages back into the set.
+    void return_huge_page(NonnullRefPtrVector<PhysicalPage>&&);
     void uncommit_one();
 
     void operator=(CommittedPhysicalPageSet&&) = delete;
@@ -167,6 +175,8 @@ public:
     void uncommit_physical_pages(Badge<CommittedPhysicalPageSet>, size_t page_count);
 
     NonnullRefPtr<PhysicalPage> allocate_committed_physical_page(Badge<CommittedPhysicalPageSet>, ShouldZeroFill = ShouldZeroFill::Yes);
+    ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_committed_huge_page(Badge<CommittedPhysicalPageSet>);
+    void deallocate_committed_huge_page(Badge<CommittedPhysicalPageSet>, NonnullRefPtrVector<PhysicalPage>&&);
     ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_physical_page(ShouldZeroFill = ShouldZeroFill::Yes, bool* did_purge = nullptr);
     ErrorOr<NonnullRefPtrVector<PhysicalPage>> allocate_contiguous_physical_pages(size_t size);
     void deallocate_physical_page(PhysicalAddress);
@@ -191,6 +201,9 @@ public:
 
     SystemMemoryInfo get_system_memory_info();
 
+    // Caches should stop growing, and start giving memory back, once this returns true.
+    bool is_low_on_physical_memory();
+
     template<IteratorFunction<VMObject&> Callback>
     static void for_each_vmobject(Callback callback)
     {
@@ -276,6 +289,7 @@ private:
         No
     };
     void release_pte(PageDirectory&, VirtualAddress, IsLastPTERelease);
+    PageDirectoryEntry* pde_for_huge_page(PageDirectory&, VirtualAddress);
 
     // NOTE: These are outside of GlobalData as they are only assigned on startup,
     //       and then never change. Atomic ref-counting covers that case without
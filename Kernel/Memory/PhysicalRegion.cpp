@@ -103,6 +103,45 @@ NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_contiguous_free_pages(siz
     return physical_pages;
 }
 
+NonnullRefPtrVector<PhysicalPage> PhysicalRegion::take_aligned_contiguous_free_pages(size_t count)
+{
+    // NOTE: The buddy allocator only aligns blocks relative to the base of their zone,
+    //       which is not necessarily aligned to the size of the block. For zones like that,
+    //       we allocate a block twice the size and give back the parts outside the aligned run.
+    VERIFY(is_power_of_two(count));
+    auto order = count_trailing_zeroes(count);
+    auto alignment = count * PAGE_SIZE;
+
+    for (auto& zone : m_usable_zones) {
+        bool is_zone_aligned = (zone.base().get() & (alignment - 1)) == 0;
+        auto block_base = zone.allocate_block(is_zone_aligned ? order : order + 1);
+        if (!block_base.has_value())
+            continue;
+
+        PhysicalPtr aligned_base = (block_base.value().get() + alignment - 1) & ~static_cast<PhysicalPtr>(alignment - 1);
+        if (!is_zone_aligned) {
+            auto block_end = block_base.value().get() + 2 * alignment;
+            for (auto paddr = block_base.value().get(); paddr < aligned_base; paddr += PAGE_SIZE)
+                zone.deallocate_block(PhysicalAddress(paddr), 0);
+            for (auto paddr = aligned_base + alignment; paddr < block_end; paddr += PAGE_SIZE)
+                zone.deallocate_block(PhysicalAddress(paddr), 0);
+        }
+
+        if (zone.is_empty()) {
+            // We've exhausted this zone, move it to the full zones list.
+            m_full_zones.append(zone);
+        }
+
+        NonnullRefPtrVector<PhysicalPage> physical_pages;
+        physical_pages.ensure_capacity(count);
+        for (size_t i = 0; i < count; ++i)
+            physical_pages.append(PhysicalPage::create(PhysicalAddress(aligned_base).offset(i * PAGE_SIZE)));
+        return physical_pages;
+    }
+
+    return {};
+}
+
 RefPtr<PhysicalPage> PhysicalRegion::take_free_page()
 {
     if (m_usable_zones.is_empty())
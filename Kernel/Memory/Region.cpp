@@ -5,6 +5,7 @@
  */
 
 #include <AK/Memory.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <AK/StringView.h>
 #include <Kernel/Arch/PageDirectory.h>
 #include <Kernel/Arch/PageFault.h>
@@ -23,6 +24,27 @@
 
 namespace Kernel::Memory {
 
+// The number of pages around a faulting page that get mapped in along with it.
+static constexpr size_t fault_around_page_count = 16;
+
+struct FaultAroundWindow {
+    size_t first_page_index { 0 };
+    size_t end_page_index { 0 };
+};
+
+// NOTE: The window is aligned in the virtual address space, so all of its pages share the
+//       page table of the faulting page and mapping them never needs to allocate anything.
+static FaultAroundWindow fault_around_window(Region const& region, size_t page_index)
+{
+    constexpr FlatPtr window_size = fault_around_page_count * PAGE_SIZE;
+    auto window_base = region.vaddr_from_page_index(page_index).get() & ~(window_size - 1);
+    auto window_end = window_base + window_size;
+    return {
+        .first_page_index = window_base < region.vaddr().get() ? 0 : region.page_index_from_address(VirtualAddress(window_base)),
+        .end_page_index = min(region.page_count(), (window_end - region.vaddr().get()) / PAGE_SIZE),
+    };
+}
+
 Region::Region()
     : m_range(VirtualRange({}, 0))
 {
@@ -109,6 +131,7 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
         region->set_mmap(m_mmap, m_mmapped_from_readable, m_mmapped_from_writable);
         region->set_shared(m_shared);
         region->set_syscall_region(is_syscall_region());
+        region->set_wants_huge_pages(m_wants_huge_pages);
         return region;
     }
 
@@ -134,6 +157,7 @@ ErrorOr<NonnullOwnPtr<Region>> Region::try_clone()
     }
     clone_region->set_syscall_region(is_syscall_region());
     clone_region->set_mmap(m_mmap, m_mmapped_from_readable, m_mmapped_from_writable);
+    clone_region->set_wants_huge_pages(m_wants_huge_pages);
     return clone_region;
 }
 
@@ -262,6 +286,24 @@ bool Region::remap_vmobject_page(size_t page_index, NonnullRefPtr<PhysicalPage>
     return success;
 }
 
+void Region::map_huge_page_impl(size_t page_index, PhysicalPage const& first_page, bool writable)
+{
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+
+    auto page_vaddr = vaddr_from_page_index(page_index);
+    bool user_allowed = page_vaddr.get() >= USER_RANGE_BASE && is_user_address(page_vaddr);
+
+    auto* pde = MM.pde_for_huge_page(*m_page_directory, page_vaddr);
+    pde->set_page_table_base(first_page.paddr().get());
+    pde->set_huge(true);
+    pde->set_cache_disabled(!m_cacheable);
+    pde->set_writable(writable);
+    if (Processor::current().has_nx())
+        pde->set_execute_disabled(!is_executable());
+    pde->set_user_allowed(user_allowed);
+    pde->set_present(true);
+}
+
 void Region::unmap(ShouldFlushTLB should_flush_tlb)
 {
     if (!m_page_directory)
@@ -408,6 +450,13 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
     if (current_thread != nullptr)
         current_thread->did_zero_fault();
 
+#if ARCH(I386) || ARCH(X86_64)
+    if (m_wants_huge_pages && page_in_slot_at_time_of_fault.is_lazy_committed_page()) {
+        if (auto response = handle_huge_zero_fault(page_index_in_region); response.has_value())
+            return response.release_value();
+    }
+#endif
+
     RefPtr<PhysicalPage> new_physical_page;
 
     if (page_in_slot_at_time_of_fault.is_lazy_committed_page()) {
@@ -443,9 +492,129 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
         dmesgln("MM: handle_zero_fault was unable to allocate a page table to map {}", new_physical_page);
         return PageFaultResponse::OutOfMemory;
     }
+
+    if (!already_handled && page_in_slot_at_time_of_fault.is_lazy_committed_page())
+        fault_around_zero_pages(page_index_in_region);
     return PageFaultResponse::Continue;
 }
 
+Optional<PageFaultResponse> Region::handle_huge_zero_fault(size_t page_index_in_region)
+{
+    auto huge_page_vaddr = VirtualAddress(vaddr_from_page_index(page_index_in_region).get() & ~(huge_page_size - 1));
+    if (huge_page_vaddr < vaddr() || huge_page_vaddr.get() + huge_page_size > vaddr().get() + size())
+        return {};
+
+    auto first_page_index = page_index_from_address(huge_page_vaddr);
+    constexpr size_t page_count_in_huge_page = huge_page_size / PAGE_SIZE;
+    auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject());
+
+    auto all_pages_are_lazy_committed = [&] {
+        for (size_t i = 0; i < page_count_in_huge_page; ++i) {
+            if (!physical_page_slot(first_page_index + i)->is_lazy_committed_page())
+                return false;
+        }
+        return true;
+    };
+
+    // Zeroing 2 MiB takes a while, so don't hold up everyone else faulting on this VMObject meanwhile.
+    // This unlocked check is only a hint; we look again once we hold the lock.
+    if (!all_pages_are_lazy_committed())
+        return {};
+
+    auto physical_pages_or_error = anonymous_vmobject.allocate_committed_huge_page({});
+    if (physical_pages_or_error.is_error()) {
+        dbgln_if(PAGE_FAULT_DEBUG, "handle_huge_zero_fault: No huge page available, falling back to regular pages");
+        return {};
+    }
+    auto physical_pages = physical_pages_or_error.release_value();
+
+    SpinlockLocker vmobject_locker(anonymous_vmobject.m_lock);
+    if (!all_pages_are_lazy_committed()) {
+        // Another fault got to some of these pages first, so let the regular path map what's there now.
+        vmobject_locker.unlock();
+        anonymous_vmobject.return_committed_huge_page({}, move(physical_pages));
+        return {};
+    }
+
+    bool needs_individual_mappings = false;
+    for (size_t i = 0; i < page_count_in_huge_page; ++i) {
+        physical_page_slot(first_page_index + i) = physical_pages.ptr_at(i);
+        if (should_cow(first_page_index + i))
+            needs_individual_mappings = true;
+    }
+    dbgln_if(PAGE_FAULT_DEBUG, "      >> ALLOCATED HUGE {}", physical_pages[0].paddr());
+
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    if (needs_individual_mappings) {
+        // Some of the pages still have to be copied on write (we were forked before they were
+        // ever touched), so they can't share a single writable mapping with the others.
+        for (size_t i = 0; i < page_count_in_huge_page; ++i) {
+            if (!map_individual_page_impl(first_page_index + i, physical_pages.ptr_at(i)))
+                return PageFaultResponse::OutOfMemory;
+        }
+    } else {
+        map_huge_page_impl(first_page_index, physical_pages[0], is_writable());
+    }
+    MemoryManager::flush_tlb(m_page_directory, huge_page_vaddr, page_count_in_huge_page);
+    return PageFaultResponse::Continue;
+}
+
+void Region::fault_around_zero_pages(size_t page_index_in_region)
+{
+    auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject());
+    auto window = fault_around_window(*this, page_index_in_region);
+
+    // Pages that are already committed to the VMObject cost us nothing but zeroing them,
+    // so we might as well do that for the neighbours of the faulting page right away.
+    SpinlockLocker vmobject_locker(anonymous_vmobject.m_lock);
+    u32 populated_pages = 0;
+    for (auto i = window.first_page_index; i < window.end_page_index; ++i) {
+        if (i == page_index_in_region)
+            continue;
+        auto& page_slot = physical_page_slot(i);
+        if (!page_slot->is_lazy_committed_page())
+            continue;
+        page_slot = anonymous_vmobject.allocate_committed_page({});
+        populated_pages |= 1u << (i - window.first_page_index);
+    }
+    if (!populated_pages)
+        return;
+
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    for (auto i = window.first_page_index; i < window.end_page_index; ++i) {
+        if (populated_pages & (1u << (i - window.first_page_index)))
+            VERIFY(map_individual_page_impl(i, physical_page_slot(i)));
+    }
+    MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(window.first_page_index), window.end_page_index - window.first_page_index);
+}
+
+void Region::fault_around_inode_pages(size_t page_index_in_region)
+{
+    // Readers that jump around are unlikely to touch the neighbouring pages any time soon.
+    if (m_readahead_state.with([](auto& state) { return state.mode(); }) == ReadaheadState::Mode::Random)
+        return;
+
+    auto window = fault_around_window(*this, page_index_in_region);
+    bool did_map_any_page = false;
+
+    SpinlockLocker vmobject_locker(vmobject().m_lock);
+    SpinlockLocker page_lock(m_page_directory->get_lock());
+    for (auto i = window.first_page_index; i < window.end_page_index; ++i) {
+        if (i == page_index_in_region)
+            continue;
+        auto const& page = physical_page_slot(i);
+        if (!page)
+            continue;
+        auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(i));
+        if (!pte || pte->is_present())
+            continue;
+        VERIFY(map_individual_page_impl(i, page));
+        did_map_any_page = true;
+    }
+    if (did_map_any_page)
+        MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(window.first_page_index), window.end_page_index - window.first_page_index);
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     auto current_thread = Thread::current();
@@ -462,6 +631,11 @@ PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
     return response;
 }
 
+void Region::set_readahead_mode(ReadaheadState::Mode mode)
+{
+    m_readahead_state.with([&](auto& state) { state.set_mode(mode); });
+}
+
 PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
 {
     VERIFY(vmobject().is_inode());
@@ -479,6 +653,8 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
             dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Page faulted in by someone else before reading, remapping.");
             if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
                 return PageFaultResponse::OutOfMemory;
+            locker.unlock();
+            fault_around_inode_pages(page_index_in_region);
             return PageFaultResponse::Continue;
         }
     }
@@ -511,6 +687,10 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
         memset(page_buffer + nread, 0, PAGE_SIZE - nread);
     }
 
+    auto readahead = m_readahead_state.with([&](auto& state) { return state.did_access(page_index_in_vmobject * PAGE_SIZE, PAGE_SIZE); });
+    if (readahead.has_value())
+        inode.prefetch(readahead->offset, readahead->length);
+
     // Allocate a new physical page, and copy the read inode contents into it.
     auto new_physical_page_or_error = MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No);
     if (new_physical_page_or_error.is_error()) {
@@ -535,6 +715,8 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
             dbgln_if(PAGE_FAULT_DEBUG, "handle_inode_fault: Page faulted in by someone else, remapping.");
             if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
                 return PageFaultResponse::OutOfMemory;
+            locker.unlock();
+            fault_around_inode_pages(page_index_in_region);
             return PageFaultResponse::Continue;
         }
 
@@ -544,6 +726,7 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
         return PageFaultResponse::OutOfMemory;
 
+    fault_around_inode_pages(page_index_in_region);
     return PageFaultResponse::Continue;
 }
 
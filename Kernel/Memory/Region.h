@@ -10,9 +10,11 @@
 #include <AK/EnumBits.h>
 #include <AK/IntrusiveList.h>
 #include <AK/IntrusiveRedBlackTree.h>
+#include <Kernel/FileSystem/ReadaheadState.h>
 #include <Kernel/Forward.h>
 #include <Kernel/KString.h>
 #include <Kernel/Library/LockWeakable.h>
+#include <Kernel/Locking/SpinlockProtected.h>
 #include <Kernel/Memory/PageFaultResponse.h>
 #include <Kernel/Memory/VirtualRange.h>
 #include <Kernel/Sections.h>
@@ -203,6 +205,13 @@ public:
     [[nodiscard]] bool mmapped_from_readable() const { return m_mmapped_from_readable; }
     [[nodiscard]] bool mmapped_from_writable() const { return m_mmapped_from_writable; }
 
+    void set_readahead_mode(ReadaheadState::Mode);
+
+    // Anonymous regions that want huge pages get them mapped in on zero faults whenever a
+    // huge page sized and aligned chunk of the region is untouched, and memory allows it.
+    [[nodiscard]] bool wants_huge_pages() const { return m_wants_huge_pages; }
+    void set_wants_huge_pages(bool wants_huge_pages) { m_wants_huge_pages = wants_huge_pages; }
+
 private:
     Region();
     Region(NonnullLockRefPtr<VMObject>, size_t offset_in_vmobject, OwnPtr<KString>, Region::Access access, Cacheable, bool shared);
@@ -221,9 +230,14 @@ private:
     [[nodiscard]] PageFaultResponse handle_cow_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_inode_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_zero_fault(size_t page_index, PhysicalPage& page_in_slot_at_time_of_fault);
+    [[nodiscard]] Optional<PageFaultResponse> handle_huge_zero_fault(size_t page_index);
+
+    void fault_around_inode_pages(size_t page_index);
+    void fault_around_zero_pages(size_t page_index);
 
     [[nodiscard]] bool map_individual_page_impl(size_t page_index);
     [[nodiscard]] bool map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage>);
+    void map_huge_page_impl(size_t page_index, PhysicalPage const& first_page, bool writable);
 
     LockRefPtr<PageDirectory> m_page_directory;
     VirtualRange m_range;
@@ -239,6 +253,9 @@ private:
     bool m_write_combine : 1 { false };
     bool m_mmapped_from_readable : 1 { false };
     bool m_mmapped_from_writable : 1 { false };
+    bool m_wants_huge_pages : 1 { false };
+
+    SpinlockProtected<ReadaheadState> m_readahead_state { LockRank::None };
 
     IntrusiveRedBlackTreeNode<FlatPtr, Region, RawPtr<Region>> m_tree_node;
     IntrusiveListNode<Region> m_vmobject_list_node;
@@ -187,6 +187,34 @@ PortAllocationResult IPv4Socket::allocate_local_port_if_needed()
     return { m_local_port, true };
 }
 
+RoutingDecision IPv4Socket::route_to_peer(AllowUsingGateway allow_using_gateway)
+{
+    auto through = bound_interface();
+    // Read the generation first, so that a change while we're routing makes us route again next time.
+    auto generation = routing_generation();
+    auto cached_decision = m_cached_route.with([&](auto const& cached_route) -> Optional<RoutingDecision> {
+        if (!cached_route.has_value() || cached_route->generation != generation)
+            return {};
+        if (cached_route->peer_address != m_peer_address || cached_route->local_address != m_local_address)
+            return {};
+        if (cached_route->through != through || cached_route->allow_using_gateway != allow_using_gateway)
+            return {};
+        return cached_route->decision;
+    });
+    if (cached_decision.has_value() && cached_decision->adapter->link_up())
+        return cached_decision.release_value();
+
+    auto routing_decision = route_to(m_peer_address, m_local_address, through, allow_using_gateway);
+    // Failures aren't remembered, an ARP response or a link coming up may change them at any moment.
+    m_cached_route.with([&](auto& cached_route) {
+        if (routing_decision.is_zero())
+            cached_route.clear();
+        else
+            cached_route = CachedRoute { routing_decision, m_peer_address, m_local_address, move(through), allow_using_gateway, generation };
+    });
+    return routing_decision;
+}
+
 ErrorOr<size_t> IPv4Socket::sendto(OpenFileDescription&, UserOrKernelBuffer const& data, size_t data_length, [[maybe_unused]] int flags, Userspace<sockaddr const*> addr, socklen_t addr_length)
 {
     MutexLocker locker(mutex());
@@ -211,7 +239,7 @@ ErrorOr<size_t> IPv4Socket::sendto(OpenFileDescription&, UserOrKernelBuffer cons
         return set_so_error(EPIPE);
 
     auto allow_using_gateway = ((flags & MSG_DONTROUTE) || m_routing_disabled) ? AllowUsingGateway::No : AllowUsingGateway::Yes;
-    auto routing_decision = route_to(m_peer_address, m_local_address, bound_interface(), allow_using_gateway);
+    auto routing_decision = route_to_peer(allow_using_gateway);
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
 
@@ -472,6 +500,22 @@ bool IPv4Socket::did_receive(IPv4Address const& source_address, u16 source_port,
     return true;
 }
 
+ErrorOr<void> IPv4Socket::try_add_statistics(JsonObjectSerializer<KBufferBuilder>& object) const
+{
+    auto local_address = TRY(m_local_address.to_string());
+    TRY(object.add("local_address"sv, local_address->view()));
+    TRY(object.add("local_port"sv, m_local_port));
+    auto peer_address = TRY(m_peer_address.to_string());
+    TRY(object.add("peer_address"sv, peer_address->view()));
+    TRY(object.add("peer_port"sv, m_peer_port));
+    TRY(object.add("bytes_received"sv, m_bytes_received));
+    if (m_buffer_mode == BufferMode::Bytes)
+        TRY(object.add("receive_queue_size"sv, m_receive_buffer ? m_receive_buffer->immediately_readable() : 0));
+    else
+        TRY(object.add("receive_queue_packets"sv, m_receive_queue.size()));
+    return {};
+}
+
 ErrorOr<NonnullOwnPtr<KString>> IPv4Socket::pseudo_path(OpenFileDescription const&) const
 {
     if (m_role == Role::None)
@@ -7,12 +7,15 @@
 #pragma once
 
 #include <AK/HashMap.h>
+#include <AK/JsonObjectSerializer.h>
 #include <AK/SinglyLinkedListWithCount.h>
 #include <Kernel/DoubleBuffer.h>
 #include <Kernel/KBuffer.h>
+#include <Kernel/KBufferBuilder.h>
 #include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/IPv4SocketTuple.h>
+#include <Kernel/Net/Routing.h>
 #include <Kernel/Net/Socket.h>
 
 namespace Kernel {
@@ -63,6 +66,9 @@ public:
 
     ErrorOr<NonnullOwnPtr<KString>> pseudo_path(OpenFileDescription const& description) const override;
 
+    // Adds the addresses and counters of this socket to a JSON object, for SysFS and ProcFS.
+    virtual ErrorOr<void> try_add_statistics(JsonObjectSerializer<KBufferBuilder>&) const;
+
     u8 type_of_service() const { return m_type_of_service; }
     u8 ttl() const { return m_ttl; }
 
@@ -78,6 +84,9 @@ protected:
 
     PortAllocationResult allocate_local_port_if_needed();
 
+    // Like route_to() to our peer, but remembers the decision until the routing tables change.
+    RoutingDecision route_to_peer(AllowUsingGateway = AllowUsingGateway::Yes);
+
     virtual ErrorOr<void> protocol_bind() { return {}; }
     virtual ErrorOr<void> protocol_listen([[maybe_unused]] bool did_allocate_port) { return {}; }
     virtual ErrorOr<size_t> protocol_receive(ReadonlyBytes /* raw_ipv4_packet */, UserOrKernelBuffer&, size_t, int) { return ENOTIMPL; }
@@ -94,6 +103,7 @@ protected:
 
     static ErrorOr<NonnullOwnPtr<DoubleBuffer>> try_create_receive_buffer();
     void drop_receive_buffer();
+    size_t receive_buffer_space() const { return m_receive_buffer ? m_receive_buffer->space_for_writing() : 0; }
 
 private:
     virtual bool is_ipv4() const override { return true; }
@@ -106,6 +116,16 @@ private:
     IPv4Address m_local_address;
     IPv4Address m_peer_address;
 
+    struct CachedRoute {
+        RoutingDecision decision;
+        IPv4Address peer_address;
+        IPv4Address local_address;
+        LockRefPtr<NetworkAdapter> through;
+        AllowUsingGateway allow_using_gateway;
+        u32 generation;
+    };
+    SpinlockProtected<Optional<CachedRoute>> m_cached_route { LockRank::None };
+
     Vector<IPv4Address> m_multicast_memberships;
     bool m_multicast_loop { true };
 
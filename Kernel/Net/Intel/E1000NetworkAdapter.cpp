@@ -121,6 +121,9 @@ namespace Kernel {
 #define INTERRUPT_TXD_LOW (1 << 15)
 #define INTERRUPT_SRPD (1 << 16)
 
+// The interrupts that tell us there are packets waiting in the receive ring.
+static constexpr u32 receive_interrupts = INTERRUPT_RXT0 | INTERRUPT_RXO;
+
 // https://www.intel.com/content/dam/doc/manual/pci-pci-x-family-gbe-controllers-software-dev-manual.pdf Section 5.2
 UNMAP_AFTER_INIT static bool is_valid_device_id(u16 device_id)
 {
@@ -187,8 +190,10 @@ UNMAP_AFTER_INIT void E1000NetworkAdapter::setup_link()
 
 UNMAP_AFTER_INIT void E1000NetworkAdapter::setup_interrupts()
 {
-    out32(REG_INTERRUPT_RATE, 6000); // Interrupt rate of 1.536 milliseconds
-    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | INTERRUPT_RXT0 | INTERRUPT_RXO);
+    // The interval is in units of 256 nanoseconds. Under load we poll instead of taking interrupts anyway,
+    // so this mostly bounds the rate at which the first packet of a burst can interrupt us.
+    out32(REG_INTERRUPT_RATE, 1'000'000'000 / (256 * max_interrupts_per_second));
+    out32(REG_INTERRUPT_MASK_SET, INTERRUPT_LSC | receive_interrupts);
     in32(REG_INTERRUPT_CAUSE_READ);
     enable_irq();
 }
@@ -250,13 +255,21 @@ bool E1000NetworkAdapter::handle_irq(RegisterState const&)
     if (status & INTERRUPT_RXO) {
         dbgln_if(E1000_DEBUG, "E1000: RX buffer overrun");
     }
-    if (status & INTERRUPT_RXT0) {
-        receive();
+    if (status & receive_interrupts) {
+        // Stop the interrupts for now, and let the NetworkTask poll the ring until it's drained.
+        out32(REG_INTERRUPT_MASK_CLEAR, receive_interrupts);
+        if (!try_schedule_poll()) {
+            receive(number_of_rx_descriptors);
+            out32(REG_INTERRUPT_MASK_SET, receive_interrupts);
+        }
     }
 
     m_wait_queue.wake_all();
 
-    out32(REG_INTERRUPT_CAUSE_READ, 0xffffffff);
+    // NOTE: Reading the cause register above already cleared it, so this write doesn't acknowledge anything.
+    //       Receive events that come in while we're polling set their cause bits again even though they're
+    //       masked, which is why unmasking them afterwards raises a new interrupt.
+    out32(REG_INTERRUPT_CAUSE_READ, status);
     return true;
 }
 
@@ -421,11 +434,12 @@ void E1000NetworkAdapter::send_raw(ReadonlyBytes payload)
     dbgln_if(E1000_DEBUG, "E1000: Sent packet, status is now {:#02x}!", (u8)descriptor.status);
 }
 
-void E1000NetworkAdapter::receive()
+size_t E1000NetworkAdapter::receive(size_t budget)
 {
     auto* rx_descriptors = (e1000_tx_desc*)m_rx_descriptors_region->vaddr().as_ptr();
     u32 rx_current;
-    for (;;) {
+    size_t received = 0;
+    while (received < budget) {
         rx_current = in32(REG_RXDESCTAIL) % number_of_rx_descriptors;
         rx_current = (rx_current + 1) % number_of_rx_descriptors;
         if (!(rx_descriptors[rx_current].status & 1))
@@ -437,7 +451,19 @@ void E1000NetworkAdapter::receive()
         did_receive({ buffer, length });
         rx_descriptors[rx_current].status = 0;
         out32(REG_RXDESCTAIL, rx_current);
+        ++received;
     }
+    return received;
+}
+
+size_t E1000NetworkAdapter::poll_receive(size_t budget)
+{
+    return receive(budget);
+}
+
+void E1000NetworkAdapter::enable_receive_interrupts()
+{
+    out32(REG_INTERRUPT_MASK_SET, receive_interrupts);
 }
 
 i32 E1000NetworkAdapter::link_speed()
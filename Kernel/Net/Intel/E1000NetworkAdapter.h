@@ -77,9 +77,12 @@ protected:
     u16 in16(u16 address);
     u32 in32(u16 address);
 
-    void receive();
+    size_t receive(size_t budget);
+    virtual size_t poll_receive(size_t budget) override;
+    virtual void enable_receive_interrupts() override;
 
     static constexpr size_t number_of_rx_descriptors = 256;
+    static constexpr u32 max_interrupts_per_second = 8000;
     static constexpr size_t number_of_tx_descriptors = 256;
 
     NonnullOwnPtr<IOWindow> m_registers_io_window;
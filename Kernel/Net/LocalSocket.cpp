@@ -45,14 +45,36 @@ ErrorOr<void> LocalSocket::try_for_each(Function<ErrorOr<void>(LocalSocket const
 
 ErrorOr<NonnullLockRefPtr<LocalSocket>> LocalSocket::try_create(int type)
 {
-    auto client_buffer = TRY(DoubleBuffer::try_create("LocalSocket: Client buffer"sv));
-    auto server_buffer = TRY(DoubleBuffer::try_create("LocalSocket: Server buffer"sv));
-    return adopt_nonnull_lock_ref_or_enomem(new (nothrow) LocalSocket(type, move(client_buffer), move(server_buffer)));
+    return adopt_nonnull_lock_ref_or_enomem(new (nothrow) LocalSocket(type));
+}
+
+ErrorOr<void> LocalSocket::try_allocate_rings()
+{
+    VERIFY(!m_ring_region);
+    // Note: The pages have to be there right away, as the peers' mappings and ours wouldn't agree on lazily allocated ones.
+    auto ring_vmobject = TRY(Memory::AnonymousVMObject::try_create_with_size(2 * ring_capacity, AllocationStrategy::AllocateNow));
+    auto ring_region = TRY(MM.allocate_kernel_region_with_vmobject(*ring_vmobject, 2 * ring_capacity, "LocalSocket: Rings"sv, Memory::Region::Access::ReadWrite));
+    auto client_ring = TRY(LocalSocketRing::try_create({ ring_region->vaddr().as_ptr(), ring_capacity }, 0));
+    auto server_ring = TRY(LocalSocketRing::try_create({ ring_region->vaddr().offset(ring_capacity).as_ptr(), ring_capacity }, ring_capacity));
+
+    client_ring->set_unblock_callback([this]() {
+        evaluate_block_conditions();
+    });
+    server_ring->set_unblock_callback([this]() {
+        evaluate_block_conditions();
+    });
+
+    m_ring_vmobject = move(ring_vmobject);
+    m_ring_region = move(ring_region);
+    m_for_client = move(client_ring);
+    m_for_server = move(server_ring);
+    return {};
 }
 
 ErrorOr<SocketPair> LocalSocket::try_create_connected_pair(int type)
 {
     auto socket = TRY(LocalSocket::try_create(type));
+    TRY(socket->try_allocate_rings());
     auto description1 = TRY(OpenFileDescription::try_create(*socket));
 
     TRY(socket->try_set_path("[socketpair]"sv));
@@ -67,10 +89,8 @@ ErrorOr<SocketPair> LocalSocket::try_create_connected_pair(int type)
     return SocketPair { move(description1), move(description2) };
 }
 
-LocalSocket::LocalSocket(int type, NonnullOwnPtr<DoubleBuffer> client_buffer, NonnullOwnPtr<DoubleBuffer> server_buffer)
+LocalSocket::LocalSocket(int type)
     : Socket(AF_LOCAL, type, 0)
-    , m_for_client(move(client_buffer))
-    , m_for_server(move(server_buffer))
 {
     auto& current_process = Process::current();
     auto current_process_credentials = current_process.credentials();
@@ -78,13 +98,6 @@ LocalSocket::LocalSocket(int type, NonnullOwnPtr<DoubleBuffer> client_buffer, No
     m_prebind_gid = current_process_credentials->egid();
     m_prebind_mode = 0666;
 
-    m_for_client->set_unblock_callback([this]() {
-        evaluate_block_conditions();
-    });
-    m_for_server->set_unblock_callback([this]() {
-        evaluate_block_conditions();
-    });
-
     all_sockets().with_exclusive([&](auto& list) {
         list.append(*this);
     });
@@ -191,6 +204,9 @@ ErrorOr<void> LocalSocket::connect(Credentials const& credentials, OpenFileDescr
 
     m_path = move(path);
 
+    if (!m_ring_region)
+        SOCKET_TRY(try_allocate_rings());
+
     VERIFY(m_connect_side_fd == &description);
     set_connect_side_role(Role::Connecting);
 
@@ -314,7 +330,7 @@ ErrorOr<size_t> LocalSocket::sendto(OpenFileDescription& description, UserOrKern
     return nwritten_or_error;
 }
 
-DoubleBuffer* LocalSocket::receive_buffer_for(OpenFileDescription& description)
+LocalSocketRing* LocalSocket::receive_buffer_for(OpenFileDescription& description)
 {
     auto role = this->role(description);
     if (role == Role::Accepted)
@@ -324,7 +340,7 @@ DoubleBuffer* LocalSocket::receive_buffer_for(OpenFileDescription& description)
     return nullptr;
 }
 
-DoubleBuffer* LocalSocket::send_buffer_for(OpenFileDescription& description)
+LocalSocketRing* LocalSocket::send_buffer_for(OpenFileDescription& description)
 {
     auto role = this->role(description);
     if (role == Role::Connected)
@@ -437,14 +453,60 @@ ErrorOr<void> LocalSocket::ioctl(OpenFileDescription& description, unsigned requ
 {
     switch (request) {
     case FIONREAD: {
-        int readable = receive_buffer_for(description)->immediately_readable();
+        auto* ring = receive_buffer_for(description);
+        int readable = ring ? ring->immediately_readable() : 0;
         return copy_to_user(static_ptr_cast<int*>(arg), &readable);
     }
+    case LOCAL_SOCKET_RING_GET_MAPPING_SIZE: {
+        if (!m_ring_region)
+            return set_so_error(ENOTCONN);
+        unsigned long mapping_size = m_ring_region->size();
+        return copy_to_user(static_ptr_cast<unsigned long*>(arg), &mapping_size);
+    }
+    case LOCAL_SOCKET_RING_CONSUME:
+    case LOCAL_SOCKET_RING_COMMIT: {
+        // Like read(), what is left in the ring can still be taken out after the peer has gone away.
+        if (request == LOCAL_SOCKET_RING_COMMIT && !has_attached_peer(description))
+            return set_so_error(EPIPE);
+        auto* ring = request == LOCAL_SOCKET_RING_CONSUME ? receive_buffer_for(description) : send_buffer_for(description);
+        if (!ring)
+            return set_so_error(EINVAL);
+        auto user_span = static_ptr_cast<LocalSocketRingSpan*>(arg);
+        LocalSocketRingSpan span;
+        TRY(copy_from_user(&span, user_span));
+        LocalSocketRing::MappedSpan next_span;
+        if (request == LOCAL_SOCKET_RING_CONSUME) {
+            TRY(ring->consume(span.size));
+            if (span.size > 0)
+                Thread::current()->did_unix_socket_read(span.size);
+            next_span = ring->readable_span();
+        } else {
+            TRY(ring->commit(span.size));
+            if (span.size > 0)
+                Thread::current()->did_unix_socket_write(span.size);
+            next_span = ring->writable_span();
+        }
+        span.offset = next_span.offset;
+        span.size = next_span.size;
+        return copy_to_user(user_span, &span);
+    }
     }
 
     return EINVAL;
 }
 
+ErrorOr<NonnullLockRefPtr<Memory::VMObject>> LocalSocket::vmobject_for_mmap(Process&, Memory::VirtualRange const& range, u64& offset, bool shared)
+{
+    // A private copy of the rings would be of no use to anyone.
+    if (!shared)
+        return EINVAL;
+    if (!m_ring_region)
+        return ENOTCONN;
+    if (offset != 0 || range.size() > m_ring_region->size())
+        return EINVAL;
+    return *m_ring_vmobject;
+}
+
 ErrorOr<void> LocalSocket::chmod(Credentials const& credentials, OpenFileDescription& description, mode_t mode)
 {
     if (m_inode) {
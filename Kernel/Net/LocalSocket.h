@@ -7,7 +7,8 @@
 #pragma once
 
 #include <AK/IntrusiveList.h>
-#include <Kernel/DoubleBuffer.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Net/LocalSocketRing.h>
 #include <Kernel/Net/Socket.h>
 
 namespace Kernel {
@@ -52,13 +53,21 @@ public:
     virtual ErrorOr<void> chown(Credentials const&, OpenFileDescription&, UserID, GroupID) override;
     virtual ErrorOr<void> chmod(Credentials const&, OpenFileDescription&, mode_t) override;
 
+    // ^File
+    virtual ErrorOr<NonnullLockRefPtr<Memory::VMObject>> vmobject_for_mmap(Process&, Memory::VirtualRange const&, u64& offset, bool shared) override;
+
 private:
-    explicit LocalSocket(int type, NonnullOwnPtr<DoubleBuffer> client_buffer, NonnullOwnPtr<DoubleBuffer> server_buffer);
+    // Both directions have this much room, which is also what the peers get to map of each.
+    static constexpr size_t ring_capacity = 64 * KiB;
+
+    explicit LocalSocket(int type);
+    // Only sockets that end up connected carry any data, so listeners never get rings of their own.
+    ErrorOr<void> try_allocate_rings();
     virtual StringView class_name() const override { return "LocalSocket"sv; }
     virtual bool is_local() const override { return true; }
     bool has_attached_peer(OpenFileDescription const&) const;
-    DoubleBuffer* receive_buffer_for(OpenFileDescription&);
-    DoubleBuffer* send_buffer_for(OpenFileDescription&);
+    LocalSocketRing* receive_buffer_for(OpenFileDescription&);
+    LocalSocketRing* send_buffer_for(OpenFileDescription&);
     NonnullLockRefPtrVector<OpenFileDescription>& sendfd_queue_for(OpenFileDescription const&);
     NonnullLockRefPtrVector<OpenFileDescription>& recvfd_queue_for(OpenFileDescription const&);
 
@@ -97,8 +106,13 @@ private:
     bool m_accept_side_fd_open { false };
     OwnPtr<KString> m_path;
 
-    NonnullOwnPtr<DoubleBuffer> m_for_client;
-    NonnullOwnPtr<DoubleBuffer> m_for_server;
+    // The rings of both directions live in this memory, which is mapped into the kernel here, and
+    // into the peers' address spaces if they mmap() the socket.
+    LockRefPtr<Memory::AnonymousVMObject> m_ring_vmobject;
+    OwnPtr<Memory::Region> m_ring_region;
+
+    OwnPtr<LocalSocketRing> m_for_client;
+    OwnPtr<LocalSocketRing> m_for_server;
 
     NonnullLockRefPtrVector<OpenFileDescription> m_fds_for_client;
     NonnullLockRefPtrVector<OpenFileDescription> m_fds_for_server;
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Net/LocalSocketRing.h>
+
+namespace Kernel {
+
+ErrorOr<NonnullOwnPtr<LocalSocketRing>> LocalSocketRing::try_create(Bytes storage, size_t offset_in_mapping)
+{
+    return adopt_nonnull_own_or_enomem(new (nothrow) LocalSocketRing(storage, offset_in_mapping));
+}
+
+LocalSocketRing::LocalSocketRing(Bytes storage, size_t offset_in_mapping)
+    : m_storage(storage)
+    , m_offset_in_mapping(offset_in_mapping)
+{
+}
+
+ErrorOr<size_t> LocalSocketRing::write(UserOrKernelBuffer const& data, size_t size)
+{
+    if (!size)
+        return 0;
+    MutexLocker locker(m_lock);
+    size_t bytes_to_write = min(size, space_for_writing());
+    size_t start = m_write_offset.load() % capacity();
+    size_t bytes_until_end = min(bytes_to_write, capacity() - start);
+    TRY(data.read(m_storage.offset_pointer(start), 0, bytes_until_end));
+    if (bytes_until_end < bytes_to_write)
+        TRY(data.read(m_storage.data(), bytes_until_end, bytes_to_write - bytes_until_end));
+    m_write_offset += bytes_to_write;
+    if (m_unblock_callback && bytes_to_write > 0)
+        m_unblock_callback();
+    return bytes_to_write;
+}
+
+ErrorOr<size_t> LocalSocketRing::read(UserOrKernelBuffer& data, size_t size)
+{
+    if (!size)
+        return 0;
+    MutexLocker locker(m_lock);
+    size_t bytes_to_read = min(size, immediately_readable());
+    size_t start = m_read_offset.load() % capacity();
+    size_t bytes_until_end = min(bytes_to_read, capacity() - start);
+    TRY(data.write(m_storage.offset_pointer(start), 0, bytes_until_end));
+    if (bytes_until_end < bytes_to_read)
+        TRY(data.write(m_storage.data(), bytes_until_end, bytes_to_read - bytes_until_end));
+    m_read_offset += bytes_to_read;
+    if (m_unblock_callback && bytes_to_read > 0)
+        m_unblock_callback();
+    return bytes_to_read;
+}
+
+LocalSocketRing::MappedSpan LocalSocketRing::readable_span()
+{
+    MutexLocker locker(m_lock);
+    size_t start = m_read_offset.load() % capacity();
+    return { m_offset_in_mapping + start, min(immediately_readable(), capacity() - start) };
+}
+
+LocalSocketRing::MappedSpan LocalSocketRing::writable_span()
+{
+    MutexLocker locker(m_lock);
+    size_t start = m_write_offset.load() % capacity();
+    return { m_offset_in_mapping + start, min(space_for_writing(), capacity() - start) };
+}
+
+ErrorOr<void> LocalSocketRing::consume(size_t size)
+{
+    MutexLocker locker(m_lock);
+    if (size > immediately_readable())
+        return EINVAL;
+    m_read_offset += size;
+    if (m_unblock_callback && size > 0)
+        m_unblock_callback();
+    return {};
+}
+
+ErrorOr<void> LocalSocketRing::commit(size_t size)
+{
+    MutexLocker locker(m_lock);
+    if (size > space_for_writing())
+        return EINVAL;
+    m_write_offset += size;
+    if (m_unblock_callback && size > 0)
+        m_unblock_callback();
+    return {};
+}
+
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/Span.h>
+#include <AK/Types.h>
+#include <Kernel/Locking/Mutex.h>
+#include <Kernel/UserOrKernelBuffer.h>
+
+namespace Kernel {
+
+// The bytes going in one direction of a LocalSocket. The storage is part of the memory that the
+// peers can map into their address spaces, so besides going through read() and write(), they can
+// also fill in and take out data in place, and tell us about it with commit() and consume().
+class LocalSocketRing {
+public:
+    static ErrorOr<NonnullOwnPtr<LocalSocketRing>> try_create(Bytes storage, size_t offset_in_mapping);
+
+    ErrorOr<size_t> write(UserOrKernelBuffer const&, size_t);
+    ErrorOr<size_t> read(UserOrKernelBuffer&, size_t);
+
+    size_t capacity() const { return m_storage.size(); }
+    bool is_empty() const { return immediately_readable() == 0; }
+    size_t space_for_writing() const { return capacity() - immediately_readable(); }
+    size_t immediately_readable() const
+    {
+        auto read_offset = m_read_offset.load();
+        return min(m_write_offset.load() - read_offset, (u64)capacity());
+    }
+
+    // A contiguous part of the ring, with the offset relative to the start of the mapping.
+    struct MappedSpan {
+        size_t offset { 0 };
+        size_t size { 0 };
+    };
+    MappedSpan readable_span();
+    MappedSpan writable_span();
+    // These hand over what the peer has taken out of, or put into, the ring in place.
+    ErrorOr<void> consume(size_t);
+    ErrorOr<void> commit(size_t);
+
+    void set_unblock_callback(Function<void()> callback)
+    {
+        VERIFY(!m_unblock_callback);
+        m_unblock_callback = move(callback);
+    }
+
+private:
+    LocalSocketRing(Bytes storage, size_t offset_in_mapping);
+
+    Bytes m_storage;
+    size_t m_offset_in_mapping { 0 };
+    Function<void()> m_unblock_callback;
+    // These only ever grow, their difference is how much there is to read.
+    Atomic<u64> m_read_offset { 0 };
+    Atomic<u64> m_write_offset { 0 };
+    mutable Mutex m_lock { "LocalSocketRing"sv };
+};
+
+}
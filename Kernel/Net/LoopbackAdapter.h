@@ -19,6 +19,7 @@ public:
     virtual ~LoopbackAdapter() override;
 
     virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offload(ReadonlyBytes, TCPTransmitOffload const&) override;
     virtual StringView class_name() const override { return "LoopbackAdapter"sv; }
     virtual bool link_up() override { return true; }
     virtual bool link_full_duplex() override { return true; }
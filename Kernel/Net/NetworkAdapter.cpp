@@ -5,10 +5,11 @@
  */
 
 #include <Kernel/Heap/kmalloc.h>
-#include <Kernel/InterruptDisabler.h>
 #include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/NetworkAdapter.h>
 #include <Kernel/Net/NetworkingManagement.h>
+#include <Kernel/Net/Routing.h>
+#include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Process.h>
 #include <Kernel/StdLib.h>
 
@@ -28,6 +29,81 @@ void NetworkAdapter::send_packet(ReadonlyBytes packet)
     send_raw(packet);
 }
 
+void NetworkAdapter::send_with_offload(ReadonlyBytes packet, TCPTransmitOffload const& offload)
+{
+    m_packets_out++;
+    m_bytes_out += packet.size();
+    send_raw_with_offload(packet, offload);
+}
+
+void NetworkAdapter::send_tcp_packet(ReadonlyBytes packet, TCPTransmitOffload const& offload)
+{
+    VERIFY(!offload.needs_checksum || has_offload(Offload::TransmitChecksum));
+
+    if (offload.segment_size != 0) {
+        if (!has_offload(Offload::TCPSegmentation)) {
+            segment_tcp_packet(packet, offload.segment_size);
+            return;
+        }
+        VERIFY(offload.needs_checksum);
+        send_with_offload(packet, offload);
+        return;
+    }
+
+    if (offload.needs_checksum)
+        send_with_offload(packet, offload);
+    else
+        send_packet(packet);
+}
+
+void NetworkAdapter::segment_tcp_packet(ReadonlyBytes packet, u16 segment_size)
+{
+    auto const& ipv4_packet = *reinterpret_cast<IPv4Packet const*>(packet.offset(layer3_payload_offset()));
+    auto const& tcp_packet = *static_cast<TCPPacket const*>(ipv4_packet.payload());
+    size_t header_size = ipv4_payload_offset() + tcp_packet.header_size();
+    VERIFY(packet.size() >= header_size);
+    size_t payload_size = packet.size() - header_size;
+    bool checksum_offloaded = has_offload(Offload::TransmitChecksum);
+
+    m_packets_segmented++;
+    u16 ident = ipv4_packet.ident();
+    for (size_t offset = 0; offset < payload_size; offset += segment_size) {
+        size_t segment_payload_size = min((size_t)segment_size, payload_size - offset);
+        bool is_last_segment = offset + segment_payload_size == payload_size;
+
+        auto segment = acquire_packet_buffer(header_size + segment_payload_size);
+        if (!segment) {
+            // The TCP socket notices that the rest is missing, and sends all of it again.
+            dbgln("NetworkAdapter: Dropping the rest of a TCP packet because we're out of memory");
+            return;
+        }
+        memcpy(segment->buffer->data(), packet.data(), header_size);
+        memcpy(segment->buffer->data() + header_size, packet.offset(header_size + offset), segment_payload_size);
+
+        auto& segment_ipv4_packet = *reinterpret_cast<IPv4Packet*>(segment->buffer->data() + layer3_payload_offset());
+        segment_ipv4_packet.set_length(sizeof(IPv4Packet) + tcp_packet.header_size() + segment_payload_size);
+        segment_ipv4_packet.set_ident(ident++);
+        segment_ipv4_packet.set_checksum(0);
+        segment_ipv4_packet.set_checksum(segment_ipv4_packet.compute_checksum());
+
+        auto& segment_tcp_packet = *static_cast<TCPPacket*>(segment_ipv4_packet.payload());
+        segment_tcp_packet.set_sequence_number(tcp_packet.sequence_number() + offset);
+        // Only the end of the data is pushed or finishes the connection.
+        if (!is_last_segment)
+            segment_tcp_packet.set_flags(tcp_packet.flags() & ~(TCPFlags::PSH | TCPFlags::FIN));
+
+        if (checksum_offloaded) {
+            segment_tcp_packet.set_checksum(TCPSocket::compute_tcp_pseudo_header_checksum(ipv4_packet.source(), ipv4_packet.destination(), segment_tcp_packet.header_size() + segment_payload_size));
+            send_with_offload(segment->bytes(), { .needs_checksum = true, .segment_size = 0 });
+        } else {
+            segment_tcp_packet.set_checksum(0);
+            segment_tcp_packet.set_checksum(TCPSocket::compute_tcp_checksum(ipv4_packet.source(), ipv4_packet.destination(), segment_tcp_packet, segment_payload_size));
+            send_packet(segment->bytes());
+        }
+        release_packet_buffer(*segment);
+    }
+}
+
 void NetworkAdapter::send(MACAddress const& destination, ARPPacket const& packet)
 {
     size_t size_in_bytes = sizeof(EthernetFrameHeader) + sizeof(ARPPacket);
@@ -47,7 +123,8 @@ void NetworkAdapter::send(MACAddress const& destination, ARPPacket const& packet
 void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Address const& source_ipv4, MACAddress const& destination_mac, IPv4Address const& destination_ipv4, IPv4Protocol protocol, size_t payload_size, u8 type_of_service, u8 ttl)
 {
     size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
-    VERIFY(ipv4_packet_size <= mtu());
+    // TCP packets may be larger than the MTU, they get split up into segments by send_tcp_packet().
+    VERIFY(ipv4_packet_size <= mtu() || (protocol == IPv4Protocol::TCP && ipv4_packet_size <= max_tcp_offload_size));
 
     size_t ethernet_frame_size = ipv4_payload_offset() + payload_size;
     VERIFY(packet.buffer->size() == ethernet_frame_size);
@@ -71,44 +148,84 @@ void NetworkAdapter::fill_in_ipv4_header(PacketWithTimestamp& packet, IPv4Addres
 
 void NetworkAdapter::did_receive(ReadonlyBytes payload)
 {
-    InterruptDisabler disabler;
-    m_packets_in++;
-    m_bytes_in += payload.size();
+    auto queue_index = NetworkTask::receive_queue_for_frame(payload);
+    auto& queue = m_receive_queues[queue_index];
 
-    if (m_packet_queue_size == max_packet_buffers) {
-        // FIXME: Keep track of the number of dropped packets
-        return;
+    {
+        SpinlockLocker locker(m_receive_queue_lock);
+        m_packets_in++;
+        m_bytes_in += payload.size();
+        if (m_packet_queue_size == max_packet_buffers) {
+            queue.dropped++;
+            return;
+        }
     }
 
     auto packet = acquire_packet_buffer(payload.size());
     if (!packet) {
         dbgln("Discarding packet because we're out of memory");
+        SpinlockLocker locker(m_receive_queue_lock);
+        queue.dropped++;
         return;
     }
 
     memcpy(packet->buffer->data(), payload.data(), payload.size());
 
-    m_packet_queue.append(*packet);
-    m_packet_queue_size++;
+    {
+        SpinlockLocker locker(m_receive_queue_lock);
+        queue.packets.append(*packet);
+        queue.size++;
+        m_packet_queue_size++;
+    }
 
     if (on_receive)
-        on_receive();
+        on_receive(queue_index);
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp)
+size_t NetworkAdapter::dequeue_packets(size_t queue_index, PacketList& packets, size_t max_packets)
 {
-    InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
-        return 0;
-    auto packet_with_timestamp = m_packet_queue.take_first();
-    m_packet_queue_size--;
-    packet_timestamp = packet_with_timestamp->timestamp;
-    auto& packet_buffer = packet_with_timestamp->buffer;
-    size_t packet_size = packet_buffer->size();
-    VERIFY(packet_size <= buffer_size);
-    memcpy(buffer, packet_buffer->data(), packet_size);
-    release_packet_buffer(*packet_with_timestamp);
-    return packet_size;
+    SpinlockLocker locker(m_receive_queue_lock);
+    auto& queue = m_receive_queues[queue_index];
+    size_t count = 0;
+    while (count < max_packets && !queue.packets.is_empty()) {
+        packets.append(*queue.packets.take_first());
+        ++count;
+    }
+    queue.size -= count;
+    m_packet_queue_size -= count;
+    return count;
+}
+
+u64 NetworkAdapter::packets_dropped() const
+{
+    SpinlockLocker locker(m_receive_queue_lock);
+    u64 dropped = 0;
+    for (auto& queue : m_receive_queues)
+        dropped += queue.dropped;
+    return dropped;
+}
+
+bool NetworkAdapter::try_schedule_poll()
+{
+    if (!on_poll_scheduled)
+        return false;
+    if (!m_poll_scheduled.exchange(true))
+        on_poll_scheduled();
+    return true;
+}
+
+bool NetworkAdapter::poll(size_t budget)
+{
+    if (!m_poll_scheduled)
+        return false;
+    m_polls++;
+    if (poll_receive(budget) == budget)
+        return true;
+
+    // Anything that arrives from now on raises an interrupt again as soon as it's unmasked.
+    m_poll_scheduled = false;
+    enable_receive_interrupts();
+    return false;
 }
 
 LockRefPtr<PacketWithTimestamp> NetworkAdapter::acquire_packet_buffer(size_t size)
@@ -152,11 +269,13 @@ void NetworkAdapter::release_packet_buffer(PacketWithTimestamp& packet)
 void NetworkAdapter::set_ipv4_address(IPv4Address const& address)
 {
     m_ipv4_address = address;
+    invalidate_cached_routes();
 }
 
 void NetworkAdapter::set_ipv4_netmask(IPv4Address const& netmask)
 {
     m_ipv4_netmask = netmask;
+    invalidate_cached_routes();
 }
 
 }
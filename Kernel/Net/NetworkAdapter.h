@@ -6,8 +6,11 @@
 
 #pragma once
 
+#include <AK/Array.h>
+#include <AK/Atomic.h>
 #include <AK/AtomicRefCounted.h>
 #include <AK/ByteBuffer.h>
+#include <AK/EnumBits.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
 #include <AK/MACAddress.h>
@@ -16,10 +19,12 @@
 #include <Kernel/KBuffer.h>
 #include <Kernel/Library/LockWeakPtr.h>
 #include <Kernel/Library/LockWeakable.h>
+#include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Net/ARP.h>
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Net/IPv4.h>
+#include <Kernel/Net/NetworkTask.h>
 #include <Kernel/UserOrKernelBuffer.h>
 
 namespace Kernel {
@@ -42,12 +47,35 @@ struct PacketWithTimestamp final : public AtomicRefCounted<PacketWithTimestamp>
     IntrusiveListNode<PacketWithTimestamp, LockRefPtr<PacketWithTimestamp>> packet_node;
 };
 
+// What is left to do for a TCP packet that is handed to NetworkAdapter::send_tcp_packet().
+struct TCPTransmitOffload {
+    // The checksum field only holds the sum of the pseudo-header, and the rest has to be added to it.
+    bool needs_checksum { false };
+    // If not zero, the packet carries more payload than fits into one segment, and has to be split
+    // into segments with at most this many bytes of payload.
+    u16 segment_size { 0 };
+};
+
 class NetworkAdapter
     : public AtomicRefCounted<NetworkAdapter>
     , public LockWeakable<NetworkAdapter> {
 public:
     static constexpr i32 LINKSPEED_INVALID = -1;
 
+    // The largest TCP packet that may be handed to send_tcp_packet(), which is the largest IPv4 packet.
+    static constexpr size_t max_tcp_offload_size = NumericLimits<u16>::max();
+
+    enum class Offload : u32 {
+        None = 0,
+        // The hardware finishes the TCP checksum of outgoing packets.
+        TransmitChecksum = 1 << 0,
+        // The hardware verifies (or finishes) the checksums of received packets.
+        ReceiveChecksum = 1 << 1,
+        // The hardware splits TCP packets that are larger than the MTU into segments.
+        TCPSegmentation = 1 << 2,
+    };
+    AK_ENUM_BITWISE_FRIEND_OPERATORS(Offload);
+
     virtual ~NetworkAdapter();
 
     virtual StringView class_name() const = 0;
@@ -71,9 +99,14 @@ public:
     void send(MACAddress const&, ARPPacket const&);
     void fill_in_ipv4_header(PacketWithTimestamp&, IPv4Address const&, MACAddress const&, IPv4Address const&, IPv4Protocol, size_t, u8 type_of_service, u8 ttl);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size, Time& packet_timestamp);
+    using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
+
+    // Moves up to `max_packets` packets from the given receive queue to `packets`, and returns how many were moved.
+    // The caller hands each of them back with release_packet_buffer() once it's done with it.
+    size_t dequeue_packets(size_t queue_index, PacketList& packets, size_t max_packets);
 
-    bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
+    size_t receive_queue_depth(size_t queue_index) const { return m_receive_queues[queue_index].size; }
+    u64 receive_queue_drops(size_t queue_index) const { return m_receive_queues[queue_index].dropped; }
 
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
@@ -82,6 +115,7 @@ public:
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
+    u64 packets_dropped() const;
 
     LockRefPtr<PacketWithTimestamp> acquire_packet_buffer(size_t);
     void release_packet_buffer(PacketWithTimestamp&);
@@ -89,9 +123,25 @@ public:
     constexpr size_t layer3_payload_offset() const { return sizeof(EthernetFrameHeader); }
     constexpr size_t ipv4_payload_offset() const { return layer3_payload_offset() + sizeof(IPv4Packet); }
 
-    Function<void()> on_receive;
+    Function<void(size_t queue_index)> on_receive;
+
+    // Takes up to `budget` packets off the hardware for a poll that the driver scheduled from its
+    // interrupt handler. Returns whether there is more left, in which case the poll stays scheduled.
+    // Otherwise the receive interrupts are turned back on.
+    bool poll(size_t budget);
+    Function<void()> on_poll_scheduled;
+
+    u64 polls() const { return m_polls; }
+
+    Offload offloads() const { return m_offloads; }
+    bool has_offload(Offload offload) const { return has_flag(m_offloads, offload); }
 
     void send_packet(ReadonlyBytes);
+    // Sends a TCP packet, which may be larger than the MTU. Unless the hardware can do it, the segmentation
+    // and the checksums are done in software here.
+    void send_tcp_packet(ReadonlyBytes, TCPTransmitOffload const&);
+
+    u64 packets_segmented() const { return m_packets_segmented; }
 
 protected:
     NetworkAdapter(NonnullOwnPtr<KString>);
@@ -99,7 +149,21 @@ protected:
     void did_receive(ReadonlyBytes);
     virtual void send_raw(ReadonlyBytes) = 0;
 
+    void set_offloads(Offload offloads) { m_offloads = offloads; }
+    // Drivers that set Offload::TransmitChecksum or Offload::TCPSegmentation send the TCP packets that need those here.
+    virtual void send_raw_with_offload(ReadonlyBytes, TCPTransmitOffload const&) { VERIFY_NOT_REACHED(); }
+
+    // Drivers that can poll call this from their interrupt handler after masking their receive interrupts,
+    // and leave the actual receiving to the NetworkTask. If there is no NetworkTask to poll yet, this
+    // returns false and the driver has to receive the packets right away.
+    bool try_schedule_poll();
+    virtual size_t poll_receive(size_t) { return 0; }
+    virtual void enable_receive_interrupts() { }
+
 private:
+    void send_with_offload(ReadonlyBytes, TCPTransmitOffload const&);
+    void segment_tcp_packet(ReadonlyBytes, u16 segment_size);
+
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
     IPv4Address m_ipv4_netmask;
@@ -107,11 +171,20 @@ private:
     // FIXME: Make this configurable
     static constexpr size_t max_packet_buffers = 1024;
 
-    using PacketList = IntrusiveList<&PacketWithTimestamp::packet_node>;
+    struct ReceiveQueue {
+        PacketList packets;
+        size_t size { 0 };
+        u64 dropped { 0 };
+    };
 
-    PacketList m_packet_queue;
+    mutable Spinlock m_receive_queue_lock { LockRank::None };
+    Array<ReceiveQueue, NetworkTask::max_receive_queue_count> m_receive_queues;
     size_t m_packet_queue_size { 0 };
     SpinlockProtected<PacketList> m_unused_packets { LockRank::None };
+    Atomic<bool> m_poll_scheduled { false };
+    u64 m_polls { 0 };
+    Offload m_offloads { Offload::None };
+    u64 m_packets_segmented { 0 };
     NonnullOwnPtr<KString> m_name;
     u32 m_packets_in { 0 };
     u32 m_bytes_in { 0 };
@@ -4,6 +4,9 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
+#include <AK/HashTable.h>
+#include <Kernel/Arch/Processor.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/MutexProtected.h>
@@ -26,41 +29,69 @@
 namespace Kernel {
 
 static void handle_arp(EthernetFrameHeader const&, size_t frame_size);
-static void handle_ipv4(EthernetFrameHeader const&, size_t frame_size, Time const& packet_timestamp);
+static void handle_ipv4(NetworkAdapter const&, EthernetFrameHeader const&, size_t frame_size, Time const& packet_timestamp);
 static void handle_icmp(EthernetFrameHeader const&, IPv4Packet const&, Time const& packet_timestamp);
 static void handle_udp(IPv4Packet const&, Time const& packet_timestamp);
-static void handle_tcp(IPv4Packet const&, Time const& packet_timestamp);
+static void handle_tcp(NetworkAdapter const&, IPv4Packet const&, Time const& packet_timestamp);
 static void send_delayed_tcp_ack(LockRefPtr<TCPSocket> socket);
 static void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, LockRefPtr<NetworkAdapter> adapter);
 static void flush_delayed_tcp_acks();
 static void retransmit_tcp_packets();
 
-static Thread* network_task = nullptr;
-static HashTable<LockRefPtr<TCPSocket>>* delayed_ack_sockets;
+// How many packets a worker takes from an adapter before it moves on to the next one.
+static constexpr size_t receive_batch_size = 64;
+
+struct ReceiveWorker {
+    Thread* thread { nullptr };
+    size_t queue_index { 0 };
+    WaitQueue wait_queue;
+    // Every connection is only ever handled by one worker, so its delayed ACKs don't need a lock.
+    HashTable<LockRefPtr<TCPSocket>> delayed_ack_sockets;
+    Atomic<u64> packets { 0 };
+    Atomic<u64> batches { 0 };
+    Atomic<u64> largest_batch { 0 };
+};
+
+static ReceiveWorker* s_workers = nullptr;
+static Atomic<size_t> s_worker_count { 0 };
+
+static ReceiveWorker& current_worker();
+static size_t poll_queue_for_adapter(size_t adapter_index);
+static void handle_frame(NetworkAdapter const&, ReadonlyBytes frame, Time const& packet_timestamp);
 
 [[noreturn]] static void NetworkTask_main(void*);
 
 void NetworkTask::spawn()
 {
+    size_t worker_count = min(Processor::count(), max_receive_queue_count);
+    s_workers = new ReceiveWorker[worker_count];
+
     LockRefPtr<Thread> thread;
     auto name = KString::try_create("Network Task"sv);
     if (name.is_error())
         TODO();
-    (void)Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, nullptr);
-    network_task = thread;
-}
-
-bool NetworkTask::is_current()
-{
-    return Thread::current() == network_task;
-}
+    // Each worker stays on its own processor, so that the connections it handles stay warm in that processor's caches.
+    u32 affinity = worker_count > 1 ? 1u : THREAD_AFFINITY_DEFAULT;
+    auto process = Process::create_kernel_process(thread, name.release_value(), NetworkTask_main, &s_workers[0], affinity);
+    if (!process)
+        TODO();
+    s_workers[0].thread = thread;
+
+    for (size_t i = 1; i < worker_count; ++i) {
+        s_workers[i].queue_index = i;
+        auto worker_name = KString::formatted("Network Task #{}", i);
+        if (worker_name.is_error())
+            TODO();
+        auto worker_thread = process->create_kernel_thread(NetworkTask_main, &s_workers[i], THREAD_PRIORITY_NORMAL, worker_name.release_value(), 1u << i, false);
+        if (!worker_thread)
+            TODO();
+        s_workers[i].thread = worker_thread;
+    }
 
-void NetworkTask_main(void*)
-{
-    delayed_ack_sockets = new HashTable<LockRefPtr<TCPSocket>>;
+    s_worker_count = worker_count;
+    dmesgln("NetworkTask: Receiving with {} worker(s)", worker_count);
 
-    WaitQueue packet_wait_queue;
-    int pending_packets = 0;
+    size_t adapter_index = 0;
     NetworkingManagement::the().for_each([&](auto& adapter) {
         dmesgln("NetworkTask: {} network adapter found: hw={}", adapter.class_name(), adapter.mac_address().to_string());
 
@@ -69,64 +100,164 @@ void NetworkTask_main(void*)
             adapter.set_ipv4_netmask({ 255, 0, 0, 0 });
         }
 
-        adapter.on_receive = [&]() {
-            pending_packets++;
-            packet_wait_queue.wake_all();
+        adapter.on_receive = [](size_t queue_index) {
+            s_workers[queue_index].wait_queue.wake_one();
+        };
+        adapter.on_poll_scheduled = [queue_index = poll_queue_for_adapter(adapter_index++)]() {
+            s_workers[queue_index].wait_queue.wake_one();
         };
     });
+}
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size, Time& packet_timestamp) -> size_t {
-        if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
-        NetworkingManagement::the().for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
-                return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size, packet_timestamp);
-            pending_packets--;
-            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued packet from {} ({} bytes)", adapter.name(), packet_size);
-        });
-        return packet_size;
+bool NetworkTask::is_current()
+{
+    auto* current_thread = Thread::current();
+    for (size_t i = 0; i < s_worker_count; ++i) {
+        if (s_workers[i].thread == current_thread)
+            return true;
+    }
+    return false;
+}
+
+ReceiveWorker& current_worker()
+{
+    auto* current_thread = Thread::current();
+    for (size_t i = 0; i < s_worker_count; ++i) {
+        if (s_workers[i].thread == current_thread)
+            return s_workers[i];
+    }
+    VERIFY_NOT_REACHED();
+}
+
+// Every adapter is polled by one of the workers, and the adapters are spread evenly over them.
+size_t poll_queue_for_adapter(size_t adapter_index)
+{
+    return adapter_index % NetworkTask::receive_queue_count();
+}
+
+size_t NetworkTask::receive_queue_count()
+{
+    return max(s_worker_count.load(), (size_t)1);
+}
+
+size_t NetworkTask::receive_queue_for_frame(ReadonlyBytes frame)
+{
+    auto queue_count = receive_queue_count();
+    if (queue_count == 1)
+        return 0;
+
+    // Anything that isn't IPv4 (like ARP) is rare enough to just go to the first worker.
+    if (frame.size() < sizeof(EthernetFrameHeader) + sizeof(IPv4Packet))
+        return 0;
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    if (eth.ether_type() != EtherType::IPv4)
+        return 0;
+    auto& ipv4_packet = *static_cast<IPv4Packet const*>(eth.payload());
+
+    // TCP and UDP both start with the source and destination ports.
+    u16 source_port = 0;
+    u16 destination_port = 0;
+    auto protocol = (IPv4Protocol)ipv4_packet.protocol();
+    if ((protocol == IPv4Protocol::TCP || protocol == IPv4Protocol::UDP)
+        && !ipv4_packet.is_a_fragment()
+        && frame.size() >= sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + sizeof(UDPPacket)) {
+        auto& udp_packet = *static_cast<UDPPacket const*>(ipv4_packet.payload());
+        source_port = udp_packet.source_port();
+        destination_port = udp_packet.destination_port();
+    }
+
+    IPv4SocketTuple tuple(ipv4_packet.destination(), destination_port, ipv4_packet.source(), source_port);
+    return Traits<IPv4SocketTuple>::hash(tuple) % queue_count;
+}
+
+NetworkTask::ReceiveQueueStatistics NetworkTask::receive_queue_statistics(size_t queue_index)
+{
+    if (queue_index >= s_worker_count)
+        return {};
+    auto& worker = s_workers[queue_index];
+    return {
+        .packets = worker.packets.load(),
+        .batches = worker.batches.load(),
+        .largest_batch = worker.largest_batch.load(),
     };
+}
 
-    size_t buffer_size = 64 * KiB;
-    auto region_or_error = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer"sv, Memory::Region::Access::ReadWrite);
-    if (region_or_error.is_error())
-        TODO();
-    auto buffer_region = region_or_error.release_value();
-    auto buffer = (u8*)buffer_region->vaddr().get();
-    Time packet_timestamp;
+void NetworkTask_main(void* data)
+{
+    auto& worker = *static_cast<ReceiveWorker*>(data);
+
+    // The adapters are all registered before the NetworkTask is spawned.
+    NonnullLockRefPtrVector<NetworkAdapter> adapters;
+    NetworkingManagement::the().for_each([&](auto& adapter) {
+        adapters.append(adapter);
+    });
 
     for (;;) {
         flush_delayed_tcp_acks();
-        retransmit_tcp_packets();
-        size_t packet_size = dequeue_packet(buffer, buffer_size, packet_timestamp);
-        if (!packet_size) {
+        // The retransmission timers aren't tied to incoming packets, so one worker takes care of all of them.
+        if (worker.queue_index == 0)
+            retransmit_tcp_packets();
+
+        // Polling only moves the packets into the receive queues, so do it before taking them off again.
+        bool has_more_to_poll = false;
+        for (size_t i = 0; i < adapters.size(); ++i) {
+            if (poll_queue_for_adapter(i) == worker.queue_index && adapters[i].poll(receive_batch_size))
+                has_more_to_poll = true;
+        }
+
+        size_t batch_size = 0;
+        for (auto& adapter : adapters) {
+            NetworkAdapter::PacketList packets;
+            size_t packet_count = adapter.dequeue_packets(worker.queue_index, packets, receive_batch_size);
+            if (packet_count == 0)
+                continue;
+            dbgln_if(NETWORK_TASK_DEBUG, "NetworkTask: Dequeued {} packets from {}", packet_count, adapter.name());
+
+            while (!packets.is_empty()) {
+                auto packet = packets.take_first();
+                handle_frame(adapter, packet->bytes(), packet->timestamp);
+                adapter.release_packet_buffer(*packet);
+            }
+            batch_size += packet_count;
+        }
+
+        if (batch_size == 0 && !has_more_to_poll) {
             auto timeout_time = Time::from_milliseconds(500);
             auto timeout = Thread::BlockTimeout { false, &timeout_time };
-            [[maybe_unused]] auto result = packet_wait_queue.wait_on(timeout, "NetworkTask"sv);
+            [[maybe_unused]] auto result = worker.wait_queue.wait_on(timeout, "NetworkTask"sv);
             continue;
         }
-        if (packet_size < sizeof(EthernetFrameHeader)) {
-            dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", packet_size);
+
+        if (batch_size == 0)
             continue;
-        }
-        auto& eth = *(EthernetFrameHeader const*)buffer;
-        dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), packet_size);
-
-        switch (eth.ether_type()) {
-        case EtherType::ARP:
-            handle_arp(eth, packet_size);
-            break;
-        case EtherType::IPv4:
-            handle_ipv4(eth, packet_size, packet_timestamp);
-            break;
-        case EtherType::IPv6:
-            // ignore
-            break;
-        default:
-            dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
-        }
+        worker.packets += batch_size;
+        worker.batches++;
+        if (batch_size > worker.largest_batch)
+            worker.largest_batch = batch_size;
+    }
+}
+
+void handle_frame(NetworkAdapter const& receiving_adapter, ReadonlyBytes frame, Time const& packet_timestamp)
+{
+    if (frame.size() < sizeof(EthernetFrameHeader)) {
+        dbgln("NetworkTask: Packet is too small to be an Ethernet packet! ({})", frame.size());
+        return;
+    }
+    auto& eth = *(EthernetFrameHeader const*)frame.data();
+    dbgln_if(ETHERNET_DEBUG, "NetworkTask: From {} to {}, ether_type={:#04x}, packet_size={}", eth.source().to_string(), eth.destination().to_string(), eth.ether_type(), frame.size());
+
+    switch (eth.ether_type()) {
+    case EtherType::ARP:
+        handle_arp(eth, frame.size());
+        break;
+    case EtherType::IPv4:
+        handle_ipv4(receiving_adapter, eth, frame.size(), packet_timestamp);
+        break;
+    case EtherType::IPv6:
+        // ignore
+        break;
+    default:
+        dbgln_if(ETHERNET_DEBUG, "NetworkTask: Unknown ethernet type {:#04x}", eth.ether_type());
     }
 }
 
@@ -178,7 +309,7 @@ void handle_arp(EthernetFrameHeader const& eth, size_t frame_size)
     }
 }
 
-void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, Time const& packet_timestamp)
+void handle_ipv4(NetworkAdapter const& receiving_adapter, EthernetFrameHeader const& eth, size_t frame_size, Time const& packet_timestamp)
 {
     constexpr size_t minimum_ipv4_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
     if (frame_size < minimum_ipv4_frame_size) {
@@ -216,7 +347,7 @@ void handle_ipv4(EthernetFrameHeader const& eth, size_t frame_size, Time const&
     case IPv4Protocol::UDP:
         return handle_udp(packet, packet_timestamp);
     case IPv4Protocol::TCP:
-        return handle_tcp(packet, packet_timestamp);
+        return handle_tcp(receiving_adapter, packet, packet_timestamp);
     default:
         dbgln_if(IPV4_DEBUG, "handle_ipv4: Unhandled protocol {:#02x}", packet.protocol());
         break;
@@ -310,13 +441,14 @@ void send_delayed_tcp_ack(LockRefPtr<TCPSocket> socket)
         return;
     }
 
-    delayed_ack_sockets->set(move(socket));
+    current_worker().delayed_ack_sockets.set(move(socket));
 }
 
 void flush_delayed_tcp_acks()
 {
+    auto& delayed_ack_sockets = current_worker().delayed_ack_sockets;
     Vector<LockRefPtr<TCPSocket>, 32> remaining_sockets;
-    for (auto& socket : *delayed_ack_sockets) {
+    for (auto& socket : delayed_ack_sockets) {
         MutexLocker locker(socket->mutex());
         if (socket->should_delay_next_ack()) {
             MUST(remaining_sockets.try_append(socket));
@@ -325,12 +457,12 @@ void flush_delayed_tcp_acks()
         [[maybe_unused]] auto result = socket->send_ack();
     }
 
-    if (remaining_sockets.size() != delayed_ack_sockets->size()) {
-        delayed_ack_sockets->clear();
+    if (remaining_sockets.size() != delayed_ack_sockets.size()) {
+        delayed_ack_sockets.clear();
         if (remaining_sockets.size() > 0)
             dbgln("flush_delayed_tcp_acks: {} sockets remaining", remaining_sockets.size());
         for (auto&& socket : remaining_sockets)
-            delayed_ack_sockets->set(move(socket));
+            delayed_ack_sockets.set(move(socket));
     }
 }
 
@@ -368,7 +500,7 @@ void send_tcp_rst(IPv4Packet const& ipv4_packet, TCPPacket const& tcp_packet, Lo
     routing_decision.adapter->release_packet_buffer(*packet);
 }
 
-void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
+void handle_tcp(NetworkAdapter const& receiving_adapter, IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
 {
     if (ipv4_packet.payload_size() < sizeof(TCPPacket)) {
         dbgln("handle_tcp: IPv4 payload is too small to be a TCP packet ({}, need {})", ipv4_packet.payload_size(), sizeof(TCPPacket));
@@ -390,6 +522,13 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
 
     size_t payload_size = ipv4_packet.payload_size() - tcp_packet.header_size();
 
+    // Adapters with receive checksum offload have already checked it (or, like the loopback adapter, never break packets).
+    if (!receiving_adapter.has_offload(NetworkAdapter::Offload::ReceiveChecksum)
+        && TCPSocket::compute_tcp_checksum(ipv4_packet.source(), ipv4_packet.destination(), tcp_packet, payload_size) != 0) {
+        dbgln_if(TCP_DEBUG, "handle_tcp: Dropping packet with a bad checksum from {}:{}", ipv4_packet.source(), tcp_packet.source_port());
+        return;
+    }
+
     dbgln_if(TCP_DEBUG, "handle_tcp: source={}:{}, destination={}:{}, seq_no={}, ack_no={}, flags={:#04x} ({}{}{}{}), window_size={}, payload_size={}",
         ipv4_packet.source().to_string(),
         tcp_packet.source_port(),
@@ -451,7 +590,11 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
             auto& peer_address = ipv4_packet.source();
             auto client_or_error = socket->try_create_client(local_address, tcp_packet.destination_port(), peer_address, tcp_packet.source_port());
             if (client_or_error.is_error()) {
-                dmesgln("handle_tcp: couldn't create client socket: {}", client_or_error.error());
+                // A full backlog is not worth a message, as it happens all the time when we're busy.
+                if (auto code = client_or_error.error().code(); code == ENOBUFS || code == ECONNREFUSED)
+                    dbgln_if(TCP_DEBUG, "handle_tcp: dropping SYN, backlog of listener {} is full", socket->tuple().to_string());
+                else
+                    dmesgln("handle_tcp: couldn't create client socket: {}", client_or_error.error());
                 return;
             }
             auto client = client_or_error.release_value();
@@ -459,6 +602,7 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
             dbgln_if(TCP_DEBUG, "handle_tcp: created new client socket with tuple {}", client->tuple().to_string());
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->negotiate_options(tcp_packet);
             [[maybe_unused]] auto rc2 = client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
@@ -472,11 +616,13 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
         switch (tcp_packet.flags()) {
         case TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->negotiate_options(tcp_packet);
             (void)socket->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             socket->set_state(TCPSocket::State::SynReceived);
             return;
         case TCPFlags::ACK | TCPFlags::SYN:
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            socket->negotiate_options(tcp_packet);
             (void)socket->send_ack(true);
             socket->set_state(TCPSocket::State::Established);
             socket->set_setup_state(Socket::SetupState::Completed);
@@ -620,6 +766,15 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
         }
 
         if (tcp_packet.sequence_number() != socket->ack_number()) {
+            if (payload_size != 0 && !tcp_packet.has_fin() && tcp_sequence_after(tcp_packet.sequence_number(), socket->ack_number())) {
+                // Something before this packet got lost. Hold on to it until the gap is filled,
+                // and let the peer know right away, so it can repair the loss (RFC 5681, 4.2).
+                dbgln_if(TCP_DEBUG, "Queueing out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
+                socket->queue_out_of_order_segment(tcp_packet, { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp);
+                [[maybe_unused]] auto result = socket->send_ack(true);
+                return;
+            }
+
             dbgln_if(TCP_DEBUG, "Discarding out of order packet: seq {} vs. ack {}", tcp_packet.sequence_number(), socket->ack_number());
             if (socket->duplicate_acks() < TCPSocket::maximum_duplicate_acks) {
                 dbgln_if(TCP_DEBUG, "Sending ACK with same ack number to trigger fast retransmission");
@@ -645,9 +800,14 @@ void handle_tcp(IPv4Packet const& ipv4_packet, Time const& packet_timestamp)
         if (payload_size) {
             if (socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), { &ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size() }, packet_timestamp)) {
                 socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
+                bool filled_gap = socket->receive_queued_segments();
                 dbgln_if(TCP_DEBUG, "Got packet with ack_no={}, seq_no={}, payload_size={}, acking it with new ack_no={}, seq_no={}",
                     tcp_packet.ack_number(), tcp_packet.sequence_number(), payload_size, socket->ack_number(), socket->sequence_number());
-                send_delayed_tcp_ack(socket);
+                // The peer is waiting to hear how much of the gap we have now, so don't delay that.
+                if (filled_gap)
+                    (void)socket->send_ack();
+                else
+                    send_delayed_tcp_ack(socket);
             }
         }
     }
@@ -6,10 +6,28 @@
 
 #pragma once
 
+#include <AK/Span.h>
+#include <AK/Types.h>
+
 namespace Kernel {
 class NetworkTask {
 public:
+    // Received packets are spread over one worker per processor, up to this many.
+    static constexpr size_t max_receive_queue_count = 8;
+
+    struct ReceiveQueueStatistics {
+        u64 packets { 0 };
+        u64 batches { 0 };
+        u64 largest_batch { 0 };
+    };
+
     static void spawn();
     static bool is_current();
+
+    static size_t receive_queue_count();
+    // Picks the queue for an incoming Ethernet frame. All packets of a connection end up in
+    // the same queue, so they are handled in order while other connections are handled in parallel.
+    static size_t receive_queue_for_frame(ReadonlyBytes);
+    static ReceiveQueueStatistics receive_queue_statistics(size_t queue_index);
 };
 }
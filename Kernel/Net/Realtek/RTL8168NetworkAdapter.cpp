@@ -81,6 +81,7 @@ namespace Kernel {
 #define INT_LINK_CHANGE 0x20
 #define INT_RX_FIFO_OVERFLOW 0x40
 #define INT_SYS_ERR 0x8000
+#define INT_RX_ALL (INT_RXOK | INT_RXERR | INT_RX_OVERFLOW | INT_RX_FIFO_OVERFLOW)
 
 #define CFG9346_NONE 0x00
 #define CFG9346_EEM0 0x40
@@ -398,6 +399,8 @@ void RTL8168NetworkAdapter::startup()
         enabled_interrupts |= INT_RX_FIFO_OVERFLOW;
         enabled_interrupts &= ~INT_RX_OVERFLOW;
     }
+    m_enabled_interrupts = enabled_interrupts;
+    m_unmasked_interrupts = enabled_interrupts;
     out16(REG_IMR, enabled_interrupts);
 
     // update link status
@@ -1132,7 +1135,9 @@ bool RTL8168NetworkAdapter::handle_irq(RegisterState const&)
 {
     bool was_handled = false;
     for (;;) {
-        int status = in16(REG_ISR);
+        // Receive events that come in while we're polling stay pending, so that they raise an
+        // interrupt once the receive interrupts are unmasked again.
+        int status = in16(REG_ISR) & m_unmasked_interrupts;
         out16(REG_ISR, status);
 
         m_entropy_source.add_random_event(status);
@@ -1143,9 +1148,14 @@ bool RTL8168NetworkAdapter::handle_irq(RegisterState const&)
             break;
 
         was_handled = true;
-        if (status & INT_RXOK) {
+        if (status & INT_RX_ALL) {
             dbgln_if(RTL8168_DEBUG, "RTL8168: RX ready");
-            receive();
+            m_unmasked_interrupts = m_enabled_interrupts & ~INT_RX_ALL;
+            out16(REG_IMR, m_unmasked_interrupts);
+            if (!try_schedule_poll()) {
+                receive(number_of_rx_descriptors);
+                enable_receive_interrupts();
+            }
         }
         if (status & INT_RXERR) {
             dbgln_if(RTL8168_DEBUG, "RTL8168: RX error - invalid packet");
@@ -1159,7 +1169,6 @@ bool RTL8168NetworkAdapter::handle_irq(RegisterState const&)
         }
         if (status & INT_RX_OVERFLOW) {
             dmesgln("RTL8168: RX descriptor unavailable (packet lost)");
-            receive();
         }
         if (status & INT_LINK_CHANGE) {
             m_link_up = (in8(REG_PHYSTATUS) & PHY_LINK_STATUS) != 0;
@@ -1167,7 +1176,6 @@ bool RTL8168NetworkAdapter::handle_irq(RegisterState const&)
         }
         if (status & INT_RX_FIFO_OVERFLOW) {
             dmesgln("RTL8168: RX FIFO overflow");
-            receive();
         }
         if (status & INT_SYS_ERR) {
             dmesgln("RTL8168: Fatal system error");
@@ -1222,17 +1230,16 @@ void RTL8168NetworkAdapter::send_raw(ReadonlyBytes payload)
     out8(REG_TXSTART, TXSTART_START); // FIXME: this shouldn't be done so often, we should look into doing this using the watchdog timer
 }
 
-void RTL8168NetworkAdapter::receive()
+size_t RTL8168NetworkAdapter::receive(size_t budget)
 {
     auto* rx_descriptors = (RXDescriptor*)m_rx_descriptors_region->vaddr().as_ptr();
-    for (u16 i = 0; i < number_of_rx_descriptors; ++i) {
-        auto descriptor_index = (m_rx_free_index + i) % number_of_rx_descriptors;
+    size_t received = 0;
+    while (received < budget) {
+        auto descriptor_index = m_rx_free_index;
         auto& descriptor = rx_descriptors[descriptor_index];
 
-        if ((descriptor.flags & RXDescriptor::Ownership) != 0) {
-            m_rx_free_index = descriptor_index;
+        if ((descriptor.flags & RXDescriptor::Ownership) != 0)
             break;
-        }
 
         u16 flags = descriptor.flags;
         u16 length = descriptor.buffer_size & 0x3FFF;
@@ -1254,7 +1261,22 @@ void RTL8168NetworkAdapter::receive()
         if (descriptor_index == number_of_rx_descriptors - 1)
             flags |= RXDescriptor::EndOfRing;
         descriptor.flags = flags; // let the NIC know it can use this descriptor again
+
+        m_rx_free_index = (descriptor_index + 1) % number_of_rx_descriptors;
+        ++received;
     }
+    return received;
+}
+
+size_t RTL8168NetworkAdapter::poll_receive(size_t budget)
+{
+    return receive(budget);
+}
+
+void RTL8168NetworkAdapter::enable_receive_interrupts()
+{
+    m_unmasked_interrupts = m_enabled_interrupts;
+    out16(REG_IMR, m_enabled_interrupts);
 }
 
 void RTL8168NetworkAdapter::out8(u16 address, u8 data)
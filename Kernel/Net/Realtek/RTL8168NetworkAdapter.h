@@ -149,7 +149,9 @@ private:
     void initialize_rx_descriptors();
     void initialize_tx_descriptors();
 
-    void receive();
+    size_t receive(size_t budget);
+    virtual size_t poll_receive(size_t budget) override;
+    virtual void enable_receive_interrupts() override;
 
     void out8(u16 address, u8 data);
     void out16(u16 address, u16 data);
@@ -208,6 +210,9 @@ private:
     NonnullOwnPtrVector<Memory::Region> m_tx_buffers_regions;
     u16 m_tx_free_index { 0 };
     bool m_link_up { false };
+    // The interrupts we want, and the ones that are currently unmasked (the receive ones are masked while we poll).
+    u16 m_enabled_interrupts { 0 };
+    Atomic<u16> m_unmasked_interrupts { 0 };
     EntropySource m_entropy_source;
     WaitQueue m_wait_queue;
 };
@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/BuiltinWrappers.h>
 #include <AK/HashMap.h>
 #include <AK/Singleton.h>
 #include <Kernel/Debug.h>
@@ -18,6 +19,109 @@ namespace Kernel {
 
 static Singleton<SpinlockProtected<HashMap<IPv4Address, MACAddress>>> s_arp_table;
 static Singleton<SpinlockProtected<Route::RouteList>> s_routing_table;
+static Atomic<u32> s_routing_generation { 0 };
+
+// A path-compressed binary trie over the routing table, keyed on the destination prefix.
+// It is never modified once built: every update of the routing table builds a new one and
+// publishes it, so route_to() can find the longest prefix match without taking the table lock.
+class RoutingTrie final : public AtomicRefCounted<RoutingTrie> {
+public:
+    static ErrorOr<NonnullLockRefPtr<RoutingTrie>> try_create(Route::RouteList& routes)
+    {
+        auto trie = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) RoutingTrie));
+        for (auto& route : routes)
+            TRY(insert(trie->m_root, route));
+        return trie;
+    }
+
+    template<typename Callback>
+    LockRefPtr<Route> longest_prefix_match(u32 target_addr, Callback matches) const
+    {
+        LockRefPtr<Route> chosen_route;
+        // Each step goes at least one bit further down, so this takes at most 33 steps.
+        for (auto* node = m_root.ptr(); node; node = node->children[bit_at(target_addr, node->prefix_length)].ptr()) {
+            if ((target_addr & mask_for(node->prefix_length)) != node->prefix)
+                break;
+            for (auto& route : node->routes) {
+                // Like before, default routes are only chosen when they go through the adapter we want.
+                if (node->prefix_length == 0 && !matches(*route->adapter))
+                    continue;
+                chosen_route = route;
+                break;
+            }
+            if (node->prefix_length == 32)
+                break;
+        }
+        return chosen_route;
+    }
+
+private:
+    struct Node {
+        u32 prefix { 0 };
+        u8 prefix_length { 0 };
+        Vector<NonnullLockRefPtr<Route>, 1> routes;
+        OwnPtr<Node> children[2];
+    };
+
+    RoutingTrie() = default;
+
+    static constexpr u32 mask_for(u8 prefix_length)
+    {
+        return prefix_length == 0 ? 0 : 0xffffffff << (32 - prefix_length);
+    }
+
+    static constexpr size_t bit_at(u32 address, u8 position)
+    {
+        return position >= 32 ? 0 : (address >> (31 - position)) & 1;
+    }
+
+    static ErrorOr<NonnullOwnPtr<Node>> create_node(u32 prefix, u8 prefix_length)
+    {
+        auto node = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Node));
+        node->prefix = prefix & mask_for(prefix_length);
+        node->prefix_length = prefix_length;
+        return node;
+    }
+
+    static ErrorOr<void> insert(OwnPtr<Node>& slot, Route& route)
+    {
+        // A route for 0.0.0.0 is the default route, whatever its netmask says.
+        auto route_addr = route.destination.to_u32();
+        u8 prefix_length = route_addr == 0 ? 0 : popcount(route.netmask.to_u32());
+        auto prefix = route_addr & mask_for(prefix_length);
+
+        auto* current_slot = &slot;
+        while (true) {
+            auto& node = *current_slot;
+            if (!node) {
+                node = TRY(create_node(prefix, prefix_length));
+                TRY(node->routes.try_append(route));
+                return {};
+            }
+
+            u8 common_length = min(prefix_length, node->prefix_length);
+            if (auto difference = prefix ^ node->prefix; difference != 0)
+                common_length = min(common_length, (u8)count_leading_zeroes(difference));
+
+            if (common_length < node->prefix_length) {
+                // The new prefix diverges from this node, so it gets a new parent where they split.
+                auto parent = TRY(create_node(prefix, common_length));
+                parent->children[bit_at(node->prefix, common_length)] = move(node);
+                node = move(parent);
+            }
+
+            if (node->prefix_length == prefix_length) {
+                TRY(node->routes.try_append(route));
+                return {};
+            }
+            current_slot = &node->children[bit_at(prefix, node->prefix_length)];
+        }
+    }
+
+    OwnPtr<Node> m_root;
+};
+
+static Singleton<LockRefPtr<RoutingTrie>> s_routing_trie;
 
 class ARPTableBlocker final : public Thread::Blocker {
 public:
@@ -111,14 +215,30 @@ SpinlockProtected<HashMap<IPv4Address, MACAddress>>& arp_table()
     return *s_arp_table;
 }
 
+u32 routing_generation()
+{
+    return s_routing_generation.load();
+}
+
+void invalidate_cached_routes()
+{
+    s_routing_generation.fetch_add(1);
+}
+
 void update_arp_table(IPv4Address const& ip_addr, MACAddress const& addr, UpdateTable update)
 {
-    arp_table().with([&](auto& table) {
-        if (update == UpdateTable::Set)
+    auto did_change = arp_table().with([&](auto& table) {
+        if (update == UpdateTable::Set) {
+            auto previous_addr = table.get(ip_addr);
             table.set(ip_addr, addr);
+            return !previous_addr.has_value() || previous_addr.value() != addr;
+        }
         if (update == UpdateTable::Delete)
-            table.remove(ip_addr);
+            return table.remove(ip_addr);
+        return false;
     });
+    if (did_change)
+        invalidate_cached_routes();
     s_arp_table_blocker_set->unblock_blockers_waiting_for_ipv4_address(ip_addr, addr);
 
     if constexpr (ARP_DEBUG) {
@@ -144,6 +264,7 @@ ErrorOr<void> update_routing_table(IPv4Address const& destination, IPv4Address c
         return ENOMEM;
 
     TRY(routing_table().with([&](auto& table) -> ErrorOr<void> {
+        LockRefPtr<Route> removed_route;
         if (update == UpdateTable::Set) {
             for (auto const& route : table) {
                 if (route == *route_entry)
@@ -156,15 +277,29 @@ ErrorOr<void> update_routing_table(IPv4Address const& destination, IPv4Address c
                 dbgln_if(ROUTING_DEBUG, "candidate: {} {} {} {} {}", route.destination, route.gateway, route.netmask, route.flags, route.adapter);
                 if (route.matches(*route_entry)) {
                     // FIXME: Remove all entries, not only the first one.
+                    removed_route = route;
                     table.remove(route);
-                    return {};
+                    break;
                 }
             }
-            return ESRCH;
+            if (!removed_route)
+                return ESRCH;
+        }
+
+        auto trie_or_error = RoutingTrie::try_create(table);
+        if (trie_or_error.is_error()) {
+            // Keep the table in sync with the trie that route_to() is still using.
+            if (update == UpdateTable::Set)
+                table.remove(*route_entry);
+            else
+                table.append(*removed_route);
+            return trie_or_error.release_error();
         }
+        *s_routing_trie = trie_or_error.release_value();
         return {};
     }));
 
+    invalidate_cached_routes();
     return {};
 }
 
@@ -222,38 +357,12 @@ RoutingDecision route_to(IPv4Address const& target, IPv4Address const& source, L
             local_adapter = adapter;
     });
 
-    u32 longest_prefix_match = 0;
-    routing_table().for_each([&target_addr, &matches, &longest_prefix_match, &chosen_route](auto& route) {
-        auto route_addr = route.destination.to_u32();
-        auto route_mask = route.netmask.to_u32();
-
-        if (route_addr == 0 && matches(*route.adapter)) {
-            dbgln_if(ROUTING_DEBUG, "Resorting to default route found for adapter: {}", route.adapter->name());
-            chosen_route = route;
-        }
-
-        // We have a direct match and we can exit the routing table earlier.
-        if (target_addr == route_addr) {
-            dbgln_if(ROUTING_DEBUG, "Target address has a direct match in the routing table");
-            chosen_route = route;
-            return;
-        }
-
-        if ((target_addr & route_mask) == (route_addr & route_mask) && (route_addr != 0)) {
-            auto prefix = (target_addr & (route_addr & route_mask));
-
-            if (chosen_route && prefix == longest_prefix_match) {
-                chosen_route = (route.netmask.to_u32() > chosen_route->netmask.to_u32()) ? route : chosen_route;
-                dbgln_if(ROUTING_DEBUG, "Found a matching prefix match. Using longer netmask: {}", chosen_route->netmask);
-            }
-
-            if (prefix > longest_prefix_match) {
-                dbgln_if(ROUTING_DEBUG, "Found a longer prefix match - route: {}, netmask: {}", route.destination.to_string(), route.netmask);
-                longest_prefix_match = prefix;
-                chosen_route = route;
-            }
-        }
-    });
+    // Taking a reference keeps the trie alive even if the routing table gets updated meanwhile.
+    if (auto trie = *s_routing_trie) {
+        chosen_route = trie->longest_prefix_match(target_addr, matches);
+        if (chosen_route)
+            dbgln_if(ROUTING_DEBUG, "Found a longest prefix match - route: {}, netmask: {}", chosen_route->destination, chosen_route->netmask);
+    }
 
     if (local_adapter && target == local_adapter->ipv4_address())
         return { local_adapter, local_adapter->mac_address() };
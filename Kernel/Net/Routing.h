@@ -66,6 +66,11 @@ enum class AllowUsingGateway {
 
 RoutingDecision route_to(IPv4Address const& target, IPv4Address const& source, LockRefPtr<NetworkAdapter> const through = nullptr, AllowUsingGateway = AllowUsingGateway::Yes);
 
+// Changes whenever the routing table, the ARP table or the address of an adapter does,
+// so whoever holds on to a RoutingDecision can tell when it has to ask route_to() again.
+u32 routing_generation();
+void invalidate_cached_routes();
+
 SpinlockProtected<HashMap<IPv4Address, MACAddress>>& arp_table();
 SpinlockProtected<Route::RouteList>& routing_table();
 
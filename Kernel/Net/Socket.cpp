@@ -67,7 +67,7 @@ ErrorOr<void> Socket::queue_connection_from(NonnullLockRefPtr<Socket> peer)
 {
     dbgln_if(SOCKET_DEBUG, "Socket({}) queueing connection", this);
     MutexLocker locker(mutex());
-    if (m_pending.size() >= m_backlog)
+    if (is_accept_queue_full())
         return set_so_error(ECONNREFUSED);
     SOCKET_TRY(m_pending.try_append(move(peer)));
     evaluate_block_conditions();
@@ -128,6 +128,15 @@ ErrorOr<void> Socket::setsockopt(int level, int option, Userspace<void const*> u
     case SO_REUSEADDR:
         dbgln("FIXME: SO_REUSEADDR requested, but not implemented.");
         return {};
+    case SO_REUSEPORT: {
+        if (user_value_size != sizeof(int))
+            return EINVAL;
+        // Sharing is decided when binding to the port, changing it afterwards wouldn't do anything.
+        if (setup_state() != SetupState::Unstarted)
+            return EINVAL;
+        m_reuse_port = TRY(copy_typed_from_user(static_ptr_cast<int const*>(user_value))) != 0;
+        return {};
+    }
     default:
         dbgln("setsockopt({}) at SOL_SOCKET not implemented.", option);
         return ENOPROTOOPT;
@@ -231,6 +240,14 @@ ErrorOr<void> Socket::getsockopt(OpenFileDescription&, int level, int option, Us
         size = sizeof(routing_disabled);
         return copy_to_user(value_size, &size);
     }
+    case SO_REUSEPORT: {
+        int reuse_port = m_reuse_port ? 1 : 0;
+        if (size < sizeof(reuse_port))
+            return EINVAL;
+        TRY(copy_to_user(static_ptr_cast<int*>(value), &reuse_port));
+        size = sizeof(reuse_port);
+        return copy_to_user(value_size, &size);
+    }
     default:
         dbgln("getsockopt({}) at SOL_SOCKET not implemented.", option);
         return ENOPROTOOPT;
@@ -68,6 +68,7 @@ public:
     void set_connected(bool);
 
     bool can_accept() const { return !m_pending.is_empty(); }
+    bool is_accept_queue_full() const { return m_pending.size() >= m_backlog; }
     LockRefPtr<Socket> accept();
 
     ErrorOr<void> shutdown(int how);
@@ -108,6 +109,7 @@ public:
     Time const& send_timeout() const { return m_send_timeout; }
 
     bool wants_timestamp() const { return m_timestamp; }
+    bool reuses_port() const { return m_reuse_port; }
 
 protected:
     Socket(int domain, int type, int protocol);
@@ -177,6 +179,7 @@ private:
     Time m_receive_timeout {};
     Time m_send_timeout {};
     int m_timestamp { 0 };
+    bool m_reuse_port { false };
 
     ErrorOr<void> m_so_error;
 
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <AK/Array.h>
+#include <AK/Optional.h>
 #include <AK/StdLibExtras.h>
 #include <Kernel/Net/IPv4.h>
 
@@ -22,6 +24,20 @@ struct TCPFlags {
     };
 };
 
+// Sequence numbers wrap around, so they have to be compared relative to each other.
+inline bool tcp_sequence_before(u32 a, u32 b) { return static_cast<i32>(a - b) < 0; }
+inline bool tcp_sequence_after(u32 a, u32 b) { return static_cast<i32>(a - b) > 0; }
+
+enum class TCPOptionKind : u8 {
+    End = 0,
+    NoOperation = 1,
+    MSS = 2,
+    WindowScale = 3,
+    SACKPermitted = 4,
+    SACK = 5,
+    Timestamp = 8,
+};
+
 class [[gnu::packed]] TCPOptionMSS {
 public:
     TCPOptionMSS(u16 value)
@@ -32,13 +48,81 @@ public:
     u16 value() const { return m_value; }
 
 private:
-    u8 m_option_kind { 0x02 };
+    u8 m_option_kind { to_underlying(TCPOptionKind::MSS) };
     u8 m_option_length { sizeof(TCPOptionMSS) };
     NetworkOrdered<u16> m_value;
 };
 
 static_assert(AssertSize<TCPOptionMSS, 4>());
 
+// RFC 7323, 2.2. Window Scale Option
+class [[gnu::packed]] TCPOptionWindowScale {
+public:
+    TCPOptionWindowScale(u8 shift_count)
+        : m_shift_count(shift_count)
+    {
+    }
+
+    u8 shift_count() const { return m_shift_count; }
+
+private:
+    u8 m_option_kind { to_underlying(TCPOptionKind::WindowScale) };
+    u8 m_option_length { sizeof(TCPOptionWindowScale) };
+    u8 m_shift_count { 0 };
+};
+
+static_assert(AssertSize<TCPOptionWindowScale, 3>());
+
+// RFC 2018, 2. Sack-Permitted Option
+class [[gnu::packed]] TCPOptionSACKPermitted {
+private:
+    u8 m_option_kind { to_underlying(TCPOptionKind::SACKPermitted) };
+    u8 m_option_length { sizeof(TCPOptionSACKPermitted) };
+};
+
+static_assert(AssertSize<TCPOptionSACKPermitted, 2>());
+
+// RFC 7323, 3.2. Timestamps Option
+class [[gnu::packed]] TCPOptionTimestamp {
+public:
+    TCPOptionTimestamp(u32 value, u32 echo_reply)
+        : m_value(value)
+        , m_echo_reply(echo_reply)
+    {
+    }
+
+    u32 value() const { return m_value; }
+    u32 echo_reply() const { return m_echo_reply; }
+
+private:
+    u8 m_option_kind { to_underlying(TCPOptionKind::Timestamp) };
+    u8 m_option_length { sizeof(TCPOptionTimestamp) };
+    NetworkOrdered<u32> m_value;
+    NetworkOrdered<u32> m_echo_reply;
+};
+
+static_assert(AssertSize<TCPOptionTimestamp, 10>());
+
+// RFC 2018, 3. Sack Option Format
+struct TCPSACKBlock {
+    u32 left_edge { 0 };
+    u32 right_edge { 0 };
+};
+
+// The options that matter to us out of a received packet's header.
+struct TCPOptions {
+    // 40 bytes of options leave room for 4 SACK blocks, or 3 along with a timestamp.
+    static constexpr size_t max_sack_blocks = 4;
+
+    Optional<u16> mss;
+    Optional<u8> window_scale;
+    bool sack_permitted { false };
+    Optional<u32> timestamp_value;
+    Optional<u32> timestamp_echo_reply;
+    Array<TCPSACKBlock, max_sack_blocks> sack_blocks;
+    size_t sack_block_count { 0 };
+};
+
 class [[gnu::packed]] TCPPacket {
 public:
     TCPPacket() = default;
@@ -81,6 +165,60 @@ public:
     void const* payload() const { return ((u8 const*)this) + header_size(); }
     void* payload() { return ((u8*)this) + header_size(); }
 
+    ReadonlyBytes options() const { return { ((u8 const*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) }; }
+    Bytes options() { return { ((u8*)this) + sizeof(TCPPacket), header_size() - sizeof(TCPPacket) }; }
+
+    TCPOptions parse_options() const
+    {
+        TCPOptions result;
+        auto bytes = options();
+        for (size_t offset = 0; offset < bytes.size();) {
+            auto kind = static_cast<TCPOptionKind>(bytes[offset]);
+            if (kind == TCPOptionKind::End)
+                break;
+            if (kind == TCPOptionKind::NoOperation) {
+                ++offset;
+                continue;
+            }
+            if (offset + 1 >= bytes.size())
+                break;
+            size_t length = bytes[offset + 1];
+            if (length < 2 || offset + length > bytes.size())
+                break;
+            auto data = bytes.slice(offset + 2, length - 2);
+            auto read_u32 = [&](size_t index) {
+                return (u32)data[index] << 24 | (u32)data[index + 1] << 16 | (u32)data[index + 2] << 8 | data[index + 3];
+            };
+            switch (kind) {
+            case TCPOptionKind::MSS:
+                if (data.size() == 2)
+                    result.mss = (u16)(data[0] << 8 | data[1]);
+                break;
+            case TCPOptionKind::WindowScale:
+                if (data.size() == 1)
+                    result.window_scale = data[0];
+                break;
+            case TCPOptionKind::SACKPermitted:
+                result.sack_permitted = data.is_empty();
+                break;
+            case TCPOptionKind::SACK:
+                for (size_t index = 0; index + 8 <= data.size() && result.sack_block_count < TCPOptions::max_sack_blocks; index += 8)
+                    result.sack_blocks[result.sack_block_count++] = { read_u32(index), read_u32(index + 4) };
+                break;
+            case TCPOptionKind::Timestamp:
+                if (data.size() == 8) {
+                    result.timestamp_value = read_u32(0);
+                    result.timestamp_echo_reply = read_u32(4);
+                }
+                break;
+            default:
+                break;
+            }
+            offset += length;
+        }
+        return result;
+    }
+
 private:
     NetworkOrdered<u16> m_source_port;
     NetworkOrdered<u16> m_destination_port;
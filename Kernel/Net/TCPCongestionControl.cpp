@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <Kernel/Net/TCPCongestionControl.h>
+
+namespace Kernel {
+
+static Atomic<TCPCongestionControl::Algorithm> s_default_algorithm { TCPCongestionControl::Algorithm::Cubic };
+
+StringView TCPCongestionControl::algorithm_to_string_view(Algorithm algorithm)
+{
+    switch (algorithm) {
+    case Algorithm::NewReno:
+        return "newreno"sv;
+    case Algorithm::Cubic:
+        return "cubic"sv;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+Optional<TCPCongestionControl::Algorithm> TCPCongestionControl::algorithm_from_string_view(StringView name)
+{
+    if (name == "newreno"sv)
+        return Algorithm::NewReno;
+    if (name == "cubic"sv)
+        return Algorithm::Cubic;
+    return {};
+}
+
+TCPCongestionControl::Algorithm TCPCongestionControl::default_algorithm()
+{
+    return s_default_algorithm.load();
+}
+
+void TCPCongestionControl::set_default_algorithm(Algorithm algorithm)
+{
+    s_default_algorithm.store(algorithm);
+}
+
+ErrorOr<NonnullOwnPtr<TCPCongestionControl>> TCPCongestionControl::try_create(Algorithm algorithm, u32 mss)
+{
+    switch (algorithm) {
+    case Algorithm::NewReno:
+        return adopt_nonnull_own_or_enomem<TCPCongestionControl>(new (nothrow) TCPNewRenoCongestionControl(mss));
+    case Algorithm::Cubic:
+        return adopt_nonnull_own_or_enomem<TCPCongestionControl>(new (nothrow) TCPCubicCongestionControl(mss));
+    }
+    VERIFY_NOT_REACHED();
+}
+
+TCPCongestionControl::TCPCongestionControl(u32 mss)
+{
+    set_mss(mss);
+}
+
+void TCPCongestionControl::set_mss(u32 mss)
+{
+    m_mss = mss;
+    // RFC 6928, 2. TCP Modification
+    m_congestion_window = min(10 * mss, max(2 * mss, 14600u));
+}
+
+void TCPCongestionControl::slow_start(u32 acked_bytes)
+{
+    m_congestion_window += min(acked_bytes, m_mss);
+}
+
+void TCPNewRenoCongestionControl::on_ack(u32 acked_bytes, Time const&, Time const&)
+{
+    if (is_in_slow_start()) {
+        slow_start(acked_bytes);
+        return;
+    }
+
+    // RFC 5681, 3.1. Congestion Avoidance: Grow by one segment per window's worth of acknowledged data.
+    m_bytes_acked += acked_bytes;
+    if (m_bytes_acked >= m_congestion_window) {
+        m_bytes_acked -= m_congestion_window;
+        m_congestion_window += m_mss;
+    }
+}
+
+void TCPNewRenoCongestionControl::on_congestion_event(u32 bytes_in_flight)
+{
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_mss);
+    m_congestion_window = m_slow_start_threshold;
+    m_bytes_acked = 0;
+}
+
+void TCPNewRenoCongestionControl::on_retransmit_timeout(u32 bytes_in_flight)
+{
+    m_slow_start_threshold = max(bytes_in_flight / 2, 2 * m_mss);
+    m_congestion_window = m_mss;
+    m_bytes_acked = 0;
+}
+
+static u64 integer_cube_root(u64 value)
+{
+    u64 root = 0;
+    for (int shift = 63; shift >= 0; shift -= 3) {
+        root *= 2;
+        u64 step = 3 * root * (root + 1) + 1;
+        if ((value >> shift) >= step) {
+            value -= step << shift;
+            ++root;
+        }
+    }
+    return root;
+}
+
+// Note: The constants from RFC 8312 are C = 0.4 and beta = 0.7. We can't use floating point
+//       math in the kernel, so they are spelled out as fractions below.
+void TCPCubicCongestionControl::on_ack(u32 acked_bytes, Time const& now, Time const& smoothed_rtt)
+{
+    if (is_in_slow_start()) {
+        slow_start(acked_bytes);
+        return;
+    }
+
+    if (!m_epoch_start.has_value()) {
+        m_epoch_start = now;
+        m_pending_growth = 0;
+        if (m_congestion_window < m_max_window) {
+            // K = cubic_root((W_max - cwnd) / C), with the windows in segments and K in seconds.
+            u64 deficit = m_max_window - m_congestion_window;
+            m_time_to_origin_ms = integer_cube_root(deficit * 2'500'000'000ull / m_mss);
+            m_origin_window = m_max_window;
+        } else {
+            m_time_to_origin_ms = 0;
+            m_origin_window = m_congestion_window;
+        }
+    }
+
+    auto elapsed_ms = (now - m_epoch_start.value()).to_milliseconds();
+    auto rtt_ms = max(smoothed_rtt.to_milliseconds(), (i64)1);
+
+    // RFC 8312, 4.1. Window Increase Function: W_cubic(t + RTT) = C * (t + RTT - K)^3 + W_max
+    auto offset_ms = clamp(elapsed_ms + rtt_ms - m_time_to_origin_ms, (i64)-1'000'000, (i64)1'000'000);
+    auto growth = offset_ms * offset_ms * offset_ms / 1'000'000 * m_mss / 2'500;
+    auto target = (i64)m_origin_window + growth;
+
+    // RFC 8312, 4.2. TCP-Friendly Region: Grow at least as fast as standard TCP would have.
+    //     W_est(t) = W_max * beta + 3 * (1 - beta) / (1 + beta) * t / RTT
+    auto estimate = (i64)m_max_window * 7 / 10 + 529 * elapsed_ms * m_mss / (1000 * rtt_ms);
+    target = max(target, estimate);
+
+    // RFC 8312, 4.3 and 4.4: Close at most half of the window's size per RTT.
+    target = min(target, (i64)m_congestion_window + m_congestion_window / 2);
+    if (target <= (i64)m_congestion_window)
+        return;
+
+    // The window grows by (target - cwnd) / cwnd segments for every segment that is acknowledged.
+    m_pending_growth += (u64)(target - m_congestion_window) * acked_bytes;
+    auto window_growth = m_pending_growth / m_congestion_window;
+    m_pending_growth %= m_congestion_window;
+    m_congestion_window += window_growth;
+}
+
+void TCPCubicCongestionControl::reduce_window()
+{
+    m_epoch_start.clear();
+
+    // RFC 8312, 4.6. Fast Convergence: If we lost before even getting back to the previous
+    // maximum, there are probably new flows around, so leave some room for them.
+    if (m_congestion_window < m_max_window)
+        m_max_window = (u64)m_congestion_window * 17 / 20;
+    else
+        m_max_window = m_congestion_window;
+
+    // RFC 8312, 4.5. Multiplicative Decrease
+    m_slow_start_threshold = max((u32)((u64)m_congestion_window * 7 / 10), 2 * m_mss);
+}
+
+void TCPCubicCongestionControl::on_congestion_event(u32)
+{
+    reduce_window();
+    m_congestion_window = m_slow_start_threshold;
+}
+
+void TCPCubicCongestionControl::on_retransmit_timeout(u32)
+{
+    reduce_window();
+    m_congestion_window = m_mss;
+}
+
+}
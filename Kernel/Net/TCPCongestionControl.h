@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/StringView.h>
+#include <AK/Time.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// Decides how much data a TCP connection may have in flight. The socket reports the
+// ACKs and the losses it sees, and sends no more than the congestion window allows.
+class TCPCongestionControl {
+public:
+    enum class Algorithm : u8 {
+        NewReno,
+        Cubic,
+    };
+
+    static StringView algorithm_to_string_view(Algorithm);
+    static Optional<Algorithm> algorithm_from_string_view(StringView);
+
+    // The algorithm that new connections use.
+    static Algorithm default_algorithm();
+    static void set_default_algorithm(Algorithm);
+
+    static ErrorOr<NonnullOwnPtr<TCPCongestionControl>> try_create(Algorithm, u32 mss);
+    virtual ~TCPCongestionControl() = default;
+
+    virtual Algorithm algorithm() const = 0;
+
+    u32 congestion_window() const { return m_congestion_window; }
+    u32 slow_start_threshold() const { return m_slow_start_threshold; }
+    bool is_in_slow_start() const { return m_congestion_window < m_slow_start_threshold; }
+
+    u32 mss() const { return m_mss; }
+    // Called once the handshake has settled on the MSS, before any data is sent.
+    void set_mss(u32);
+
+    // Called for every ACK that acknowledges new data, except during fast recovery.
+    virtual void on_ack(u32 acked_bytes, Time const& now, Time const& smoothed_rtt) = 0;
+
+    // Called when a loss has been detected through duplicate ACKs or SACK, and fast recovery begins.
+    virtual void on_congestion_event(u32 bytes_in_flight) = 0;
+
+    // Called when the retransmission timer expires.
+    virtual void on_retransmit_timeout(u32 bytes_in_flight) = 0;
+
+    // Called once everything that was outstanding when fast recovery began has been acknowledged.
+    void on_recovery_exit() { m_congestion_window = m_slow_start_threshold; }
+
+protected:
+    explicit TCPCongestionControl(u32 mss);
+
+    // RFC 5681, 3.1. Slow Start: Grow by at most one segment for every ACK.
+    void slow_start(u32 acked_bytes);
+
+    u32 m_mss { 0 };
+    u32 m_congestion_window { 0 };
+    u32 m_slow_start_threshold { NumericLimits<u32>::max() };
+};
+
+// RFC 5681 and RFC 6582
+class TCPNewRenoCongestionControl final : public TCPCongestionControl {
+public:
+    explicit TCPNewRenoCongestionControl(u32 mss)
+        : TCPCongestionControl(mss)
+    {
+    }
+
+    virtual Algorithm algorithm() const override { return Algorithm::NewReno; }
+    virtual void on_ack(u32 acked_bytes, Time const& now, Time const& smoothed_rtt) override;
+    virtual void on_congestion_event(u32 bytes_in_flight) override;
+    virtual void on_retransmit_timeout(u32 bytes_in_flight) override;
+
+private:
+    // Bytes acknowledged since the window last grew during congestion avoidance (RFC 3465).
+    u32 m_bytes_acked { 0 };
+};
+
+// RFC 8312
+class TCPCubicCongestionControl final : public TCPCongestionControl {
+public:
+    explicit TCPCubicCongestionControl(u32 mss)
+        : TCPCongestionControl(mss)
+    {
+    }
+
+    virtual Algorithm algorithm() const override { return Algorithm::Cubic; }
+    virtual void on_ack(u32 acked_bytes, Time const& now, Time const& smoothed_rtt) override;
+    virtual void on_congestion_event(u32 bytes_in_flight) override;
+    virtual void on_retransmit_timeout(u32 bytes_in_flight) override;
+
+private:
+    void reduce_window();
+
+    // The window right before the last reduction (W_max), in bytes.
+    u32 m_max_window { 0 };
+    // The window the cubic function plateaus at, and how long it takes to get there (K).
+    u32 m_origin_window { 0 };
+    i64 m_time_to_origin_ms { 0 };
+    // When the current congestion avoidance period began.
+    Optional<Time> m_epoch_start;
+    // Growth that is still owed to the window, in bytes times the window size.
+    u64 m_pending_growth { 0 };
+};
+
+}
@@ -19,9 +19,33 @@
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
+// RFC 6298, 2. The Basic Algorithm: The RTO is kept within these bounds.
+static constexpr Time minimum_retransmit_timeout = Time::from_seconds(1);
+static constexpr Time maximum_retransmit_timeout = Time::from_seconds(60);
+
+// RFC 7323, 2.3. Using the Window Scale Option
+static constexpr u8 maximum_window_scale = 14;
+
+static constexpr size_t maximum_options_size = 40;
+
+// The clock we put into the timestamps option. It ticks once per millisecond.
+static u32 current_timestamp()
+{
+    return static_cast<u32>(TimeManagement::the().monotonic_time().to_milliseconds());
+}
+
+static u8 window_scale_for(size_t receive_buffer_size)
+{
+    u8 window_scale = 0;
+    while ((receive_buffer_size >> window_scale) > NumericLimits<u16>::max() && window_scale < maximum_window_scale)
+        ++window_scale;
+    return window_scale;
+}
+
 void TCPSocket::for_each(Function<void(TCPSocket const&)> callback)
 {
     sockets_by_tuple().for_each_shared([&](auto const& it) {
@@ -43,7 +67,7 @@ bool TCPSocket::unref() const
     bool did_hit_zero = sockets_by_tuple().with_exclusive([&](auto& table) {
         if (deref_base())
             return false;
-        table.remove(tuple());
+        remove_from_sockets_by_tuple(table);
         const_cast<TCPSocket&>(*this).revoke_weak_ptrs();
         return true;
     });
@@ -73,6 +97,8 @@ void TCPSocket::set_state(State new_state)
         // are packets on the way which we wouldn't want a new socket to get hit
         // with, so there's no point in keeping the receive buffer around.
         drop_receive_buffer();
+        m_out_of_order_segments.clear();
+        m_out_of_order_bytes = 0;
     }
 
     if (new_state == State::Closed) {
@@ -102,8 +128,28 @@ MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tupl
     return *s_socket_tuples;
 }
 
+static Singleton<MutexProtected<HashMap<IPv4SocketTuple, Vector<TCPSocket*>>>> s_reuse_port_groups;
+
+MutexProtected<HashMap<IPv4SocketTuple, Vector<TCPSocket*>>>& TCPSocket::reuse_port_groups()
+{
+    return *s_reuse_port_groups;
+}
+
 LockRefPtr<TCPSocket> TCPSocket::from_tuple(IPv4SocketTuple const& tuple)
 {
+    auto pick_listener = [&](TCPSocket& listener) -> LockRefPtr<TCPSocket> {
+        if (!listener.reuses_port())
+            return listener;
+        return reuse_port_groups().with_shared([&](auto const& groups) -> LockRefPtr<TCPSocket> {
+            auto group = groups.find(listener.tuple());
+            if (group == groups.end())
+                return listener;
+            // Hashing the whole tuple makes every packet of a handshake go to the same listener.
+            auto& members = group->value;
+            return *members[Traits<IPv4SocketTuple>::hash(tuple) % members.size()];
+        });
+    };
+
     return sockets_by_tuple().with_shared([&](auto const& table) -> LockRefPtr<TCPSocket> {
         auto exact_match = table.get(tuple);
         if (exact_match.has_value())
@@ -112,19 +158,52 @@ LockRefPtr<TCPSocket> TCPSocket::from_tuple(IPv4SocketTuple const& tuple)
         auto address_tuple = IPv4SocketTuple(tuple.local_address(), tuple.local_port(), IPv4Address(), 0);
         auto address_match = table.get(address_tuple);
         if (address_match.has_value())
-            return { *address_match.value() };
+            return pick_listener(*address_match.value());
 
         auto wildcard_tuple = IPv4SocketTuple(IPv4Address(), tuple.local_port(), IPv4Address(), 0);
         auto wildcard_match = table.get(wildcard_tuple);
         if (wildcard_match.has_value())
-            return { *wildcard_match.value() };
+            return pick_listener(*wildcard_match.value());
 
         return {};
     });
 }
+
+bool TCPSocket::can_share_port_with(TCPSocket const& listener) const
+{
+    // Only sockets of the same user may share a port, so nobody can steal connections meant for someone else.
+    return reuses_port() && listener.reuses_port() && listener.state() == State::Listen && origin_uid() == listener.origin_uid();
+}
+
+void TCPSocket::remove_from_sockets_by_tuple(HashMap<IPv4SocketTuple, TCPSocket*>& table) const
+{
+    auto tuple = this->tuple();
+    reuse_port_groups().with_exclusive([&](auto& groups) {
+        auto group = groups.find(tuple);
+        if (group != groups.end() && group->value.remove_first_matching([&](auto* member) { return member == this; })) {
+            // One of the remaining listeners takes our place in the table.
+            auto& members = group->value;
+            if (table.get(tuple).value_or(nullptr) == this)
+                table.set(tuple, members.first());
+            if (members.size() == 1)
+                groups.remove(group);
+            return;
+        }
+        // A socket that failed to listen has the same tuple as the one that is listening, so make sure we remove ourselves.
+        if (table.get(tuple).value_or(nullptr) == this)
+            table.remove(tuple);
+    });
+}
 ErrorOr<NonnullLockRefPtr<TCPSocket>> TCPSocket::try_create_client(IPv4Address const& new_local_address, u16 new_local_port, IPv4Address const& new_peer_address, u16 new_peer_port)
 {
     auto tuple = IPv4SocketTuple(new_local_address, new_local_port, new_peer_address, new_peer_port);
+    // Drop the SYN if too many handshakes are going on already, or if nobody would accept the connection.
+    // The peer retransmits it, so it gets another chance once things have calmed down.
+    if (m_pending_release_for_accept.size() >= maximum_syn_backlog)
+        return ENOBUFS;
+    if (is_accept_queue_full())
+        return ECONNREFUSED;
+
     return sockets_by_tuple().with_exclusive([&](auto& table) -> ErrorOr<NonnullLockRefPtr<TCPSocket>> {
         if (table.contains(tuple))
             return EEXIST;
@@ -162,10 +241,10 @@ void TCPSocket::release_for_accept(NonnullLockRefPtr<TCPSocket> socket)
     [[maybe_unused]] auto rc = queue_connection_from(move(socket));
 }
 
-TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer)
+TCPSocket::TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl> congestion_control)
     : IPv4Socket(SOCK_STREAM, protocol, move(receive_buffer), move(scratch_buffer))
+    , m_congestion_control(move(congestion_control))
 {
-    m_last_retransmit_time = kgettimeofday();
 }
 
 TCPSocket::~TCPSocket()
@@ -179,7 +258,9 @@ ErrorOr<NonnullLockRefPtr<TCPSocket>> TCPSocket::try_create(int protocol, Nonnul
 {
     // Note: Scratch buffer is only used for SOCK_STREAM sockets.
     auto scratch_buffer = TRY(KBuffer::try_create_with_size("TCPSocket: Scratch buffer"sv, 65536));
-    return adopt_nonnull_lock_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer)));
+    // Note: We don't know the MSS until the handshake, so this starts out with the smallest one.
+    auto congestion_control = TRY(TCPCongestionControl::try_create(TCPCongestionControl::default_algorithm(), 536));
+    return adopt_nonnull_lock_ref_or_enomem(new (nothrow) TCPSocket(protocol, move(receive_buffer), move(scratch_buffer), move(congestion_control)));
 }
 
 ErrorOr<size_t> TCPSocket::protocol_size(ReadonlyBytes raw_ipv4_packet)
@@ -202,11 +283,16 @@ ErrorOr<size_t> TCPSocket::protocol_receive(ReadonlyBytes raw_ipv4_packet, UserO
 
 ErrorOr<size_t> TCPSocket::protocol_send(UserOrKernelBuffer const& data, size_t data_length)
 {
-    RoutingDecision routing_decision = route_to(peer_address(), local_address(), bound_interface());
+    RoutingDecision routing_decision = route_to_peer();
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
-    size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-    data_length = min(data_length, mss);
+    auto send_window = m_unacked_packets.with_shared([&](auto const& unacked_packets) {
+        return available_send_window(unacked_packets);
+    });
+    // Don't chop the data into tiny segments just because the window is almost full.
+    if (send_window < min(data_length, (size_t)m_congestion_control->mss()))
+        return set_so_error(EAGAIN);
+    data_length = min(min(data_length, maximum_packet_payload_size(routing_decision)), send_window);
     TRY(send_tcp_packet(TCPFlags::PSH | TCPFlags::ACK, &data, data_length, &routing_decision));
     return data_length;
 }
@@ -218,16 +304,229 @@ ErrorOr<void> TCPSocket::send_ack(bool allow_duplicate)
     return send_tcp_packet(TCPFlags::ACK);
 }
 
+size_t TCPSocket::collect_sack_blocks(Span<TCPSACKBlock> blocks) const
+{
+    auto for_each_range = [&](auto callback) {
+        Optional<TCPSACKBlock> range;
+        for (auto const& segment : m_out_of_order_segments) {
+            u32 end = segment.sequence_number + segment.payload_size;
+            if (range.has_value() && !tcp_sequence_after(segment.sequence_number, range->right_edge)) {
+                if (tcp_sequence_after(end, range->right_edge))
+                    range->right_edge = end;
+                continue;
+            }
+            if (range.has_value())
+                callback(range.value());
+            range = TCPSACKBlock { segment.sequence_number, end };
+        }
+        if (range.has_value())
+            callback(range.value());
+    };
+    auto contains_latest_segment = [&](TCPSACKBlock const& block) {
+        return !tcp_sequence_before(m_last_out_of_order_sequence_number, block.left_edge) && tcp_sequence_before(m_last_out_of_order_sequence_number, block.right_edge);
+    };
+
+    // RFC 2018, 4. Generating Sack Options: Data Receiver Behavior
+    // The first block has to report the most recently received segment, the others may come in any order.
+    size_t block_count = 0;
+    for_each_range([&](auto const& block) {
+        if (block_count < blocks.size() && contains_latest_segment(block))
+            blocks[block_count++] = block;
+    });
+    for_each_range([&](auto const& block) {
+        if (block_count < blocks.size() && !contains_latest_segment(block))
+            blocks[block_count++] = block;
+    });
+    return block_count;
+}
+
+size_t TCPSocket::write_options(u16 flags, u16 local_mss, Bytes options) const
+{
+    VERIFY(options.size() >= maximum_options_size);
+    size_t offset = 0;
+    auto append = [&](auto const& option) {
+        memcpy(options.offset_pointer(offset), &option, sizeof(option));
+        offset += sizeof(option);
+    };
+    auto append_padding = [&](size_t count) {
+        for (size_t i = 0; i < count; ++i)
+            options[offset++] = to_underlying(TCPOptionKind::NoOperation);
+    };
+
+    if (flags & TCPFlags::SYN) {
+        // We offer everything we support in our own SYN, but only answer with what the peer offered to us.
+        bool is_initial_syn = !(flags & TCPFlags::ACK);
+        bool use_window_scale = is_initial_syn || m_window_scaling_enabled;
+        bool use_sack = is_initial_syn || m_sack_enabled;
+        bool use_timestamps = is_initial_syn || m_timestamps_enabled;
+
+        append(TCPOptionMSS { local_mss });
+        if (use_window_scale) {
+            append_padding(1);
+            append(TCPOptionWindowScale { window_scale_for(receive_buffer_space()) });
+        }
+        if (use_sack && use_timestamps) {
+            append(TCPOptionSACKPermitted {});
+            append(TCPOptionTimestamp { current_timestamp(), m_recent_timestamp });
+        } else if (use_timestamps) {
+            append_padding(2);
+            append(TCPOptionTimestamp { current_timestamp(), m_recent_timestamp });
+        } else if (use_sack) {
+            append_padding(2);
+            append(TCPOptionSACKPermitted {});
+        }
+        return offset;
+    }
+
+    if (m_timestamps_enabled) {
+        append_padding(2);
+        append(TCPOptionTimestamp { current_timestamp(), m_recent_timestamp });
+    }
+
+    if (m_sack_enabled && !m_out_of_order_segments.is_empty()) {
+        Array<TCPSACKBlock, TCPOptions::max_sack_blocks> blocks;
+        size_t remaining_size = maximum_options_size - offset - 4;
+        auto block_count = collect_sack_blocks(blocks.span().trim(remaining_size / 8));
+        append_padding(2);
+        options[offset++] = to_underlying(TCPOptionKind::SACK);
+        options[offset++] = 2 + block_count * 8;
+        for (size_t i = 0; i < block_count; ++i) {
+            NetworkOrdered<u32> edges[2] = { blocks[i].left_edge, blocks[i].right_edge };
+            append(edges);
+        }
+    }
+    return offset;
+}
+
+size_t TCPSocket::options_size(u16 flags) const
+{
+    Array<u8, maximum_options_size> options;
+    return write_options(flags, 0, options);
+}
+
+u16 TCPSocket::receive_window_for_packet(u16 flags) const
+{
+    // The headers of the packets we receive take up space in the receive buffer too.
+    size_t space = receive_buffer_space();
+    size_t header_room = sizeof(IPv4Packet) + sizeof(TCPPacket) + maximum_options_size;
+    space = space > header_room ? space - header_room : 0;
+
+    // RFC 7323, 2.2: The window field of a SYN is never scaled.
+    if (!(flags & TCPFlags::SYN))
+        space >>= m_receive_window_scale;
+    return min(space, (size_t)NumericLimits<u16>::max());
+}
+
+size_t TCPSocket::maximum_segment_payload_size(RoutingDecision const& routing_decision) const
+{
+    size_t mss = min((size_t)m_peer_mss, routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket));
+    // RFC 6691, 2. The Short Statement: The options have to fit into the MSS as well.
+    return mss - options_size(TCPFlags::PSH | TCPFlags::ACK);
+}
+
+size_t TCPSocket::maximum_packet_payload_size(RoutingDecision const& routing_decision) const
+{
+    auto mss = maximum_segment_payload_size(routing_decision);
+    // Sending a whole bunch of segments at once saves us most of the per-packet work, even when
+    // the adapter can't do the segmentation and it has to be done in software.
+    auto max_payload_size = NetworkAdapter::max_tcp_offload_size - sizeof(IPv4Packet) - sizeof(TCPPacket) - options_size(TCPFlags::PSH | TCPFlags::ACK);
+    return max(mss, max_payload_size / mss * mss);
+}
+
+TCPTransmitOffload TCPSocket::fill_in_checksum(TCPPacket& tcp_packet, size_t payload_size, RoutingDecision const& routing_decision) const
+{
+    auto& adapter = *routing_decision.adapter;
+    TCPTransmitOffload offload;
+    auto mss = maximum_segment_payload_size(routing_decision);
+    if (payload_size > mss)
+        offload.segment_size = mss;
+
+    tcp_packet.set_checksum(0);
+    if (adapter.has_offload(NetworkAdapter::Offload::TransmitChecksum)) {
+        tcp_packet.set_checksum(compute_tcp_pseudo_header_checksum(local_address(), peer_address(), tcp_packet.header_size() + payload_size));
+        offload.needs_checksum = true;
+    } else if (offload.segment_size == 0) {
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+    }
+    // Otherwise, the checksums are computed for each segment once the adapter has split up the packet.
+    return offload;
+}
+
+size_t TCPSocket::UnackedPackets::bytes_in_flight() const
+{
+    size_t bytes = 0;
+    for (auto const& packet : packets) {
+        // Whatever the peer has SACKed, or what we think was lost, has left the network.
+        if (!packet.is_sacked && !packet.is_lost)
+            bytes += packet.payload_size;
+    }
+    return bytes;
+}
+
+size_t TCPSocket::available_send_window(UnackedPackets const& unacked_packets) const
+{
+    auto congestion_window = m_congestion_control->congestion_window();
+
+    // With nothing outstanding, we always let one segment through. If the peer has closed its
+    // window, this is what finds out once it opens up again.
+    if (unacked_packets.packets.is_empty())
+        return max(min(congestion_window, m_send_window_size), m_congestion_control->mss());
+
+    auto bytes_in_flight = unacked_packets.bytes_in_flight();
+    size_t congestion_window_space = congestion_window > bytes_in_flight ? congestion_window - bytes_in_flight : 0;
+    size_t receive_window_space = m_send_window_size > unacked_packets.size ? m_send_window_size - unacked_packets.size : 0;
+    return min(congestion_window_space, receive_window_space);
+}
+
+void TCPSocket::negotiate_options(TCPPacket const& syn_packet)
+{
+    VERIFY(syn_packet.has_syn());
+    auto options = syn_packet.parse_options();
+
+    if (options.mss.has_value() && options.mss.value() > 0)
+        m_peer_mss = options.mss.value();
+
+    // RFC 7323, 2.2. Window Scale Option
+    m_window_scaling_enabled = options.window_scale.has_value();
+    if (m_window_scaling_enabled) {
+        m_send_window_scale = min(options.window_scale.value(), maximum_window_scale);
+        m_receive_window_scale = window_scale_for(receive_buffer_space());
+    } else {
+        m_send_window_scale = 0;
+        m_receive_window_scale = 0;
+    }
+    // The window in a SYN is never scaled.
+    m_send_window_size = syn_packet.window_size();
+
+    m_sack_enabled = options.sack_permitted;
+
+    // RFC 7323, 3.2. Timestamps Option
+    m_timestamps_enabled = options.timestamp_value.has_value();
+    if (m_timestamps_enabled)
+        m_recent_timestamp = options.timestamp_value.value();
+
+    auto routing_decision = route_to_peer();
+    if (!routing_decision.is_zero())
+        m_congestion_control->set_mss(maximum_segment_payload_size(routing_decision));
+    else
+        m_congestion_control->set_mss(m_peer_mss - options_size(TCPFlags::ACK));
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) negotiated mss={}, window_scale={}/{}, sack={}, timestamps={}",
+        this, m_congestion_control->mss(), m_send_window_scale, m_receive_window_scale, m_sack_enabled, m_timestamps_enabled);
+}
+
 ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* payload, size_t payload_size, RoutingDecision* user_routing_decision)
 {
-    RoutingDecision routing_decision = user_routing_decision ? *user_routing_decision : route_to(peer_address(), local_address(), bound_interface());
+    RoutingDecision routing_decision = user_routing_decision ? *user_routing_decision : route_to_peer();
     if (routing_decision.is_zero())
         return set_so_error(EHOSTUNREACH);
 
     auto ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
 
-    bool const has_mss_option = flags == TCPFlags::SYN;
-    const size_t options_size = has_mss_option ? sizeof(TCPOptionMSS) : 0;
+    u16 local_mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    Array<u8, maximum_options_size> options;
+    size_t const options_size = write_options(flags, local_mss, options);
+    VERIFY(options_size % sizeof(u32) == 0);
     const size_t tcp_header_size = sizeof(TCPPacket) + options_size;
     const size_t buffer_size = ipv4_payload_offset + tcp_header_size + payload_size;
     auto packet = routing_decision.adapter->acquire_packet_buffer(buffer_size);
@@ -241,10 +540,11 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
     VERIFY(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(NumericLimits<u16>::max());
+    tcp_packet.set_window_size(receive_window_for_packet(flags));
     tcp_packet.set_sequence_number(m_sequence_number);
     tcp_packet.set_data_offset(tcp_header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
+    memcpy(tcp_packet.options().data(), options.data(), options_size);
 
     if (payload) {
         if (auto result = payload->read(tcp_packet.payload(), payload_size); result.is_error()) {
@@ -265,26 +565,40 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
         m_sequence_number += payload_size;
     }
 
-    if (has_mss_option) {
-        u16 mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
-        TCPOptionMSS mss_option { mss };
-        VERIFY(packet->buffer->size() >= ipv4_payload_offset + sizeof(TCPPacket) + sizeof(mss_option));
-        memcpy(packet->buffer->data() + ipv4_payload_offset + sizeof(TCPPacket), &mss_option, sizeof(mss_option));
-    }
-
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+    auto offload = fill_in_checksum(tcp_packet, payload_size, routing_decision);
 
     bool expect_ack { tcp_packet.has_syn() || payload_size > 0 };
     if (expect_ack) {
         bool append_failed { false };
         m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            auto result = unacked_packets.packets.try_append({ m_sequence_number, packet, ipv4_payload_offset, *routing_decision.adapter });
-            if (result.is_error()) {
-                dbgln("TCPSocket: Dropped outbound packet because try_append() failed");
-                append_failed = true;
-                return;
-            }
+            auto now = TimeManagement::the().monotonic_time();
+            // The peer acknowledges, SACKs and loses segments, not the packets we hand to the adapter,
+            // so that's what we keep track of.
+            u32 segment_size = offload.segment_size != 0 ? offload.segment_size : payload_size;
+            u32 payload_offset = 0;
+            do {
+                u32 segment_payload_size = min(segment_size, payload_size - payload_offset);
+                u32 ack_number = m_sequence_number - (payload_size - payload_offset - segment_payload_size);
+                auto result = unacked_packets.packets.try_append({ ack_number, segment_payload_size, payload_offset, packet, ipv4_payload_offset, *routing_decision.adapter, now });
+                if (result.is_error()) {
+                    if (payload_offset == 0) {
+                        dbgln("TCPSocket: Dropped outbound packet because try_append() failed");
+                        append_failed = true;
+                        return;
+                    }
+                    // Keep track of the rest in one piece, it's going out either way.
+                    auto& last_segment = unacked_packets.packets.last();
+                    last_segment.ack_number = m_sequence_number;
+                    last_segment.payload_size += payload_size - payload_offset;
+                    break;
+                }
+                payload_offset += segment_payload_size;
+            } while (payload_offset < payload_size);
             unacked_packets.size += payload_size;
+            m_send_queue_size = unacked_packets.size;
+            // RFC 6298, 5. Managing the RTO Timer: (5.1)
+            if (!m_retransmit_deadline.has_value())
+                m_retransmit_deadline = now + m_retransmit_timeout;
             enqueue_for_retransmit();
         });
         if (append_failed)
@@ -293,7 +607,7 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
     m_packets_out++;
     m_bytes_out += buffer_size;
-    routing_decision.adapter->send_packet(packet->bytes());
+    routing_decision.adapter->send_tcp_packet(packet->bytes(), offload);
     if (!expect_ack)
         routing_decision.adapter->release_packet_buffer(*packet);
 
@@ -302,44 +616,405 @@ ErrorOr<void> TCPSocket::send_tcp_packet(u16 flags, UserOrKernelBuffer const* pa
 
 void TCPSocket::receive_tcp_packet(TCPPacket const& packet, u16 size)
 {
-    if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+    auto options = packet.parse_options();
+
+    // RFC 7323, 4.3. Which Timestamp to Echo
+    if (m_timestamps_enabled && options.timestamp_value.has_value()) {
+        if (!tcp_sequence_after(packet.sequence_number(), m_last_ack_number_sent) && !tcp_sequence_before(options.timestamp_value.value(), m_recent_timestamp))
+            m_recent_timestamp = options.timestamp_value.value();
+    }
 
-        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+    if (packet.has_ack())
+        process_ack(packet, options, size - packet.header_size());
 
-        int removed = 0;
-        m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-            while (!unacked_packets.packets.is_empty()) {
-                auto& packet = unacked_packets.packets.first();
-
-                dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
-
-                if (packet.ack_number <= ack_number) {
-                    auto old_adapter = packet.adapter.strong_ref();
-                    if (old_adapter)
-                        old_adapter->release_packet_buffer(*packet.buffer);
-                    TCPPacket& tcp_packet = *(TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                    auto payload_size = packet.buffer->buffer->data() + packet.buffer->buffer->size() - (u8*)tcp_packet.payload();
-                    unacked_packets.size -= payload_size;
-                    evaluate_block_conditions();
-                    unacked_packets.packets.take_first();
-                    removed++;
-                } else {
+    m_packets_in++;
+    m_bytes_in += packet.header_size() + size;
+}
+
+void TCPSocket::process_ack(TCPPacket const& packet, TCPOptions const& options, size_t payload_size)
+{
+    u32 ack_number = packet.ack_number();
+
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet: {}", ack_number);
+
+    // An ACK for something that has been acknowledged already can't tell us anything new.
+    if (tcp_sequence_before(ack_number, m_send_unacknowledged))
+        return;
+
+    auto now = TimeManagement::the().monotonic_time();
+    u32 window_size = packet.window_size() << (packet.has_syn() ? 0 : m_send_window_scale);
+    bool is_new_ack = tcp_sequence_after(ack_number, m_send_unacknowledged);
+    // RFC 5681, 2. Definitions: DUPLICATE ACKNOWLEDGMENT
+    bool is_duplicate_ack = !is_new_ack && payload_size == 0 && !packet.has_syn() && !packet.has_fin() && window_size == m_send_window_size;
+    m_send_window_size = window_size;
+    if (is_new_ack)
+        m_send_unacknowledged = ack_number;
+
+    // RFC 7323, 4.1. RTTM Rule: With timestamps, any ACK of new data gives us an RTT sample,
+    // even when the data was retransmitted.
+    Optional<Time> rtt;
+    if (is_new_ack && m_timestamps_enabled && options.timestamp_echo_reply.has_value() && options.timestamp_echo_reply.value() != 0)
+        rtt = Time::from_milliseconds(current_timestamp() - options.timestamp_echo_reply.value());
+
+    int removed = 0;
+    m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
+        u32 acked_bytes = 0;
+        while (!unacked_packets.packets.is_empty()) {
+            auto& packet = unacked_packets.packets.first();
+
+            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: iterate: {}", packet.ack_number);
+
+            if (tcp_sequence_after(packet.ack_number, ack_number)) {
+                // The peer may acknowledge part of a segment, e.g. if we resent it with a smaller MSS.
+                // Whatever was acknowledged doesn't need to be sent again, nor does it count as in flight.
+                u32 sequence_number = packet.ack_number - packet.payload_size;
+                if (tcp_sequence_after(ack_number, sequence_number)) {
+                    u32 acked_part = ack_number - sequence_number;
+                    packet.payload_offset += acked_part;
+                    packet.payload_size -= acked_part;
+                    unacked_packets.size -= acked_part;
+                    m_send_queue_size = unacked_packets.size;
+                    acked_bytes += acked_part;
+                }
+                break;
+            }
+
+            // RFC 6298, 3. Taking RTT Samples: Karn's algorithm
+            if (packet.tx_counter == 0 && !m_timestamps_enabled)
+                rtt = now - packet.sent_time;
+
+            unacked_packets.size -= packet.payload_size;
+            m_send_queue_size = unacked_packets.size;
+            acked_bytes += packet.payload_size;
+            auto acked_packet = unacked_packets.packets.take_first();
+            removed++;
+
+            // The buffer goes back to the adapter along with the last segment that was sent in it.
+            if (!unacked_packets.packets.is_empty() && unacked_packets.packets.first().buffer == acked_packet.buffer)
+                continue;
+            auto old_adapter = acked_packet.adapter.strong_ref();
+            if (old_adapter)
+                old_adapter->release_packet_buffer(*acked_packet.buffer);
+        }
+
+        // RFC 2018, 5. Interpreting the Sack Option and Retransmission Strategy
+        if (m_sack_enabled) {
+            for (size_t i = 0; i < options.sack_block_count; ++i) {
+                auto const& block = options.sack_blocks[i];
+                for (auto& outgoing_packet : unacked_packets.packets) {
+                    u32 sequence_number = outgoing_packet.ack_number - outgoing_packet.payload_size;
+                    if (outgoing_packet.payload_size > 0 && !tcp_sequence_before(sequence_number, block.left_edge) && !tcp_sequence_after(outgoing_packet.ack_number, block.right_edge))
+                        outgoing_packet.is_sacked = true;
+                }
+            }
+        }
+
+        if (rtt.has_value())
+            update_rtt(rtt.value());
+
+        if (is_new_ack) {
+            m_retransmit_attempts = 0;
+            m_duplicate_acks_received = 0;
+            restart_retransmit_timer(unacked_packets);
+        }
+
+        if (unacked_packets.packets.is_empty())
+            dequeue_for_retransmit();
+
+        if (m_recovery_state != RecoveryState::None && !tcp_sequence_before(ack_number, m_recovery_point)) {
+            if (m_recovery_state == RecoveryState::FastRecovery)
+                m_congestion_control->on_recovery_exit();
+            m_recovery_state = RecoveryState::None;
+        }
+
+        if (acked_bytes > 0 && m_recovery_state != RecoveryState::FastRecovery)
+            m_congestion_control->on_ack(acked_bytes, now, m_smoothed_rtt.value_or(m_retransmit_timeout));
+
+        switch (m_recovery_state) {
+        case RecoveryState::None: {
+            if (is_duplicate_ack && !unacked_packets.packets.is_empty())
+                ++m_duplicate_acks_received;
+            bool found_lost_packets = mark_lost_packets(unacked_packets);
+            if (found_lost_packets || m_duplicate_acks_received >= duplicate_ack_threshold) {
+                enter_recovery(unacked_packets, RecoveryState::FastRecovery);
+                retransmit_lost_packets(unacked_packets, true);
+            }
+            break;
+        }
+        case RecoveryState::FastRecovery:
+            mark_lost_packets(unacked_packets);
+            // RFC 6582, 3.2. Specification: A partial ACK means that the packet right after it got lost as well.
+            if (is_new_ack) {
+                for (auto& outgoing_packet : unacked_packets.packets) {
+                    if (outgoing_packet.is_sacked)
+                        continue;
+                    if (!outgoing_packet.was_retransmitted)
+                        outgoing_packet.is_lost = true;
                     break;
                 }
             }
+            retransmit_lost_packets(unacked_packets, false);
+            break;
+        case RecoveryState::RetransmitTimeout:
+            retransmit_lost_packets(unacked_packets, false);
+            break;
+        }
+
+        dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
+    });
+
+    if (removed > 0 || is_new_ack)
+        evaluate_block_conditions();
+}
 
-            if (unacked_packets.packets.is_empty()) {
-                m_retransmit_attempts = 0;
-                dequeue_for_retransmit();
+void TCPSocket::update_rtt(Time const& rtt)
+{
+    // RFC 6298, 2. The Basic Algorithm
+    auto rtt_us = rtt.to_microseconds();
+    if (!m_smoothed_rtt.has_value()) {
+        m_smoothed_rtt = rtt;
+        m_rtt_variance = Time::from_microseconds(rtt_us / 2);
+    } else {
+        auto smoothed_rtt_us = m_smoothed_rtt->to_microseconds();
+        auto deviation_us = smoothed_rtt_us > rtt_us ? smoothed_rtt_us - rtt_us : rtt_us - smoothed_rtt_us;
+        m_rtt_variance = Time::from_microseconds((3 * m_rtt_variance.to_microseconds() + deviation_us) / 4);
+        m_smoothed_rtt = Time::from_microseconds((7 * smoothed_rtt_us + rtt_us) / 8);
+    }
+    auto retransmit_timeout = m_smoothed_rtt.value() + Time::from_microseconds(4 * m_rtt_variance.to_microseconds());
+    m_retransmit_timeout = clamp(retransmit_timeout, minimum_retransmit_timeout, maximum_retransmit_timeout);
+}
+
+void TCPSocket::restart_retransmit_timer(UnackedPackets const& unacked_packets)
+{
+    // RFC 6298, 5. Managing the RTO Timer: (5.2) and (5.3)
+    if (unacked_packets.packets.is_empty())
+        m_retransmit_deadline.clear();
+    else
+        m_retransmit_deadline = TimeManagement::the().monotonic_time() + m_retransmit_timeout;
+}
+
+bool TCPSocket::mark_lost_packets(UnackedPackets& unacked_packets)
+{
+    if (!m_sack_enabled)
+        return false;
+
+    // RFC 6675, 4. Algorithm Details: IsLost()
+    // A packet is lost once more than (DupThresh - 1) segments' worth of data after it has been SACKed.
+    size_t sacked_bytes_after = 0;
+    for (auto const& packet : unacked_packets.packets) {
+        if (packet.is_sacked)
+            sacked_bytes_after += packet.payload_size;
+    }
+
+    bool found_lost_packets = false;
+    size_t loss_threshold = (duplicate_ack_threshold - 1) * m_congestion_control->mss();
+    for (auto& packet : unacked_packets.packets) {
+        if (packet.is_sacked) {
+            sacked_bytes_after -= packet.payload_size;
+            continue;
+        }
+        if (sacked_bytes_after <= loss_threshold)
+            break;
+        if (!packet.was_retransmitted)
+            packet.is_lost = true;
+        found_lost_packets |= packet.is_lost;
+    }
+    return found_lost_packets;
+}
+
+void TCPSocket::enter_recovery(UnackedPackets& unacked_packets, RecoveryState state)
+{
+    VERIFY(state != RecoveryState::None);
+    dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) entering {} recovery with {} bytes outstanding",
+        this, state == RecoveryState::FastRecovery ? "fast"sv : "timeout"sv, unacked_packets.size);
+
+    m_recovery_state = state;
+    m_recovery_point = m_sequence_number;
+    m_duplicate_acks_received = 0;
+
+    for (auto& packet : unacked_packets.packets)
+        packet.was_retransmitted = false;
+
+    if (state == RecoveryState::FastRecovery) {
+        m_congestion_control->on_congestion_event(unacked_packets.size);
+        for (auto& packet : unacked_packets.packets) {
+            if (!packet.is_sacked) {
+                packet.is_lost = true;
+                break;
             }
+        }
+        return;
+    }
 
-            dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket: receive_tcp_packet acknowledged {} packets", removed);
-        });
+    // RFC 6675, 5.1. Retransmission Timeouts: Forget what the peer has told us through SACK,
+    // and send everything again.
+    m_congestion_control->on_retransmit_timeout(unacked_packets.size);
+    for (auto& packet : unacked_packets.packets) {
+        packet.is_sacked = false;
+        packet.is_lost = true;
+    }
+}
+
+void TCPSocket::retransmit_lost_packets(UnackedPackets& unacked_packets, bool send_at_least_one)
+{
+    auto routing_decision = route_to_peer();
+    if (routing_decision.is_zero())
+        return;
+
+    auto bytes_in_flight = unacked_packets.bytes_in_flight();
+    auto congestion_window = m_congestion_control->congestion_window();
+    for (auto& packet : unacked_packets.packets) {
+        if (!packet.is_lost)
+            continue;
+        if (bytes_in_flight >= congestion_window && !send_at_least_one)
+            break;
+        send_at_least_one = false;
+        retransmit_packet(packet, routing_decision);
+        packet.is_lost = false;
+        packet.was_retransmitted = true;
+        bytes_in_flight += packet.payload_size;
     }
+}
 
-    m_packets_in++;
-    m_bytes_in += packet.header_size() + size;
+static void update_timestamp_option(TCPPacket& packet, u32 value, u32 echo_reply)
+{
+    auto options = packet.options();
+    for (size_t offset = 0; offset < options.size();) {
+        auto kind = static_cast<TCPOptionKind>(options[offset]);
+        if (kind == TCPOptionKind::End)
+            return;
+        if (kind == TCPOptionKind::NoOperation) {
+            ++offset;
+            continue;
+        }
+        if (kind == TCPOptionKind::Timestamp) {
+            TCPOptionTimestamp timestamp { value, echo_reply };
+            memcpy(options.offset_pointer(offset), &timestamp, sizeof(timestamp));
+            return;
+        }
+        offset += options[offset + 1];
+    }
+}
+
+void TCPSocket::retransmit_packet(OutgoingPacket& packet, RoutingDecision& routing_decision)
+{
+    size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
+    if (ipv4_payload_offset != packet.ipv4_payload_offset) {
+        // FIXME: Add support for this. This can happen if after a route change
+        // we ended up on another adapter which doesn't have the same layer 2 type
+        // like the previous adapter.
+        VERIFY_NOT_REACHED();
+    }
+
+    // If the packet was sent in a buffer together with other segments (or the peer has acknowledged
+    // part of it), only its own part of the buffer goes out again, in a packet of its own.
+    auto buffer = packet.buffer;
+    auto const& original_tcp_packet = *(TCPPacket const*)(packet.buffer->buffer->data() + ipv4_payload_offset);
+    size_t headers_size = ipv4_payload_offset + original_tcp_packet.header_size();
+    size_t buffer_payload_size = packet.buffer->buffer->size() - headers_size;
+    bool is_part_of_buffer = packet.payload_offset != 0 || packet.payload_size != buffer_payload_size;
+    if (is_part_of_buffer) {
+        buffer = routing_decision.adapter->acquire_packet_buffer(headers_size + packet.payload_size);
+        if (!buffer) {
+            // The retransmission timer makes sure we get around to it eventually.
+            dbgln("TCPSocket: Couldn't retransmit a segment because we're out of memory");
+            return;
+        }
+        memcpy(buffer->buffer->data(), packet.buffer->buffer->data(), headers_size);
+        memcpy(buffer->buffer->data() + headers_size, packet.buffer->buffer->data() + headers_size + packet.payload_offset, packet.payload_size);
+        auto& segment_tcp_packet = *(TCPPacket*)(buffer->buffer->data() + ipv4_payload_offset);
+        segment_tcp_packet.set_sequence_number(packet.ack_number - packet.payload_size);
+        // Only the end of the data is pushed or finishes the connection.
+        if (packet.payload_offset + packet.payload_size != buffer_payload_size)
+            segment_tcp_packet.set_flags(segment_tcp_packet.flags() & ~(TCPFlags::PSH | TCPFlags::FIN));
+    }
+
+    packet.tx_counter++;
+    m_packets_retransmitted++;
+
+    auto& tcp_packet = *(TCPPacket*)(buffer->buffer->data() + ipv4_payload_offset);
+
+    if constexpr (TCP_SOCKET_DEBUG) {
+        dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
+            local_address(), local_port(),
+            peer_address(), peer_port(),
+            (tcp_packet.has_syn() ? "SYN " : ""),
+            (tcp_packet.has_ack() ? "ACK " : ""),
+            (tcp_packet.has_fin() ? "FIN " : ""),
+            (tcp_packet.has_rst() ? "RST " : ""),
+            tcp_packet.sequence_number(),
+            tcp_packet.ack_number(),
+            packet.tx_counter);
+    }
+
+    // Bring the header up to date, so the peer doesn't get stale information from us.
+    if (tcp_packet.has_ack()) {
+        m_last_ack_number_sent = m_ack_number;
+        m_last_ack_sent_time = kgettimeofday();
+        tcp_packet.set_ack_number(m_ack_number);
+    }
+    tcp_packet.set_window_size(receive_window_for_packet(tcp_packet.flags()));
+    update_timestamp_option(tcp_packet, current_timestamp(), m_recent_timestamp);
+    auto offload = fill_in_checksum(tcp_packet, packet.payload_size, routing_decision);
+
+    auto packet_buffer = buffer->bytes();
+
+    routing_decision.adapter->fill_in_ipv4_header(*buffer,
+        local_address(), routing_decision.next_hop, peer_address(),
+        IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
+    routing_decision.adapter->send_tcp_packet(packet_buffer, offload);
+    m_packets_out++;
+    m_bytes_out += packet_buffer.size();
+
+    if (is_part_of_buffer)
+        routing_decision.adapter->release_packet_buffer(*buffer);
+}
+
+void TCPSocket::queue_out_of_order_segment(TCPPacket const& packet, ReadonlyBytes raw_ipv4_packet, Time const& packet_timestamp)
+{
+    u32 sequence_number = packet.sequence_number();
+    u32 payload_size = raw_ipv4_packet.size() - sizeof(IPv4Packet) - packet.header_size();
+
+    // Don't hold on to more than we could possibly have a window for.
+    if (m_out_of_order_bytes + payload_size > receive_buffer_space())
+        return;
+
+    size_t index = 0;
+    for (; index < m_out_of_order_segments.size(); ++index) {
+        auto const& segment = m_out_of_order_segments[index];
+        if (segment.sequence_number == sequence_number)
+            return;
+        if (tcp_sequence_after(segment.sequence_number, sequence_number))
+            break;
+    }
+
+    auto buffer_or_error = KBuffer::try_create_with_bytes("TCPSocket: Out of order segment"sv, raw_ipv4_packet);
+    if (buffer_or_error.is_error())
+        return;
+    if (m_out_of_order_segments.try_insert(index, { sequence_number, payload_size, buffer_or_error.release_value(), packet_timestamp }).is_error())
+        return;
+    m_out_of_order_bytes += payload_size;
+    m_last_out_of_order_sequence_number = sequence_number;
+}
+
+bool TCPSocket::receive_queued_segments()
+{
+    bool had_gap = !m_out_of_order_segments.is_empty();
+    while (!m_out_of_order_segments.is_empty()) {
+        auto& segment = m_out_of_order_segments.first();
+        if (tcp_sequence_after(segment.sequence_number, m_ack_number))
+            break;
+        if (segment.sequence_number == m_ack_number) {
+            if (!did_receive(peer_address(), peer_port(), segment.raw_ipv4_packet->bytes(), segment.timestamp))
+                break;
+            m_ack_number += segment.payload_size;
+        }
+        // Note: A segment that starts before that but overlaps what we have received by now is
+        //       dropped, and the peer will send that data again.
+        m_out_of_order_bytes -= segment.payload_size;
+        m_out_of_order_segments.take_first();
+    }
+    return had_gap;
 }
 
 bool TCPSocket::should_delay_next_ack() const
@@ -358,7 +1033,7 @@ bool TCPSocket::should_delay_next_ack() const
     return true;
 }
 
-NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(IPv4Address const& source, IPv4Address const& destination, TCPPacket const& packet, u16 payload_size)
+NetworkOrdered<u16> TCPSocket::compute_tcp_pseudo_header_checksum(IPv4Address const& source, IPv4Address const& destination, u16 tcp_size)
 {
     struct [[gnu::packed]] PseudoHeader {
         IPv4Address source;
@@ -368,7 +1043,7 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(IPv4Address const& source, I
         NetworkOrdered<u16> payload_size;
     };
 
-    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, packet.header_size() + payload_size };
+    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, tcp_size };
 
     u32 checksum = 0;
     auto raw_pseudo_header = bit_cast<u16*>(&pseudo_header);
@@ -377,6 +1052,12 @@ NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(IPv4Address const& source, I
         if (checksum > 0xffff)
             checksum = (checksum >> 16) + (checksum & 0xffff);
     }
+    return checksum;
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(IPv4Address const& source, IPv4Address const& destination, TCPPacket const& packet, u16 payload_size)
+{
+    u32 checksum = compute_tcp_pseudo_header_checksum(source, destination, packet.header_size() + payload_size);
     auto raw_packet = bit_cast<u16*>(&packet);
     for (size_t i = 0; i < packet.header_size() / sizeof(u16); ++i) {
         checksum += AK::convert_between_host_and_network_endian(raw_packet[i]);
@@ -413,14 +1094,26 @@ ErrorOr<void> TCPSocket::protocol_bind()
 ErrorOr<void> TCPSocket::protocol_listen(bool did_allocate_port)
 {
     if (!did_allocate_port) {
-        bool ok = sockets_by_tuple().with_exclusive([&](auto& table) -> bool {
-            if (table.contains(tuple()))
-                return false;
-            table.set(tuple(), this);
-            return true;
-        });
-        if (!ok)
-            return set_so_error(EADDRINUSE);
+        TRY(sockets_by_tuple().with_exclusive([&](auto& table) -> ErrorOr<void> {
+            auto listener = table.get(tuple());
+            if (!listener.has_value()) {
+                table.set(tuple(), this);
+                return {};
+            }
+            if (!can_share_port_with(*listener.value()))
+                return set_so_error(EADDRINUSE);
+            return reuse_port_groups().with_exclusive([&](auto& groups) -> ErrorOr<void> {
+                auto group = groups.find(tuple());
+                if (group == groups.end()) {
+                    Vector<TCPSocket*> members;
+                    TRY(members.try_append(listener.value()));
+                    TRY(groups.try_set(tuple(), move(members)));
+                    group = groups.find(tuple());
+                }
+                TRY(group->value.try_append(this));
+                return {};
+            });
+        }));
     }
 
     set_direction(Direction::Passive);
@@ -442,7 +1135,7 @@ ErrorOr<void> TCPSocket::protocol_connect(OpenFileDescription& description)
     if (auto result = allocate_local_port_if_needed(); result.error_or_port.is_error())
         return result.error_or_port.release_error();
 
-    m_sequence_number = get_good_random<u32>();
+    set_sequence_number(get_good_random<u32>());
     m_ack_number = 0;
 
     set_setup_state(SetupState::InProgress);
@@ -527,6 +1220,31 @@ void TCPSocket::shut_down_for_writing()
     }
 }
 
+ErrorOr<void> TCPSocket::try_add_statistics(JsonObjectSerializer<KBufferBuilder>& object) const
+{
+    TRY(IPv4Socket::try_add_statistics(object));
+    TRY(object.add("state"sv, to_string(state())));
+    TRY(object.add("ack_number"sv, ack_number()));
+    TRY(object.add("sequence_number"sv, sequence_number()));
+    TRY(object.add("packets_in"sv, packets_in()));
+    TRY(object.add("bytes_in"sv, bytes_in()));
+    TRY(object.add("packets_out"sv, packets_out()));
+    TRY(object.add("bytes_out"sv, bytes_out()));
+    TRY(object.add("packets_retransmitted"sv, packets_retransmitted()));
+    TRY(object.add("send_queue_size"sv, send_queue_size()));
+    TRY(object.add("congestion_control"sv, TCPCongestionControl::algorithm_to_string_view(congestion_control().algorithm())));
+    TRY(object.add("congestion_window"sv, congestion_control().congestion_window()));
+    TRY(object.add("slow_start_threshold"sv, congestion_control().slow_start_threshold()));
+    if (auto smoothed_rtt = this->smoothed_rtt(); smoothed_rtt.has_value())
+        TRY(object.add("smoothed_rtt_us"sv, smoothed_rtt->to_microseconds()));
+    TRY(object.add("retransmit_timeout_us"sv, retransmit_timeout().to_microseconds()));
+    TRY(object.add("sack"sv, is_sack_enabled()));
+    TRY(object.add("timestamps"sv, are_timestamps_enabled()));
+    TRY(object.add("send_window_scale"sv, send_window_scale()));
+    TRY(object.add("receive_window_scale"sv, receive_window_scale()));
+    return {};
+}
+
 ErrorOr<void> TCPSocket::close()
 {
     MutexLocker locker(mutex());
@@ -567,20 +1285,12 @@ void TCPSocket::dequeue_for_retransmit()
 
 void TCPSocket::retransmit_packets()
 {
-    auto now = kgettimeofday();
-
-    // RFC6298 says we should have at least one second between retransmits. According to
-    // RFC1122 we must do exponential backoff - even for SYN packets.
-    i64 retransmit_interval = 1;
-    for (decltype(m_retransmit_attempts) i = 0; i < m_retransmit_attempts; i++)
-        retransmit_interval *= 2;
-
-    if (m_last_retransmit_time > now - Time::from_seconds(retransmit_interval))
+    auto now = TimeManagement::the().monotonic_time();
+    if (!m_retransmit_deadline.has_value() || now < m_retransmit_deadline.value())
         return;
 
     dbgln_if(TCP_SOCKET_DEBUG, "TCPSocket({}) handling retransmit", this);
 
-    m_last_retransmit_time = now;
     ++m_retransmit_attempts;
 
     if (m_retransmit_attempts > maximum_retransmits) {
@@ -590,45 +1300,20 @@ void TCPSocket::retransmit_packets()
         return;
     }
 
-    auto routing_decision = route_to(peer_address(), local_address(), bound_interface());
-    if (routing_decision.is_zero())
-        return;
+    // RFC 6298, 5. Managing the RTO Timer: (5.5) and (5.6)
+    // According to RFC1122 we must do exponential backoff - even for SYN packets.
+    m_retransmit_timeout = min(Time::from_microseconds(2 * m_retransmit_timeout.to_microseconds()), maximum_retransmit_timeout);
+    m_retransmit_deadline = now + m_retransmit_timeout;
 
     m_unacked_packets.with_exclusive([&](auto& unacked_packets) {
-        for (auto& packet : unacked_packets.packets) {
-            packet.tx_counter++;
-
-            if constexpr (TCP_SOCKET_DEBUG) {
-                auto& tcp_packet = *(const TCPPacket*)(packet.buffer->buffer->data() + packet.ipv4_payload_offset);
-                dbgln("Sending TCP packet from {}:{} to {}:{} with ({}{}{}{}) seq_no={}, ack_no={}, tx_counter={}",
-                    local_address(), local_port(),
-                    peer_address(), peer_port(),
-                    (tcp_packet.has_syn() ? "SYN " : ""),
-                    (tcp_packet.has_ack() ? "ACK " : ""),
-                    (tcp_packet.has_fin() ? "FIN " : ""),
-                    (tcp_packet.has_rst() ? "RST " : ""),
-                    tcp_packet.sequence_number(),
-                    tcp_packet.ack_number(),
-                    packet.tx_counter);
-            }
-
-            size_t ipv4_payload_offset = routing_decision.adapter->ipv4_payload_offset();
-            if (ipv4_payload_offset != packet.ipv4_payload_offset) {
-                // FIXME: Add support for this. This can happen if after a route change
-                // we ended up on another adapter which doesn't have the same layer 2 type
-                // like the previous adapter.
-                VERIFY_NOT_REACHED();
-            }
-
-            auto packet_buffer = packet.buffer->bytes();
-
-            routing_decision.adapter->fill_in_ipv4_header(*packet.buffer,
-                local_address(), routing_decision.next_hop, peer_address(),
-                IPv4Protocol::TCP, packet_buffer.size() - ipv4_payload_offset, type_of_service(), ttl());
-            routing_decision.adapter->send_packet(packet_buffer);
-            m_packets_out++;
-            m_bytes_out += packet_buffer.size();
+        if (unacked_packets.packets.is_empty()) {
+            m_retransmit_deadline.clear();
+            return;
         }
+        enter_recovery(unacked_packets, RecoveryState::RetransmitTimeout);
+        // RFC 6298, 5. Managing the RTO Timer: (5.4) Only the earliest packet goes out right away,
+        // the rest follow as the ACKs come in and the congestion window opens up again.
+        retransmit_lost_packets(unacked_packets, true);
     });
 }
 
@@ -640,11 +1325,8 @@ bool TCPSocket::can_write(OpenFileDescription const& file_description, u64 size)
     if (m_state == State::SynSent || m_state == State::SynReceived)
         return false;
 
-    if (!file_description.is_blocking())
-        return true;
-
-    return m_unacked_packets.with_shared([&](auto& unacked_packets) {
-        return unacked_packets.size + size <= m_send_window_size;
+    return m_unacked_packets.with_shared([&](auto const& unacked_packets) {
+        return available_send_window(unacked_packets) >= m_congestion_control->mss();
     });
 }
 }
@@ -13,6 +13,9 @@
 #include <Kernel/Library/LockWeakPtr.h>
 #include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Net/IPv4Socket.h>
+#include <Kernel/Net/Routing.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Net/TCPCongestionControl.h>
 
 namespace Kernel {
 
@@ -126,13 +129,28 @@ public:
     void set_error(Error error) { m_error = error; }
 
     void set_ack_number(u32 n) { m_ack_number = n; }
-    void set_sequence_number(u32 n) { m_sequence_number = n; }
+    void set_sequence_number(u32 n)
+    {
+        m_sequence_number = n;
+        m_send_unacknowledged = n;
+    }
     u32 ack_number() const { return m_ack_number; }
     u32 sequence_number() const { return m_sequence_number; }
     u32 packets_in() const { return m_packets_in; }
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
+    u32 packets_retransmitted() const { return m_packets_retransmitted; }
+    // Bytes that were sent but haven't been acknowledged yet.
+    size_t send_queue_size() const { return m_send_queue_size; }
+
+    TCPCongestionControl const& congestion_control() const { return *m_congestion_control; }
+    Optional<Time> smoothed_rtt() const { return m_smoothed_rtt; }
+    Time retransmit_timeout() const { return m_retransmit_timeout; }
+    bool is_sack_enabled() const { return m_sack_enabled; }
+    bool are_timestamps_enabled() const { return m_timestamps_enabled; }
+    u8 send_window_scale() const { return m_send_window_scale; }
+    u8 receive_window_scale() const { return m_receive_window_scale; }
 
     // FIXME: Make this configurable?
     static constexpr u32 maximum_duplicate_acks = 5;
@@ -143,11 +161,26 @@ public:
     ErrorOr<void> send_tcp_packet(u16 flags, UserOrKernelBuffer const* = nullptr, size_t = 0, RoutingDecision* = nullptr);
     void receive_tcp_packet(TCPPacket const&, u16 size);
 
+    // Picks up the options of the peer's SYN, which decide what we may use on this connection.
+    void negotiate_options(TCPPacket const& syn_packet);
+
+    // Holds on to a segment that arrived ahead of the ones we are waiting for.
+    void queue_out_of_order_segment(TCPPacket const&, ReadonlyBytes raw_ipv4_packet, Time const& packet_timestamp);
+    // Receives the queued segments that are now in order, and returns whether there were any.
+    bool receive_queued_segments();
+
     bool should_delay_next_ack() const;
 
     static MutexProtected<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
     static LockRefPtr<TCPSocket> from_tuple(IPv4SocketTuple const& tuple);
 
+    // Listeners that share their port through SO_REUSEPORT, by the tuple they listen on.
+    // sockets_by_tuple() has one of them, and must be locked first.
+    static MutexProtected<HashMap<IPv4SocketTuple, Vector<TCPSocket*>>>& reuse_port_groups();
+
+    // How many connections may be in the middle of the handshake on a listener, on top of the ones waiting to be accepted.
+    static constexpr size_t maximum_syn_backlog = 256;
+
     static MutexProtected<HashMap<IPv4SocketTuple, LockRefPtr<TCPSocket>>>& closing_sockets();
 
     ErrorOr<NonnullLockRefPtr<TCPSocket>> try_create_client(IPv4Address const& local_address, u16 local_port, IPv4Address const& peer_address, u16 peer_port);
@@ -160,15 +193,19 @@ public:
 
     virtual ErrorOr<void> close() override;
 
+    virtual ErrorOr<void> try_add_statistics(JsonObjectSerializer<KBufferBuilder>&) const override;
+
     virtual bool can_write(OpenFileDescription const&, u64) const override;
 
     static NetworkOrdered<u16> compute_tcp_checksum(IPv4Address const& source, IPv4Address const& destination, TCPPacket const&, u16 payload_size);
+    // The sum of the pseudo-header, which is what goes into the checksum field when the hardware finishes the checksum.
+    static NetworkOrdered<u16> compute_tcp_pseudo_header_checksum(IPv4Address const& source, IPv4Address const& destination, u16 tcp_size);
 
 protected:
     void set_direction(Direction direction) { m_direction = direction; }
 
 private:
-    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer);
+    explicit TCPSocket(int protocol, NonnullOwnPtr<DoubleBuffer> receive_buffer, NonnullOwnPtr<KBuffer> scratch_buffer, NonnullOwnPtr<TCPCongestionControl>);
     virtual StringView class_name() const override { return "TCPSocket"sv; }
 
     virtual void shut_down_for_writing() override;
@@ -185,6 +222,38 @@ private:
     void enqueue_for_retransmit();
     void dequeue_for_retransmit();
 
+    bool can_share_port_with(TCPSocket const& listener) const;
+    void remove_from_sockets_by_tuple(HashMap<IPv4SocketTuple, TCPSocket*>&) const;
+
+    struct OutgoingPacket;
+    struct UnackedPackets;
+
+    enum class RecoveryState {
+        None,
+        // Repairing losses we found out about through duplicate ACKs or SACK.
+        FastRecovery,
+        // Sending everything again after the retransmission timer expired.
+        RetransmitTimeout,
+    };
+
+    size_t write_options(u16 flags, u16 local_mss, Bytes) const;
+    size_t options_size(u16 flags) const;
+    size_t collect_sack_blocks(Span<TCPSACKBlock>) const;
+    u16 receive_window_for_packet(u16 flags) const;
+    size_t maximum_segment_payload_size(RoutingDecision const&) const;
+    // How much payload goes into one packet, which the adapter splits up into segments if it's larger than the MSS.
+    size_t maximum_packet_payload_size(RoutingDecision const&) const;
+    TCPTransmitOffload fill_in_checksum(TCPPacket&, size_t payload_size, RoutingDecision const&) const;
+    size_t available_send_window(UnackedPackets const&) const;
+
+    void process_ack(TCPPacket const&, TCPOptions const&, size_t payload_size);
+    void update_rtt(Time const& rtt);
+    void restart_retransmit_timer(UnackedPackets const&);
+    bool mark_lost_packets(UnackedPackets&);
+    void enter_recovery(UnackedPackets&, RecoveryState);
+    void retransmit_lost_packets(UnackedPackets&, bool send_at_least_one);
+    void retransmit_packet(OutgoingPacket&, RoutingDecision&);
+
     LockWeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullLockRefPtr<TCPSocket>> m_pending_release_for_accept;
     Direction m_direction { Direction::Unspecified };
@@ -197,18 +266,36 @@ private:
     u32 m_bytes_in { 0 };
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
+    u32 m_packets_retransmitted { 0 };
+    // Mirrors the size of m_unacked_packets, so the statistics don't need to take its lock.
+    Atomic<size_t, AK::MemoryOrder::memory_order_relaxed> m_send_queue_size { 0 };
 
     struct OutgoingPacket {
+        // The sequence number right after this packet, which the peer acknowledges it with.
         u32 ack_number { 0 };
+        u32 payload_size { 0 };
+        // Where the payload starts within the payload of the buffer. A packet that is larger than one
+        // segment is tracked one segment at a time, and all of those share the buffer it was sent in.
+        u32 payload_offset { 0 };
         LockRefPtr<PacketWithTimestamp> buffer;
         size_t ipv4_payload_offset;
         LockWeakPtr<NetworkAdapter> adapter;
+        Time sent_time;
         int tx_counter { 0 };
+        // The peer has told us through SACK that it has received this packet.
+        bool is_sacked { false };
+        // We think the packet is lost and have to send it again.
+        bool is_lost { false };
+        // The packet has been sent again since the current recovery began.
+        bool was_retransmitted { false };
     };
 
     struct UnackedPackets {
         SinglyLinkedList<OutgoingPacket> packets;
         size_t size { 0 };
+
+        // RFC 6675, 4. Algorithm Details: Our estimate of how much data is in the network ("pipe").
+        size_t bytes_in_flight() const;
     };
 
     MutexProtected<UnackedPackets> m_unacked_packets;
@@ -220,11 +307,47 @@ private:
 
     // FIXME: Make this configurable (sysctl)
     static constexpr u32 maximum_retransmits = 5;
-    Time m_last_retransmit_time;
     u32 m_retransmit_attempts { 0 };
 
-    // FIXME: Parse window size TCP option from the peer
+    // The oldest sequence number that the peer has not acknowledged yet (SND.UNA).
+    u32 m_send_unacknowledged { 0 };
+    // How much the peer is willing to receive, already scaled.
     u32 m_send_window_size { 64 * KiB };
+    // The MSS the peer told us about, or the default one from RFC 9293, 3.7.1.
+    u16 m_peer_mss { 536 };
+
+    // RFC 7323 and RFC 2018. These are only enabled if both sides asked for them in their SYN.
+    bool m_window_scaling_enabled { false };
+    bool m_sack_enabled { false };
+    bool m_timestamps_enabled { false };
+    u8 m_send_window_scale { 0 };
+    u8 m_receive_window_scale { 0 };
+    u32 m_recent_timestamp { 0 };
+
+    NonnullOwnPtr<TCPCongestionControl> m_congestion_control;
+
+    // RFC 6298
+    Optional<Time> m_smoothed_rtt;
+    Time m_rtt_variance;
+    Time m_retransmit_timeout { Time::from_seconds(1) };
+    Optional<Time> m_retransmit_deadline;
+
+    RecoveryState m_recovery_state { RecoveryState::None };
+    // Recovery is over once the peer has acknowledged everything up to here.
+    u32 m_recovery_point { 0 };
+    u32 m_duplicate_acks_received { 0 };
+    static constexpr u32 duplicate_ack_threshold = 3;
+
+    struct OutOfOrderSegment {
+        u32 sequence_number { 0 };
+        u32 payload_size { 0 };
+        NonnullOwnPtr<KBuffer> raw_ipv4_packet;
+        Time timestamp;
+    };
+    // Sorted by sequence number. We tell the peer about these through SACK.
+    Vector<OutOfOrderSegment> m_out_of_order_segments;
+    size_t m_out_of_order_bytes { 0 };
+    u32 m_last_out_of_order_sequence_number { 0 };
 
     IntrusiveListNode<TCPSocket> m_retransmit_list_node;
 
@@ -0,0 +1,505 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/MACAddress.h>
+#include <Kernel/Arch/Processor.h>
+#include <Kernel/Bus/PCI/IDs.h>
+#include <Kernel/CommandLine.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Net/NetworkTask.h>
+#include <Kernel/Net/NetworkingManagement.h>
+#include <Kernel/Net/TCP.h>
+#include <Kernel/Net/VirtIO/VirtIONetworkAdapter.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+// Every receive buffer and every transmit buffer is a single page, and we don't use more of them than this per queue.
+static constexpr size_t max_buffers_per_queue = 256;
+
+// The largest frame the device can hand us with VIRTIO_NET_F_GUEST_TSO4: an IPv4 packet of maximum length.
+static constexpr size_t max_receive_frame_size = sizeof(EthernetFrameHeader) + 65535;
+
+// Where the checksum is within the TCP header.
+static constexpr u16 tcp_checksum_offset = 16;
+
+UNMAP_AFTER_INIT LockRefPtr<VirtIONetworkAdapter> VirtIONetworkAdapter::try_to_initialize(PCI::DeviceIdentifier const& device_identifier)
+{
+    if (kernel_command_line().disable_virtio())
+        return {};
+    if (device_identifier.hardware_id().vendor_id != PCI::VendorID::VirtIO)
+        return {};
+    if (device_identifier.hardware_id().device_id != PCI::DeviceID::VirtIONetAdapter)
+        return {};
+    // FIXME: Better propagate errors here
+    auto interface_name_or_error = NetworkingManagement::generate_interface_name_from_pci_address(device_identifier);
+    if (interface_name_or_error.is_error())
+        return {};
+    auto adapter = adopt_lock_ref_if_nonnull(new (nothrow) VirtIONetworkAdapter(device_identifier, interface_name_or_error.release_value()));
+    if (!adapter)
+        return {};
+    if (adapter->try_initialize())
+        return adapter;
+    return {};
+}
+
+UNMAP_AFTER_INIT VirtIONetworkAdapter::VirtIONetworkAdapter(PCI::DeviceIdentifier const& device_identifier, NonnullOwnPtr<KString> interface_name)
+    : NetworkAdapter(move(interface_name))
+    , VirtIO::Device(device_identifier)
+{
+}
+
+UNMAP_AFTER_INIT bool VirtIONetworkAdapter::try_initialize()
+{
+    VirtIO::Device::initialize();
+    m_device_config = get_config(VirtIO::ConfigurationType::Device);
+    if (!m_device_config) {
+        dmesgln("VirtIONetworkAdapter: Device has no configuration space");
+        return false;
+    }
+
+    bool success = negotiate_features([&](u64 supported_features) {
+        u64 negotiated = 0;
+        if (is_feature_set(supported_features, VIRTIO_NET_F_MAC))
+            negotiated |= VIRTIO_NET_F_MAC;
+        if (is_feature_set(supported_features, VIRTIO_NET_F_STATUS))
+            negotiated |= VIRTIO_NET_F_STATUS;
+        if (is_feature_set(supported_features, VIRTIO_NET_F_MRG_RXBUF))
+            negotiated |= VIRTIO_NET_F_MRG_RXBUF;
+        if (is_feature_set(supported_features, VIRTIO_NET_F_CSUM)) {
+            negotiated |= VIRTIO_NET_F_CSUM;
+            if (is_feature_set(supported_features, VIRTIO_NET_F_HOST_TSO4))
+                negotiated |= VIRTIO_NET_F_HOST_TSO4;
+        }
+        if (is_feature_set(supported_features, VIRTIO_NET_F_GUEST_CSUM)) {
+            negotiated |= VIRTIO_NET_F_GUEST_CSUM;
+            // Large frames only fit into our page-sized receive buffers if they can be spread over several of them.
+            if (is_feature_set(supported_features, VIRTIO_NET_F_GUEST_TSO4 | VIRTIO_NET_F_MRG_RXBUF))
+                negotiated |= VIRTIO_NET_F_GUEST_TSO4;
+        }
+        if (is_feature_set(supported_features, VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_MQ))
+            negotiated |= VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_MQ;
+        return negotiated;
+    });
+    if (!success)
+        return false;
+
+    if (!is_feature_accepted(VIRTIO_NET_F_MAC)) {
+        dmesgln("VirtIONetworkAdapter: Device doesn't tell us its MAC address");
+        return false;
+    }
+
+    MACAddress mac {};
+    u16 max_queue_pairs = 1;
+    read_config_atomic([&]() {
+        for (size_t i = 0; i < 6; ++i)
+            mac[i] = config_read8(*m_device_config, i);
+        if (is_feature_accepted(VIRTIO_NET_F_MQ))
+            max_queue_pairs = config_read16(*m_device_config, 0x8);
+    });
+    set_mac_address(mac);
+    update_link_status();
+
+    auto offloads = Offload::None;
+    if (is_feature_accepted(VIRTIO_NET_F_CSUM))
+        offloads |= Offload::TransmitChecksum;
+    if (is_feature_accepted(VIRTIO_NET_F_HOST_TSO4))
+        offloads |= Offload::TCPSegmentation;
+    // NOTE: VIRTIO_NET_F_GUEST_CSUM doesn't make this Offload::ReceiveChecksum. The device only vouches
+    //       for the frames it marks with VIRTIO_NET_HDR_F_DATA_VALID, and we don't pass that on per frame.
+    set_offloads(offloads);
+
+    // The control queue comes after the queue pairs, and there may be more of those than we use.
+    u16 queue_count = 2 * max_queue_pairs;
+    if (is_feature_accepted(VIRTIO_NET_F_CTRL_VQ)) {
+        m_control_queue_index = queue_count;
+        ++queue_count;
+    }
+    if (!setup_queues(queue_count))
+        return false;
+    finish_init();
+
+    u16 queue_pair_count = min(max_queue_pairs, (u16)min(Processor::count(), NetworkTask::max_receive_queue_count));
+    if (m_queue_pairs.try_ensure_capacity(queue_pair_count).is_error())
+        return false;
+    for (u16 i = 0; i < queue_pair_count; ++i) {
+        QueuePair pair;
+        pair.receive_queue_index = 2 * i;
+        pair.transmit_queue_index = 2 * i + 1;
+
+        auto receive_buffer_count = min((size_t)get_queue(pair.receive_queue_index).size(), max_buffers_per_queue);
+        auto receive_buffers_or_error = MM.allocate_contiguous_kernel_region(receive_buffer_count * PAGE_SIZE, "VirtIONetworkAdapter RX Buffers"sv, Memory::Region::Access::ReadWrite);
+        if (receive_buffers_or_error.is_error())
+            return false;
+        pair.receive_buffers = receive_buffers_or_error.release_value();
+
+        auto transmit_buffer_count = min((size_t)get_queue(pair.transmit_queue_index).size(), max_buffers_per_queue);
+        auto transmit_buffers_or_error = MM.allocate_contiguous_kernel_region(transmit_buffer_count * PAGE_SIZE, "VirtIONetworkAdapter TX Buffers"sv, Memory::Region::Access::ReadWrite);
+        if (transmit_buffers_or_error.is_error())
+            return false;
+        pair.transmit_buffers = transmit_buffers_or_error.release_value();
+        if (pair.free_transmit_pages.try_ensure_capacity(transmit_buffer_count).is_error())
+            return false;
+        for (size_t page_index = 0; page_index < transmit_buffer_count; ++page_index)
+            pair.free_transmit_pages.unchecked_append(page_index);
+
+        // We only want to hear about finished transmissions when we're waiting for a free buffer.
+        get_queue(pair.transmit_queue_index).disable_interrupts();
+        m_queue_pairs.unchecked_append(move(pair));
+    }
+
+    if (is_feature_accepted(VIRTIO_NET_F_MRG_RXBUF)) {
+        auto assembly_buffer_or_error = MM.allocate_kernel_region(MUST(Memory::page_round_up(max_receive_frame_size)), "VirtIONetworkAdapter RX Assembly"sv, Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow);
+        if (assembly_buffer_or_error.is_error())
+            return false;
+        m_receive_assembly_buffer = assembly_buffer_or_error.release_value();
+    }
+
+    for (auto& pair : m_queue_pairs) {
+        auto& queue = get_queue(pair.receive_queue_index);
+        SpinlockLocker locker(queue.lock());
+        for (size_t page_index = 0; page_index < pair.receive_buffers->size() / PAGE_SIZE; ++page_index)
+            supply_receive_buffer(pair, page_index);
+        notify_queue_if_needed(pair.receive_queue_index);
+    }
+
+    if (is_feature_accepted(VIRTIO_NET_F_MQ)) {
+        auto control_buffer_or_error = MM.allocate_contiguous_kernel_region(PAGE_SIZE, "VirtIONetworkAdapter Control"sv, Memory::Region::Access::ReadWrite);
+        if (control_buffer_or_error.is_error())
+            return false;
+        m_control_buffer = control_buffer_or_error.release_value();
+        if (!set_queue_pair_count(queue_pair_count)) {
+            dmesgln("VirtIONetworkAdapter: Device refused to use {} queue pairs", queue_pair_count);
+            return false;
+        }
+    }
+
+    dmesgln("VirtIONetworkAdapter: MAC address: {}, {} queue pair(s), checksum offload: tx={} rx={}, TSO: tx={} rx={}",
+        mac.to_string(),
+        m_queue_pairs.size(),
+        is_feature_accepted(VIRTIO_NET_F_CSUM),
+        is_feature_accepted(VIRTIO_NET_F_GUEST_CSUM),
+        is_feature_accepted(VIRTIO_NET_F_HOST_TSO4),
+        is_feature_accepted(VIRTIO_NET_F_GUEST_TSO4));
+    return true;
+}
+
+bool VirtIONetworkAdapter::set_queue_pair_count(u16 queue_pair_count)
+{
+    VERIFY(m_control_queue_index.has_value());
+    auto control_queue_index = m_control_queue_index.value();
+
+    // virtio_net_ctrl, followed by the virtio_net_ctrl_mq command and the ack that the device writes back.
+    auto* buffer = m_control_buffer->vaddr().as_ptr();
+    buffer[0] = VIRTIO_NET_CTRL_MQ;
+    buffer[1] = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+    memcpy(buffer + 2, &queue_pair_count, sizeof(u16));
+    buffer[4] = ~VIRTIO_NET_OK;
+
+    auto& queue = get_queue(control_queue_index);
+    SpinlockLocker locker(queue.lock());
+    auto address = m_control_buffer->physical_page(0)->paddr();
+    VirtIO::QueueChain chain(queue);
+    chain.add_buffer_to_chain(address, 2, VirtIO::BufferType::DeviceReadable);
+    chain.add_buffer_to_chain(address.offset(2), sizeof(u16), VirtIO::BufferType::DeviceReadable);
+    chain.add_buffer_to_chain(address.offset(4), 1, VirtIO::BufferType::DeviceWritable);
+    supply_chain_and_notify(control_queue_index, chain);
+
+    // This only happens during initialization, and the device answers right away.
+    while (!queue.new_data_available())
+        Processor::wait_check();
+    size_t used;
+    auto used_chain = queue.pop_used_buffer_chain(used);
+    used_chain.release_buffer_slots_to_queue();
+    return buffer[4] == VIRTIO_NET_OK;
+}
+
+void VirtIONetworkAdapter::update_link_status()
+{
+    if (!is_feature_accepted(VIRTIO_NET_F_STATUS)) {
+        m_link_up = true;
+        return;
+    }
+    u16 status = 0;
+    read_config_atomic([&]() {
+        status = config_read16(*m_device_config, 0x6);
+    });
+    m_link_up = (status & VIRTIO_NET_S_LINK_UP) != 0;
+}
+
+bool VirtIONetworkAdapter::handle_device_config_change()
+{
+    update_link_status();
+    dmesgln("VirtIONetworkAdapter: Link status changed up={}", m_link_up);
+    return true;
+}
+
+void VirtIONetworkAdapter::handle_queue_update(u16 queue_index)
+{
+    // We wait for the answers to our control commands ourselves.
+    if (queue_index == m_control_queue_index)
+        return;
+
+    if (queue_index % 2 == 1) {
+        m_transmit_wait_queue.wake_all();
+        return;
+    }
+
+    set_receive_interrupts_enabled(false);
+    if (try_schedule_poll())
+        return;
+
+    // Nobody is polling yet, so receive everything right away.
+    for (;;) {
+        receive(NumericLimits<size_t>::max());
+        set_receive_interrupts_enabled(true);
+        if (!has_received_frames())
+            break;
+        set_receive_interrupts_enabled(false);
+    }
+}
+
+void VirtIONetworkAdapter::set_receive_interrupts_enabled(bool enabled)
+{
+    for (auto& pair : m_queue_pairs) {
+        auto& queue = get_queue(pair.receive_queue_index);
+        if (enabled)
+            queue.enable_interrupts();
+        else
+            queue.disable_interrupts();
+    }
+}
+
+bool VirtIONetworkAdapter::has_received_frames() const
+{
+    for (auto& pair : m_queue_pairs) {
+        if (get_queue(pair.receive_queue_index).new_data_available())
+            return true;
+    }
+    return false;
+}
+
+size_t VirtIONetworkAdapter::poll_receive(size_t budget)
+{
+    return receive(budget);
+}
+
+void VirtIONetworkAdapter::enable_receive_interrupts()
+{
+    set_receive_interrupts_enabled(true);
+
+    // Unlike a NIC's interrupt cause register, the device doesn't remember that it used buffers
+    // while the interrupts were off. Pick those up now, or they would sit there until the next frame.
+    if (has_received_frames()) {
+        set_receive_interrupts_enabled(false);
+        (void)try_schedule_poll();
+    }
+}
+
+void VirtIONetworkAdapter::supply_receive_buffer(QueuePair& pair, size_t page_index)
+{
+    auto& queue = get_queue(pair.receive_queue_index);
+    VERIFY(queue.lock().is_locked());
+    VirtIO::QueueChain chain(queue);
+    VERIFY(chain.add_buffer_to_chain(pair.receive_buffers->physical_page(page_index)->paddr(), PAGE_SIZE, VirtIO::BufferType::DeviceWritable));
+    chain.submit_to_queue();
+}
+
+size_t VirtIONetworkAdapter::receive(size_t budget)
+{
+    // Take turns between the queues, so that a busy one can't starve the others.
+    size_t received = 0;
+    bool received_any = true;
+    while (received < budget && received_any) {
+        received_any = false;
+        for (auto& pair : m_queue_pairs) {
+            if (received == budget)
+                break;
+            if (receive_from(pair)) {
+                ++received;
+                received_any = true;
+            }
+        }
+    }
+    return received;
+}
+
+bool VirtIONetworkAdapter::receive_from(QueuePair& pair)
+{
+    auto& queue = get_queue(pair.receive_queue_index);
+    SpinlockLocker locker(queue.lock());
+
+    auto buffers_base = pair.receive_buffers->physical_page(0)->paddr();
+    auto take_used_buffer = [&](size_t& used) -> Optional<size_t> {
+        auto chain = queue.pop_used_buffer_chain(used);
+        if (chain.is_empty())
+            return {};
+        size_t page_index = 0;
+        chain.for_each([&](PhysicalAddress address, size_t) {
+            page_index = (address.get() - buffers_base.get()) / PAGE_SIZE;
+        });
+        chain.release_buffer_slots_to_queue();
+        return page_index;
+    };
+    auto buffer_data = [&](size_t page_index) {
+        return pair.receive_buffers->vaddr().offset(page_index * PAGE_SIZE).as_ptr();
+    };
+
+    size_t used;
+    auto page_index = take_used_buffer(used);
+    if (!page_index.has_value())
+        return false;
+
+    if (used < header_size()) {
+        dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: Received a buffer without a header ({} bytes)", used);
+        supply_receive_buffer(pair, page_index.value());
+        notify_queue_if_needed(pair.receive_queue_index);
+        return true;
+    }
+
+    Header header {};
+    memcpy(&header, buffer_data(page_index.value()), header_size());
+    Bytes frame { buffer_data(page_index.value()) + header_size(), used - header_size() };
+
+    u16 buffer_count = is_feature_accepted(VIRTIO_NET_F_MRG_RXBUF) ? header.buffer_count : 1;
+    if (buffer_count > 1) {
+        // The frame continues in the next buffers that the device used, so put it back together.
+        auto* assembly_buffer = m_receive_assembly_buffer->vaddr().as_ptr();
+        size_t frame_size = frame.size();
+        memcpy(assembly_buffer, frame.data(), frame_size);
+        supply_receive_buffer(pair, page_index.value());
+        for (u16 i = 1; i < buffer_count; ++i) {
+            auto next_page_index = take_used_buffer(used);
+            if (!next_page_index.has_value()) {
+                dmesgln("VirtIONetworkAdapter: Frame is missing {} of its {} buffers", buffer_count - i, buffer_count);
+                notify_queue_if_needed(pair.receive_queue_index);
+                return true;
+            }
+            if (frame_size + used <= m_receive_assembly_buffer->size())
+                memcpy(assembly_buffer + frame_size, buffer_data(next_page_index.value()), used);
+            frame_size += used;
+            supply_receive_buffer(pair, next_page_index.value());
+        }
+        if (frame_size > m_receive_assembly_buffer->size()) {
+            dmesgln("VirtIONetworkAdapter: Discarding frame that is too large ({} bytes)", frame_size);
+            notify_queue_if_needed(pair.receive_queue_index);
+            return true;
+        }
+        frame = { assembly_buffer, frame_size };
+    }
+
+    if (header.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) {
+        // The device left it to us to finish the checksum. It already put the sum of the pseudo-header
+        // in its place, so all that's left is to sum up everything from the start of the checksummed area.
+        size_t checksum_start = header.checksum_start;
+        size_t checksum_position = checksum_start + header.checksum_offset;
+        if (checksum_position + sizeof(u16) <= frame.size()) {
+            auto checksum = internet_checksum(frame.offset(checksum_start), frame.size() - checksum_start);
+            memcpy(frame.offset(checksum_position), &checksum, sizeof(u16));
+        }
+    }
+
+    did_receive(frame);
+
+    if (buffer_count <= 1)
+        supply_receive_buffer(pair, page_index.value());
+    notify_queue_if_needed(pair.receive_queue_index);
+    return true;
+}
+
+size_t VirtIONetworkAdapter::header_size() const
+{
+    if (is_feature_accepted(VIRTIO_F_VERSION_1) || is_feature_accepted(VIRTIO_NET_F_MRG_RXBUF))
+        return sizeof(Header);
+    return offsetof(Header, buffer_count);
+}
+
+void VirtIONetworkAdapter::reclaim_transmit_buffers(QueuePair& pair)
+{
+    auto& queue = get_queue(pair.transmit_queue_index);
+    VERIFY(queue.lock().is_locked());
+    auto buffers_base = pair.transmit_buffers->physical_page(0)->paddr();
+    size_t used;
+    for (auto chain = queue.pop_used_buffer_chain(used); !chain.is_empty(); chain = queue.pop_used_buffer_chain(used)) {
+        chain.for_each([&](PhysicalAddress address, size_t) {
+            pair.free_transmit_pages.unchecked_append((address.get() - buffers_base.get()) / PAGE_SIZE);
+        });
+        chain.release_buffer_slots_to_queue();
+    }
+}
+
+void VirtIONetworkAdapter::send_raw(ReadonlyBytes payload)
+{
+    Header header {};
+    header.gso_type = VIRTIO_NET_HDR_GSO_NONE;
+    send_frame(header, payload);
+}
+
+void VirtIONetworkAdapter::send_raw_with_offload(ReadonlyBytes payload, TCPTransmitOffload const& offload)
+{
+    auto const& tcp_packet = *reinterpret_cast<TCPPacket const*>(payload.offset(ipv4_payload_offset()));
+
+    Header header {};
+    header.gso_type = VIRTIO_NET_HDR_GSO_NONE;
+    if (offload.needs_checksum) {
+        header.flags = VIRTIO_NET_HDR_F_NEEDS_CSUM;
+        header.checksum_start = ipv4_payload_offset();
+        header.checksum_offset = tcp_checksum_offset;
+    }
+    if (offload.segment_size != 0) {
+        VERIFY(is_feature_accepted(VIRTIO_NET_F_HOST_TSO4));
+        header.gso_type = VIRTIO_NET_HDR_GSO_TCPV4;
+        header.gso_size = offload.segment_size;
+        header.header_length = ipv4_payload_offset() + tcp_packet.header_size();
+    }
+    send_frame(header, payload);
+}
+
+void VirtIONetworkAdapter::send_frame(Header const& header, ReadonlyBytes frame)
+{
+    // Every processor sends through its own queue, so that they don't have to wait for each other.
+    auto& pair = m_queue_pairs[Processor::current_id() % m_queue_pairs.size()];
+    auto& queue = get_queue(pair.transmit_queue_index);
+
+    size_t total_size = header_size() + frame.size();
+    size_t page_count = ceil_div(total_size, static_cast<size_t>(PAGE_SIZE));
+    if (page_count > pair.transmit_buffers->size() / PAGE_SIZE) {
+        dmesgln("VirtIONetworkAdapter: Frame is too large to send ({} bytes)", frame.size());
+        return;
+    }
+
+    SpinlockLocker locker(queue.lock());
+    reclaim_transmit_buffers(pair);
+    while (pair.free_transmit_pages.size() < page_count) {
+        dbgln_if(VIRTIO_DEBUG, "VirtIONetworkAdapter: No free TX buffers, waiting for the device to catch up");
+        locker.unlock();
+        queue.enable_interrupts();
+        auto timeout_time = Time::from_milliseconds(10);
+        auto timeout = Thread::BlockTimeout { false, &timeout_time };
+        [[maybe_unused]] auto result = m_transmit_wait_queue.wait_on(timeout, "VirtIONetworkAdapter"sv);
+        queue.disable_interrupts();
+        locker.lock();
+        reclaim_transmit_buffers(pair);
+    }
+
+    VirtIO::QueueChain chain(queue);
+    for (size_t offset = 0; offset < total_size; offset += PAGE_SIZE) {
+        auto page_index = pair.free_transmit_pages.take_last();
+        auto* page = pair.transmit_buffers->vaddr().offset(page_index * PAGE_SIZE).as_ptr();
+        size_t chunk_size = min(PAGE_SIZE, total_size - offset);
+        size_t header_size_in_page = 0;
+        if (offset == 0) {
+            header_size_in_page = header_size();
+            memcpy(page, &header, header_size_in_page);
+        }
+        memcpy(page + header_size_in_page, frame.offset(offset + header_size_in_page - header_size()), chunk_size - header_size_in_page);
+        VERIFY(chain.add_buffer_to_chain(pair.transmit_buffers->physical_page(page_index)->paddr(), chunk_size, VirtIO::BufferType::DeviceReadable));
+    }
+    chain.submit_to_queue();
+    notify_queue_if_needed(pair.transmit_queue_index);
+}
+
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/Bus/VirtIO/Device.h>
+#include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+#define VIRTIO_NET_F_CSUM (1 << 0)
+#define VIRTIO_NET_F_GUEST_CSUM (1 << 1)
+#define VIRTIO_NET_F_MAC (1 << 5)
+#define VIRTIO_NET_F_GUEST_TSO4 (1 << 7)
+#define VIRTIO_NET_F_HOST_TSO4 (1 << 11)
+#define VIRTIO_NET_F_MRG_RXBUF (1 << 15)
+#define VIRTIO_NET_F_STATUS (1 << 16)
+#define VIRTIO_NET_F_CTRL_VQ (1 << 17)
+#define VIRTIO_NET_F_MQ (1 << 22)
+
+#define VIRTIO_NET_S_LINK_UP 1
+
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM 1
+#define VIRTIO_NET_HDR_GSO_NONE 0
+#define VIRTIO_NET_HDR_GSO_TCPV4 1
+
+#define VIRTIO_NET_CTRL_MQ 4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET 0
+#define VIRTIO_NET_OK 0
+
+// https://docs.oasis-open.org/virtio/virtio/v1.1/csprd01/virtio-v1.1-csprd01.html#x1-1940001
+class VirtIONetworkAdapter final
+    : public NetworkAdapter
+    , public VirtIO::Device {
+public:
+    static LockRefPtr<VirtIONetworkAdapter> try_to_initialize(PCI::DeviceIdentifier const&);
+
+    virtual ~VirtIONetworkAdapter() override = default;
+
+    virtual void send_raw(ReadonlyBytes) override;
+    virtual void send_raw_with_offload(ReadonlyBytes, TCPTransmitOffload const&) override;
+    virtual bool link_up() override { return m_link_up; }
+    virtual bool link_full_duplex() override { return true; }
+
+    virtual StringView purpose() const override { return class_name(); }
+
+private:
+    // virtio_net_hdr. Legacy devices leave out buffer_count, unless they use mergeable receive buffers.
+    struct [[gnu::packed]] Header {
+        u8 flags;
+        u8 gso_type;
+        u16 header_length;
+        u16 gso_size;
+        u16 checksum_start;
+        u16 checksum_offset;
+        u16 buffer_count;
+    };
+    static_assert(AssertSize<Header, 12>());
+    size_t header_size() const;
+
+    // Every receive queue has a transmit queue next to it, and together they form a pair.
+    struct QueuePair {
+        u16 receive_queue_index { 0 };
+        u16 transmit_queue_index { 0 };
+        // One page per receive buffer, and the transmit pages that the device isn't reading from.
+        OwnPtr<Memory::Region> receive_buffers;
+        OwnPtr<Memory::Region> transmit_buffers;
+        Vector<u16> free_transmit_pages;
+    };
+
+    VirtIONetworkAdapter(PCI::DeviceIdentifier const&, NonnullOwnPtr<KString> interface_name);
+    bool try_initialize();
+
+    virtual StringView class_name() const override { return "VirtIONetworkAdapter"sv; }
+    virtual bool handle_device_config_change() override;
+    virtual void handle_queue_update(u16 queue_index) override;
+
+    virtual size_t poll_receive(size_t budget) override;
+    virtual void enable_receive_interrupts() override;
+
+    bool set_queue_pair_count(u16);
+    void update_link_status();
+    void set_receive_interrupts_enabled(bool);
+    bool has_received_frames() const;
+
+    void supply_receive_buffer(QueuePair&, size_t page_index);
+    size_t receive(size_t budget);
+    bool receive_from(QueuePair&);
+    void reclaim_transmit_buffers(QueuePair&);
+    void send_frame(Header const&, ReadonlyBytes);
+
+    Vector<QueuePair> m_queue_pairs;
+    Optional<u16> m_control_queue_index;
+    VirtIO::Configuration const* m_device_config { nullptr };
+    // Frames that span several receive buffers are put back together here.
+    OwnPtr<Memory::Region> m_receive_assembly_buffer;
+    OwnPtr<Memory::Region> m_control_buffer;
+    WaitQueue m_transmit_wait_queue;
+    bool m_link_up { false };
+};
+
+}
@@ -989,6 +989,7 @@ bool Process::remove_thread(Thread& thread)
     u32 thread_count_before = 0;
     thread_list().with([&](auto& thread_list) {
         thread_list.remove(thread);
+        m_exited_threads_network_io.add(thread);
         with_mutable_protected_data([&](auto& protected_data) {
             thread_count_before = protected_data.thread_count.fetch_sub(1, AK::MemoryOrder::memory_order_acq_rel);
             VERIFY(thread_count_before != 0);
@@ -997,6 +998,24 @@ bool Process::remove_thread(Thread& thread)
     return thread_count_before == 1;
 }
 
+void Process::NetworkIOStatistics::add(Thread const& thread)
+{
+    ipv4_socket_read_bytes += thread.ipv4_socket_read_bytes();
+    ipv4_socket_write_bytes += thread.ipv4_socket_write_bytes();
+    unix_socket_read_bytes += thread.unix_socket_read_bytes();
+    unix_socket_write_bytes += thread.unix_socket_write_bytes();
+}
+
+Process::NetworkIOStatistics Process::network_io_statistics() const
+{
+    return thread_list().with([&](auto const& thread_list) {
+        auto statistics = m_exited_threads_network_io;
+        for (auto const& thread : thread_list)
+            statistics.add(thread);
+        return statistics;
+    });
+}
+
 bool Process::add_thread(Thread& thread)
 {
     bool is_first = false;
@@ -315,13 +315,18 @@ public:
     ErrorOr<FlatPtr> sys$close(int fd);
     ErrorOr<FlatPtr> sys$read(int fd, Userspace<u8*>, size_t);
     ErrorOr<FlatPtr> sys$pread(int fd, Userspace<u8*>, size_t, Userspace<off_t const*>);
+    ErrorOr<FlatPtr> sys$preadv(int fd, Userspace<const struct iovec*> iov, int iov_count, Userspace<off_t const*>);
+    ErrorOr<FlatPtr> sys$sendfile(int out_fd, int in_fd, Userspace<off_t*>, size_t);
     ErrorOr<FlatPtr> sys$readv(int fd, Userspace<const struct iovec*> iov, int iov_count);
     ErrorOr<FlatPtr> sys$write(int fd, Userspace<u8 const*>, size_t);
+    ErrorOr<FlatPtr> sys$pwrite(int fd, Userspace<u8 const*>, size_t, Userspace<off_t const*>);
     ErrorOr<FlatPtr> sys$writev(int fd, Userspace<const struct iovec*> iov, int iov_count);
+    ErrorOr<FlatPtr> sys$pwritev(int fd, Userspace<const struct iovec*> iov, int iov_count, Userspace<off_t const*>);
     ErrorOr<FlatPtr> sys$fstat(int fd, Userspace<stat*>);
     ErrorOr<FlatPtr> sys$stat(Userspace<Syscall::SC_stat_params const*>);
     ErrorOr<FlatPtr> sys$lseek(int fd, Userspace<off_t*>, int whence);
     ErrorOr<FlatPtr> sys$ftruncate(int fd, Userspace<off_t const*>);
+    ErrorOr<FlatPtr> sys$posix_fadvise(int fd, Userspace<off_t const*>, Userspace<off_t const*>, int advice);
     ErrorOr<FlatPtr> sys$posix_fallocate(int fd, Userspace<off_t const*>, Userspace<off_t const*>);
     ErrorOr<FlatPtr> sys$kill(pid_t pid_or_pgid, int sig);
     [[noreturn]] void sys$exit(int status);
@@ -337,6 +342,11 @@ public:
     ErrorOr<FlatPtr> sys$msync(Userspace<void*>, size_t, int flags);
     ErrorOr<FlatPtr> sys$purge(int mode);
     ErrorOr<FlatPtr> sys$poll(Userspace<Syscall::SC_poll_params const*>);
+    ErrorOr<FlatPtr> sys$epoll_create(int flags);
+    ErrorOr<FlatPtr> sys$epoll_ctl(Userspace<Syscall::SC_epoll_ctl_params const*>);
+    ErrorOr<FlatPtr> sys$epoll_wait(Userspace<Syscall::SC_epoll_wait_params const*>);
+    ErrorOr<FlatPtr> sys$io_ring_setup(Userspace<io_ring_params*>);
+    ErrorOr<FlatPtr> sys$io_ring_enter(int fd, u32 to_submit, u32 min_complete, u32 flags);
     ErrorOr<FlatPtr> sys$get_dir_entries(int fd, Userspace<void*>, size_t);
     ErrorOr<FlatPtr> sys$getcwd(Userspace<char*>, size_t);
     ErrorOr<FlatPtr> sys$chdir(Userspace<char const*>, size_t);
@@ -397,6 +407,8 @@ public:
     ErrorOr<FlatPtr> sys$shutdown(int sockfd, int how);
     ErrorOr<FlatPtr> sys$sendmsg(int sockfd, Userspace<const struct msghdr*>, int flags);
     ErrorOr<FlatPtr> sys$recvmsg(int sockfd, Userspace<struct msghdr*>, int flags);
+    ErrorOr<FlatPtr> sys$sendmmsg(int sockfd, Userspace<struct mmsghdr*>, unsigned int vlen, int flags);
+    ErrorOr<FlatPtr> sys$recvmmsg(Userspace<Syscall::SC_recvmmsg_params const*>);
     ErrorOr<FlatPtr> sys$getsockopt(Userspace<Syscall::SC_getsockopt_params const*>);
     ErrorOr<FlatPtr> sys$setsockopt(Userspace<Syscall::SC_setsockopt_params const*>);
     ErrorOr<FlatPtr> sys$getsockname(Userspace<Syscall::SC_getsockname_params const*>);
@@ -638,6 +650,7 @@ public:
     ErrorOr<void> procfs_get_binary_link(KBufferBuilder& builder) const;
     ErrorOr<void> procfs_get_current_work_directory_link(KBufferBuilder& builder) const;
     ErrorOr<void> procfs_get_command_line(KBufferBuilder& builder) const;
+    ErrorOr<void> procfs_get_network_stats(KBufferBuilder& builder) const;
     mode_t binary_link_required_mode() const;
     ErrorOr<void> procfs_get_thread_stack(ThreadID thread_id, KBufferBuilder& builder) const;
     ErrorOr<void> traverse_stacks_directory(FileSystemID, Function<ErrorOr<void>(FileSystem::DirectoryEntryView const&)> callback) const;
@@ -838,6 +851,17 @@ public:
         return m_fds.with_shared([fd](auto& fds) { return fds.open_file_description(fd); });
     }
 
+    // Socket I/O of all threads, including the ones that have exited.
+    struct NetworkIOStatistics {
+        u64 ipv4_socket_read_bytes { 0 };
+        u64 ipv4_socket_write_bytes { 0 };
+        u64 unix_socket_read_bytes { 0 };
+        u64 unix_socket_write_bytes { 0 };
+
+        void add(Thread const&);
+    };
+    NetworkIOStatistics network_io_statistics() const;
+
     ErrorOr<ScopedDescriptionAllocation> allocate_fd()
     {
         return m_fds.with_exclusive([](auto& fds) { return fds.allocate(); });
@@ -850,6 +874,9 @@ private:
     ErrorOr<NonnullRefPtr<Thread>> get_thread_from_pid_or_tid(pid_t pid_or_tid, Syscall::SchedulerParametersMode mode);
 
     SpinlockProtected<Thread::ListInProcess> m_thread_list { LockRank::None };
+    // Threads count their own I/O, so they don't contend over it. When one goes away, its counts
+    // are folded in here while holding the thread list lock, so nothing is ever counted twice.
+    NetworkIOStatistics m_exited_threads_network_io;
 
     MutexProtected<OpenFileDescriptions> m_fds;
 
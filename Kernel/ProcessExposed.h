@@ -31,6 +31,7 @@ enum class MainProcessProperty {
     PerformanceEvents = 6,
     VirtualMemoryStats = 7,
     CommandLine = 8,
+    NetworkStats = 9,
 };
 
 enum class ProcessSubDirectory {
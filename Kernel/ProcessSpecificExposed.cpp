@@ -13,6 +13,7 @@
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Net/IPv4Socket.h>
 #include <Kernel/Process.h>
 #include <Kernel/ProcessExposed.h>
 #include <Kernel/TTY/TTY.h>
@@ -324,6 +325,39 @@ ErrorOr<void> Process::procfs_get_command_line(KBufferBuilder& builder) const
     return {};
 }
 
+ErrorOr<void> Process::procfs_get_network_stats(KBufferBuilder& builder) const
+{
+    auto obj = TRY(JsonObjectSerializer<>::try_create(builder));
+    auto io = network_io_statistics();
+    TRY(obj.add("ipv4_socket_read_bytes"sv, io.ipv4_socket_read_bytes));
+    TRY(obj.add("ipv4_socket_write_bytes"sv, io.ipv4_socket_write_bytes));
+    TRY(obj.add("unix_socket_read_bytes"sv, io.unix_socket_read_bytes));
+    TRY(obj.add("unix_socket_write_bytes"sv, io.unix_socket_write_bytes));
+
+    auto sockets_array = TRY(obj.add_array("sockets"sv));
+    TRY(fds().with_shared([&](auto& fds) -> ErrorOr<void> {
+        size_t fd = 0;
+        return fds.try_enumerate([&](auto& file_description_metadata) -> ErrorOr<void> {
+            auto index = fd++;
+            if (!file_description_metadata.is_valid())
+                return {};
+            auto description = file_description_metadata.description();
+            auto* socket = description->socket();
+            if (!socket || !socket->is_ipv4())
+                return {};
+            auto socket_object = TRY(sockets_array.add_object());
+            TRY(socket_object.add("fd"sv, index));
+            TRY(socket_object.add("class"sv, description->file().class_name()));
+            TRY(static_cast<IPv4Socket const&>(*socket).try_add_statistics(socket_object));
+            TRY(socket_object.finish());
+            return {};
+        });
+    }));
+    TRY(sockets_array.finish());
+    TRY(obj.finish());
+    return {};
+}
+
 mode_t Process::binary_link_required_mode() const
 {
     if (!executable())
@@ -41,12 +41,143 @@ struct ThreadReadyQueue {
 };
 
 struct ThreadReadyQueues {
+    static ProcessorSpecificDataID processor_specific_data_id() { return ProcessorSpecificDataID::Scheduler; }
+
     u32 mask {};
     static constexpr size_t count = sizeof(mask) * 8;
     Array<ThreadReadyQueue, count> queues;
+
+    Spinlock lock { LockRank::None };
+
+    // The number of queued threads. This is read without holding the lock by
+    // other processors to estimate how busy this processor is.
+    Atomic<u32, AK::MemoryOrder::memory_order_relaxed> thread_count { 0 };
+
+    u32 ticks_until_load_balance { 0 };
+
+    void append(Thread& thread, u32 priority)
+    {
+        SpinlockLocker locker(lock);
+        append_locked(thread, priority);
+    }
+
+    void append_locked(Thread& thread, u32 priority)
+    {
+        VERIFY(lock.is_locked());
+        VERIFY(thread.m_runnable_priority < 0);
+        VERIFY(!thread.m_ready_queue_node.is_in_list());
+        thread.m_runnable_priority = (int)priority;
+        thread.m_runnable_queues = this;
+        auto& ready_queue = queues[priority];
+        bool was_empty = ready_queue.thread_list.is_empty();
+        ready_queue.thread_list.append(thread);
+        if (was_empty)
+            mask |= (1u << priority);
+        thread_count++;
+    }
+
+    void remove(Thread& thread)
+    {
+        VERIFY(lock.is_locked());
+        VERIFY(thread.m_runnable_queues == this);
+        auto priority = thread.m_runnable_priority;
+        VERIFY(priority >= 0);
+        VERIFY(mask & (1u << priority));
+        auto& ready_queue = queues[priority];
+        thread.m_runnable_priority = -1;
+        thread.m_runnable_queues = nullptr;
+        ready_queue.thread_list.remove(thread);
+        if (ready_queue.thread_list.is_empty())
+            mask &= ~(1u << priority);
+        thread_count--;
+    }
+
+    // Returns the highest priority thread that may run on the given processor,
+    // and removes it from the queue if requested.
+    Thread* find_runnable_thread(u32 cpu, bool take)
+    {
+        SpinlockLocker locker(lock);
+        auto* thread = find_runnable_thread_locked(cpu, take);
+        if (thread && take) {
+            // Mark it as active because we are using this thread. This is similar
+            // to comparing it with Processor::current_thread, but when there are
+            // multiple processors there's no easy way to check whether the thread
+            // is actually still needed. This prevents accidental finalization when
+            // a thread is no longer in Running state, but running on another core.
+
+            // We need to mark it active while still holding the lock so that
+            // this thread won't be scheduled on another core, nor finalized,
+            // before we actually switch to it.
+            thread->set_active(true);
+        }
+        return thread;
+    }
+
+    Thread* find_runnable_thread_locked(u32 cpu, bool take)
+    {
+        VERIFY(lock.is_locked());
+        auto affinity_mask = 1u << cpu;
+        auto priority_mask = mask;
+        while (priority_mask != 0) {
+            auto priority = bit_scan_forward(priority_mask);
+            VERIFY(priority > 0);
+            auto& ready_queue = queues[--priority];
+            for (auto& thread : ready_queue.thread_list) {
+                VERIFY(thread.m_runnable_priority == (int)priority);
+                if (thread.is_active())
+                    continue;
+                if (!(thread.affinity() & affinity_mask))
+                    continue;
+                if (take)
+                    remove(thread);
+                return &thread;
+            }
+            priority_mask &= ~(1u << priority);
+        }
+        return nullptr;
+    }
+
+    Thread* take_runnable_thread(u32 cpu) { return find_runnable_thread(cpu, true); }
+
+    // Moves the highest priority thread that may run on the given processor over to
+    // another set of queues. Both sets are locked throughout, so the thread is always
+    // on one of them and dequeue_runnable_thread() can't miss it.
+    Thread* move_runnable_thread_to(ThreadReadyQueues& destination, u32 cpu)
+    {
+        VERIFY(&destination != this);
+        // Always lock in the same order, so that two processors pulling from each other can't deadlock.
+        auto& first = this < &destination ? *this : destination;
+        auto& second = this < &destination ? destination : *this;
+        SpinlockLocker first_locker(first.lock);
+        SpinlockLocker second_locker(second.lock);
+
+        auto* thread = find_runnable_thread_locked(cpu, false);
+        if (!thread)
+            return nullptr;
+        auto priority = static_cast<u32>(thread->m_runnable_priority);
+        remove(*thread);
+        destination.append_locked(*thread, priority);
+        return thread;
+    }
 };
 
-static Singleton<SpinlockProtected<ThreadReadyQueues>> g_ready_queues;
+// Thread affinity is a u32 bitmask, so we can never schedule on more processors than that.
+static constexpr u32 max_scheduled_processors = min<size_t>(MAX_CPU_COUNT, sizeof(u32) * 8);
+
+// How many more threads another processor has to have queued before we place a
+// thread there rather than on the processor whose caches it last warmed up.
+static constexpr u32 cache_affinity_imbalance_threshold = 2;
+
+// How often (in timer ticks) every processor checks whether it should pull work
+// from the busiest processor.
+static constexpr u32 load_balance_interval_ticks = 50;
+
+static Array<ThreadReadyQueues*, max_scheduled_processors> s_ready_queues_by_processor;
+static Atomic<u32> s_online_processors_mask { 0 };
+
+// Threads that became runnable before any processor they have affinity for has
+// come online (e.g. the idle threads of APs) are parked here until one does.
+static Singleton<ThreadReadyQueues> s_pending_ready_queues;
 
 static SpinlockProtected<TotalTimeScheduled> g_total_time_scheduled { LockRank::None };
 
@@ -55,7 +186,7 @@ static void dump_thread_list(bool = false);
 static inline u32 thread_priority_to_priority_index(u32 thread_priority)
 {
     // Converts the priority in the range of THREAD_PRIORITY_MIN...THREAD_PRIORITY_MAX
-    // to a index into g_ready_queues where 0 is the highest priority bucket
+    // to a index into ThreadReadyQueues::queues where 0 is the highest priority bucket
     VERIFY(thread_priority >= THREAD_PRIORITY_MIN && thread_priority <= THREAD_PRIORITY_MAX);
     constexpr u32 thread_priority_count = THREAD_PRIORITY_MAX - THREAD_PRIORITY_MIN + 1;
     static_assert(thread_priority_count > 0);
@@ -64,71 +195,109 @@ static inline u32 thread_priority_to_priority_index(u32 thread_priority)
     return priority_bucket;
 }
 
+static ThreadReadyQueues& current_ready_queues()
+{
+    return ProcessorSpecific<ThreadReadyQueues>::get();
+}
+
+static ThreadReadyQueues* ready_queues_for_processor(u32 cpu)
+{
+    if (cpu >= max_scheduled_processors)
+        return nullptr;
+    if (!(s_online_processors_mask.load(AK::MemoryOrder::memory_order_acquire) & (1u << cpu)))
+        return nullptr;
+    return s_ready_queues_by_processor[cpu];
+}
+
+static Thread* steal_runnable_thread(u32 cpu)
+{
+    // Start looking at the next processor so that idle processors don't all
+    // gang up on the same victim.
+    for (u32 i = 1; i < max_scheduled_processors; i++) {
+        auto* ready_queues = ready_queues_for_processor((cpu + i) % max_scheduled_processors);
+        if (!ready_queues || ready_queues->thread_count.load() == 0)
+            continue;
+        if (auto* thread = ready_queues->take_runnable_thread(cpu))
+            return thread;
+    }
+
+    // Threads may have been parked before their processor came online and
+    // then had their affinity changed.
+    if (s_pending_ready_queues->thread_count.load() != 0)
+        return s_pending_ready_queues->take_runnable_thread(cpu);
+    return nullptr;
+}
+
+static ThreadReadyQueues& select_ready_queues_for(Thread const& thread)
+{
+    auto eligible_mask = s_online_processors_mask.load(AK::MemoryOrder::memory_order_acquire) & thread.affinity();
+    if (eligible_mask == 0)
+        return *s_pending_ready_queues;
+
+    ThreadReadyQueues* least_loaded = nullptr;
+    for (auto mask = eligible_mask; mask != 0;) {
+        auto cpu = bit_scan_forward(mask) - 1;
+        mask &= ~(1u << cpu);
+        auto* ready_queues = s_ready_queues_by_processor[cpu];
+        if (!least_loaded || ready_queues->thread_count.load() < least_loaded->thread_count.load())
+            least_loaded = ready_queues;
+    }
+    VERIFY(least_loaded);
+
+    // A thread that never ran has no cache footprint anywhere, so just put it
+    // wherever there is the least amount of work.
+    if (thread.times_scheduled() == 0)
+        return *least_loaded;
+
+    // Otherwise prefer the processor the thread last ran on, as long as it's
+    // not much busier than the alternative.
+    auto last_cpu = thread.cpu();
+    if (last_cpu >= max_scheduled_processors || !(eligible_mask & (1u << last_cpu)))
+        return *least_loaded;
+    auto& last_ready_queues = *s_ready_queues_by_processor[last_cpu];
+    if (last_ready_queues.thread_count.load() >= least_loaded->thread_count.load() + cache_affinity_imbalance_threshold)
+        return *least_loaded;
+    return last_ready_queues;
+}
+
 Thread& Scheduler::pull_next_runnable_thread()
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    auto cpu = Processor::current_id();
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread& {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                thread.m_runnable_priority = -1;
-                ready_queue.thread_list.remove(thread);
-                if (ready_queue.thread_list.is_empty())
-                    ready_queues.mask &= ~(1u << priority);
-                // Mark it as active because we are using this thread. This is similar
-                // to comparing it with Processor::current_thread, but when there are
-                // multiple processors there's no easy way to check whether the thread
-                // is actually still needed. This prevents accidental finalization when
-                // a thread is no longer in Running state, but running on another core.
-
-                // We need to mark it active here so that this thread won't be
-                // scheduled on another core if it were to be queued before actually
-                // switching to it.
-                // FIXME: Figure out a better way maybe?
-                thread.set_active(true);
-                return thread;
-            }
-            priority_mask &= ~(1u << priority);
-        }
+    auto* thread = current_ready_queues().take_runnable_thread(cpu);
+    if (!thread)
+        thread = steal_runnable_thread(cpu);
+    if (!thread)
         return *Processor::idle_thread();
-    });
+    return *thread;
 }
 
-Thread* Scheduler::peek_next_runnable_thread()
+// Threads are picked without holding g_scheduler_lock, so by the time we get
+// to switch to one, another processor may have changed its state.
+static bool claim_picked_thread(Thread& thread)
 {
-    auto affinity_mask = 1u << Processor::current_id();
+    VERIFY(g_scheduler_lock.is_locked_by_current_processor());
+    if (thread.is_idle_thread())
+        return true;
+    if (thread.state() == Thread::State::Runnable) {
+        // It may have been stopped and resumed in the meantime, which put it on a ready queue again.
+        Scheduler::dequeue_runnable_thread(thread);
+        return true;
+    }
 
-    return g_ready_queues->with([&](auto& ready_queues) -> Thread* {
-        auto priority_mask = ready_queues.mask;
-        while (priority_mask != 0) {
-            auto priority = bit_scan_forward(priority_mask);
-            VERIFY(priority > 0);
-            auto& ready_queue = ready_queues.queues[--priority];
-            for (auto& thread : ready_queue.thread_list) {
-                VERIFY(thread.m_runnable_priority == (int)priority);
-                if (thread.is_active())
-                    continue;
-                if (!(thread.affinity() & affinity_mask))
-                    continue;
-                return &thread;
-            }
-            priority_mask &= ~(1u << priority);
-        }
+    thread.set_active(false);
+    // Whoever killed it couldn't hand it to the finalizer while it was marked active.
+    if (thread.state() == Thread::State::Dying)
+        Scheduler::notify_finalizer();
+    return false;
+}
 
-        // Unlike in pull_next_runnable_thread() we don't want to fall back to
-        // the idle thread. We just want to see if we have any other thread ready
-        // to be scheduled.
-        return nullptr;
-    });
+Thread* Scheduler::peek_next_runnable_thread()
+{
+    // Unlike in pull_next_runnable_thread() we don't want to fall back to
+    // the idle thread, nor do we want to steal from other processors. We
+    // just want to see if we have any other thread ready to be scheduled.
+    return current_ready_queues().find_runnable_thread(Processor::current_id(), false);
 }
 
 bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
@@ -136,43 +305,71 @@ bool Scheduler::dequeue_runnable_thread(Thread& thread, bool check_affinity)
     if (thread.is_idle_thread())
         return true;
 
-    return g_ready_queues->with([&](auto& ready_queues) {
-        auto priority = thread.m_runnable_priority;
-        if (priority < 0) {
-            VERIFY(!thread.m_ready_queue_node.is_in_list());
-            return false;
-        }
+    if (check_affinity && !(thread.affinity() & (1 << Processor::current_id())))
+        return false;
 
-        if (check_affinity && !(thread.affinity() & (1 << Processor::current_id())))
+    for (;;) {
+        ThreadReadyQueues* ready_queues = thread.m_runnable_queues;
+        if (!ready_queues)
             return false;
 
-        VERIFY(ready_queues.mask & (1u << priority));
-        auto& ready_queue = ready_queues.queues[priority];
-        thread.m_runnable_priority = -1;
-        ready_queue.thread_list.remove(thread);
-        if (ready_queue.thread_list.is_empty())
-            ready_queues.mask &= ~(1u << priority);
+        // Other processors pick and move threads without holding g_scheduler_lock,
+        // so make sure the thread is still queued where we looked.
+        SpinlockLocker locker(ready_queues->lock);
+        if (thread.m_runnable_queues != ready_queues)
+            continue;
+        ready_queues->remove(thread);
         return true;
-    });
+    }
 }
 
 void Scheduler::enqueue_runnable_thread(Thread& thread)
 {
-    VERIFY(g_scheduler_lock.is_locked_by_current_processor());
     if (thread.is_idle_thread())
         return;
     auto priority = thread_priority_to_priority_index(thread.priority());
+    select_ready_queues_for(thread).append(thread, priority);
+}
 
-    g_ready_queues->with([&](auto& ready_queues) {
-        VERIFY(thread.m_runnable_priority < 0);
-        thread.m_runnable_priority = (int)priority;
-        VERIFY(!thread.m_ready_queue_node.is_in_list());
-        auto& ready_queue = ready_queues.queues[priority];
-        bool was_empty = ready_queue.thread_list.is_empty();
-        ready_queue.thread_list.append(thread);
-        if (was_empty)
-            ready_queues.mask |= (1u << priority);
-    });
+static void balance_load()
+{
+    auto cpu = Processor::current_id();
+    auto& local_ready_queues = current_ready_queues();
+
+    ThreadReadyQueues* busiest = nullptr;
+    for (u32 other_cpu = 0; other_cpu < max_scheduled_processors; other_cpu++) {
+        if (other_cpu == cpu)
+            continue;
+        auto* ready_queues = ready_queues_for_processor(other_cpu);
+        if (!ready_queues)
+            continue;
+        if (!busiest || ready_queues->thread_count.load() > busiest->thread_count.load())
+            busiest = ready_queues;
+    }
+
+    // Moving a single thread is only worth it if it doesn't just flip the imbalance around.
+    if (!busiest || busiest->thread_count.load() < local_ready_queues.thread_count.load() + 2)
+        return;
+
+    if (busiest->move_runnable_thread_to(local_ready_queues, cpu))
+        dbgln_if(SCHEDULER_DEBUG, "Scheduler[{}]: Pulled a thread over to balance load", cpu);
+}
+
+UNMAP_AFTER_INIT static void initialize_ready_queues()
+{
+    ProcessorSpecific<ThreadReadyQueues>::initialize();
+
+    auto cpu = Processor::current_id();
+    VERIFY(cpu < max_scheduled_processors);
+    auto& ready_queues = current_ready_queues();
+    // Stagger the load balancing passes so that processors don't all go looking at once.
+    ready_queues.ticks_until_load_balance = load_balance_interval_ticks + cpu;
+    s_ready_queues_by_processor[cpu] = &ready_queues;
+    s_online_processors_mask.fetch_or(1u << cpu, AK::MemoryOrder::memory_order_release);
+
+    // Adopt any threads that were waiting for this processor to come online.
+    while (s_pending_ready_queues->move_runnable_thread_to(ready_queues, cpu))
+        ;
 }
 
 UNMAP_AFTER_INIT void Scheduler::start()
@@ -214,26 +411,33 @@ void Scheduler::pick_next()
             Processor::set_current_in_scheduler(false);
         });
 
+    // Picking a thread (and stealing one from another processor) only takes the
+    // ready queue locks. The scheduler lock is only needed for the switch itself.
+    auto* thread_to_schedule = &pull_next_runnable_thread();
+
     SpinlockLocker lock(g_scheduler_lock);
+    // Threads are only queued while Runnable, and we now hold the lock that
+    // guards state changes, so picking again can't go stale.
+    while (!claim_picked_thread(*thread_to_schedule))
+        thread_to_schedule = &pull_next_runnable_thread();
 
     if constexpr (SCHEDULER_RUNNABLE_DEBUG) {
         dump_thread_list();
     }
 
-    auto& thread_to_schedule = pull_next_runnable_thread();
     if constexpr (SCHEDULER_DEBUG) {
         dbgln("Scheduler[{}]: Switch to {} @ {:#04x}:{:p}",
             Processor::current_id(),
-            thread_to_schedule,
-            thread_to_schedule.regs().cs, thread_to_schedule.regs().ip());
+            *thread_to_schedule,
+            thread_to_schedule->regs().cs, thread_to_schedule->regs().ip());
     }
 
     // We need to leave our first critical section before switching context,
     // but since we're still holding the scheduler lock we're still in a critical section
     critical.leave();
 
-    thread_to_schedule.set_ticks_left(time_slice_for(thread_to_schedule));
-    context_switch(&thread_to_schedule);
+    thread_to_schedule->set_ticks_left(time_slice_for(*thread_to_schedule));
+    context_switch(thread_to_schedule);
 }
 
 void Scheduler::yield()
@@ -381,9 +585,16 @@ UNMAP_AFTER_INIT void Scheduler::initialize()
 
 UNMAP_AFTER_INIT void Scheduler::set_idle_thread(Thread* idle_thread)
 {
-    idle_thread->set_idle_thread();
     Processor::current().set_idle_thread(*idle_thread);
     Processor::set_current_thread(*idle_thread);
+    {
+        // The idle thread was queued up like any other thread when it was
+        // created, but it must never be picked from a ready queue.
+        SpinlockLocker lock(g_scheduler_lock);
+        dequeue_runnable_thread(*idle_thread);
+    }
+    idle_thread->set_idle_thread();
+    initialize_ready_queues();
 }
 
 UNMAP_AFTER_INIT Thread* Scheduler::create_ap_idle_thread(u32 cpu)
@@ -435,6 +646,12 @@ void Scheduler::timer_tick(RegisterState const& regs)
         return;
     }
 
+    auto& ready_queues = current_ready_queues();
+    if (--ready_queues.ticks_until_load_balance == 0) {
+        ready_queues.ticks_until_load_balance = load_balance_interval_ticks;
+        balance_load();
+    }
+
     if (current_thread->tick())
         return;
 
@@ -507,6 +724,13 @@ void dump_thread_list(bool with_stack_traces)
 {
     dbgln("Scheduler thread list for processor {}:", Processor::current_id());
 
+    for (u32 cpu = 0; cpu < max_scheduled_processors; cpu++) {
+        if (auto* ready_queues = ready_queues_for_processor(cpu))
+            dmesgln("  Processor {} has {} runnable thread(s) queued", cpu, ready_queues->thread_count.load());
+    }
+    if (auto pending_count = s_pending_ready_queues->thread_count.load(); pending_count != 0)
+        dmesgln("  {} runnable thread(s) waiting for their processor to come online", pending_count);
+
     auto get_cs = [](Thread& thread) -> u16 {
 #if ARCH(I386) || ARCH(X86_64)
         if (!thread.current_trap())
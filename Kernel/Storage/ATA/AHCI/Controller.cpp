@@ -93,6 +93,13 @@ void AHCIController::start_request(ATADevice const& device, AsyncBlockDeviceRequ
     port->start_request(request);
 }
 
+u32 AHCIController::max_blocks_per_merged_request(ATADevice const& device) const
+{
+    auto port = m_ports[device.ata_address().port];
+    VERIFY(port);
+    return port->max_transfer_size() / device.block_size();
+}
+
 void AHCIController::complete_current_request(AsyncDeviceRequest::RequestResult)
 {
     VERIFY_NOT_REACHED();
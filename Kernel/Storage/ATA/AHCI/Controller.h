@@ -32,6 +32,7 @@ public:
     virtual bool shutdown() override;
     virtual size_t devices_count() const override;
     virtual void start_request(ATADevice const&, AsyncBlockDeviceRequest&) override;
+    virtual u32 max_blocks_per_merged_request(ATADevice const&) const override;
     virtual void complete_current_request(AsyncDeviceRequest::RequestResult) override;
 
     void handle_interrupt_for_port(Badge<AHCIInterruptHandler>, u32 port_index) const;
@@ -38,7 +38,7 @@ ErrorOr<void> AHCIPort::allocate_resources_and_initialize_ports()
 
     m_fis_receive_page = TRY(MM.allocate_physical_page());
 
-    for (size_t index = 0; index < 1; index++) {
+    for (size_t index = 0; index < dma_buffer_page_count; index++) {
         auto dma_page = TRY(MM.allocate_physical_page());
         m_dma_buffers.append(move(dma_page));
     }
@@ -150,7 +150,7 @@ void AHCIPort::handle_interrupt()
                     return;
                 }
                 if (m_current_request->request_type() == AsyncBlockDeviceRequest::Read) {
-                    if (auto result = m_current_request->write_to_buffer(m_current_request->buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * m_current_request->block_count()); result.is_error()) {
+                    if (auto result = m_current_request->scatter_into_buffers(m_current_scatter_list->dma_region().as_ptr()); result.is_error()) {
                         dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
                         m_current_scatter_list = nullptr;
                         complete_current_request(AsyncDeviceRequest::MemoryFault);
@@ -498,7 +498,7 @@ Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_li
     VERIFY(request.block_count() > 0);
 
     NonnullRefPtrVector<Memory::PhysicalPage> allocated_dma_regions;
-    for (size_t index = 0; index < calculate_descriptors_count(request.block_count()); index++) {
+    for (size_t index = 0; index < calculate_descriptors_count(request.total_block_count()); index++) {
         allocated_dma_regions.append(m_dma_buffers.at(index));
     }
 
@@ -506,7 +506,7 @@ Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_li
     if (!m_current_scatter_list)
         return AsyncDeviceRequest::Failure;
     if (request.request_type() == AsyncBlockDeviceRequest::Write) {
-        if (auto result = request.read_from_buffer(request.buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count()); result.is_error()) {
+        if (auto result = request.gather_from_buffers(m_current_scatter_list->dma_region().as_ptr()); result.is_error()) {
             return AsyncDeviceRequest::MemoryFault;
         }
     }
@@ -530,7 +530,7 @@ void AHCIPort::start_request(AsyncBlockDeviceRequest& request)
         return;
     }
 
-    auto success = access_device(request.request_type(), request.block_index(), request.block_count());
+    auto success = access_device(request.request_type(), request.block_index(), request.total_block_count());
     if (!success) {
         dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
         locker.unlock();
@@ -563,7 +563,7 @@ bool AHCIPort::spin_until_ready() const
     return true;
 }
 
-bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64 lba, u8 block_count)
+bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64 lba, u16 block_count)
 {
     VERIFY(m_connected_device);
     VERIFY(is_operable());
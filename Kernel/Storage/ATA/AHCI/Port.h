@@ -47,11 +47,16 @@ public:
 
     LockRefPtr<StorageDevice> connected_device() const { return m_connected_device; }
 
+    // Every command can scatter its data across all of our DMA pages.
+    size_t max_transfer_size() const { return dma_buffer_page_count * PAGE_SIZE; }
+
     bool reset();
     bool initialize_without_reset();
     void handle_interrupt();
 
 private:
+    static constexpr size_t dma_buffer_page_count = 16;
+
     ErrorOr<void> allocate_resources_and_initialize_ports();
 
     bool is_phy_enabled() const { return (m_port_registers.ssts & 0xf) == 3; }
@@ -75,7 +80,7 @@ private:
 
     void start_request(AsyncBlockDeviceRequest&);
     void complete_current_request(AsyncDeviceRequest::RequestResult);
-    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u8 block_count);
+    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u16 block_count);
     size_t calculate_descriptors_count(size_t block_count) const;
     [[nodiscard]] Optional<AsyncDeviceRequest::RequestResult> prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request);
 
@@ -22,6 +22,7 @@ class ATAController
     , public LockWeakable<ATAController> {
 public:
     virtual void start_request(ATADevice const&, AsyncBlockDeviceRequest&) = 0;
+    virtual u32 max_blocks_per_merged_request(ATADevice const&) const { return 0; }
 
 protected:
     ATAController();
@@ -33,4 +33,12 @@ void ATADevice::start_request(AsyncBlockDeviceRequest& request)
     controller->start_request(*this, request);
 }
 
+u32 ATADevice::max_blocks_per_merged_request() const
+{
+    auto controller = m_controller.strong_ref();
+    if (!controller)
+        return 0;
+    return controller->max_blocks_per_merged_request(*this);
+}
+
 }
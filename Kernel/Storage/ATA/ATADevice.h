@@ -32,6 +32,9 @@ public:
     // ^BlockDevice
     virtual void start_request(AsyncBlockDeviceRequest&) override;
 
+    // ^StorageDevice
+    virtual u32 max_blocks_per_merged_request() const override;
+
     u16 ata_capabilites() const { return m_capabilities; }
     Address const& ata_address() const { return m_ata_address; }
 
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Storage/BlockRequestQueue.h>
+#include <Kernel/Storage/StorageDevice.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+BlockRequestQueue::BlockRequestQueue(StorageDevice& device)
+    : m_device(device)
+{
+}
+
+auto BlockRequestQueue::policy() const -> Policy
+{
+    SpinlockLocker lock(m_lock);
+    return m_policy;
+}
+
+void BlockRequestQueue::set_policy(Policy policy)
+{
+    SpinlockLocker lock(m_lock);
+    m_policy = policy;
+    m_starved_write_batches = 0;
+}
+
+StringView BlockRequestQueue::policy_to_string_view(Policy policy)
+{
+    switch (policy) {
+    case Policy::Noop:
+        return "noop"sv;
+    case Policy::Deadline:
+        return "deadline"sv;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+auto BlockRequestQueue::policy_from_string_view(StringView name) -> Optional<Policy>
+{
+    if (name == "noop"sv)
+        return Policy::Noop;
+    if (name == "deadline"sv)
+        return Policy::Deadline;
+    return {};
+}
+
+void BlockRequestQueue::queue(NonnullLockRefPtr<AsyncBlockDeviceRequest> request)
+{
+    auto max_merged_block_count = m_device.max_blocks_per_merged_request();
+    auto now_ms = TimeManagement::the().uptime_ms();
+
+    SpinlockLocker lock(m_lock);
+    request->m_deadline_ms = now_ms + (request->request_type() == AsyncBlockDeviceRequest::Read ? read_expire_ms : write_expire_ms);
+    m_pending_requests.append(*request);
+    dispatch(move(lock), max_merged_block_count);
+}
+
+void BlockRequestQueue::request_finished(AsyncBlockDeviceRequest const& request)
+{
+    auto max_merged_block_count = m_device.max_blocks_per_merged_request();
+
+    SpinlockLocker lock(m_lock);
+    // The requests that were merged into one in flight are completed below, and
+    // come back here once they are. There is nothing to dispatch for them.
+    if (!m_requests_in_flight.contains(request))
+        return;
+    NonnullLockRefPtr<AsyncBlockDeviceRequest> finished_request = const_cast<AsyncBlockDeviceRequest&>(request);
+    m_requests_in_flight.remove(*finished_request);
+    m_request_in_flight_count--;
+    dispatch(move(lock), max_merged_block_count);
+
+    finished_request->complete_merged_requests();
+}
+
+void BlockRequestQueue::plug()
+{
+    SpinlockLocker lock(m_lock);
+    m_plug_count++;
+}
+
+void BlockRequestQueue::unplug()
+{
+    auto max_merged_block_count = m_device.max_blocks_per_merged_request();
+
+    SpinlockLocker lock(m_lock);
+    VERIFY(m_plug_count > 0);
+    if (--m_plug_count > 0)
+        return;
+    dispatch(move(lock), max_merged_block_count);
+}
+
+bool BlockRequestQueue::can_merge(AsyncBlockDeviceRequest const& request, AsyncBlockDeviceRequest const& other_request)
+{
+    if (request.request_type() != other_request.request_type())
+        return false;
+    // A fault on one of the buffers fails the whole merged request, so we only
+    // let requests share a command if they can't hurt each other that way.
+    if (request.buffer().is_kernel_buffer() && other_request.buffer().is_kernel_buffer())
+        return true;
+    return &request.process() == &other_request.process();
+}
+
+AsyncBlockDeviceRequest& BlockRequestQueue::select_next_request()
+{
+    VERIFY(m_lock.is_locked());
+    VERIFY(!m_pending_requests.is_empty());
+    switch (m_policy) {
+    case Policy::Noop:
+        return *m_pending_requests.first();
+    case Policy::Deadline:
+        return select_next_request_by_deadline();
+    }
+    VERIFY_NOT_REACHED();
+}
+
+AsyncBlockDeviceRequest& BlockRequestQueue::select_next_request_by_deadline()
+{
+    // Note: Requests are queued in the order they were made, and all requests of the
+    //       same type wait for the same amount of time, so the first request of each
+    //       type is also the one whose deadline expires first.
+    AsyncBlockDeviceRequest* oldest_read = nullptr;
+    AsyncBlockDeviceRequest* oldest_write = nullptr;
+    for (auto& request : m_pending_requests) {
+        auto*& oldest = request.request_type() == AsyncBlockDeviceRequest::Read ? oldest_read : oldest_write;
+        if (!oldest)
+            oldest = &request;
+        if (oldest_read && oldest_write)
+            break;
+    }
+
+    auto now_ms = TimeManagement::the().uptime_ms();
+    if (oldest_read && oldest_read->m_deadline_ms <= now_ms)
+        return *oldest_read;
+    if (oldest_write && oldest_write->m_deadline_ms <= now_ms) {
+        m_starved_write_batches = 0;
+        return *oldest_write;
+    }
+
+    auto type = AsyncBlockDeviceRequest::Write;
+    if (oldest_read && (!oldest_write || m_starved_write_batches < max_starved_write_batches)) {
+        type = AsyncBlockDeviceRequest::Read;
+        if (oldest_write)
+            m_starved_write_batches++;
+    } else {
+        m_starved_write_batches = 0;
+    }
+
+    // Continue the sweep where the previous request ended, and start over from the
+    // lowest block once there is nothing left beyond that point.
+    AsyncBlockDeviceRequest* next_in_sweep = nullptr;
+    AsyncBlockDeviceRequest* lowest = nullptr;
+    for (auto& request : m_pending_requests) {
+        if (request.request_type() != type)
+            continue;
+        if (request.block_index() >= m_next_block_index && (!next_in_sweep || request.block_index() < next_in_sweep->block_index()))
+            next_in_sweep = &request;
+        if (!lowest || request.block_index() < lowest->block_index())
+            lowest = &request;
+    }
+    VERIFY(lowest);
+    return next_in_sweep ? *next_in_sweep : *lowest;
+}
+
+void BlockRequestQueue::dispatch(SpinlockLocker<Spinlock>&& lock, u32 max_merged_block_count)
+{
+    auto max_requests_in_flight = m_device.max_requests_in_flight();
+    VERIFY(max_requests_in_flight > 0);
+    while (m_request_in_flight_count < max_requests_in_flight && !m_pending_requests.is_empty() && m_plug_count == 0) {
+        auto request = take_next_batch(max_merged_block_count);
+        m_requests_in_flight.append(*request);
+        m_request_in_flight_count++;
+        // Note: The request may complete before start() returns, which dispatches the
+        //       next one already, so we have to check again with the lock held.
+        request->do_start(move(lock));
+        if (!lock.have_lock())
+            lock.lock();
+    }
+    lock.unlock();
+}
+
+NonnullLockRefPtr<AsyncBlockDeviceRequest> BlockRequestQueue::take_next_batch(u32 max_merged_block_count)
+{
+    VERIFY(m_lock.is_locked());
+
+    // Note: Moving a request between lists briefly drops the list's reference to it,
+    //       so we have to hold on to it ourselves while doing so.
+    NonnullLockRefPtr<AsyncBlockDeviceRequest> selected_request = select_next_request();
+
+    // Build the batch in block order: requests for the blocks right after it go to
+    // the back, requests for the blocks right before it go to the front.
+    AsyncBlockDeviceRequest::QueueList batch;
+    batch.append(*selected_request);
+    u64 first_block_index = selected_request->block_index();
+    u64 end_block_index = first_block_index + selected_request->block_count();
+    u32 total_block_count = selected_request->block_count();
+
+    bool did_merge = max_merged_block_count > total_block_count;
+    while (did_merge) {
+        did_merge = false;
+        for (auto& request : m_pending_requests) {
+            if (total_block_count + request.block_count() > max_merged_block_count || !can_merge(*selected_request, request))
+                continue;
+            bool is_back_merge = request.block_index() == end_block_index;
+            bool is_front_merge = request.block_index() + request.block_count() == first_block_index;
+            if (!is_back_merge && !is_front_merge)
+                continue;
+            NonnullLockRefPtr<AsyncBlockDeviceRequest> merged_request = request;
+            total_block_count += merged_request->block_count();
+            if (is_back_merge) {
+                end_block_index += merged_request->block_count();
+                batch.append(*merged_request);
+            } else {
+                first_block_index = merged_request->block_index();
+                batch.prepend(*merged_request);
+            }
+            // The request was moved out of the list we are iterating, so start over.
+            did_merge = true;
+            break;
+        }
+    }
+
+    auto request = batch.take_first();
+    request->m_total_block_count = total_block_count;
+    while (!batch.is_empty()) {
+        auto merged_request = batch.take_first();
+        merged_request->mark_started_as_part_of_other_request();
+        request->m_merged_requests.append(*merged_request);
+    }
+
+    m_next_block_index = end_block_index;
+    return request.release_nonnull();
+}
+
+}
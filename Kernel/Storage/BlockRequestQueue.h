@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Optional.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+#include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/Locking/Spinlock.h>
+
+namespace Kernel {
+
+class StorageDevice;
+
+// Sits between the users of a storage device and its driver. Requests are held
+// back while the driver has as many requests in flight as it can handle (or while
+// a submitter has the queue plugged), and whenever one of them completes the
+// scheduling policy picks the next request and merges queued requests for the
+// adjacent blocks into it, so that the driver can carry out all of them with a
+// single command.
+class BlockRequestQueue {
+    AK_MAKE_NONCOPYABLE(BlockRequestQueue);
+    AK_MAKE_NONMOVABLE(BlockRequestQueue);
+
+public:
+    enum class Policy {
+        // Dispatch requests in the order they were made.
+        Noop,
+        // Sweep across the device, preferring reads over writes, unless a request
+        // has been waiting for longer than its deadline.
+        Deadline,
+    };
+
+    // Holds back dispatching while the submitter queues up a batch of requests, so
+    // that requests for adjacent blocks get a chance to be merged with each other.
+    class Plug {
+    public:
+        explicit Plug(BlockRequestQueue& queue)
+            : m_queue(queue)
+        {
+            m_queue.plug();
+        }
+        ~Plug() { m_queue.unplug(); }
+
+    private:
+        BlockRequestQueue& m_queue;
+    };
+
+    explicit BlockRequestQueue(StorageDevice&);
+
+    Policy policy() const;
+    void set_policy(Policy);
+
+    static StringView policy_to_string_view(Policy);
+    static Optional<Policy> policy_from_string_view(StringView);
+
+    void queue(NonnullLockRefPtr<AsyncBlockDeviceRequest>);
+    void request_finished(AsyncBlockDeviceRequest const&);
+
+private:
+    static constexpr u64 read_expire_ms = 500;
+    static constexpr u64 write_expire_ms = 5000;
+    // How many times in a row reads may be dispatched ahead of pending writes.
+    static constexpr size_t max_starved_write_batches = 2;
+
+    void plug();
+    void unplug();
+
+    void dispatch(SpinlockLocker<Spinlock>&&, u32 max_merged_block_count);
+    NonnullLockRefPtr<AsyncBlockDeviceRequest> take_next_batch(u32 max_merged_block_count);
+    AsyncBlockDeviceRequest& select_next_request();
+    AsyncBlockDeviceRequest& select_next_request_by_deadline();
+    static bool can_merge(AsyncBlockDeviceRequest const&, AsyncBlockDeviceRequest const&);
+
+    StorageDevice& m_device;
+
+    mutable Spinlock m_lock { LockRank::None };
+    Policy m_policy { Policy::Deadline };
+    AsyncBlockDeviceRequest::QueueList m_pending_requests;
+    AsyncBlockDeviceRequest::QueueList m_requests_in_flight;
+    size_t m_request_in_flight_count { 0 };
+    size_t m_plug_count { 0 };
+    u64 m_next_block_index { 0 };
+    size_t m_starved_write_batches { 0 };
+};
+
+}
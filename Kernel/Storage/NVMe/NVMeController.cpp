@@ -16,6 +16,10 @@
 #include <Kernel/Sections.h>
 #include <Kernel/Storage/NVMe/NVMeController.h>
 #include <Kernel/Storage/StorageManagement.h>
+#if ARCH(I386) || ARCH(X86_64)
+#    include <Kernel/Arch/InterruptManagement.h>
+#    include <Kernel/Arch/x86/common/Interrupts/APIC.h>
+#endif
 
 namespace Kernel {
 
@@ -36,9 +40,18 @@ UNMAP_AFTER_INIT NVMeController::NVMeController(const PCI::DeviceIdentifier& dev
 UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize(bool is_queue_polled)
 {
     // Nr of queues = one queue per core
-    auto nr_of_queues = Processor::count();
+    u32 nr_of_queues = Processor::count();
     auto irq = is_queue_polled ? Optional<u8> {} : m_pci_device_id.interrupt_line().value();
 
+#if ARCH(I386) || ARCH(X86_64)
+    // With MSI-X, every queue gets a vector of its own (the admin queue always uses the first one),
+    // so completions of an IO queue can be delivered straight to the processor that submitted to it.
+    if (!is_queue_polled && APIC::initialized() && msix_table_entry_count() >= 2) {
+        m_uses_msix = true;
+        nr_of_queues = min<u32>(nr_of_queues, msix_table_entry_count() - 1);
+    }
+#endif
+
     PCI::enable_memory_space(m_pci_device_id.address());
     PCI::enable_bus_mastering(m_pci_device_id.address());
     m_bar = PCI::get_BAR0(m_pci_device_id.address()) & BAR_ADDR_MASK;
@@ -53,16 +66,27 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::initialize(bool is_queue_polled)
     m_ready_timeout = Time::from_milliseconds((CAP_TO(caps) + 1) * 500); // CAP.TO is in 500ms units
 
     calculate_doorbell_stride();
+    if (m_uses_msix) {
+        // Note: All table entries come out of reset masked, so nothing is signalled before we set them up.
+        TRY(enable_extended_message_signalled_interrupts());
+        irq = TRY(setup_msix_interrupt(0, 0));
+    }
     TRY(create_admin_queue(irq));
     VERIFY(m_admin_queue_ready == true);
 
     VERIFY(IO_QUEUE_SIZE < MQES(caps));
     dbgln_if(NVME_DEBUG, "NVMe: IO queue depth is: {}", IO_QUEUE_SIZE);
 
+    nr_of_queues = TRY(negotiate_io_queue_count(nr_of_queues));
+    dmesgln("NVMe: Using {} IO queue(s){}", nr_of_queues, m_uses_msix ? " with MSI-X"sv : ""sv);
+
     // Create an IO queue per core
     for (u32 cpuid = 0; cpuid < nr_of_queues; ++cpuid) {
         // qid is zero is used for admin queue
-        TRY(create_io_queue(cpuid + 1, irq));
+        u8 qid = cpuid + 1;
+        if (m_uses_msix)
+            irq = TRY(setup_msix_interrupt(qid, cpuid));
+        TRY(create_io_queue(qid, irq));
     }
     TRY(identify_and_init_namespaces());
     return {};
@@ -213,6 +237,38 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::identify_and_init_namespaces()
     return {};
 }
 
+UNMAP_AFTER_INIT ErrorOr<u32> NVMeController::negotiate_io_queue_count(u32 desired_count)
+{
+    VERIFY(desired_count > 0);
+    NVMeSubmission sub {};
+    sub.op = OP_ADMIN_SET_FEATURES;
+    sub.generic.cdw10 = AK::convert_between_host_and_little_endian(static_cast<u32>(FEATURE_NUMBER_OF_QUEUES));
+    // Both counts are 0 based, with the completion queue count in the upper half.
+    sub.generic.cdw11 = AK::convert_between_host_and_little_endian(((desired_count - 1) << 16) | (desired_count - 1));
+    u32 result = 0;
+    if (auto status = m_admin_queue->submit_sync_sqe(sub, &result); status) {
+        dmesgln("NVMe: Failed to set the number of queues: status {:#x}", status);
+        return EFAULT;
+    }
+    // The controller tells us how many queues it actually allocated, which may be more or less than we asked for.
+    u32 allocated_submission_queues = (result & 0xffff) + 1;
+    u32 allocated_completion_queues = (result >> 16) + 1;
+    return min(desired_count, min(allocated_submission_queues, allocated_completion_queues));
+}
+
+UNMAP_AFTER_INIT ErrorOr<u8> NVMeController::setup_msix_interrupt([[maybe_unused]] u16 table_entry, [[maybe_unused]] u32 cpu)
+{
+#if ARCH(I386) || ARCH(X86_64)
+    auto interrupt_number = TRY(InterruptManagement::the().allocate_message_signalled_interrupt_number());
+    auto address = TRY(APIC::the().message_signalled_interrupt_address(cpu));
+    TRY(set_msix_table_entry(table_entry, address, APIC::message_signalled_interrupt_data(interrupt_number)));
+    dbgln_if(NVME_DEBUG, "NVMe: MSI-X table entry {} routed to CPU #{} with interrupt number {}", table_entry, cpu, interrupt_number);
+    return interrupt_number;
+#else
+    return ENOTSUP;
+#endif
+}
+
 UNMAP_AFTER_INIT Tuple<u64, u8> NVMeController::get_ns_features(IdentifyNamespace& identify_data_struct)
 {
     auto flbas = identify_data_struct.flbas & FLBA_SIZE_MASK;
@@ -289,7 +345,7 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_admin_queue(Optional<u8> i
         return EFAULT;
     }
     set_admin_queue_ready_flag();
-    m_admin_queue = TRY(NVMeQueue::try_create(0, irq, qdepth, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs)));
+    m_admin_queue = TRY(NVMeQueue::try_create(*this, 0, irq, m_uses_msix, qdepth, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs)));
 
     dbgln_if(NVME_DEBUG, "NVMe: Admin queue created");
     return {};
@@ -327,10 +383,10 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 qid, Optional<
         sub.create_cq.qsize = AK::convert_between_host_and_little_endian(IO_QUEUE_SIZE - 1);
         auto flags = irq.has_value() ? QUEUE_IRQ_ENABLED : QUEUE_IRQ_DISABLED;
         flags |= QUEUE_PHY_CONTIGUOUS;
-        // TODO: Eventually move to MSI.
-        // For now using pin based interrupts. Clear the first 16 bits
-        // to use pin-based interrupts.
         sub.create_cq.cq_flags = AK::convert_between_host_and_little_endian(flags & 0xFFFF);
+        // With MSI-X, the queue's interrupt goes through the table entry with the same index as its id.
+        // Pin-based interrupts ignore the interrupt vector.
+        sub.create_cq.irq_vector = AK::convert_between_host_and_little_endian(static_cast<u16>(m_uses_msix ? qid : 0));
         submit_admin_command(sub, true);
     }
     {
@@ -349,7 +405,7 @@ UNMAP_AFTER_INIT ErrorOr<void> NVMeController::create_io_queue(u8 qid, Optional<
     auto queue_doorbell_offset = REG_SQ0TDBL_START + ((2 * qid) * (4 << m_dbl_stride));
     auto doorbell_regs = TRY(Memory::map_typed_writable<DoorbellRegister volatile>(PhysicalAddress(m_bar + queue_doorbell_offset)));
 
-    m_queues.append(TRY(NVMeQueue::try_create(qid, irq, IO_QUEUE_SIZE, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs))));
+    m_queues.append(TRY(NVMeQueue::try_create(*this, qid, irq, m_uses_msix, IO_QUEUE_SIZE, move(cq_dma_region), cq_dma_pages, move(sq_dma_region), sq_dma_pages, move(doorbell_regs))));
     dbgln_if(NVME_DEBUG, "NVMe: Created IO Queue with QID{}", m_queues.size());
     return {};
 }
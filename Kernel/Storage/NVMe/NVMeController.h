@@ -61,6 +61,8 @@ private:
     Tuple<u64, u8> get_ns_features(IdentifyNamespace& identify_data_struct);
     ErrorOr<void> create_admin_queue(Optional<u8> irq);
     ErrorOr<void> create_io_queue(u8 qid, Optional<u8> irq);
+    ErrorOr<u32> negotiate_io_queue_count(u32 desired_count);
+    ErrorOr<u8> setup_msix_interrupt(u16 table_entry, u32 cpu);
     void calculate_doorbell_stride()
     {
         m_dbl_stride = (m_controller_regs->cap >> CAP_DBL_SHIFT) & CAP_DBL_MASK;
@@ -74,6 +76,7 @@ private:
     NonnullLockRefPtrVector<NVMeNameSpace> m_namespaces;
     Memory::TypedMapping<ControllerRegister volatile> m_controller_regs;
     bool m_admin_queue_ready { false };
+    bool m_uses_msix { false };
     size_t m_device_count { 0 };
     AK::Time m_ready_timeout;
     u32 m_bar { 0 };
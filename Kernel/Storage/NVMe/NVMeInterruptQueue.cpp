@@ -11,16 +11,16 @@
 
 namespace Kernel {
 
-UNMAP_AFTER_INIT NVMeInterruptQueue::NVMeInterruptQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
-    : NVMeQueue(move(rw_dma_region), rw_dma_page, qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))
-    , IRQHandler(irq)
+UNMAP_AFTER_INIT NVMeInterruptQueue::NVMeInterruptQueue(PCI::Device& device, NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, u16 qid, u8 irq, bool irq_is_message_signalled, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
+    : NVMeQueue(move(rw_dma_region), move(rw_dma_pages), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))
+    , PCIIRQHandler(device, irq, irq_is_message_signalled ? qid : Optional<u16> {})
 {
     enable_irq();
 }
 
 bool NVMeInterruptQueue::handle_irq(RegisterState const&)
 {
-    SpinlockLocker lock(m_request_lock);
+    SpinlockLocker lock(m_cq_lock);
     return process_cq() ? true : false;
 }
 
@@ -29,34 +29,23 @@ void NVMeInterruptQueue::submit_sqe(NVMeSubmission& sub)
     NVMeQueue::submit_sqe(sub);
 }
 
-void NVMeInterruptQueue::complete_current_request(u16 status)
+void NVMeInterruptQueue::complete_request(u16 command_id, u16 status)
 {
-    VERIFY(m_request_lock.is_locked());
-
-    auto work_item_creation_result = g_io_work->try_queue([this, status]() {
-        SpinlockLocker lock(m_request_lock);
-        auto current_request = m_current_request;
-        m_current_request.clear();
-        if (status) {
-            lock.unlock();
-            current_request->complete(AsyncBlockDeviceRequest::Failure);
-            return;
-        }
-        if (current_request->request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
-            if (auto result = current_request->write_to_buffer(current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), current_request->buffer_size()); result.is_error()) {
-                lock.unlock();
-                current_request->complete(AsyncDeviceRequest::MemoryFault);
-                return;
-            }
-        }
-        lock.unlock();
-        current_request->complete(AsyncDeviceRequest::Success);
+    // With MSI-X, this runs on the processor that owns the queue, which is usually the one that submitted the request.
+    // Copying into a user buffer may fault though, and handling the fault may block, which we can't do in an interrupt
+    // handler. Reads into user buffers therefore complete on the IO work queue, and their command stays in use until then.
+    auto request = request_for_command(command_id);
+    if (status || request->request_type() != AsyncBlockDeviceRequest::Read || request->buffer().is_kernel_buffer()) {
+        finish_request(command_id, status);
         return;
+    }
+
+    auto work_item_creation_result = g_io_work->try_queue([this, command_id, status]() {
+        finish_request(command_id, status);
     });
     if (work_item_creation_result.is_error()) {
-        auto current_request = m_current_request;
-        m_current_request.clear();
-        current_request->complete(AsyncDeviceRequest::OutOfMemory);
+        free_command(command_id);
+        request->complete(AsyncDeviceRequest::Failure);
     }
 }
 }
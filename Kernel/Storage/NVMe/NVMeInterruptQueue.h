@@ -6,19 +6,20 @@
 
 #pragma once
 
+#include <Kernel/Interrupts/PCIIRQHandler.h>
 #include <Kernel/Storage/NVMe/NVMeQueue.h>
 
 namespace Kernel {
 
 class NVMeInterruptQueue : public NVMeQueue
-    , public IRQHandler {
+    , public PCIIRQHandler {
 public:
-    NVMeInterruptQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u8 irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
+    NVMeInterruptQueue(PCI::Device&, NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, u16 qid, u8 irq, bool irq_is_message_signalled, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs);
     void submit_sqe(NVMeSubmission& submission) override;
     virtual ~NVMeInterruptQueue() override {};
 
 private:
-    virtual void complete_current_request(u16 status) override;
+    virtual void complete_request(u16 command_id, u16 status) override;
     bool handle_irq(RegisterState const&) override;
 };
 }
@@ -25,18 +25,24 @@ UNMAP_AFTER_INIT NVMeNameSpace::NVMeNameSpace(LUNAddress logical_unit_number_add
 {
 }
 
+ErrorOr<void> NVMeNameSpace::queue_request(NonnullLockRefPtr<AsyncDeviceRequest> request)
+{
+    // Every processor submits to a queue of its own that can have several commands in flight, and there is
+    // no seek penalty to avoid, so we skip the request queue of the device and start every request right away.
+    request->do_start();
+    return {};
+}
+
 void NVMeNameSpace::start_request(AsyncBlockDeviceRequest& request)
 {
-    auto index = Processor::current_id();
+    // Every processor has a queue of its own, unless the controller ran out of them, in which case they have to share.
+    // NOTE: Being moved to another processor right after picking the queue is harmless, the queue has its own locking.
+    auto index = Processor::current_id() % m_queues.size();
     auto& queue = m_queues.at(index);
     // TODO: For now we support only IO transfers of size PAGE_SIZE (Going along with the current constraint in the block layer)
     // Eventually remove this constraint by using the PRP2 field in the submission struct and remove block layer constraint for NVMe driver.
     VERIFY(request.block_count() <= (PAGE_SIZE / block_size()));
 
-    if (request.request_type() == AsyncBlockDeviceRequest::Read) {
-        queue.read(request, m_nsid, request.block_index(), request.block_count());
-    } else {
-        queue.write(request, m_nsid, request.block_index(), request.block_count());
-    }
+    queue.submit_request(request, m_nsid);
 }
 }
@@ -29,6 +29,11 @@ public:
     CommandSet command_set() const override { return CommandSet::NVMe; };
     void start_request(AsyncBlockDeviceRequest& request) override;
 
+protected:
+    // ^Device
+    virtual ErrorOr<void> queue_request(NonnullLockRefPtr<AsyncDeviceRequest>) override;
+    virtual void start_next_queued_request(AsyncDeviceRequest const&) override { }
+
 private:
     NVMeNameSpace(LUNAddress, u32 hardware_relative_controller_id, NonnullLockRefPtrVector<NVMeQueue> queues, size_t storage_size, size_t lba_size, u16 nsid);
 
@@ -10,8 +10,8 @@
 #include <Kernel/Storage/NVMe/NVMePollQueue.h>
 
 namespace Kernel {
-UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
-    : NVMeQueue(move(rw_dma_region), rw_dma_page, qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))
+UNMAP_AFTER_INIT NVMePollQueue::NVMePollQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
+    : NVMeQueue(move(rw_dma_region), move(rw_dma_pages), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))
 {
 }
 
@@ -24,21 +24,8 @@ void NVMePollQueue::submit_sqe(NVMeSubmission& sub)
     }
 }
 
-void NVMePollQueue::complete_current_request(u16 status)
+void NVMePollQueue::complete_request(u16 command_id, u16 status)
 {
-    auto current_request = m_current_request;
-    m_current_request.clear();
-    if (status) {
-        current_request->complete(AsyncBlockDeviceRequest::Failure);
-        return;
-    }
-    if (current_request->request_type() == AsyncBlockDeviceRequest::RequestType::Read) {
-        if (auto result = current_request->write_to_buffer(current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), current_request->buffer_size()); result.is_error()) {
-            current_request->complete(AsyncDeviceRequest::MemoryFault);
-            return;
-        }
-    }
-    current_request->complete(AsyncDeviceRequest::Success);
-    return;
+    finish_request(command_id, status);
 }
 }
@@ -12,23 +12,23 @@
 #include <Kernel/Storage/NVMe/NVMeQueue.h>
 
 namespace Kernel {
-ErrorOr<NonnullLockRefPtr<NVMeQueue>> NVMeQueue::try_create(u16 qid, Optional<u8> irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
+ErrorOr<NonnullLockRefPtr<NVMeQueue>> NVMeQueue::try_create(PCI::Device& device, u16 qid, Optional<u8> irq, bool irq_is_message_signalled, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
 {
     // Note: Allocate DMA region for RW operation. For now the requests don't exceed more than 4096 bytes (Storage device takes care of it)
-    RefPtr<Memory::PhysicalPage> rw_dma_page;
-    auto rw_dma_region = TRY(MM.allocate_dma_buffer_page("NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_page));
+    // A polled queue waits for each command right after submitting it, so it only ever has a single one in flight.
+    size_t command_count = irq.has_value() ? max_commands_in_flight : 1;
+    NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages;
+    auto rw_dma_region = TRY(MM.allocate_dma_buffer_pages(command_count * PAGE_SIZE, "NVMe Queue Read/Write DMA"sv, Memory::Region::Access::ReadWrite, rw_dma_pages));
     if (!irq.has_value()) {
-        auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), *rw_dma_page, qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+        auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMePollQueue(move(rw_dma_region), move(rw_dma_pages), qid, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
         return queue;
     }
-    auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMeInterruptQueue(move(rw_dma_region), *rw_dma_page, qid, irq.value(), q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
+    auto queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) NVMeInterruptQueue(device, move(rw_dma_region), move(rw_dma_pages), qid, irq.value(), irq_is_message_signalled, q_depth, move(cq_dma_region), cq_dma_page, move(sq_dma_region), sq_dma_page, move(db_regs))));
     return queue;
 }
 
-UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
-    : m_current_request(nullptr)
-    , m_rw_dma_region(move(rw_dma_region))
-    , m_qid(qid)
+UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<volatile DoorbellRegister> db_regs)
+    : m_qid(qid)
     , m_admin_queue(qid == 0)
     , m_qdepth(q_depth)
     , m_cq_dma_region(move(cq_dma_region))
@@ -36,9 +36,11 @@ UNMAP_AFTER_INIT NVMeQueue::NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_regio
     , m_sq_dma_region(move(sq_dma_region))
     , m_sq_dma_page(sq_dma_page)
     , m_db_regs(move(db_regs))
-    , m_rw_dma_page(rw_dma_page)
+    , m_rw_dma_region(move(rw_dma_region))
+    , m_rw_dma_pages(move(rw_dma_pages))
 
 {
+    VERIFY(m_rw_dma_pages.size() <= max_commands_in_flight);
     m_sqe_array = { reinterpret_cast<NVMeSubmission*>(m_sq_dma_region->vaddr().as_ptr()), m_qdepth };
     m_cqe_array = { reinterpret_cast<NVMeCompletion*>(m_cq_dma_region->vaddr().as_ptr()), m_qdepth };
 }
@@ -73,13 +75,9 @@ u32 NVMeQueue::process_cq()
         // TODO: We don't use AsyncBlockDevice requests for admin queue as it is only applicable for a block device (NVMe namespace)
         //  But admin commands precedes namespace creation. Unify requests to avoid special conditions
         if (m_admin_queue == false) {
-            // As the block layer calls are now sync (as we wait on each requests),
-            // everything is operated on a single request similar to BMIDE driver.
-            // TODO: Remove this constraint eventually.
-            VERIFY(cmdid == m_prev_sq_tail);
-            if (m_current_request) {
-                complete_current_request(status);
-            }
+            // IO commands are identified by the index of the command they were submitted with.
+            VERIFY(cmdid < m_rw_dma_pages.size());
+            complete_request(cmdid, status);
         }
         update_cqe_head();
     }
@@ -92,9 +90,9 @@ u32 NVMeQueue::process_cq()
 void NVMeQueue::submit_sqe(NVMeSubmission& sub)
 {
     SpinlockLocker lock(m_sq_lock);
-    // For now let's use sq tail as a unique command id.
-    sub.cmdid = m_sq_tail;
-    m_prev_sq_tail = m_sq_tail;
+    // For now let's use sq tail as a unique command id for admin commands.
+    if (m_admin_queue)
+        sub.cmdid = m_sq_tail;
 
     memcpy(&m_sqe_array[m_sq_tail], &sub, sizeof(NVMeSubmission));
     {
@@ -110,15 +108,15 @@ void NVMeQueue::submit_sqe(NVMeSubmission& sub)
     update_sq_doorbell();
 }
 
-u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
+u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub, u32* command_specific_result)
 {
     // For now let's use sq tail as a unique command id.
     u16 cqe_cid;
     u16 cid = m_sq_tail;
+    int index;
 
     submit_sqe(sub);
     do {
-        int index;
         {
             SpinlockLocker lock(m_cq_lock);
             index = m_cq_head - 1;
@@ -129,47 +127,83 @@ u16 NVMeQueue::submit_sync_sqe(NVMeSubmission& sub)
         microseconds_delay(1);
     } while (cid != cqe_cid);
 
-    auto status = CQ_STATUS_FIELD(m_cqe_array[m_cq_head].status);
+    if (command_specific_result)
+        *command_specific_result = m_cqe_array[index].cmd_spec;
+    auto status = CQ_STATUS_FIELD(m_cqe_array[index].status);
     return status;
 }
 
-void NVMeQueue::read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+Optional<u16> NVMeQueue::try_allocate_command(AsyncBlockDeviceRequest& request)
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
+    SpinlockLocker lock(m_request_lock);
+    for (u16 command_id = 0; command_id < m_rw_dma_pages.size(); ++command_id) {
+        if (!m_command_requests[command_id]) {
+            m_command_requests[command_id] = request;
+            return command_id;
+        }
+    }
+    return {};
+}
 
-    sub.op = OP_NVME_READ;
-    sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
-    // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+NonnullLockRefPtr<AsyncBlockDeviceRequest> NVMeQueue::request_for_command(u16 command_id)
+{
+    SpinlockLocker lock(m_request_lock);
+    return *m_command_requests[command_id];
+}
 
-    full_memory_barrier();
-    submit_sqe(sub);
+void NVMeQueue::free_command(u16 command_id)
+{
+    {
+        SpinlockLocker lock(m_request_lock);
+        VERIFY(m_command_requests[command_id]);
+        m_command_requests[command_id].clear();
+    }
+    m_free_command_wait_queue.wake_one();
 }
 
-void NVMeQueue::write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count)
+void NVMeQueue::submit_request(AsyncBlockDeviceRequest& request, u16 nsid)
 {
-    NVMeSubmission sub {};
-    SpinlockLocker m_lock(m_request_lock);
-    m_current_request = request;
+    auto command_id = try_allocate_command(request);
+    while (!command_id.has_value()) {
+        // Note: A command freed in between is not lost, the wait queue remembers the wake-up.
+        m_free_command_wait_queue.wait_forever("NVMeQueue"sv);
+        command_id = try_allocate_command(request);
+    }
 
-    if (auto result = m_current_request->read_from_buffer(m_current_request->buffer(), m_rw_dma_region->vaddr().as_ptr(), m_current_request->buffer_size()); result.is_error()) {
-        complete_current_request(AsyncDeviceRequest::MemoryFault);
-        return;
+    if (request.request_type() == AsyncBlockDeviceRequest::Write) {
+        if (auto result = request.read_from_buffer(request.buffer(), dma_buffer_for_command(command_id.value()), request.buffer_size()); result.is_error()) {
+            free_command(command_id.value());
+            request.complete(AsyncDeviceRequest::MemoryFault);
+            return;
+        }
     }
-    sub.op = OP_NVME_WRITE;
+
+    NVMeSubmission sub {};
+    sub.op = request.request_type() == AsyncBlockDeviceRequest::Read ? OP_NVME_READ : OP_NVME_WRITE;
+    sub.cmdid = command_id.value();
     sub.rw.nsid = nsid;
-    sub.rw.slba = AK::convert_between_host_and_little_endian(index);
+    sub.rw.slba = AK::convert_between_host_and_little_endian(request.block_index());
     // No. of lbas is 0 based
-    sub.rw.length = AK::convert_between_host_and_little_endian((count - 1) & 0xFFFF);
-    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_page->paddr().as_ptr()));
+    sub.rw.length = AK::convert_between_host_and_little_endian((request.block_count() - 1) & 0xFFFF);
+    sub.rw.data_ptr.prp1 = reinterpret_cast<u64>(AK::convert_between_host_and_little_endian(m_rw_dma_pages[command_id.value()].paddr().as_ptr()));
 
     full_memory_barrier();
     submit_sqe(sub);
 }
 
+void NVMeQueue::finish_request(u16 command_id, u16 status)
+{
+    auto request = request_for_command(command_id);
+    auto result = AsyncDeviceRequest::Success;
+    if (status) {
+        result = AsyncDeviceRequest::Failure;
+    } else if (request->request_type() == AsyncBlockDeviceRequest::Read) {
+        if (auto copy_result = request->write_to_buffer(request->buffer(), dma_buffer_for_command(command_id), request->buffer_size()); copy_result.is_error())
+            result = AsyncDeviceRequest::MemoryFault;
+    }
+    free_command(command_id);
+    request->complete(result);
+}
+
 UNMAP_AFTER_INIT NVMeQueue::~NVMeQueue() = default;
 }
@@ -6,12 +6,12 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/AtomicRefCounted.h>
 #include <AK/NonnullRefPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <AK/Types.h>
 #include <Kernel/Bus/PCI/Device.h>
-#include <Kernel/Interrupts/IRQHandler.h>
 #include <Kernel/Library/LockRefPtr.h>
 #include <Kernel/Library/NonnullLockRefPtr.h>
 #include <Kernel/Library/NonnullLockRefPtrVector.h>
@@ -19,6 +19,7 @@
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/TypedMapping.h>
 #include <Kernel/Storage/NVMe/NVMeDefinitions.h>
+#include <Kernel/WaitQueue.h>
 
 namespace Kernel {
 
@@ -30,11 +31,17 @@ struct DoorbellRegister {
 class AsyncBlockDeviceRequest;
 class NVMeQueue : public AtomicRefCounted<NVMeQueue> {
 public:
-    static ErrorOr<NonnullLockRefPtr<NVMeQueue>> try_create(u16 qid, Optional<u8> irq, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs);
+    // The number of IO commands an interrupt driven queue can have in flight at once. Every
+    // command has a DMA buffer of its own, and its index doubles as the command identifier.
+    static constexpr u16 max_commands_in_flight = 16;
+    static_assert(max_commands_in_flight < IO_QUEUE_SIZE);
+
+    // With MSI-X, the interrupt of each queue is signalled through the MSI-X table entry with the same index as the queue id.
+    static ErrorOr<NonnullLockRefPtr<NVMeQueue>> try_create(PCI::Device&, u16 qid, Optional<u8> irq, bool irq_is_message_signalled, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs);
     bool is_admin_queue() { return m_admin_queue; };
-    u16 submit_sync_sqe(NVMeSubmission&);
-    void read(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
-    void write(AsyncBlockDeviceRequest& request, u16 nsid, u64 index, u32 count);
+    u16 submit_sync_sqe(NVMeSubmission&, u32* command_specific_result = nullptr);
+    // Blocks until one of the commands of the queue is free, so this must be called from a thread.
+    void submit_request(AsyncBlockDeviceRequest&, u16 nsid);
     virtual void submit_sqe(NVMeSubmission&);
     virtual ~NVMeQueue();
 
@@ -44,12 +51,19 @@ protected:
     {
         m_db_regs->sq_tail = m_sq_tail;
     }
-    NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, Memory::PhysicalPage const& rw_dma_page, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs);
+    NVMeQueue(NonnullOwnPtr<Memory::Region> rw_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> rw_dma_pages, u16 qid, u32 q_depth, OwnPtr<Memory::Region> cq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> cq_dma_page, OwnPtr<Memory::Region> sq_dma_region, NonnullRefPtrVector<Memory::PhysicalPage> sq_dma_page, Memory::TypedMapping<DoorbellRegister volatile> db_regs);
+
+    NonnullLockRefPtr<AsyncBlockDeviceRequest> request_for_command(u16 command_id);
+    // Copies the data of a read out of the command's DMA buffer, frees the command and completes its request.
+    void finish_request(u16 command_id, u16 status);
+    void free_command(u16 command_id);
 
 private:
     bool cqe_available();
     void update_cqe_head();
-    virtual void complete_current_request(u16 status) = 0;
+    virtual void complete_request(u16 command_id, u16 status) = 0;
+    Optional<u16> try_allocate_command(AsyncBlockDeviceRequest&);
+    u8* dma_buffer_for_command(u16 command_id) { return m_rw_dma_region->vaddr().offset(command_id * PAGE_SIZE).as_ptr(); }
     void update_cq_doorbell()
     {
         m_db_regs->cq_head = m_cq_head;
@@ -57,15 +71,11 @@ private:
 
 protected:
     Spinlock m_cq_lock { LockRank::Interrupts };
-    LockRefPtr<AsyncBlockDeviceRequest> m_current_request;
-    NonnullOwnPtr<Memory::Region> m_rw_dma_region;
-    Spinlock m_request_lock { LockRank::None };
 
 private:
     u16 m_qid {};
     u8 m_cq_valid_phase { 1 };
     u16 m_sq_tail {};
-    u16 m_prev_sq_tail {};
     u16 m_cq_head {};
     bool m_admin_queue { false };
     u32 m_qdepth {};
@@ -77,6 +87,11 @@ private:
     NonnullRefPtrVector<Memory::PhysicalPage> m_sq_dma_page;
     Span<NVMeCompletion> m_cqe_array;
     Memory::TypedMapping<DoorbellRegister volatile> m_db_regs;
-    NonnullRefPtr<Memory::PhysicalPage> m_rw_dma_page;
+
+    Spinlock m_request_lock { LockRank::None };
+    Array<LockRefPtr<AsyncBlockDeviceRequest>, max_commands_in_flight> m_command_requests;
+    WaitQueue m_free_command_wait_queue;
+    NonnullOwnPtr<Memory::Region> m_rw_dma_region;
+    NonnullRefPtrVector<Memory::PhysicalPage> m_rw_dma_pages;
 };
 }
@@ -25,6 +25,7 @@ StorageDevice::StorageDevice(LUNAddress logical_unit_number_address, u32 hardwar
     , m_hardware_relative_controller_id(hardware_relative_controller_id)
     , m_max_addressable_block(max_addressable_block)
     , m_blocks_per_page(PAGE_SIZE / block_size())
+    , m_request_queue(*this)
 {
 }
 
@@ -34,6 +35,7 @@ StorageDevice::StorageDevice(Badge<RamdiskDevice>, LUNAddress logical_unit_numbe
     , m_hardware_relative_controller_id(hardware_relative_controller_id)
     , m_max_addressable_block(max_addressable_block)
     , m_blocks_per_page(PAGE_SIZE / block_size())
+    , m_request_queue(*this)
 {
 }
 
@@ -63,6 +65,18 @@ StringView StorageDevice::class_name() const
     return "StorageDevice"sv;
 }
 
+ErrorOr<void> StorageDevice::queue_request(NonnullLockRefPtr<AsyncDeviceRequest> request)
+{
+    // Note: Block devices are only ever asked to carry out block device requests.
+    m_request_queue.queue(static_ptr_cast<AsyncBlockDeviceRequest>(request));
+    return {};
+}
+
+void StorageDevice::start_next_queued_request(AsyncDeviceRequest const& completed_request)
+{
+    m_request_queue.request_finished(static_cast<AsyncBlockDeviceRequest const&>(completed_request));
+}
+
 StringView StorageDevice::command_set_to_string_view() const
 {
     switch (command_set()) {
@@ -85,10 +99,8 @@ ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKern
     size_t whole_blocks = len >> block_size_log();
     size_t remaining = len - (whole_blocks << block_size_log());
 
-    // PATAChannel will chuck a wobbly if we try to read more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= m_blocks_per_page) {
-        whole_blocks = m_blocks_per_page;
+    if (whole_blocks >= max_blocks_per_transfer()) {
+        whole_blocks = max_blocks_per_transfer();
         remaining = 0;
     }
 
@@ -98,19 +110,9 @@ ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKern
     dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::read() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
 
     if (whole_blocks > 0) {
-        auto read_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf, whole_blocks * block_size()));
-        auto result = read_request->wait();
-        if (result.wait_result().was_interrupted())
-            return EINTR;
-        switch (result.request_result()) {
-        case AsyncDeviceRequest::Failure:
-        case AsyncDeviceRequest::Cancelled:
-            return EIO;
-        case AsyncDeviceRequest::MemoryFault:
-            return EFAULT;
-        default:
-            break;
-        }
+        auto nread = TRY(transfer_whole_blocks(AsyncBlockDeviceRequest::Read, index, whole_blocks, outbuf));
+        if (nread < whole_blocks * block_size())
+            return nread;
     }
 
     off_t pos = whole_blocks * block_size();
@@ -119,10 +121,7 @@ ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKern
         auto data = TRY(ByteBuffer::create_uninitialized(block_size()));
         auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(data.data());
         auto read_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index + whole_blocks, 1, data_buffer, block_size()));
-        auto result = read_request->wait();
-        if (result.wait_result().was_interrupted())
-            return EINTR;
-        switch (result.request_result()) {
+        switch (read_request->wait_until_completed()) {
         case AsyncDeviceRequest::Failure:
             return pos;
         case AsyncDeviceRequest::Cancelled:
@@ -139,6 +138,76 @@ ErrorOr<size_t> StorageDevice::read(OpenFileDescription&, u64 offset, UserOrKern
     return pos + remaining;
 }
 
+ErrorOr<size_t> StorageDevice::transfer_whole_blocks(AsyncBlockDeviceRequest::RequestType request_type, u64 index, size_t block_count, UserOrKernelBuffer const& buffer)
+{
+    auto transfer = TRY(start_whole_block_transfer(request_type, index, block_count, buffer));
+    return finish_transfer(transfer);
+}
+
+auto StorageDevice::start_whole_block_transfer(AsyncBlockDeviceRequest::RequestType request_type, u64 index, size_t block_count, UserOrKernelBuffer const& buffer) -> ErrorOr<PendingTransfer>
+{
+    VERIFY(block_count <= max_blocks_per_transfer());
+
+    // PATAChannel will chuck a wobbly if we try to transfer more than PAGE_SIZE at a time,
+    // because it uses a single page for its DMA buffer. So we make page-sized requests,
+    // but queue all of them at once and let the request queue merge them into as few
+    // commands as the driver can handle.
+    PendingTransfer requests;
+    BlockRequestQueue::Plug plug(m_request_queue);
+    for (size_t block = 0; block < block_count; block += m_blocks_per_page) {
+        auto request_block_count = min(m_blocks_per_page, block_count - block);
+        auto request_or_error = try_make_request<AsyncBlockDeviceRequest>(request_type, index + block, request_block_count, buffer.offset(block * block_size()), request_block_count * block_size());
+        if (request_or_error.is_error()) {
+            // Note: We can't bail out while earlier requests are still using the buffer.
+            if (requests.is_empty())
+                return request_or_error.release_error();
+            break;
+        }
+        requests.unchecked_append(request_or_error.release_value());
+    }
+    return requests;
+}
+
+auto StorageDevice::start_transfer(AsyncBlockDeviceRequest::RequestType request_type, u64 offset, UserOrKernelBuffer const& buffer, size_t length) -> ErrorOr<PendingTransfer>
+{
+    if ((offset & (block_size() - 1)) != 0 || (length & (block_size() - 1)) != 0 || length == 0)
+        return EINVAL;
+    u64 index = offset >> block_size_log();
+    if (index >= max_addressable_block())
+        return EINVAL;
+    size_t block_count = min(length >> block_size_log(), max_blocks_per_transfer());
+    block_count = min<u64>(block_count, max_addressable_block() - index);
+    return start_whole_block_transfer(request_type, index, block_count, buffer);
+}
+
+ErrorOr<size_t> StorageDevice::finish_transfer(PendingTransfer& requests)
+{
+    // NOTE: Queued requests can't be taken back, and all of them point into the caller's buffer.
+    //       So even after a failure, we have to wait for every last one of them before returning.
+    size_t transferred_blocks = 0;
+    Optional<Error> error;
+    for (auto& request : requests) {
+        auto result = request->wait_until_completed();
+        if (error.has_value())
+            continue;
+        switch (result) {
+        case AsyncDeviceRequest::Failure:
+        case AsyncDeviceRequest::Cancelled:
+            error = Error::from_errno(EIO);
+            break;
+        case AsyncDeviceRequest::MemoryFault:
+            error = Error::from_errno(EFAULT);
+            break;
+        default:
+            transferred_blocks += request->block_count();
+            break;
+        }
+    }
+    if (error.has_value() && transferred_blocks == 0)
+        return error.release_value();
+    return transferred_blocks * block_size();
+}
+
 bool StorageDevice::can_read(OpenFileDescription const&, u64 offset) const
 {
     return offset < (max_addressable_block() * block_size());
@@ -151,10 +220,8 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, UserOrKer
     size_t whole_blocks = len >> block_size_log();
     size_t remaining = len - (whole_blocks << block_size_log());
 
-    // PATAChannel will chuck a wobbly if we try to write more than PAGE_SIZE
-    // at a time, because it uses a single page for its DMA buffer.
-    if (whole_blocks >= m_blocks_per_page) {
-        whole_blocks = m_blocks_per_page;
+    if (whole_blocks >= max_blocks_per_transfer()) {
+        whole_blocks = max_blocks_per_transfer();
         remaining = 0;
     }
 
@@ -170,19 +237,9 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, UserOrKer
     dbgln_if(STORAGE_DEVICE_DEBUG, "StorageDevice::write() index={}, whole_blocks={}, remaining={}", index, whole_blocks, remaining);
 
     if (whole_blocks > 0) {
-        auto write_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf, whole_blocks * block_size()));
-        auto result = write_request->wait();
-        if (result.wait_result().was_interrupted())
-            return EINTR;
-        switch (result.request_result()) {
-        case AsyncDeviceRequest::Failure:
-        case AsyncDeviceRequest::Cancelled:
-            return EIO;
-        case AsyncDeviceRequest::MemoryFault:
-            return EFAULT;
-        default:
-            break;
-        }
+        auto nwritten = TRY(transfer_whole_blocks(AsyncBlockDeviceRequest::Write, index, whole_blocks, inbuf));
+        if (nwritten < whole_blocks * block_size())
+            return nwritten;
     }
 
     off_t pos = whole_blocks * block_size();
@@ -194,10 +251,7 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, UserOrKer
         auto data_buffer = UserOrKernelBuffer::for_kernel_buffer(partial_write_block->data());
         {
             auto read_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index + whole_blocks, 1, data_buffer, block_size()));
-            auto result = read_request->wait();
-            if (result.wait_result().was_interrupted())
-                return EINTR;
-            switch (result.request_result()) {
+            switch (read_request->wait_until_completed()) {
             case AsyncDeviceRequest::Failure:
                 return pos;
             case AsyncDeviceRequest::Cancelled:
@@ -214,10 +268,7 @@ ErrorOr<size_t> StorageDevice::write(OpenFileDescription&, u64 offset, UserOrKer
 
         {
             auto write_request = TRY(try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write, index + whole_blocks, 1, data_buffer, block_size()));
-            auto result = write_request->wait();
-            if (result.wait_result().was_interrupted())
-                return EINTR;
-            switch (result.request_result()) {
+            switch (write_request->wait_until_completed()) {
             case AsyncDeviceRequest::Failure:
                 return pos;
             case AsyncDeviceRequest::Cancelled:
@@ -10,6 +10,7 @@
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Interrupts/IRQHandler.h>
 #include <Kernel/Locking/Mutex.h>
+#include <Kernel/Storage/BlockRequestQueue.h>
 #include <Kernel/Storage/DiskPartition.h>
 #include <Kernel/Storage/StorageController.h>
 
@@ -74,6 +75,30 @@ public:
 
     StringView command_set_to_string_view() const;
 
+    // The number of blocks the driver can transfer with a single command, if it is able
+    // to carry out requests that were merged together (see AsyncBlockDeviceRequest), or 0.
+    virtual u32 max_blocks_per_merged_request() const { return 0; }
+
+    // The number of requests the driver can carry out at the same time. The request
+    // queue holds back any further requests until one of them completes.
+    virtual size_t max_requests_in_flight() const { return 1; }
+
+    BlockRequestQueue& request_queue() { return m_request_queue; }
+    BlockRequestQueue const& request_queue() const { return m_request_queue; }
+
+    static constexpr size_t max_requests_per_transfer = 64;
+    using PendingTransfer = Vector<NonnullLockRefPtr<AsyncBlockDeviceRequest>, max_requests_per_transfer>;
+
+    // Starts a transfer of whole blocks without waiting for it, so that a caller with several
+    // transfers to do can have all of them in flight at once. Like read() and write(), this may
+    // transfer less than asked for; finish_transfer() tells how much it was.
+    ErrorOr<PendingTransfer> start_transfer(AsyncBlockDeviceRequest::RequestType, u64 offset, UserOrKernelBuffer const&, size_t length);
+    // Waits for every request of the transfer to complete, even when the thread is interrupted,
+    // since the device may be accessing the buffer until then.
+    ErrorOr<size_t> finish_transfer(PendingTransfer&);
+
+    virtual bool is_storage_device() const final { return true; }
+
     // ^File
     virtual ErrorOr<void> ioctl(OpenFileDescription&, unsigned request, Userspace<void*> arg) final;
 
@@ -87,10 +112,18 @@ protected:
     // ^DiskDevice
     virtual StringView class_name() const override;
 
+    // ^Device
+    virtual ErrorOr<void> queue_request(NonnullLockRefPtr<AsyncDeviceRequest>) override;
+    virtual void start_next_queued_request(AsyncDeviceRequest const& completed_request) override;
+
 private:
     virtual void after_inserting() override;
     virtual void will_be_destroyed() override;
 
+    size_t max_blocks_per_transfer() const { return m_blocks_per_page * max_requests_per_transfer; }
+    ErrorOr<size_t> transfer_whole_blocks(AsyncBlockDeviceRequest::RequestType, u64 index, size_t block_count, UserOrKernelBuffer const&);
+    ErrorOr<PendingTransfer> start_whole_block_transfer(AsyncBlockDeviceRequest::RequestType, u64 index, size_t block_count, UserOrKernelBuffer const&);
+
     mutable IntrusiveListNode<StorageDevice, LockRefPtr<StorageDevice>> m_list_node;
     NonnullLockRefPtrVector<DiskPartition> m_partitions;
 
@@ -105,6 +138,8 @@ private:
 
     u64 m_max_addressable_block { 0 };
     size_t m_blocks_per_page { 0 };
+
+    BlockRequestQueue m_request_queue;
 };
 
 }
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/ScopeGuard.h>
+#include <Kernel/FileSystem/EventPoll.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+// The most events a single epoll_wait() hands out; anything beyond that is left for the next call.
+static constexpr size_t max_events_per_wait = 256;
+
+ErrorOr<FlatPtr> Process::sys$epoll_create(int flags)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    if ((flags & EPOLL_CLOEXEC) != flags)
+        return EINVAL;
+
+    u32 fd_flags = (flags & EPOLL_CLOEXEC) ? FD_CLOEXEC : 0;
+    auto event_poll = TRY(EventPoll::try_create());
+    auto description = TRY(OpenFileDescription::try_create(move(event_poll)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        auto fd_allocation = TRY(fds.allocate());
+        fds[fd_allocation.fd].set(move(description), fd_flags);
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_ctl(Userspace<Syscall::SC_epoll_ctl_params const*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto params = TRY(copy_typed_from_user(user_params));
+    auto epoll_description = TRY(open_file_description(params.epoll_fd));
+    if (!epoll_description->is_event_poll())
+        return EINVAL;
+    auto& event_poll = *epoll_description->event_poll();
+    auto description = TRY(open_file_description(params.fd));
+
+    switch (params.op) {
+    case EPOLL_CTL_ADD: {
+        epoll_event event {};
+        TRY(copy_from_user(&event, params.event));
+        TRY(event_poll.add_watch(params.fd, *description, event));
+        return 0;
+    }
+    case EPOLL_CTL_MOD: {
+        epoll_event event {};
+        TRY(copy_from_user(&event, params.event));
+        TRY(event_poll.modify_watch(params.fd, *description, event));
+        return 0;
+    }
+    case EPOLL_CTL_DEL:
+        TRY(event_poll.remove_watch(params.fd, *description));
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<FlatPtr> Process::sys$epoll_wait(Userspace<Syscall::SC_epoll_wait_params const*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto params = TRY(copy_typed_from_user(user_params));
+    if (params.max_events <= 0)
+        return EINVAL;
+
+    auto description = TRY(open_file_description(params.epoll_fd));
+    if (!description->is_event_poll())
+        return EINVAL;
+    auto& event_poll = *description->event_poll();
+
+    Thread::BlockTimeout timeout;
+    if (params.timeout_ms > 0) {
+        auto timeout_time = Time::from_milliseconds(params.timeout_ms);
+        timeout = Thread::BlockTimeout(false, &timeout_time);
+    }
+
+    sigset_t sigmask = {};
+    if (params.sigmask)
+        TRY(copy_from_user(&sigmask, params.sigmask));
+
+    Vector<epoll_event> events;
+    TRY(events.try_resize(min(static_cast<size_t>(params.max_events), max_events_per_wait)));
+
+    auto* current_thread = Thread::current();
+
+    u32 previous_signal_mask = 0;
+    if (params.sigmask)
+        previous_signal_mask = current_thread->update_signal_mask(sigmask);
+    ScopeGuard rollback_signal_mask([&]() {
+        if (params.sigmask)
+            current_thread->update_signal_mask(previous_signal_mask);
+    });
+
+    for (;;) {
+        auto event_count = event_poll.collect_ready_events(events.span());
+        if (event_count > 0) {
+            TRY(copy_n_to_user(params.events, events.data(), event_count));
+            return event_count;
+        }
+        if (params.timeout_ms == 0)
+            return 0;
+
+        // Note: Waking up doesn't mean that any of the watches is ready; it only means that one
+        //       of the watched files changed its state, so we have to go around and check.
+        Thread::FileBlocker::BlockFlags unblocked_flags = Thread::FileBlocker::BlockFlags::None;
+        auto block_result = current_thread->block<Thread::ReadBlocker>(timeout, *description, unblocked_flags);
+        if (block_result.was_interrupted())
+            return EINTR;
+        if (block_result == Thread::BlockResult::InterruptedByTimeout)
+            return 0;
+    }
+}
+
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/InodeFile.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+// https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_fadvise.html
+ErrorOr<FlatPtr> Process::sys$posix_fadvise(int fd, Userspace<off_t const*> userspace_offset, Userspace<off_t const*> userspace_length, int advice)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    // [EINVAL] The value of advice is invalid, or the value of len is less than zero.
+    auto offset = TRY(copy_typed_from_user(userspace_offset));
+    if (offset < 0)
+        return EINVAL;
+    auto length = TRY(copy_typed_from_user(userspace_length));
+    if (length < 0)
+        return EINVAL;
+
+    switch (advice) {
+    case POSIX_FADV_NORMAL:
+    case POSIX_FADV_SEQUENTIAL:
+    case POSIX_FADV_RANDOM:
+    case POSIX_FADV_WILLNEED:
+    case POSIX_FADV_DONTNEED:
+    case POSIX_FADV_NOREUSE:
+        break;
+    default:
+        return EINVAL;
+    }
+
+    // [EBADF] The fd argument is not a valid file descriptor.
+    auto description = TRY(open_file_description(fd));
+
+    // [ESPIPE] The fd argument is associated with a pipe or FIFO.
+    if (description->is_fifo())
+        return ESPIPE;
+
+    // "The posix_fadvise() function shall have no effect on the semantics of other operations on the specified data,
+    // although it may affect the performance of other operations."
+    // Only regular files have anything to gain from these hints, so we silently accept them for everything else.
+    if (!description->file().is_regular_file())
+        return 0;
+
+    switch (advice) {
+    case POSIX_FADV_NORMAL:
+        description->set_readahead_mode(ReadaheadState::Mode::Normal);
+        break;
+    case POSIX_FADV_SEQUENTIAL:
+        description->set_readahead_mode(ReadaheadState::Mode::Sequential);
+        break;
+    case POSIX_FADV_RANDOM:
+        description->set_readahead_mode(ReadaheadState::Mode::Random);
+        break;
+    case POSIX_FADV_WILLNEED: {
+        VERIFY(description->file().is_inode());
+        auto& inode = static_cast<InodeFile&>(description->file()).inode();
+        // A length of zero means "until the end of the file".
+        u64 size = inode.size();
+        if (static_cast<u64>(offset) >= size)
+            break;
+        u64 remaining = size - offset;
+        inode.prefetch(offset, length == 0 ? remaining : min(static_cast<u64>(length), remaining));
+        break;
+    }
+    default:
+        // FIXME: Drop clean cached blocks for POSIX_FADV_DONTNEED.
+        break;
+    }
+
+    return 0;
+}
+
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/IORing.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+ErrorOr<FlatPtr> Process::sys$io_ring_setup(Userspace<io_ring_params*> user_params)
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto params = TRY(copy_typed_from_user(user_params));
+    u32 fd_flags = (params.flags & IO_RING_SETUP_CLOEXEC) ? FD_CLOEXEC : 0;
+    auto ring = TRY(IORing::try_create(*this, params));
+    auto description = TRY(OpenFileDescription::try_create(move(ring)));
+    description->set_readable(true);
+
+    return m_fds.with_exclusive([&](auto& fds) -> ErrorOr<FlatPtr> {
+        auto fd_allocation = TRY(fds.allocate());
+        TRY(copy_to_user(user_params, &params));
+        fds[fd_allocation.fd].set(move(description), fd_flags);
+        return fd_allocation.fd;
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$io_ring_enter(int fd, u32 to_submit, u32 min_complete, u32 flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+
+    if ((flags & ~(IO_RING_ENTER_GETEVENTS | IO_RING_ENTER_SQ_WAKEUP)) != 0)
+        return EINVAL;
+
+    auto description = TRY(open_file_description(fd));
+    if (!description->is_io_ring())
+        return EINVAL;
+    auto& ring = *description->io_ring();
+    // The entries point into the memory of the process that set up the ring, so nobody else gets to use it.
+    if (!ring.belongs_to(*this))
+        return EPERM;
+
+    size_t submitted = 0;
+    if (ring.has_submission_poller()) {
+        if (flags & IO_RING_ENTER_SQ_WAKEUP)
+            ring.wake_submission_poller();
+        submitted = to_submit;
+    } else if (to_submit > 0) {
+        submitted = TRY(ring.submit(*this, to_submit));
+    }
+
+    if (flags & IO_RING_ENTER_GETEVENTS) {
+        auto result = ring.wait_for_completions(*this, min_complete);
+        // Note: Once something has been submitted, the caller has to hear about it, even if the wait was cut short.
+        if (result.is_error() && submitted == 0)
+            return result.release_error();
+    } else {
+        ring.run_ready_operations(*this);
+    }
+    return submitted;
+}
+
+}
@@ -408,8 +408,13 @@ ErrorOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, int
     if (!is_user_range(range_to_madvise))
         return EFAULT;
 
-    return address_space().with([&](auto& space) -> ErrorOr<FlatPtr> {
-        auto* region = space->find_region_from_range(range_to_madvise);
+    LockRefPtr<Inode> inode_to_prefetch;
+    u64 prefetch_offset = 0;
+    u64 prefetch_length = 0;
+
+    auto result = TRY(address_space().with([&](auto& space) -> ErrorOr<FlatPtr> {
+        // Prefetching makes sense for any part of a mapping, everything else applies to whole regions.
+        auto* region = advice == MADV_WILLNEED ? space->find_region_containing(range_to_madvise) : space->find_region_from_range(range_to_madvise);
         if (!region)
             return EINVAL;
         if (!region->is_mmap())
@@ -424,8 +429,36 @@ ErrorOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, int
             TRY(vmobject.set_volatile(advice == MADV_SET_VOLATILE, was_purged));
             return was_purged ? 1 : 0;
         }
+        if (advice == MADV_HUGEPAGE || advice == MADV_NOHUGEPAGE) {
+            // Only zero faults in anonymous memory are ever satisfied with huge pages, so for anything else this is a no-op.
+            if (!region->vmobject().is_anonymous())
+                return 0;
+            region->set_wants_huge_pages(advice == MADV_HUGEPAGE);
+            return 0;
+        }
+        if (advice == MADV_NORMAL || advice == MADV_SEQUENTIAL || advice == MADV_RANDOM || advice == MADV_WILLNEED) {
+            // Access pattern hints only mean something for file-backed mappings; for anything else they are a no-op.
+            if (!region->vmobject().is_inode())
+                return 0;
+            if (advice == MADV_WILLNEED) {
+                // NOTE: We can't touch the inode while holding the address space lock, so the prefetch is started below.
+                inode_to_prefetch = static_cast<Memory::InodeVMObject&>(region->vmobject()).inode();
+                prefetch_offset = region->offset_in_vmobject() + (address.ptr() - region->vaddr().get());
+                prefetch_length = size;
+                return 0;
+            }
+            auto mode = advice == MADV_SEQUENTIAL ? ReadaheadState::Mode::Sequential
+                : advice == MADV_RANDOM           ? ReadaheadState::Mode::Random
+                                                  : ReadaheadState::Mode::Normal;
+            region->set_readahead_mode(mode);
+            return 0;
+        }
         return EINVAL;
-    });
+    }));
+
+    if (inode_to_prefetch)
+        inode_to_prefetch->prefetch(prefetch_offset, prefetch_length);
+    return result;
 }
 
 ErrorOr<FlatPtr> Process::sys$set_mmap_name(Userspace<Syscall::SC_set_mmap_name_params const*> user_params)
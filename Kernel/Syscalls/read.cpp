@@ -42,21 +42,7 @@ ErrorOr<FlatPtr> Process::sys$readv(int fd, Userspace<const struct iovec*> iov,
 {
     VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
     TRY(require_promise(Pledge::stdio));
-    if (iov_count < 0)
-        return EINVAL;
-
-    if (iov_count > IOV_MAX)
-        return EFAULT;
-
-    u64 total_length = 0;
-    Vector<iovec, 32> vecs;
-    TRY(vecs.try_resize(iov_count));
-    TRY(copy_n_from_user(vecs.data(), iov, iov_count));
-    for (auto& vec : vecs) {
-        total_length += vec.iov_len;
-        if (total_length > NumericLimits<i32>::max())
-            return EINVAL;
-    }
+    auto vecs = TRY(OpenFileDescription::copy_iovecs_from_user(iov, iov_count));
 
     auto description = TRY(open_readable_file_description(fds(), fd));
 
@@ -71,6 +57,22 @@ ErrorOr<FlatPtr> Process::sys$readv(int fd, Userspace<const struct iovec*> iov,
     return nread;
 }
 
+ErrorOr<FlatPtr> Process::sys$preadv(int fd, Userspace<const struct iovec*> iov, int iov_count, Userspace<off_t const*> userspace_offset)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto vecs = TRY(OpenFileDescription::copy_iovecs_from_user(iov, iov_count));
+    auto offset = TRY(copy_typed_from_user(userspace_offset));
+    if (offset < 0)
+        return EINVAL;
+    dbgln_if(IO_DEBUG, "sys$preadv({}, {}, {}, {})", fd, iov.ptr(), iov_count, offset);
+    auto description = TRY(open_readable_file_description(fds(), fd));
+    if (!description->file().is_seekable())
+        return EINVAL;
+    TRY(check_blocked_read(description));
+    return TRY(description->read_vectored(offset, vecs.span()));
+}
+
 ErrorOr<FlatPtr> Process::sys$read(int fd, Userspace<u8*> buffer, size_t size)
 {
     auto const start_timestamp = TimeManagement::the().uptime_ms();
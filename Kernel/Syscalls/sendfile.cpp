@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/NumericLimits.h>
+#include <Kernel/Debug.h>
+#include <Kernel/FileSystem/OpenFileDescription.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Process.h>
+
+namespace Kernel {
+
+// How much of the input file we move over to the output in one go.
+static constexpr size_t sendfile_chunk_size = 64 * KiB;
+
+// NOTE: The offset is passed by pointer because off_t is 64bit,
+// hence it can't be passed by register on 32bit platforms.
+ErrorOr<FlatPtr> Process::sys$sendfile(int out_fd, int in_fd, Userspace<off_t*> userspace_offset, size_t count)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    if (count > NumericLimits<ssize_t>::max())
+        return EINVAL;
+
+    auto in_description = TRY(open_file_description(in_fd));
+    if (!in_description->is_readable())
+        return EBADF;
+    auto out_description = TRY(open_file_description(out_fd));
+    if (!out_description->is_writable())
+        return EBADF;
+
+    // The point is to never bring the data into userspace, which only makes sense if it's
+    // already in the kernel, i.e. in the caches of a regular file.
+    if (!in_description->file().is_regular_file())
+        return EINVAL;
+
+    // Without an offset we use (and advance) the offset of the input description.
+    off_t start_offset;
+    if (userspace_offset) {
+        start_offset = TRY(copy_typed_from_user(userspace_offset));
+        if (start_offset < 0)
+            return EINVAL;
+    } else {
+        start_offset = in_description->offset();
+    }
+
+    dbgln_if(IO_DEBUG, "sys$sendfile({}, {}, {}, {})", out_fd, in_fd, start_offset, count);
+
+    if (count == 0)
+        return 0;
+
+    auto chunk = TRY(KBuffer::try_create_with_size("sendfile"sv, min(count, sendfile_chunk_size), Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow));
+    auto chunk_buffer = UserOrKernelBuffer::for_kernel_buffer(chunk->data());
+
+    size_t total_nsent = 0;
+    Optional<Error> error;
+    while (total_nsent < count) {
+        auto nread_or_error = in_description->read(chunk_buffer, start_offset + total_nsent, min(count - total_nsent, chunk->size()));
+        if (nread_or_error.is_error()) {
+            error = nread_or_error.release_error();
+            break;
+        }
+        auto nread = nread_or_error.value();
+        if (nread == 0)
+            break;
+
+        auto nwritten_or_error = do_write(*out_description, chunk_buffer, nread);
+        if (nwritten_or_error.is_error()) {
+            error = nwritten_or_error.release_error();
+            break;
+        }
+        total_nsent += nwritten_or_error.value();
+        // A non-blocking output took less than we gave it, so there is no point in trying again right away.
+        if (nwritten_or_error.value() < nread)
+            break;
+    }
+
+    if (error.has_value() && total_nsent == 0)
+        return error.release_value();
+
+    // Only what actually made it to the output counts as consumed.
+    off_t end_offset = start_offset + total_nsent;
+    if (userspace_offset)
+        TRY(copy_to_user(userspace_offset, &end_offset));
+    else
+        TRY(in_description->seek(end_offset, SEEK_SET));
+    return total_nsent;
+}
+
+}
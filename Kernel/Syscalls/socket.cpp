@@ -7,6 +7,7 @@
 #include <Kernel/FileSystem/OpenFileDescription.h>
 #include <Kernel/Net/LocalSocket.h>
 #include <Kernel/Process.h>
+#include <Kernel/Time/TimeManagement.h>
 #include <Kernel/UnixTypes.h>
 
 namespace Kernel {
@@ -172,12 +173,11 @@ ErrorOr<FlatPtr> Process::sys$shutdown(int sockfd, int how)
     return 0;
 }
 
-ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*> user_msg, int flags)
-{
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
-    TRY(require_promise(Pledge::stdio));
-    auto msg = TRY(copy_typed_from_user(user_msg));
+// The most messages a single sendmmsg() or recvmmsg() handles; the caller has to come back for the rest.
+static constexpr size_t max_messages_per_call = 1024;
 
+static ErrorOr<size_t> send_message(OpenFileDescription& description, Socket& socket, struct msghdr const& msg, int flags)
+{
     if (msg.msg_iovlen != 1)
         return ENOTSUP; // FIXME: Support this :)
     Vector<iovec, 1> iovs;
@@ -189,11 +189,6 @@ ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*
     Userspace<sockaddr const*> user_addr((FlatPtr)msg.msg_name);
     socklen_t addr_length = msg.msg_namelen;
 
-    auto description = TRY(open_file_description(sockfd));
-    if (!description->is_socket())
-        return ENOTSOCK;
-
-    auto& socket = *description->socket();
     if (socket.is_shut_down_for_writing()) {
         if ((flags & MSG_NOSIGNAL) == 0)
             Thread::current()->send_signal(SIGPIPE, &Process::current());
@@ -202,19 +197,19 @@ ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*
     auto data_buffer = TRY(UserOrKernelBuffer::for_user_buffer((u8*)iovs[0].iov_base, iovs[0].iov_len));
 
     while (true) {
-        while (!description->can_write()) {
-            if (!description->is_blocking()) {
+        while (!description.can_write()) {
+            if (!description.is_blocking()) {
                 return EAGAIN;
             }
 
             auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
-            if (Thread::current()->block<Thread::WriteBlocker>({}, *description, unblock_flags).was_interrupted()) {
+            if (Thread::current()->block<Thread::WriteBlocker>({}, description, unblock_flags).was_interrupted()) {
                 return EINTR;
             }
             // TODO: handle exceptions in unblock_flags
         }
 
-        auto bytes_sent_or_error = socket.sendto(*description, data_buffer, iovs[0].iov_len, flags, user_addr, addr_length);
+        auto bytes_sent_or_error = socket.sendto(description, data_buffer, iovs[0].iov_len, flags, user_addr, addr_length);
         if (bytes_sent_or_error.is_error()) {
             if ((flags & MSG_NOSIGNAL) == 0 && bytes_sent_or_error.error().code() == EPIPE)
                 Thread::current()->send_signal(SIGPIPE, &Process::current());
@@ -227,11 +222,8 @@ ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*
     }
 }
 
-ErrorOr<FlatPtr> Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user_msg, int flags)
+static ErrorOr<size_t> receive_message(OpenFileDescription& description, Socket& socket, Userspace<struct msghdr*> user_msg, int flags)
 {
-    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
-    TRY(require_promise(Pledge::stdio));
-
     struct msghdr msg;
     TRY(copy_from_user(&msg, user_msg));
 
@@ -244,18 +236,13 @@ ErrorOr<FlatPtr> Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user
     Userspace<sockaddr*> user_addr((FlatPtr)msg.msg_name);
     Userspace<socklen_t*> user_addr_length(msg.msg_name ? (FlatPtr)&user_msg.unsafe_userspace_ptr()->msg_namelen : 0);
 
-    auto description = TRY(open_file_description(sockfd));
-    if (!description->is_socket())
-        return ENOTSOCK;
-    auto& socket = *description->socket();
-
     if (socket.is_shut_down_for_reading())
         return 0;
 
     auto data_buffer = TRY(UserOrKernelBuffer::for_user_buffer((u8*)iovs[0].iov_base, iovs[0].iov_len));
     Time timestamp {};
-    bool blocking = (flags & MSG_DONTWAIT) ? false : description->is_blocking();
-    auto result = socket.recvfrom(*description, data_buffer, iovs[0].iov_len, flags, user_addr, user_addr_length, timestamp, blocking);
+    bool blocking = (flags & MSG_DONTWAIT) ? false : description.is_blocking();
+    auto result = socket.recvfrom(description, data_buffer, iovs[0].iov_len, flags, user_addr, user_addr_length, timestamp, blocking);
 
     if (result.is_error())
         return result.release_error();
@@ -286,6 +273,100 @@ ErrorOr<FlatPtr> Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user
     return result.value();
 }
 
+ErrorOr<FlatPtr> Process::sys$sendmsg(int sockfd, Userspace<const struct msghdr*> user_msg, int flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto msg = TRY(copy_typed_from_user(user_msg));
+
+    auto description = TRY(open_file_description(sockfd));
+    if (!description->is_socket())
+        return ENOTSOCK;
+
+    return send_message(*description, *description->socket(), msg, flags);
+}
+
+ErrorOr<FlatPtr> Process::sys$recvmsg(int sockfd, Userspace<struct msghdr*> user_msg, int flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto description = TRY(open_file_description(sockfd));
+    if (!description->is_socket())
+        return ENOTSOCK;
+
+    return receive_message(*description, *description->socket(), user_msg, flags);
+}
+
+ErrorOr<FlatPtr> Process::sys$sendmmsg(int sockfd, Userspace<struct mmsghdr*> user_msgvec, unsigned int vlen, int flags)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto description = TRY(open_file_description(sockfd));
+    if (!description->is_socket())
+        return ENOTSOCK;
+    auto& socket = *description->socket();
+
+    size_t message_count = min(static_cast<size_t>(vlen), max_messages_per_call);
+    size_t messages_sent = 0;
+    for (; messages_sent < message_count; ++messages_sent) {
+        auto* user_message = user_msgvec.unsafe_userspace_ptr() + messages_sent;
+        auto msg = TRY(copy_typed_from_user(Userspace<struct msghdr const*>((FlatPtr)&user_message->msg_hdr)));
+        auto bytes_sent_or_error = send_message(*description, socket, msg, flags);
+        // NOTE: An error past the first message ends the batch early; the caller will see it on its next call.
+        if (bytes_sent_or_error.is_error()) {
+            if (messages_sent == 0)
+                return bytes_sent_or_error.release_error();
+            break;
+        }
+        unsigned int bytes_sent = bytes_sent_or_error.release_value();
+        TRY(copy_to_user(&user_message->msg_len, &bytes_sent));
+    }
+    return messages_sent;
+}
+
+ErrorOr<FlatPtr> Process::sys$recvmmsg(Userspace<Syscall::SC_recvmmsg_params const*> user_params)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto params = TRY(copy_typed_from_user(user_params));
+
+    auto description = TRY(open_file_description(params.sockfd));
+    if (!description->is_socket())
+        return ENOTSOCK;
+    auto& socket = *description->socket();
+
+    // NOTE: Like on other systems, the timeout is only checked after each message, so a blocking
+    //       socket can still wait indefinitely for the first one.
+    Optional<Time> deadline;
+    if (params.timeout)
+        deadline = TimeManagement::the().monotonic_time() + TRY(copy_time_from_user(params.timeout));
+
+    int flags = params.flags & ~MSG_WAITFORONE;
+    size_t message_count = min(static_cast<size_t>(params.vlen), max_messages_per_call);
+    size_t messages_received = 0;
+    while (messages_received < message_count) {
+        auto* user_message = params.msgvec + messages_received;
+        auto bytes_received_or_error = receive_message(*description, socket, Userspace<struct msghdr*>((FlatPtr)&user_message->msg_hdr), flags);
+        // NOTE: An error past the first message ends the batch early; the caller will see it on its next call.
+        if (bytes_received_or_error.is_error()) {
+            if (messages_received == 0)
+                return bytes_received_or_error.release_error();
+            break;
+        }
+        unsigned int bytes_received = bytes_received_or_error.release_value();
+        TRY(copy_to_user(&user_message->msg_len, &bytes_received));
+        ++messages_received;
+
+        if (params.flags & MSG_WAITFORONE)
+            flags |= MSG_DONTWAIT;
+        if (deadline.has_value() && TimeManagement::the().monotonic_time() >= deadline.value())
+            break;
+    }
+    return messages_received;
+}
+
 template<bool sockname, typename Params>
 ErrorOr<void> Process::get_sock_or_peer_name(Params const& params)
 {
@@ -11,25 +11,21 @@
 
 namespace Kernel {
 
+static ErrorOr<NonnullLockRefPtr<OpenFileDescription>> open_positionally_writable_file_description(Process& process, int fd)
+{
+    auto description = TRY(process.open_file_description(fd));
+    if (!description->is_writable())
+        return EBADF;
+    if (!description->file().is_seekable())
+        return EINVAL;
+    return description;
+}
+
 ErrorOr<FlatPtr> Process::sys$writev(int fd, Userspace<const struct iovec*> iov, int iov_count)
 {
     VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
     TRY(require_promise(Pledge::stdio));
-    if (iov_count < 0)
-        return EINVAL;
-
-    if (iov_count > IOV_MAX)
-        return EFAULT;
-
-    u64 total_length = 0;
-    Vector<iovec, 32> vecs;
-    TRY(vecs.try_resize(iov_count));
-    TRY(copy_n_from_user(vecs.data(), iov, iov_count));
-    for (auto& vec : vecs) {
-        total_length += vec.iov_len;
-        if (total_length > NumericLimits<i32>::max())
-            return EINVAL;
-    }
+    auto vecs = TRY(OpenFileDescription::copy_iovecs_from_user(iov, iov_count));
 
     auto description = TRY(open_file_description(fd));
     if (!description->is_writable())
@@ -50,6 +46,19 @@ ErrorOr<FlatPtr> Process::sys$writev(int fd, Userspace<const struct iovec*> iov,
     return nwritten;
 }
 
+ErrorOr<FlatPtr> Process::sys$pwritev(int fd, Userspace<const struct iovec*> iov, int iov_count, Userspace<off_t const*> userspace_offset)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    auto vecs = TRY(OpenFileDescription::copy_iovecs_from_user(iov, iov_count));
+    auto offset = TRY(copy_typed_from_user(userspace_offset));
+    if (offset < 0)
+        return EINVAL;
+    dbgln_if(IO_DEBUG, "sys$pwritev({}, {}, {}, {})", fd, iov.ptr(), iov_count, offset);
+    auto description = TRY(open_positionally_writable_file_description(*this, fd));
+    return TRY(description->write_vectored(offset, vecs.span()));
+}
+
 ErrorOr<FlatPtr> Process::do_write(OpenFileDescription& description, UserOrKernelBuffer const& data, size_t data_size)
 {
     size_t total_nwritten = 0;
@@ -106,4 +115,23 @@ ErrorOr<FlatPtr> Process::sys$write(int fd, Userspace<u8 const*> data, size_t si
     return do_write(*description, buffer, size);
 }
 
+// NOTE: The offset is passed by pointer because off_t is 64bit,
+// hence it can't be passed by register on 32bit platforms.
+ErrorOr<FlatPtr> Process::sys$pwrite(int fd, Userspace<u8 const*> data, size_t size, Userspace<off_t const*> userspace_offset)
+{
+    VERIFY_PROCESS_BIG_LOCK_ACQUIRED(this);
+    TRY(require_promise(Pledge::stdio));
+    if (size == 0)
+        return 0;
+    if (size > NumericLimits<ssize_t>::max())
+        return EINVAL;
+    auto offset = TRY(copy_typed_from_user(userspace_offset));
+    if (offset < 0)
+        return EINVAL;
+    dbgln_if(IO_DEBUG, "sys$pwrite({}, {}, {}, {})", fd, data.ptr(), size, offset);
+    auto description = TRY(open_positionally_writable_file_description(*this, fd));
+    auto buffer = TRY(UserOrKernelBuffer::for_user_buffer(data, size));
+    return TRY(description->write(offset, buffer, size));
+}
+
 }
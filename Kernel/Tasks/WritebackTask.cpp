@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/FileSystem/VirtualFileSystem.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Process.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/WritebackTask.h>
+#include <Kernel/WaitQueue.h>
+
+namespace Kernel {
+
+Atomic<u32> g_dirty_background_ratio { 10 };
+Atomic<u32> g_dirty_ratio { 40 };
+
+static constexpr StringView writeback_task_name = "Writeback Task"sv;
+static constexpr u64 writeback_interval_ms = 500;
+
+static WaitQueue* s_writeback_wait_queue;
+static WaitQueue* s_writeback_progress_wait_queue;
+static Thread* s_writeback_thread;
+
+static void writeback_task(void*)
+{
+    dbgln("Writeback Task is running");
+    for (;;) {
+        auto interval = Time::from_milliseconds(writeback_interval_ms);
+        (void)s_writeback_wait_queue->wait_on(Thread::BlockTimeout(false, &interval), writeback_task_name);
+
+        // NOTE: Inodes may still be holding on to metadata that hasn't made it into the block cache yet.
+        Inode::sync_all();
+        auto written_back = VirtualFileSystem::the().write_back_filesystems();
+        if (MM.is_low_on_physical_memory())
+            VirtualFileSystem::the().release_cached_memory_of_filesystems();
+
+        // NOTE: A wake with nobody waiting is remembered, so only wake when there actually was progress.
+        if (written_back > 0)
+            s_writeback_progress_wait_queue->wake_all();
+    }
+}
+
+UNMAP_AFTER_INIT void WritebackTask::spawn()
+{
+    s_writeback_wait_queue = new WaitQueue;
+    s_writeback_progress_wait_queue = new WaitQueue;
+
+    LockRefPtr<Thread> writeback_thread;
+    auto writeback_process = Process::create_kernel_process(writeback_thread, KString::must_create(writeback_task_name), writeback_task, nullptr);
+    VERIFY(writeback_process);
+    s_writeback_thread = writeback_thread.ptr();
+}
+
+bool WritebackTask::is_current_thread()
+{
+    return Thread::current() == s_writeback_thread;
+}
+
+void WritebackTask::wake()
+{
+    if (s_writeback_wait_queue)
+        s_writeback_wait_queue->wake_all();
+}
+
+void WritebackTask::wait_for_progress(Time timeout)
+{
+    if (!s_writeback_progress_wait_queue || is_current_thread())
+        return;
+    (void)s_writeback_progress_wait_queue->wait_on(Thread::BlockTimeout(false, &timeout), "WritebackTask"sv);
+}
+
+}
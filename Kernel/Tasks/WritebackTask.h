@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Time.h>
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// Percentage of the block cache that may be dirty before writeback starts in the background.
+extern Atomic<u32> g_dirty_background_ratio;
+// Percentage of the block cache that may be dirty before writers have to wait for writeback.
+extern Atomic<u32> g_dirty_ratio;
+
+class WritebackTask {
+public:
+    static void spawn();
+
+    // Makes the task start a writeback pass right away, instead of waiting for its next periodic pass.
+    static void wake();
+
+    // Blocks until a writeback pass has written something back, or until the timeout expires.
+    static void wait_for_progress(Time timeout);
+
+    static bool is_current_thread();
+};
+
+}
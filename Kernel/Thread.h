@@ -35,6 +35,7 @@
 namespace Kernel {
 
 class Timer;
+struct ThreadReadyQueues;
 
 enum class DispatchSignalResult {
     Deferred = 0,
@@ -136,6 +137,7 @@ class Thread
     friend class Process;
     friend class Scheduler;
     friend struct ThreadReadyQueue;
+    friend struct ThreadReadyQueues;
 
 public:
     inline static Thread* current()
@@ -589,6 +591,11 @@ public:
         virtual Type blocker_type() const override { return Type::File; }
 
         virtual bool unblock_if_conditions_are_met(bool, void*) = 0;
+
+        // Exclusive blockers wait for something only one of them can take, so
+        // waking more than one of them at a time would only make the rest go
+        // back to sleep again.
+        virtual bool is_exclusive() const { return false; }
     };
 
     class OpenFileDescriptionBlocker : public FileBlocker {
@@ -613,6 +620,7 @@ public:
     public:
         explicit AcceptBlocker(OpenFileDescription&, BlockFlags&);
         virtual StringView state_string() const override { return "Accepting"sv; }
+        virtual bool is_exclusive() const override { return true; }
     };
 
     class ConnectBlocker final : public OpenFileDescriptionBlocker {
@@ -1172,6 +1180,7 @@ private:
 
     IntrusiveListNode<Thread> m_process_thread_list_node;
     int m_runnable_priority { -1 };
+    Atomic<ThreadReadyQueues*> m_runnable_queues { nullptr };
 
     friend class WaitQueue;
 
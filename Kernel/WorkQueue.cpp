@@ -14,11 +14,15 @@ namespace Kernel {
 
 WorkQueue* g_io_work;
 WorkQueue* g_ata_work;
+WorkQueue* g_readahead_work;
 
 UNMAP_AFTER_INIT void WorkQueue::initialize()
 {
     g_io_work = new WorkQueue("IO WorkQueue Task"sv);
     g_ata_work = new WorkQueue("ATA WorkQueue Task"sv);
+    // NOTE: Readahead blocks on disk I/O, so it must not share a queue with the
+    //       storage drivers, which complete their requests via g_io_work.
+    g_readahead_work = new WorkQueue("Readahead WorkQueue Task"sv);
 }
 
 UNMAP_AFTER_INIT WorkQueue::WorkQueue(StringView name)
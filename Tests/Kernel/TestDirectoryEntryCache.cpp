@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void create_file(StringView path)
+{
+    auto fd = MUST(Core::System::open(path, O_CREAT | O_WRONLY | O_TRUNC, 0644));
+    MUST(Core::System::close(fd));
+}
+
+static bool exists(StringView path)
+{
+    return !Core::System::stat(path).is_error();
+}
+
+TEST_CASE(created_file_replaces_negative_entry)
+{
+    auto path = "/tmp/dentry-cache-created"sv;
+    (void)Core::System::unlink(path);
+
+    EXPECT(!exists(path));
+    EXPECT(!exists(path));
+    create_file(path);
+    EXPECT(exists(path));
+
+    MUST(Core::System::unlink(path));
+    EXPECT(!exists(path));
+}
+
+TEST_CASE(rename_moves_cached_entry)
+{
+    auto old_path = "/tmp/dentry-cache-old"sv;
+    auto new_path = "/tmp/dentry-cache-new"sv;
+    (void)Core::System::unlink(new_path);
+
+    create_file(old_path);
+    EXPECT(exists(old_path));
+    EXPECT(!exists(new_path));
+
+    MUST(Core::System::rename(old_path, new_path));
+    EXPECT(!exists(old_path));
+    EXPECT(exists(new_path));
+
+    MUST(Core::System::unlink(new_path));
+}
+
+TEST_CASE(recreated_directory_starts_empty)
+{
+    auto directory_path = "/tmp/dentry-cache-directory"sv;
+    auto file_path = "/tmp/dentry-cache-directory/file"sv;
+
+    MUST(Core::System::mkdir(directory_path, 0755));
+    create_file(file_path);
+    EXPECT(exists(file_path));
+    MUST(Core::System::unlink(file_path));
+    MUST(Core::System::rmdir(directory_path));
+
+    MUST(Core::System::mkdir(directory_path, 0755));
+    EXPECT(!exists(file_path));
+    create_file(file_path);
+    EXPECT(exists(file_path));
+
+    MUST(Core::System::unlink(file_path));
+    MUST(Core::System::rmdir(directory_path));
+}
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/Vector.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+static int add_watch(int epoll_fd, int fd, u32 events, u64 data)
+{
+    epoll_event event {};
+    event.events = events;
+    event.data.u64 = data;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+}
+
+static void write_byte(int fd)
+{
+    char byte = 'x';
+    EXPECT_EQ(write(fd, &byte, 1), 1);
+}
+
+static void read_byte(int fd)
+{
+    char byte;
+    EXPECT_EQ(read(fd, &byte, 1), 1);
+}
+
+TEST_CASE(epoll_level_triggered)
+{
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    EXPECT(epoll_fd >= 0);
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(add_watch(epoll_fd, pipe_fds[0], EPOLLIN, 42), 0);
+
+    epoll_event events[4];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    write_byte(pipe_fds[1]);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+    EXPECT_EQ(events[0].events, static_cast<u32>(EPOLLIN));
+    EXPECT_EQ(events[0].data.u64, 42u);
+
+    // Nothing was read, so the pipe is still reported.
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+
+    read_byte(pipe_fds[0]);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_edge_triggered)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(add_watch(epoll_fd, pipe_fds[0], EPOLLIN | EPOLLET, 1), 0);
+
+    epoll_event events[4];
+    write_byte(pipe_fds[1]);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+    // Nothing changed since the last report.
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    write_byte(pipe_fds[1]);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_one_shot)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(add_watch(epoll_fd, pipe_fds[0], EPOLLIN | EPOLLONESHOT, 1), 0);
+
+    epoll_event events[4];
+    write_byte(pipe_fds[1]);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+    write_byte(pipe_fds[1]);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    // Modifying the watch arms it again.
+    epoll_event event {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = 2;
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pipe_fds[0], &event), 0);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 1);
+    EXPECT_EQ(events[0].data.u64, 2u);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_ctl_errors)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, pipe_fds[0], &event), -1);
+    EXPECT_EQ(errno, ENOENT);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, pipe_fds[0], nullptr), -1);
+    EXPECT_EQ(errno, ENOENT);
+
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), 0);
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, pipe_fds[0], &event), -1);
+    EXPECT_EQ(errno, EEXIST);
+
+    // An event poll can't watch another one (or itself).
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, epoll_fd, &event), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(epoll_ctl(pipe_fds[0], EPOLL_CTL_ADD, pipe_fds[1], &event), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    EXPECT_EQ(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, pipe_fds[0], nullptr), 0);
+    write_byte(pipe_fds[1]);
+    epoll_event events[4];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    EXPECT_EQ(epoll_create1(O_NONBLOCK), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 0, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_closed_fd_is_dropped)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(add_watch(epoll_fd, pipe_fds[0], EPOLLIN, 1), 0);
+    write_byte(pipe_fds[1]);
+
+    close(pipe_fds[0]);
+    epoll_event events[4];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 0), 0);
+
+    // The fd number can be watched again once it's reused.
+    auto new_pipe_fds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(new_pipe_fds[0], pipe_fds[0]);
+    EXPECT_EQ(add_watch(epoll_fd, new_pipe_fds[0], EPOLLIN, 2), 0);
+
+    close(new_pipe_fds[0]);
+    close(new_pipe_fds[1]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+TEST_CASE(epoll_wait_blocks)
+{
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(add_watch(epoll_fd, pipe_fds[0], EPOLLIN, 7), 0);
+
+    epoll_event events[4];
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, 50), 0);
+
+    pid_t pid = fork();
+    EXPECT(pid >= 0);
+    if (pid == 0) {
+        usleep(50'000);
+        write_byte(pipe_fds[1]);
+        _exit(0);
+    }
+
+    EXPECT_EQ(epoll_wait(epoll_fd, events, 4, -1), 1);
+    EXPECT_EQ(events[0].data.u64, 7u);
+    MUST(Core::System::waitpid(pid, 0));
+
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+    close(epoll_fd);
+}
+
+BENCHMARK_CASE(epoll_few_active_among_many_idle)
+{
+    // Lots of idle pipes that never become ready, plus a single one that is kept busy.
+    // The cost of each wait should only depend on the pipes that actually changed state.
+    static constexpr size_t idle_pipe_count = 400;
+    static constexpr size_t iteration_count = 10'000;
+
+    int epoll_fd = epoll_create1(0);
+    EXPECT(epoll_fd >= 0);
+
+    Vector<Array<int, 2>> idle_pipes;
+    for (size_t i = 0; i < idle_pipe_count; ++i) {
+        auto pipe_fds = MUST(Core::System::pipe2(0));
+        EXPECT_EQ(add_watch(epoll_fd, pipe_fds[0], EPOLLIN, i), 0);
+        idle_pipes.append(pipe_fds);
+    }
+
+    auto active_pipe_fds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(add_watch(epoll_fd, active_pipe_fds[0], EPOLLIN, idle_pipe_count), 0);
+
+    epoll_event events[16];
+    for (size_t i = 0; i < iteration_count; ++i) {
+        write_byte(active_pipe_fds[1]);
+        EXPECT_EQ(epoll_wait(epoll_fd, events, 16, -1), 1);
+        read_byte(active_pipe_fds[0]);
+    }
+
+    for (auto& pipe_fds : idle_pipes) {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+    }
+    close(active_pipe_fds[0]);
+    close(active_pipe_fds[1]);
+    close(epoll_fd);
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+// Big enough to need doubly indirect blocks with 1 KiB and 4 KiB file system blocks.
+static constexpr size_t file_size = 8 * MiB;
+
+static bool matches_pattern(int fd, size_t offset, size_t size)
+{
+    Array<u8, 64 * KiB> buffer;
+    VERIFY(size <= buffer.size());
+    auto nread = pread(fd, buffer.data(), size, offset);
+    if (nread != static_cast<ssize_t>(size))
+        return false;
+    for (size_t i = 0; i < size; ++i) {
+        if (buffer[i] != static_cast<u8>((offset + i) % 251))
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(large_file_reads_back_across_indirect_blocks)
+{
+    // /tmp is a TmpFS, so put the file somewhere that lives on the Ext2 root file system.
+    char pattern[] = "/home/anon/ext2_block_map.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, sizeof(pattern) - 1 }));
+
+    Array<u8, 64 * KiB> buffer;
+    for (size_t offset = 0; offset < file_size; offset += buffer.size()) {
+        for (size_t i = 0; i < buffer.size(); ++i)
+            buffer[i] = static_cast<u8>((offset + i) % 251);
+        VERIFY(pwrite(fd, buffer.data(), buffer.size(), offset) == static_cast<ssize_t>(buffer.size()));
+    }
+
+    // Unaligned reads that start and end in the middle of blocks, all over the file.
+    for (size_t offset = 0; offset < file_size; offset += 123 * KiB + 7)
+        EXPECT(matches_pattern(fd, offset, min(static_cast<size_t>(40 * KiB + 3), file_size - offset)));
+    EXPECT(matches_pattern(fd, file_size - 1, 1));
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(shrunk_and_regrown_file_reads_back_zeroes)
+{
+    char pattern[] = "/home/anon/ext2_block_map.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, sizeof(pattern) - 1 }));
+
+    Array<u8, 64 * KiB> buffer;
+    for (size_t offset = 0; offset < file_size; offset += buffer.size()) {
+        for (size_t i = 0; i < buffer.size(); ++i)
+            buffer[i] = static_cast<u8>((offset + i) % 251);
+        VERIFY(pwrite(fd, buffer.data(), buffer.size(), offset) == static_cast<ssize_t>(buffer.size()));
+    }
+
+    static constexpr size_t shrunk_size = 100 * KiB + 3;
+    MUST(Core::System::ftruncate(fd, shrunk_size));
+    MUST(Core::System::ftruncate(fd, file_size / 2));
+
+    EXPECT(matches_pattern(fd, 0, 64 * KiB));
+    EXPECT(matches_pattern(fd, shrunk_size - 3, 3));
+
+    for (size_t offset = shrunk_size; offset < file_size / 2; offset += buffer.size()) {
+        auto nread = pread(fd, buffer.data(), buffer.size(), offset);
+        EXPECT_EQ(nread, static_cast<ssize_t>(min(buffer.size(), file_size / 2 - offset)));
+        for (ssize_t i = 0; i < nread; ++i)
+            EXPECT_EQ(buffer[i], 0);
+    }
+
+    MUST(Core::System::close(fd));
+}
+
+// Counts the physically contiguous pieces the file is made of, or returns nothing if we're not allowed to look.
+static Optional<size_t> count_fragments(int fd)
+{
+    auto st = MUST(Core::System::fstat(fd));
+    size_t block_count = ceil_div(static_cast<size_t>(st.st_size), static_cast<size_t>(st.st_blksize));
+    size_t fragments = 0;
+    int previous_block = 0;
+    for (size_t i = 0; i < block_count; ++i) {
+        int block = static_cast<int>(i);
+        if (Core::System::ioctl(fd, FIBMAP, &block).is_error())
+            return {};
+        if (i == 0 || block != previous_block + 1)
+            ++fragments;
+        previous_block = block;
+    }
+    return fragments;
+}
+
+TEST_CASE(interleaved_appends_stay_mostly_contiguous)
+{
+    char first_pattern[] = "/home/anon/ext2_block_map.XXXXXX";
+    auto first_fd = MUST(Core::System::mkstemp(first_pattern));
+    MUST(Core::System::unlink({ first_pattern, sizeof(first_pattern) - 1 }));
+    char second_pattern[] = "/home/anon/ext2_block_map.XXXXXX";
+    auto second_fd = MUST(Core::System::mkstemp(second_pattern));
+    MUST(Core::System::unlink({ second_pattern, sizeof(second_pattern) - 1 }));
+
+    static constexpr size_t appended_size = 2 * MiB;
+    Array<u8, 4 * KiB> buffer;
+    for (size_t offset = 0; offset < appended_size; offset += buffer.size()) {
+        for (size_t i = 0; i < buffer.size(); ++i)
+            buffer[i] = static_cast<u8>((offset + i) % 251);
+        VERIFY(write(first_fd, buffer.data(), buffer.size()) == static_cast<ssize_t>(buffer.size()));
+        VERIFY(write(second_fd, buffer.data(), buffer.size()) == static_cast<ssize_t>(buffer.size()));
+    }
+
+    EXPECT(matches_pattern(first_fd, appended_size - 64 * KiB, 64 * KiB));
+    EXPECT(matches_pattern(second_fd, appended_size - 64 * KiB, 64 * KiB));
+
+    // Without anything holding on to the blocks after each file, every append would start a new fragment.
+    auto first_fragments = count_fragments(first_fd);
+    auto second_fragments = count_fragments(second_fd);
+    if (first_fragments.has_value() && second_fragments.has_value()) {
+        EXPECT(first_fragments.value() * 8 <= appended_size / buffer.size());
+        EXPECT(second_fragments.value() * 8 <= appended_size / buffer.size());
+    }
+
+    MUST(Core::System::close(first_fd));
+    MUST(Core::System::close(second_fd));
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibCore/IORing.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static io_ring_cqe take_completion(Core::IORing& ring)
+{
+    auto completion = ring.next_completion();
+    VERIFY(completion.has_value());
+    return completion.release_value();
+}
+
+TEST_CASE(pipe_write_and_read_in_one_batch)
+{
+    auto ring = MUST(Core::IORing::create());
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+
+    auto message = "hello, ring"sv;
+    Array<u8, 32> buffer {};
+    EXPECT(ring->enqueue_write(pipe_fds[1], message.bytes(), 1));
+    EXPECT(ring->enqueue_read(pipe_fds[0], buffer.span(), 2));
+    EXPECT_EQ(MUST(ring->submit(2)), 2u);
+
+    auto first = take_completion(*ring);
+    auto second = take_completion(*ring);
+    EXPECT_EQ(first.user_data, 1u);
+    EXPECT_EQ(first.result, static_cast<i32>(message.length()));
+    EXPECT_EQ(second.user_data, 2u);
+    EXPECT_EQ(second.result, static_cast<i32>(message.length()));
+    EXPECT_EQ(StringView(buffer.data(), message.length()), message);
+    EXPECT(!ring->next_completion().has_value());
+
+    MUST(Core::System::close(pipe_fds[0]));
+    MUST(Core::System::close(pipe_fds[1]));
+}
+
+TEST_CASE(pwrite_pread_and_fsync)
+{
+    auto path = "/tmp/io-ring-file"sv;
+    auto fd = MUST(Core::System::open(path, O_CREAT | O_RDWR | O_TRUNC, 0644));
+    MUST(Core::System::unlink(path));
+    auto ring = MUST(Core::IORing::create());
+
+    Array<u8, 512> written;
+    for (size_t i = 0; i < written.size(); ++i)
+        written[i] = static_cast<u8>(i);
+    EXPECT(ring->enqueue_pwrite(fd, written.span(), 4096, 1));
+    EXPECT(ring->enqueue_fsync(fd, 2));
+    EXPECT_EQ(MUST(ring->submit(2)), 2u);
+    EXPECT_EQ(take_completion(*ring).result, 512);
+    EXPECT_EQ(take_completion(*ring).result, 0);
+
+    // A positional write must leave the file offset alone.
+    EXPECT_EQ(MUST(Core::System::lseek(fd, 0, SEEK_CUR)), 0);
+
+    Array<u8, 512> read_back {};
+    EXPECT(ring->enqueue_pread(fd, read_back.span(), 4096, 3));
+    EXPECT_EQ(MUST(ring->submit(1)), 1u);
+    auto completion = take_completion(*ring);
+    EXPECT_EQ(completion.user_data, 3u);
+    EXPECT_EQ(completion.result, 512);
+    EXPECT_EQ(read_back, written);
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(recv_waits_for_data_without_blocking_submission)
+{
+    int fds[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, fds));
+    auto ring = MUST(Core::IORing::create());
+
+    Array<u8, 16> buffer {};
+    EXPECT(ring->enqueue_recv(fds[0], buffer.span(), 0, 7));
+    EXPECT(ring->enqueue_poll(fds[0], POLLIN, 8));
+    EXPECT_EQ(MUST(ring->submit()), 2u);
+    EXPECT(!ring->next_completion().has_value());
+
+    EXPECT_EQ(write(fds[1], "ping", 4), 4);
+    MUST(ring->submit(2));
+
+    size_t completions = 0;
+    for (auto completion = ring->next_completion(); completion.has_value(); completion = ring->next_completion()) {
+        if (completion->user_data == 7) {
+            EXPECT_EQ(completion->result, 4);
+            EXPECT_EQ(StringView(buffer.data(), 4), "ping"sv);
+        } else {
+            EXPECT_EQ(completion->user_data, 8u);
+            EXPECT(completion->result & POLLIN);
+        }
+        ++completions;
+    }
+    EXPECT_EQ(completions, 2u);
+
+    MUST(Core::System::close(fds[0]));
+    MUST(Core::System::close(fds[1]));
+}
+
+TEST_CASE(errors_are_reported_in_completions)
+{
+    auto ring = MUST(Core::IORing::create());
+    Array<u8, 4> buffer {};
+    EXPECT(ring->enqueue_read(-1, buffer.span(), 1));
+    EXPECT_EQ(MUST(ring->submit(1)), 1u);
+    EXPECT_EQ(take_completion(*ring).result, -EBADF);
+}
+
+TEST_CASE(rings_and_event_polls_are_not_valid_targets)
+{
+    auto ring = MUST(Core::IORing::create());
+    auto other_ring = MUST(Core::IORing::create());
+    auto epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    VERIFY(epoll_fd >= 0);
+
+    EXPECT(ring->enqueue_poll(ring->fd(), POLLIN, 1));
+    EXPECT(ring->enqueue_poll(other_ring->fd(), POLLIN, 2));
+    EXPECT(ring->enqueue_poll(epoll_fd, POLLIN, 3));
+    EXPECT_EQ(MUST(ring->submit(3)), 3u);
+    for (size_t i = 0; i < 3; ++i)
+        EXPECT_EQ(take_completion(*ring).result, -EINVAL);
+
+    MUST(Core::System::close(epoll_fd));
+}
+
+TEST_CASE(accept_needs_a_listening_socket)
+{
+    auto ring = MUST(Core::IORing::create());
+    auto fd = MUST(Core::System::socket(AF_LOCAL, SOCK_STREAM, 0));
+    EXPECT(ring->enqueue_accept(fd, 0, 1));
+    EXPECT_EQ(MUST(ring->submit(1)), 1u);
+    EXPECT_EQ(take_completion(*ring).result, -EINVAL);
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(submission_poller_picks_up_entries)
+{
+    auto ring = MUST(Core::IORing::create({ .entries = 8, .submission_polling = true, .submission_poller_idle_ms = 10 }));
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+
+    for (u64 round = 0; round < 4; ++round) {
+        Array<u8, 1> byte { static_cast<u8>(round) };
+        EXPECT(ring->enqueue_write(pipe_fds[1], byte.span(), round));
+        MUST(ring->submit(1));
+        auto completion = take_completion(*ring);
+        EXPECT_EQ(completion.user_data, round);
+        EXPECT_EQ(completion.result, 1);
+        // Give the poller a chance to go to sleep, so it has to be woken up again.
+        if (round == 1)
+            usleep(50'000);
+    }
+
+    MUST(Core::System::close(pipe_fds[0]));
+    MUST(Core::System::close(pipe_fds[1]));
+}
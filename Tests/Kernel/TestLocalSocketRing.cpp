@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+struct MappedSocket {
+    int fd { -1 };
+    u8* mapping { nullptr };
+    size_t mapping_size { 0 };
+};
+
+static MappedSocket map_socket(int fd)
+{
+    unsigned long mapping_size = 0;
+    MUST(Core::System::ioctl(fd, LOCAL_SOCKET_RING_GET_MAPPING_SIZE, &mapping_size));
+    auto* mapping = static_cast<u8*>(MUST(Core::System::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)));
+    return { fd, mapping, mapping_size };
+}
+
+// Puts `size` bytes counting up modulo 251 from `pattern_offset` into the socket in place, and returns how many fit.
+static size_t commit_pattern(MappedSocket const& socket, size_t pattern_offset, size_t size)
+{
+    LocalSocketRingSpan span {};
+    MUST(Core::System::ioctl(socket.fd, LOCAL_SOCKET_RING_COMMIT, &span));
+    size_t committed = 0;
+    while (committed < size && span.size > 0) {
+        size_t chunk_size = min(size - committed, span.size);
+        for (size_t i = 0; i < chunk_size; ++i)
+            socket.mapping[span.offset + i] = static_cast<u8>((pattern_offset + committed + i) % 251);
+        committed += chunk_size;
+        span.size = chunk_size;
+        MUST(Core::System::ioctl(socket.fd, LOCAL_SOCKET_RING_COMMIT, &span));
+    }
+    return committed;
+}
+
+// Takes out what's readable in place, and returns how many bytes continued the count from `pattern_offset`.
+static size_t consume_pattern(MappedSocket const& socket, size_t pattern_offset)
+{
+    LocalSocketRingSpan span {};
+    MUST(Core::System::ioctl(socket.fd, LOCAL_SOCKET_RING_CONSUME, &span));
+    size_t consumed = 0;
+    while (span.size > 0) {
+        for (size_t i = 0; i < span.size; ++i) {
+            if (socket.mapping[span.offset + i] != static_cast<u8>((pattern_offset + consumed + i) % 251))
+                return consumed + i;
+        }
+        consumed += span.size;
+        MUST(Core::System::ioctl(socket.fd, LOCAL_SOCKET_RING_CONSUME, &span));
+    }
+    return consumed;
+}
+
+TEST_CASE(local_socket_ring_in_place_write_is_readable)
+{
+    int fds[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, fds));
+    auto sender = map_socket(fds[0]);
+
+    EXPECT_EQ(commit_pattern(sender, 0, 1000), 1000u);
+
+    int readable = 0;
+    MUST(Core::System::ioctl(fds[1], FIONREAD, &readable));
+    EXPECT_EQ(readable, 1000);
+
+    Array<u8, 1000> buffer;
+    EXPECT_EQ(MUST(Core::System::read(fds[1], buffer.span())), 1000u);
+    for (size_t i = 0; i < buffer.size(); ++i)
+        EXPECT_EQ(buffer[i], static_cast<u8>(i % 251));
+
+    MUST(Core::System::munmap(sender.mapping, sender.mapping_size));
+    MUST(Core::System::close(fds[0]));
+    MUST(Core::System::close(fds[1]));
+}
+
+TEST_CASE(local_socket_ring_write_is_readable_in_place)
+{
+    int fds[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, fds));
+    auto receiver = map_socket(fds[1]);
+
+    Array<u8, 1000> buffer;
+    for (size_t i = 0; i < buffer.size(); ++i)
+        buffer[i] = static_cast<u8>(i % 251);
+    EXPECT_EQ(MUST(Core::System::write(fds[0], buffer.span())), 1000u);
+
+    EXPECT_EQ(consume_pattern(receiver, 0), 1000u);
+
+    int readable = 0;
+    MUST(Core::System::ioctl(fds[1], FIONREAD, &readable));
+    EXPECT_EQ(readable, 0);
+
+    MUST(Core::System::munmap(receiver.mapping, receiver.mapping_size));
+    MUST(Core::System::close(fds[0]));
+    MUST(Core::System::close(fds[1]));
+}
+
+TEST_CASE(local_socket_ring_wraps_around)
+{
+    int fds[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, fds));
+    auto sender = map_socket(fds[0]);
+    auto receiver = map_socket(fds[1]);
+
+    // Go around the ring a few times, with a size that doesn't divide it evenly.
+    static constexpr size_t chunk_size = 3000;
+    size_t offset = 0;
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_EQ(commit_pattern(sender, offset, chunk_size), chunk_size);
+        EXPECT_EQ(consume_pattern(receiver, offset), chunk_size);
+        offset += chunk_size;
+    }
+
+    MUST(Core::System::munmap(sender.mapping, sender.mapping_size));
+    MUST(Core::System::munmap(receiver.mapping, receiver.mapping_size));
+    MUST(Core::System::close(fds[0]));
+    MUST(Core::System::close(fds[1]));
+}
+
+TEST_CASE(local_socket_ring_drains_after_peer_closes)
+{
+    int fds[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, fds));
+    auto sender = map_socket(fds[0]);
+    auto receiver = map_socket(fds[1]);
+
+    EXPECT_EQ(commit_pattern(sender, 0, 1000), 1000u);
+    MUST(Core::System::munmap(sender.mapping, sender.mapping_size));
+    MUST(Core::System::close(fds[0]));
+
+    // Whatever was sent before the peer went away can still be taken out in place, just like with read().
+    EXPECT_EQ(consume_pattern(receiver, 0), 1000u);
+
+    LocalSocketRingSpan span {};
+    EXPECT(Core::System::ioctl(fds[1], LOCAL_SOCKET_RING_COMMIT, &span).is_error());
+
+    MUST(Core::System::munmap(receiver.mapping, receiver.mapping_size));
+    MUST(Core::System::close(fds[1]));
+}
+
+TEST_CASE(local_socket_ring_listener_has_no_rings)
+{
+    auto fd = MUST(Core::System::socket(AF_LOCAL, SOCK_STREAM, 0));
+    unsigned long mapping_size = 0;
+    auto result = Core::System::ioctl(fd, LOCAL_SOCKET_RING_GET_MAPPING_SIZE, &mapping_size);
+    EXPECT(result.is_error());
+    EXPECT_EQ(result.error().code(), ENOTCONN);
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(local_socket_ring_rejects_overcommit)
+{
+    int fds[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, fds));
+
+    LocalSocketRingSpan span {};
+    MUST(Core::System::ioctl(fds[0], LOCAL_SOCKET_RING_COMMIT, &span));
+    span.size += 1;
+    EXPECT(Core::System::ioctl(fds[0], LOCAL_SOCKET_RING_COMMIT, &span).is_error());
+
+    span = {};
+    span.size = 1;
+    EXPECT(Core::System::ioctl(fds[1], LOCAL_SOCKET_RING_CONSUME, &span).is_error());
+
+    MUST(Core::System::close(fds[0]));
+    MUST(Core::System::close(fds[1]));
+}
+
+TEST_CASE(local_socket_ring_rejects_private_mapping)
+{
+    int fds[2];
+    MUST(Core::System::socketpair(AF_LOCAL, SOCK_STREAM, 0, fds));
+
+    unsigned long mapping_size = 0;
+    MUST(Core::System::ioctl(fds[0], LOCAL_SOCKET_RING_GET_MAPPING_SIZE, &mapping_size));
+    EXPECT(Core::System::mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fds[0], 0).is_error());
+
+    MUST(Core::System::close(fds[0]));
+    MUST(Core::System::close(fds[1]));
+}
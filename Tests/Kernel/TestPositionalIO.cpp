@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/ByteBuffer.h>
+#include <AK/StringView.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+TEST_CASE(pwrite_leaves_offset_alone)
+{
+    char pattern[] = "/tmp/positional_io.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, sizeof(pattern) - 1 }));
+    EXPECT_EQ(write(fd, "abcdef", 6), 6);
+    EXPECT_EQ(pwrite(fd, "XY", 2, 1), 2);
+    EXPECT_EQ(MUST(Core::System::lseek(fd, 0, SEEK_CUR)), 6);
+
+    char buffer[6];
+    EXPECT_EQ(pread(fd, buffer, sizeof(buffer), 0), 6);
+    EXPECT_EQ(StringView(buffer, 6), "aXYdef"sv);
+
+    // Writing past the end extends the file.
+    EXPECT_EQ(pwrite(fd, "!", 1, 9), 1);
+    EXPECT_EQ(MUST(Core::System::fstat(fd)).st_size, 10);
+
+    EXPECT_EQ(pwrite(fd, "!", 1, -1), -1);
+    EXPECT_EQ(errno, EINVAL);
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(pwrite_needs_seekable_writable_file)
+{
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(pwrite(pipe_fds[1], "x", 1, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    MUST(Core::System::close(pipe_fds[0]));
+    MUST(Core::System::close(pipe_fds[1]));
+
+    auto fd = MUST(Core::System::open("/tmp"sv, O_RDONLY | O_DIRECTORY));
+    EXPECT_EQ(pwrite(fd, "x", 1, 0), -1);
+    EXPECT_EQ(errno, EBADF);
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(pwritev_and_preadv_round_trip)
+{
+    char pattern[] = "/tmp/positional_io.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, sizeof(pattern) - 1 }));
+
+    char header[] = "head";
+    char body[] = "-and-";
+    char footer[] = "tail";
+    Array<iovec, 3> out_vecs {
+        iovec { header, 4 },
+        iovec { body, 5 },
+        iovec { footer, 4 },
+    };
+    EXPECT_EQ(pwritev(fd, out_vecs.data(), out_vecs.size(), 100), 13);
+    EXPECT_EQ(MUST(Core::System::lseek(fd, 0, SEEK_CUR)), 0);
+
+    char first[6] {};
+    char second[16] {};
+    Array<iovec, 2> in_vecs {
+        iovec { first, 6 },
+        iovec { second, sizeof(second) },
+    };
+    // Only 13 bytes are there to be read, so the second buffer is filled partially.
+    EXPECT_EQ(preadv(fd, in_vecs.data(), in_vecs.size(), 100), 13);
+    EXPECT_EQ(StringView(first, 6), "head-a"sv);
+    EXPECT_EQ(StringView(second, 7), "nd-tail"sv);
+    EXPECT_EQ(MUST(Core::System::lseek(fd, 0, SEEK_CUR)), 0);
+
+    // The gap before the written data reads back as zeroes.
+    EXPECT_EQ(preadv(fd, in_vecs.data(), 1, 0), 6);
+    EXPECT_EQ(first[0], 0);
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(gathered_vectored_transfers)
+{
+    char pattern[] = "/tmp/positional_io.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, sizeof(pattern) - 1 }));
+
+    // Bigger than a page but small enough to be staged in one kernel buffer, and split at
+    // offsets that don't line up with blocks.
+    static constexpr Array<size_t, 5> chunk_sizes { 100, 4096, 7000, 13, 12791 };
+    size_t total_size = 0;
+    for (auto chunk_size : chunk_sizes)
+        total_size += chunk_size;
+    EXPECT_EQ(total_size, 24000u);
+
+    auto out_data = MUST(ByteBuffer::create_uninitialized(total_size));
+    for (size_t i = 0; i < out_data.size(); ++i)
+        out_data[i] = static_cast<u8>(i * 13);
+    Array<iovec, chunk_sizes.size()> vecs;
+    for (size_t i = 0, offset = 0; i < vecs.size(); offset += chunk_sizes[i++])
+        vecs[i] = { out_data.data() + offset, chunk_sizes[i] };
+    EXPECT_EQ(pwritev(fd, vecs.data(), vecs.size(), 1000), static_cast<ssize_t>(total_size));
+    EXPECT_EQ(MUST(Core::System::lseek(fd, 0, SEEK_CUR)), 0);
+
+    // Read it back in one go, so the result doesn't depend on how the write was split up.
+    auto whole = MUST(ByteBuffer::create_zeroed(total_size));
+    EXPECT_EQ(pread(fd, whole.data(), whole.size(), 1000), static_cast<ssize_t>(total_size));
+    EXPECT_EQ(whole, out_data);
+
+    // And the other way around, scattered into differently sized buffers.
+    static constexpr Array<size_t, 3> read_sizes { 5000, 9000, 10000 };
+    auto in_data = MUST(ByteBuffer::create_zeroed(total_size));
+    Array<iovec, read_sizes.size()> read_vecs;
+    for (size_t i = 0, offset = 0; i < read_vecs.size(); offset += read_sizes[i++])
+        read_vecs[i] = { in_data.data() + offset, read_sizes[i] };
+    EXPECT_EQ(preadv(fd, read_vecs.data(), read_vecs.size(), 1000), static_cast<ssize_t>(total_size));
+    EXPECT_EQ(in_data, out_data);
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(large_vectored_transfers)
+{
+    char pattern[] = "/tmp/positional_io.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, sizeof(pattern) - 1 }));
+
+    // More than gets staged in one kernel buffer, so each iovec goes to the file on its own.
+    static constexpr size_t chunk_size = 48 * KiB;
+    auto out_data = MUST(ByteBuffer::create_uninitialized(3 * chunk_size));
+    for (size_t i = 0; i < out_data.size(); ++i)
+        out_data[i] = static_cast<u8>(i * 7);
+    Array<iovec, 3> vecs;
+    for (size_t i = 0; i < vecs.size(); ++i)
+        vecs[i] = { out_data.data() + i * chunk_size, chunk_size };
+    EXPECT_EQ(pwritev(fd, vecs.data(), vecs.size(), 4096), static_cast<ssize_t>(out_data.size()));
+
+    auto in_data = MUST(ByteBuffer::create_zeroed(out_data.size()));
+    for (size_t i = 0; i < vecs.size(); ++i)
+        vecs[i] = { in_data.data() + i * chunk_size, chunk_size };
+    EXPECT_EQ(preadv(fd, vecs.data(), vecs.size(), 4096), static_cast<ssize_t>(in_data.size()));
+    EXPECT_EQ(in_data, out_data);
+
+    MUST(Core::System::close(fd));
+}
+
+TEST_CASE(preadv_rejects_bad_arguments)
+{
+    char pattern[] = "/tmp/positional_io.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::unlink({ pattern, sizeof(pattern) - 1 }));
+    char buffer[4];
+    iovec vec { buffer, sizeof(buffer) };
+
+    EXPECT_EQ(preadv(fd, &vec, -1, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    EXPECT_EQ(preadv(fd, &vec, 1, -1), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(preadv(pipe_fds[0], &vec, 1, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+    MUST(Core::System::close(pipe_fds[0]));
+    MUST(Core::System::close(pipe_fds[1]));
+
+    MUST(Core::System::close(fd));
+}
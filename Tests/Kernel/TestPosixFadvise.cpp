@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+TEST_CASE(posix_fadvise_basics)
+{
+    char pattern[] = "/tmp/posix_fadvise.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    VERIFY(fd >= 0);
+
+    Array<u8, 8192> data;
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<u8>(i);
+    EXPECT_EQ(MUST(Core::System::write(fd, data.span())), static_cast<ssize_t>(data.size()));
+
+    // All valid hints are accepted.
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_NORMAL), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 4096, POSIX_FADV_WILLNEED), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_NOREUSE), 0);
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL), 0);
+
+    // Hints past the end of the file are harmless.
+    EXPECT_EQ(posix_fadvise(fd, static_cast<off_t>(1 * MiB), 4096, POSIX_FADV_WILLNEED), 0);
+
+    // Hints must not change what we read back.
+    MUST(Core::System::lseek(fd, 0, SEEK_SET));
+    Array<u8, 8192> read_back;
+    EXPECT_EQ(MUST(Core::System::read(fd, read_back.span())), static_cast<ssize_t>(read_back.size()));
+    EXPECT(read_back == data);
+
+    // Invalid advice
+    EXPECT_EQ(posix_fadvise(fd, 0, 0, 1234), EINVAL);
+
+    // Invalid length (-1)
+    EXPECT_EQ(posix_fadvise(fd, 0, -1, POSIX_FADV_NORMAL), EINVAL);
+
+    // Invalid offset (-1)
+    EXPECT_EQ(posix_fadvise(fd, -1, 0, POSIX_FADV_NORMAL), EINVAL);
+
+    // Invalid fd (-1)
+    EXPECT_EQ(posix_fadvise(-1, 0, 0, POSIX_FADV_NORMAL), EBADF);
+
+    MUST(Core::System::close(fd));
+    MUST(Core::System::unlink({ pattern, strlen(pattern) }));
+}
+
+TEST_CASE(posix_fadvise_on_pipe)
+{
+    auto pipefds = MUST(Core::System::pipe2(0));
+    EXPECT_EQ(posix_fadvise(pipefds[0], 0, 0, POSIX_FADV_SEQUENTIAL), ESPIPE);
+    MUST(Core::System::close(pipefds[0]));
+    MUST(Core::System::close(pipefds[1]));
+}
+
+TEST_CASE(madvise_willneed_on_part_of_a_mapping)
+{
+    char pattern[] = "/tmp/madvise_willneed.XXXXXX";
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    MUST(Core::System::ftruncate(fd, 4 * PAGE_SIZE));
+
+    auto* mapping = static_cast<u8*>(MUST(Core::System::mmap(nullptr, 4 * PAGE_SIZE, PROT_READ, MAP_SHARED, fd, 0)));
+    // Prefetching doesn't need to cover a whole mapping, and lengths don't need to be page-sized.
+    EXPECT_EQ(madvise(mapping + PAGE_SIZE, PAGE_SIZE + 100, MADV_WILLNEED), 0);
+    EXPECT_EQ(mapping[PAGE_SIZE], 0);
+
+    MUST(Core::System::munmap(mapping, 4 * PAGE_SIZE));
+    MUST(Core::System::close(fd));
+    MUST(Core::System::unlink({ pattern, strlen(pattern) }));
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/sendfile.h>
+
+static int create_file_with_pattern(Span<char> pattern, Span<u8 const> data)
+{
+    auto fd = MUST(Core::System::mkstemp(pattern));
+    EXPECT_EQ(MUST(Core::System::write(fd, data)), static_cast<ssize_t>(data.size()));
+    MUST(Core::System::lseek(fd, 0, SEEK_SET));
+    return fd;
+}
+
+TEST_CASE(sendfile_file_to_file)
+{
+    Array<u8, 100000> data;
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<u8>(i * 7);
+
+    char in_pattern[] = "/tmp/sendfile_in.XXXXXX";
+    auto in_fd = create_file_with_pattern(in_pattern, data.span());
+    char out_pattern[] = "/tmp/sendfile_out.XXXXXX";
+    auto out_fd = MUST(Core::System::mkstemp(out_pattern));
+
+    // Without an offset, the offset of the input file is used and advanced.
+    EXPECT_EQ(sendfile(out_fd, in_fd, nullptr, 1000), 1000);
+    EXPECT_EQ(MUST(Core::System::lseek(in_fd, 0, SEEK_CUR)), 1000);
+    EXPECT_EQ(sendfile(out_fd, in_fd, nullptr, data.size()), static_cast<ssize_t>(data.size() - 1000));
+    EXPECT_EQ(sendfile(out_fd, in_fd, nullptr, data.size()), 0);
+
+    MUST(Core::System::lseek(out_fd, 0, SEEK_SET));
+    Array<u8, 100000> read_back;
+    EXPECT_EQ(MUST(Core::System::read(out_fd, read_back.span())), static_cast<ssize_t>(read_back.size()));
+    EXPECT(read_back == data);
+
+    // With an offset, the offset of the input file stays where it is.
+    MUST(Core::System::lseek(in_fd, 0, SEEK_SET));
+    MUST(Core::System::lseek(out_fd, 0, SEEK_SET));
+    off_t offset = 100;
+    EXPECT_EQ(sendfile(out_fd, in_fd, &offset, 50), 50);
+    EXPECT_EQ(offset, 150);
+    EXPECT_EQ(MUST(Core::System::lseek(in_fd, 0, SEEK_CUR)), 0);
+    MUST(Core::System::lseek(out_fd, 0, SEEK_SET));
+    EXPECT_EQ(MUST(Core::System::read(out_fd, read_back.span().trim(50))), 50);
+    EXPECT_EQ(memcmp(read_back.data(), data.data() + 100, 50), 0);
+
+    MUST(Core::System::close(in_fd));
+    MUST(Core::System::close(out_fd));
+    MUST(Core::System::unlink({ in_pattern, strlen(in_pattern) }));
+    MUST(Core::System::unlink({ out_pattern, strlen(out_pattern) }));
+}
+
+TEST_CASE(sendfile_file_to_pipe)
+{
+    Array<u8, 1000> data;
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<u8>(i);
+
+    char in_pattern[] = "/tmp/sendfile_in.XXXXXX";
+    auto in_fd = create_file_with_pattern(in_pattern, data.span());
+    auto pipe_fds = MUST(Core::System::pipe2(0));
+
+    EXPECT_EQ(sendfile(pipe_fds[1], in_fd, nullptr, data.size()), static_cast<ssize_t>(data.size()));
+    Array<u8, 1000> read_back;
+    EXPECT_EQ(MUST(Core::System::read(pipe_fds[0], read_back.span())), static_cast<ssize_t>(read_back.size()));
+    EXPECT(read_back == data);
+
+    // Only regular files can be sent from.
+    EXPECT_EQ(sendfile(in_fd, pipe_fds[0], nullptr, 1), -1);
+    EXPECT_EQ(errno, EINVAL);
+    // The output has to be writable.
+    EXPECT_EQ(sendfile(pipe_fds[0], in_fd, nullptr, 1), -1);
+    EXPECT_EQ(errno, EBADF);
+    off_t negative_offset = -1;
+    EXPECT_EQ(sendfile(pipe_fds[1], in_fd, &negative_offset, 1), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    MUST(Core::System::close(in_fd));
+    MUST(Core::System::close(pipe_fds[0]));
+    MUST(Core::System::close(pipe_fds[1]));
+    MUST(Core::System::unlink({ in_pattern, strlen(in_pattern) }));
+}
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/Vector.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int listen_on_loopback(sockaddr_in& address)
+{
+    auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+    address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    MUST(Core::System::bind(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    MUST(Core::System::listen(fd, 1));
+    socklen_t address_length = sizeof(address);
+    MUST(Core::System::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_length));
+    return fd;
+}
+
+// Sends `total_size` bytes counting up modulo 251 from a child process, and returns the connection to it.
+static int connect_to_sender(int listen_fd, sockaddr_in const& address, size_t total_size, pid_t& sender_pid)
+{
+    sender_pid = MUST(Core::System::fork());
+    if (sender_pid == 0) {
+        auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+        MUST(Core::System::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+        Array<u8, 16 * KiB> buffer;
+        for (size_t offset = 0; offset < total_size;) {
+            auto chunk_size = min(buffer.size(), total_size - offset);
+            for (size_t i = 0; i < chunk_size; ++i)
+                buffer[i] = static_cast<u8>((offset + i) % 251);
+            offset += MUST(Core::System::write(fd, buffer.span().trim(chunk_size)));
+        }
+        MUST(Core::System::close(fd));
+        _exit(0);
+    }
+    return MUST(Core::System::accept(listen_fd, nullptr, nullptr));
+}
+
+// Reads until the sender closes the connection, and returns how many bytes arrived intact.
+static size_t receive_pattern(int fd, useconds_t delay_between_reads = 0)
+{
+    Array<u8, 16 * KiB> buffer;
+    size_t offset = 0;
+    for (;;) {
+        size_t nread = MUST(Core::System::read(fd, buffer.span()));
+        if (nread == 0)
+            break;
+        for (size_t i = 0; i < nread; ++i) {
+            if (buffer[i] != static_cast<u8>((offset + i) % 251))
+                return offset + i;
+        }
+        offset += nread;
+        if (delay_between_reads)
+            usleep(delay_between_reads);
+    }
+    return offset;
+}
+
+TEST_CASE(tcp_bulk_transfer_over_loopback)
+{
+    // Much more than fits into a window without window scaling.
+    static constexpr size_t total_size = 8 * MiB;
+
+    sockaddr_in address;
+    auto listen_fd = listen_on_loopback(address);
+    pid_t sender_pid;
+    auto fd = connect_to_sender(listen_fd, address, total_size, sender_pid);
+
+    EXPECT_EQ(receive_pattern(fd), total_size);
+
+    MUST(Core::System::waitpid(sender_pid, 0));
+    MUST(Core::System::close(fd));
+    MUST(Core::System::close(listen_fd));
+}
+
+TEST_CASE(tcp_slow_reader)
+{
+    // The receive buffer fills up, so the sender has to wait for the window to open up again.
+    static constexpr size_t total_size = 1 * MiB;
+
+    sockaddr_in address;
+    auto listen_fd = listen_on_loopback(address);
+    pid_t sender_pid;
+    auto fd = connect_to_sender(listen_fd, address, total_size, sender_pid);
+
+    EXPECT_EQ(receive_pattern(fd, 2'000), total_size);
+
+    MUST(Core::System::waitpid(sender_pid, 0));
+    MUST(Core::System::close(fd));
+    MUST(Core::System::close(listen_fd));
+}
+
+static int listen_with_reuse_port(sockaddr_in& address, int backlog)
+{
+    auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+    int enable = 1;
+    MUST(Core::System::setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    MUST(Core::System::bind(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    MUST(Core::System::listen(fd, backlog));
+    socklen_t address_length = sizeof(address);
+    MUST(Core::System::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &address_length));
+    return fd;
+}
+
+TEST_CASE(tcp_reuse_port_spreads_connections)
+{
+    static constexpr size_t connection_count = 32;
+
+    sockaddr_in address {};
+    auto first_listen_fd = listen_with_reuse_port(address, connection_count);
+    auto second_listen_fd = listen_with_reuse_port(address, connection_count);
+
+    Vector<int> client_fds;
+    for (size_t i = 0; i < connection_count; ++i) {
+        auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+        MUST(Core::System::connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+        client_fds.append(fd);
+    }
+
+    // The handshake may not have finished on our end yet, so wait for the connections to show up.
+    Array<pollfd, 2> poll_fds { pollfd { first_listen_fd, POLLIN, 0 }, pollfd { second_listen_fd, POLLIN, 0 } };
+    Array<size_t, 2> accepted {};
+    for (size_t total_accepted = 0; total_accepted < connection_count;) {
+        VERIFY(::poll(poll_fds.data(), poll_fds.size(), -1) > 0);
+        for (size_t i = 0; i < poll_fds.size(); ++i) {
+            if (!(poll_fds[i].revents & POLLIN))
+                continue;
+            MUST(Core::System::close(MUST(Core::System::accept(poll_fds[i].fd, nullptr, nullptr))));
+            ++accepted[i];
+            ++total_accepted;
+        }
+    }
+    EXPECT(accepted[0] > 0);
+    EXPECT(accepted[1] > 0);
+
+    for (auto fd : client_fds)
+        MUST(Core::System::close(fd));
+    MUST(Core::System::close(first_listen_fd));
+    MUST(Core::System::close(second_listen_fd));
+}
+
+TEST_CASE(tcp_port_is_not_shared_without_reuse_port)
+{
+    sockaddr_in address;
+    auto listen_fd = listen_on_loopback(address);
+
+    auto fd = MUST(Core::System::socket(AF_INET, SOCK_STREAM, 0));
+    MUST(Core::System::bind(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    auto result = Core::System::listen(fd, 1);
+    EXPECT(result.is_error());
+    EXPECT_EQ(result.error().code(), EADDRINUSE);
+
+    MUST(Core::System::close(fd));
+    MUST(Core::System::close(listen_fd));
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <LibCore/System.h>
+#include <LibTest/TestCase.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static constexpr size_t batch_size = 16;
+static constexpr size_t datagram_size = 64;
+
+struct SocketPair {
+    int sender { -1 };
+    int receiver { -1 };
+};
+
+static SocketPair create_connected_udp_pair()
+{
+    int receiver = MUST(Core::System::socket(AF_INET, SOCK_DGRAM, 0));
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    MUST(Core::System::bind(receiver, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    socklen_t address_length = sizeof(address);
+    MUST(Core::System::getsockname(receiver, reinterpret_cast<sockaddr*>(&address), &address_length));
+
+    int sender = MUST(Core::System::socket(AF_INET, SOCK_DGRAM, 0));
+    MUST(Core::System::connect(sender, reinterpret_cast<sockaddr const*>(&address), sizeof(address)));
+    return { sender, receiver };
+}
+
+static void close_pair(SocketPair const& pair)
+{
+    MUST(Core::System::close(pair.sender));
+    MUST(Core::System::close(pair.receiver));
+}
+
+struct Batch {
+    Array<Array<u8, datagram_size>, batch_size> buffers;
+    Array<iovec, batch_size> iovs;
+    Array<mmsghdr, batch_size> messages;
+
+    Batch()
+    {
+        for (size_t i = 0; i < batch_size; ++i) {
+            iovs[i] = { buffers[i].data(), buffers[i].size() };
+            messages[i] = {};
+            messages[i].msg_hdr.msg_iov = &iovs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+};
+
+// Receives exactly `count` datagrams into the batch, since loopback delivery may split them across calls.
+static void receive_all(int fd, Batch& batch, size_t count)
+{
+    size_t received = 0;
+    while (received < count)
+        received += MUST(Core::System::recvmmsg(fd, batch.messages.data() + received, count - received, MSG_WAITFORONE, nullptr));
+}
+
+TEST_CASE(sendmmsg_and_recvmmsg_keep_datagrams_apart)
+{
+    auto pair = create_connected_udp_pair();
+
+    Batch outgoing;
+    for (size_t i = 0; i < batch_size; ++i) {
+        outgoing.buffers[i].fill(static_cast<u8>(i));
+        outgoing.iovs[i].iov_len = i + 1;
+    }
+    EXPECT_EQ(MUST(Core::System::sendmmsg(pair.sender, outgoing.messages.data(), batch_size, 0)), static_cast<int>(batch_size));
+    for (size_t i = 0; i < batch_size; ++i)
+        EXPECT_EQ(outgoing.messages[i].msg_len, i + 1);
+
+    Batch incoming;
+    receive_all(pair.receiver, incoming, batch_size);
+    for (size_t i = 0; i < batch_size; ++i) {
+        EXPECT_EQ(incoming.messages[i].msg_len, i + 1);
+        EXPECT_EQ(incoming.buffers[i][0], static_cast<u8>(i));
+        EXPECT_EQ(incoming.buffers[i][i], static_cast<u8>(i));
+    }
+
+    close_pair(pair);
+}
+
+TEST_CASE(recvmmsg_does_not_wait_on_an_empty_socket_with_dontwait)
+{
+    auto pair = create_connected_udp_pair();
+
+    Batch incoming;
+    auto result = Core::System::recvmmsg(pair.receiver, incoming.messages.data(), batch_size, MSG_DONTWAIT, nullptr);
+    EXPECT(result.is_error());
+    EXPECT_EQ(result.error().code(), EAGAIN);
+
+    close_pair(pair);
+}
+
+TEST_CASE(recvmmsg_reports_truncated_datagrams)
+{
+    auto pair = create_connected_udp_pair();
+
+    Array<u8, datagram_size> datagram {};
+    MUST(Core::System::send(pair.sender, datagram.data(), datagram.size(), 0));
+
+    Batch incoming;
+    incoming.iovs[0].iov_len = datagram_size / 2;
+    receive_all(pair.receiver, incoming, 1);
+    EXPECT(incoming.messages[0].msg_hdr.msg_flags & MSG_TRUNC);
+
+    close_pair(pair);
+}
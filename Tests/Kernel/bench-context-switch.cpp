@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Format.h>
+#include <AK/Vector.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/ElapsedTimer.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+// Measures how many context switches per second the scheduler sustains as the
+// number of concurrently ping-ponging thread pairs grows. Every pair bounces a
+// byte back and forth over two pipes, so each round trip forces (at least) two
+// context switches. With per-processor run queues the aggregate throughput
+// should grow with the number of pairs until we run out of processors.
+
+struct PingPongPair {
+    int ping[2] { -1, -1 };
+    int pong[2] { -1, -1 };
+    int round_trips { 0 };
+    pthread_t ping_thread {};
+    pthread_t pong_thread {};
+};
+
+static void* ping_main(void* arg)
+{
+    auto& pair = *static_cast<PingPongPair*>(arg);
+    char byte = 'x';
+    for (int i = 0; i < pair.round_trips; ++i) {
+        if (write(pair.ping[1], &byte, 1) != 1 || read(pair.pong[0], &byte, 1) != 1) {
+            perror("ping");
+            break;
+        }
+    }
+    return nullptr;
+}
+
+static void* pong_main(void* arg)
+{
+    auto& pair = *static_cast<PingPongPair*>(arg);
+    char byte;
+    for (int i = 0; i < pair.round_trips; ++i) {
+        if (read(pair.ping[0], &byte, 1) != 1 || write(pair.pong[1], &byte, 1) != 1) {
+            perror("pong");
+            break;
+        }
+    }
+    return nullptr;
+}
+
+static bool run_with_pairs(int pair_count, int round_trips)
+{
+    Vector<PingPongPair> pairs;
+    pairs.resize(pair_count);
+
+    for (auto& pair : pairs) {
+        pair.round_trips = round_trips;
+        if (pipe(pair.ping) < 0 || pipe(pair.pong) < 0) {
+            perror("pipe");
+            return false;
+        }
+    }
+
+    auto timer = Core::ElapsedTimer::start_new();
+    for (auto& pair : pairs) {
+        if (int rc = pthread_create(&pair.pong_thread, nullptr, pong_main, &pair); rc != 0) {
+            fprintf(stderr, "pthread_create: %s\n", strerror(rc));
+            return false;
+        }
+        if (int rc = pthread_create(&pair.ping_thread, nullptr, ping_main, &pair); rc != 0) {
+            fprintf(stderr, "pthread_create: %s\n", strerror(rc));
+            return false;
+        }
+    }
+    for (auto& pair : pairs) {
+        pthread_join(pair.ping_thread, nullptr);
+        pthread_join(pair.pong_thread, nullptr);
+    }
+    auto elapsed_ms = max(timer.elapsed(), 1);
+
+    for (auto& pair : pairs) {
+        close(pair.ping[0]);
+        close(pair.ping[1]);
+        close(pair.pong[0]);
+        close(pair.pong[1]);
+    }
+
+    u64 switches = 2ull * pair_count * round_trips;
+    outln("{:3} pair(s): {:8} context switches in {:6} ms, {:8} switches/s",
+        pair_count, switches, elapsed_ms, switches * 1000 / elapsed_ms);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int max_pairs = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    int round_trips = 100000;
+
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Measure context switch throughput for a growing number of thread pairs.");
+    args_parser.add_option(max_pairs, "Maximum number of ping-pong thread pairs (default: number of processors)", "pairs", 'p', "number");
+    args_parser.add_option(round_trips, "Number of round trips per pair", "round-trips", 'n', "number");
+    args_parser.parse(argc, argv);
+
+    if (max_pairs < 1 || round_trips < 1) {
+        fprintf(stderr, "Both the number of pairs and round trips must be positive\n");
+        return 1;
+    }
+
+    for (int pair_count = 1;; pair_count = min(pair_count * 2, max_pairs)) {
+        if (!run_with_pairs(pair_count, round_trips))
+            return 1;
+        if (pair_count == max_pairs)
+            break;
+    }
+    return 0;
+}
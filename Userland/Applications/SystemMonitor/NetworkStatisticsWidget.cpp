@@ -111,6 +111,11 @@ NetworkStatisticsWidget::NetworkStatisticsWidget()
         net_tcp_fields.empend("packets_out", "Pkt Out", Gfx::TextAlignment::CenterRight);
         net_tcp_fields.empend("bytes_in", "Bytes In", Gfx::TextAlignment::CenterRight);
         net_tcp_fields.empend("bytes_out", "Bytes Out", Gfx::TextAlignment::CenterRight);
+        net_tcp_fields.empend("packets_retransmitted", "Retrans", Gfx::TextAlignment::CenterRight);
+        net_tcp_fields.empend("receive_queue_size", "Recv-Q", Gfx::TextAlignment::CenterRight);
+        net_tcp_fields.empend("send_queue_size", "Send-Q", Gfx::TextAlignment::CenterRight);
+        net_tcp_fields.empend("congestion_window", "Cwnd", Gfx::TextAlignment::CenterRight);
+        net_tcp_fields.empend("smoothed_rtt_us", "RTT (µs)", Gfx::TextAlignment::CenterRight);
         m_tcp_socket_model = GUI::JsonArrayModel::create("/sys/kernel/net/tcp", move(net_tcp_fields));
         m_tcp_socket_table_view->set_model(MUST(GUI::SortingProxyModel::create(*m_tcp_socket_model)));
 
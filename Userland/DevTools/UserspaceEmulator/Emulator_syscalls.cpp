@@ -18,6 +18,7 @@
 #include <sched.h>
 #include <serenity.h>
 #include <strings.h>
+#include <sys/epoll.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/poll.h>
@@ -78,6 +79,12 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
         return virt$dup2(arg1, arg2);
     case SC_emuctl:
         return virt$emuctl(arg1, arg2, arg3);
+    case SC_epoll_create:
+        return virt$epoll_create(arg1);
+    case SC_epoll_ctl:
+        return virt$epoll_ctl(arg1);
+    case SC_epoll_wait:
+        return virt$epoll_wait(arg1);
     case SC_execve:
         return virt$execve(arg1);
     case SC_exit:
@@ -1644,6 +1651,51 @@ int Emulator::virt$futex(FlatPtr params_addr)
     return 0;
 }
 
+int Emulator::virt$epoll_create(int flags)
+{
+    int rc = epoll_create1(flags);
+    if (rc < 0)
+        return -errno;
+    return rc;
+}
+
+int Emulator::virt$epoll_ctl(FlatPtr params_addr)
+{
+    Syscall::SC_epoll_ctl_params params;
+    mmu().copy_from_vm(&params, params_addr, sizeof(params));
+
+    epoll_event event {};
+    if (params.event)
+        mmu().copy_from_vm(&event, (FlatPtr)params.event, sizeof(event));
+
+    int rc = epoll_ctl(params.epoll_fd, params.op, params.fd, params.event ? &event : nullptr);
+    if (rc < 0)
+        return -errno;
+    return rc;
+}
+
+int Emulator::virt$epoll_wait(FlatPtr params_addr)
+{
+    Syscall::SC_epoll_wait_params params;
+    mmu().copy_from_vm(&params, params_addr, sizeof(params));
+
+    if (params.max_events <= 0)
+        return -EINVAL;
+
+    Vector<epoll_event> events;
+    events.resize(params.max_events);
+    u32 sigmask;
+    if (params.sigmask)
+        mmu().copy_from_vm(&sigmask, (FlatPtr)params.sigmask, sizeof(sigmask));
+
+    int rc = epoll_pwait(params.epoll_fd, events.data(), params.max_events, params.timeout_ms, params.sigmask ? &sigmask : nullptr);
+    if (rc < 0)
+        return -errno;
+
+    mmu().copy_to_vm((FlatPtr)params.events, events.data(), sizeof(epoll_event) * rc);
+    return rc;
+}
+
 int Emulator::virt$poll(FlatPtr params_addr)
 {
     Syscall::SC_poll_params params;
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <bits/pthread_cancel.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <syscall.h>
+
+extern "C" {
+
+int epoll_create(int size)
+{
+    // The size is only a hint from the days when the interest set had a fixed size, but it must still be positive.
+    if (size <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    return epoll_create1(0);
+}
+
+int epoll_create1(int flags)
+{
+    int rc = syscall(SC_epoll_create, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int epoll_ctl(int epfd, int op, int fd, epoll_event* event)
+{
+    Syscall::SC_epoll_ctl_params params { epfd, op, fd, event };
+    int rc = syscall(SC_epoll_ctl, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int epoll_wait(int epfd, epoll_event* events, int max_events, int timeout)
+{
+    return epoll_pwait(epfd, events, max_events, timeout, nullptr);
+}
+
+int epoll_pwait(int epfd, epoll_event* events, int max_events, int timeout, sigset_t const* sigmask)
+{
+    __pthread_maybe_cancel();
+
+    Syscall::SC_epoll_wait_params params { epfd, events, max_events, timeout, sigmask };
+    int rc = syscall(SC_epoll_wait, &params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+}
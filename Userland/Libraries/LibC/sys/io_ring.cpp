@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <bits/pthread_cancel.h>
+#include <errno.h>
+#include <sys/io_ring.h>
+#include <syscall.h>
+
+extern "C" {
+
+int io_ring_setup(io_ring_params* params)
+{
+    int rc = syscall(SC_io_ring_setup, params);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+int io_ring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    if (flags & IO_RING_ENTER_GETEVENTS)
+        __pthread_maybe_cancel();
+
+    int rc = syscall(SC_io_ring_enter, ring_fd, to_submit, min_complete, flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+}
@@ -71,6 +71,14 @@ struct FBFlushRects {
     struct FBRect const* rects;
 };
 
+// Where to find data in the memory of an mmap()'ed local socket.
+// LOCAL_SOCKET_RING_CONSUME and LOCAL_SOCKET_RING_COMMIT hand over `size` bytes that were taken out of,
+// or put into, the socket in place, and fill in the next part of the mapping that can be read or written.
+struct LocalSocketRingSpan {
+    unsigned long offset;
+    unsigned long size;
+};
+
 enum ConsoleModes {
     KD_TEXT = 0x00,
     KD_GRAPHICS = 0x01,
@@ -138,6 +146,9 @@ enum IOCtlNumber {
     VIRGL_IOCTL_TRANSFER_DATA,
     KDSETMODE,
     KDGETMODE,
+    LOCAL_SOCKET_RING_GET_MAPPING_SIZE,
+    LOCAL_SOCKET_RING_CONSUME,
+    LOCAL_SOCKET_RING_COMMIT,
 };
 
 #define TIOCGPGRP TIOCGPGRP
@@ -194,3 +205,6 @@ enum IOCtlNumber {
 #define VIRGL_IOCTL_TRANSFER_DATA VIRGL_IOCTL_TRANSFER_DATA
 #define KDSETMODE KDSETMODE
 #define KDGETMODE KDGETMODE
+#define LOCAL_SOCKET_RING_GET_MAPPING_SIZE LOCAL_SOCKET_RING_GET_MAPPING_SIZE
+#define LOCAL_SOCKET_RING_CONSUME LOCAL_SOCKET_RING_CONSUME
+#define LOCAL_SOCKET_RING_COMMIT LOCAL_SOCKET_RING_COMMIT
@@ -26,4 +26,20 @@ ssize_t readv(int fd, const struct iovec* iov, int iov_count)
     int rc = syscall(SC_readv, fd, iov, iov_count);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
+
+ssize_t pwritev(int fd, const struct iovec* iov, int iov_count, off_t offset)
+{
+    __pthread_maybe_cancel();
+
+    int rc = syscall(SC_pwritev, fd, iov, iov_count, &offset);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
+ssize_t preadv(int fd, const struct iovec* iov, int iov_count, off_t offset)
+{
+    __pthread_maybe_cancel();
+
+    int rc = syscall(SC_preadv, fd, iov, iov_count, &offset);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
 }
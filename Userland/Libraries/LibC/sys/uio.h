@@ -13,5 +13,7 @@ __BEGIN_DECLS
 
 ssize_t writev(int fd, const struct iovec*, int iov_count);
 ssize_t readv(int fd, const struct iovec*, int iov_count);
+ssize_t pwritev(int fd, const struct iovec*, int iov_count, off_t);
+ssize_t preadv(int fd, const struct iovec*, int iov_count, off_t);
 
 __END_DECLS
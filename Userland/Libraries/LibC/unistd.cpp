@@ -409,12 +409,8 @@ ssize_t pwrite(int fd, void const* buf, size_t count, off_t offset)
 {
     __pthread_maybe_cancel();
 
-    // FIXME: This is not thread safe and should be implemented in the kernel instead.
-    off_t old_offset = lseek(fd, 0, SEEK_CUR);
-    lseek(fd, offset, SEEK_SET);
-    ssize_t nwritten = write(fd, buf, count);
-    lseek(fd, old_offset, SEEK_SET);
-    return nwritten;
+    int rc = syscall(SC_pwrite, fd, buf, count, &offset);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
 // Note: Be sure to send to directory_name parameter a directory name ended with trailing slash.
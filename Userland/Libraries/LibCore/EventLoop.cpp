@@ -14,6 +14,7 @@
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
 #include <AK/NeverDestroyed.h>
+#include <AK/NumericLimits.h>
 #include <AK/Singleton.h>
 #include <AK/TemporaryChange.h>
 #include <AK/Time.h>
@@ -38,6 +39,7 @@
 
 #ifdef AK_OS_SERENITY
 #    include <LibCore/Account.h>
+#    include <sys/epoll.h>
 
 extern bool s_global_initializers_ran;
 #endif
@@ -74,6 +76,59 @@ static thread_local HashTable<Notifier*>* s_notifiers;
 thread_local int EventLoop::s_wake_pipe_fds[2];
 thread_local bool EventLoop::s_wake_pipe_initialized { false };
 
+#ifdef AK_OS_SERENITY
+// On Serenity the notifiers live in an epoll interest set, so that waiting doesn't have to
+// hand every single one of them to the kernel (and have it look at all of them) again.
+static constexpr size_t max_epoll_events_per_wait = 64;
+static thread_local int s_epoll_fd { -1 };
+static thread_local HashMap<int, Vector<Notifier*, 1>>* s_notifiers_by_fd;
+
+static void initialize_epoll(int wake_pipe_read_fd)
+{
+    s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    VERIFY(s_epoll_fd >= 0);
+
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = wake_pipe_read_fd;
+    int rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, wake_pipe_read_fd, &event);
+    VERIFY(rc == 0);
+}
+
+static void update_epoll_interest(int fd)
+{
+    u32 events = 0;
+    if (auto it = s_notifiers_by_fd->find(fd); it != s_notifiers_by_fd->end()) {
+        for (auto* notifier : it->value) {
+            if (notifier->event_mask() & Notifier::Read)
+                events |= EPOLLIN;
+            if (notifier->event_mask() & Notifier::Write)
+                events |= EPOLLOUT;
+            if (notifier->event_mask() & Notifier::Exceptional)
+                VERIFY_NOT_REACHED();
+        }
+    }
+
+    if (events == 0) {
+        // If the fd has been closed already, it's gone from the interest set anyway.
+        (void)epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
+
+    // Note: The interest set watches descriptions, not fd numbers. If the fd has been closed and reused since
+    //       we last got here, adding it watches the description it refers to now, and only if that one is
+    //       watched already do we update its events instead.
+    epoll_event event {};
+    event.events = events;
+    event.data.fd = fd;
+    int rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    if (rc < 0 && errno == EEXIST)
+        rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    if (rc < 0)
+        dbgln("Core::EventLoop: Failed to watch fd {}: {}", fd, strerror(errno));
+}
+#endif
+
 void EventLoop::initialize_wake_pipes()
 {
     if (!s_wake_pipe_initialized) {
@@ -328,6 +383,9 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
         s_event_loop_stack = new Vector<EventLoop&>;
         s_timers = new HashMap<int, NonnullOwnPtr<EventLoopTimer>>;
         s_notifiers = new HashTable<Notifier*>;
+#ifdef AK_OS_SERENITY
+        s_notifiers_by_fd = new HashMap<int, Vector<Notifier*, 1>>;
+#endif
     }
 
     if (s_event_loop_stack->is_empty()) {
@@ -349,6 +407,10 @@ EventLoop::EventLoop([[maybe_unused]] MakeInspectable make_inspectable)
     }
 
     initialize_wake_pipes();
+#ifdef AK_OS_SERENITY
+    if (s_epoll_fd < 0)
+        initialize_epoll(s_wake_pipe_fds[0]);
+#endif
 
     dbgln_if(EVENTLOOP_DEBUG, "{} Core::EventLoop constructed :)", getpid());
 }
@@ -665,6 +727,12 @@ void EventLoop::notify_forked(ForkEvent event)
         s_notifiers->clear();
         s_wake_pipe_initialized = false;
         initialize_wake_pipes();
+#ifdef AK_OS_SERENITY
+        // The interest set is shared with the parent, so we need one of our own.
+        s_notifiers_by_fd->clear();
+        close(s_epoll_fd);
+        initialize_epoll(s_wake_pipe_fds[0]);
+#endif
         if (auto* info = signals_info<false>()) {
             info->signal_handlers.clear();
             info->next_signal_id = 0;
@@ -678,6 +746,10 @@ void EventLoop::notify_forked(ForkEvent event)
 
 void EventLoop::wait_for_event(WaitMode mode)
 {
+#ifdef AK_OS_SERENITY
+    epoll_event ready_events[max_epoll_events_per_wait];
+retry:
+#else
     fd_set rfds;
     fd_set wfds;
 retry:
@@ -703,6 +775,7 @@ retry:
         if (notifier->event_mask() & Notifier::Exceptional)
             VERIFY_NOT_REACHED();
     }
+#endif
 
     bool queued_events_is_empty;
     {
@@ -727,7 +800,21 @@ retry:
     }
 
 try_select_again:
+#ifdef AK_OS_SERENITY
+    // Round up, so we don't wake up just before the next timer expires and then have to wait again.
+    // A timeout that doesn't fit into an int is clamped, waking up early just means that we wait again.
+    int timeout_ms = -1;
+    if (!should_wait_forever) {
+        constexpr time_t max_timeout_seconds = NumericLimits<int>::max() / 1000 - 1;
+        if (timeout.tv_sec >= max_timeout_seconds)
+            timeout_ms = max_timeout_seconds * 1000;
+        else
+            timeout_ms = timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000;
+    }
+    int marked_fd_count = epoll_wait(s_epoll_fd, ready_events, max_epoll_events_per_wait, timeout_ms);
+#else
     int marked_fd_count = select(max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
+#endif
     if (marked_fd_count < 0) {
         int saved_errno = errno;
         if (saved_errno == EINTR) {
@@ -738,7 +825,16 @@ try_select_again:
         dbgln("Core::EventLoop::wait_for_event: {} ({}: {})", marked_fd_count, saved_errno, strerror(saved_errno));
         VERIFY_NOT_REACHED();
     }
-    if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
+#ifdef AK_OS_SERENITY
+    bool wake_pipe_is_readable = false;
+    for (int i = 0; i < marked_fd_count; ++i) {
+        if (ready_events[i].data.fd == s_wake_pipe_fds[0])
+            wake_pipe_is_readable = true;
+    }
+#else
+    bool wake_pipe_is_readable = FD_ISSET(s_wake_pipe_fds[0], &rfds);
+#endif
+    if (wake_pipe_is_readable) {
         int wake_events[8];
         ssize_t nread;
         // We might receive another signal while read()ing here. The signal will go to the handle_signal properly,
@@ -796,6 +892,20 @@ try_select_again:
     if (!marked_fd_count)
         return;
 
+#ifdef AK_OS_SERENITY
+    for (int i = 0; i < marked_fd_count; ++i) {
+        auto& ready_event = ready_events[i];
+        auto it = s_notifiers_by_fd->find(ready_event.data.fd);
+        if (it == s_notifiers_by_fd->end())
+            continue;
+        for (auto* notifier : it->value) {
+            if ((ready_event.events & EPOLLIN) && (notifier->event_mask() & Notifier::Event::Read))
+                post_event(*notifier, make<NotifierReadEvent>(notifier->fd()));
+            if ((ready_event.events & EPOLLOUT) && (notifier->event_mask() & Notifier::Event::Write))
+                post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
+        }
+    }
+#else
     for (auto& notifier : *s_notifiers) {
         if (FD_ISSET(notifier->fd(), &rfds)) {
             if (notifier->event_mask() & Notifier::Event::Read)
@@ -806,6 +916,7 @@ try_select_again:
                 post_event(*notifier, make<NotifierWriteEvent>(notifier->fd()));
         }
     }
+#endif
 }
 
 bool EventLoopTimer::has_expired(Time const& now) const
@@ -870,12 +981,35 @@ void EventLoop::register_notifier(Badge<Notifier>, Notifier& notifier)
 {
     VERIFY_EVENT_LOOP_INITIALIZED();
     s_notifiers->set(&notifier);
+#ifdef AK_OS_SERENITY
+    auto& notifiers = s_notifiers_by_fd->ensure(notifier.fd());
+    if (!notifiers.contains_slow(&notifier))
+        notifiers.append(&notifier);
+    update_epoll_interest(notifier.fd());
+#endif
 }
 
 void EventLoop::unregister_notifier(Badge<Notifier>, Notifier& notifier)
 {
     VERIFY_EVENT_LOOP_INITIALIZED();
     s_notifiers->remove(&notifier);
+#ifdef AK_OS_SERENITY
+    if (auto it = s_notifiers_by_fd->find(notifier.fd()); it != s_notifiers_by_fd->end()) {
+        it->value.remove_first_matching([&](auto* other) { return other == &notifier; });
+        if (it->value.is_empty())
+            s_notifiers_by_fd->remove(it);
+    }
+    update_epoll_interest(notifier.fd());
+#endif
+}
+
+void EventLoop::notifier_event_mask_changed(Badge<Notifier>, [[maybe_unused]] Notifier& notifier)
+{
+    VERIFY_EVENT_LOOP_INITIALIZED();
+#ifdef AK_OS_SERENITY
+    if (s_notifiers->contains(&notifier))
+        update_epoll_interest(notifier.fd());
+#endif
 }
 
 void EventLoop::wake_current()
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <LibCore/IORing.h>
+#include <LibCore/System.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifdef AK_OS_SERENITY
+#    include <sys/io_ring.h>
+#endif
+
+namespace Core {
+
+ErrorOr<NonnullOwnPtr<IORing>> IORing::create(Options options)
+{
+#ifdef AK_OS_SERENITY
+    io_ring_params params {};
+    params.sq_entries = options.entries;
+    params.flags = IO_RING_SETUP_CLOEXEC;
+    if (options.submission_polling) {
+        params.flags |= IO_RING_SETUP_SQPOLL;
+        params.sq_thread_idle_ms = options.submission_poller_idle_ms;
+    }
+
+    int fd = io_ring_setup(&params);
+    if (fd < 0)
+        return Error::from_syscall("io_ring_setup"sv, -errno);
+
+    auto mapping_or_error = System::mmap(nullptr, params.mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0, 0, "IORing"sv);
+    if (mapping_or_error.is_error()) {
+        (void)System::close(fd);
+        return mapping_or_error.release_error();
+    }
+    return adopt_own(*new IORing(fd, params, static_cast<u8*>(mapping_or_error.value()), options.submission_polling));
+#else
+    (void)options;
+    return Error::from_errno(ENOTSUP);
+#endif
+}
+
+IORing::IORing(int fd, io_ring_params const& params, u8* mapping, bool has_submission_poller)
+    : m_fd(fd)
+    , m_mapping(mapping)
+    , m_mapping_size(params.mapping_size)
+    , m_header(reinterpret_cast<io_ring_header*>(mapping))
+    , m_sqes(reinterpret_cast<io_ring_sqe*>(mapping + params.sqes_offset))
+    , m_cqes(reinterpret_cast<io_ring_cqe*>(mapping + params.cqes_offset))
+    , m_sq_entries(params.sq_entries)
+    , m_cq_entries(params.cq_entries)
+    , m_has_submission_poller(has_submission_poller)
+{
+}
+
+IORing::~IORing()
+{
+    (void)System::munmap(m_mapping, m_mapping_size);
+    (void)System::close(m_fd);
+}
+
+io_ring_sqe* IORing::next_submission()
+{
+    auto head = AK::atomic_load(&m_header->sq_head, AK::memory_order_acquire);
+    if (m_sq_tail - head >= m_sq_entries)
+        return nullptr;
+    auto* sqe = &m_sqes[m_sq_tail & (m_sq_entries - 1)];
+    memset(sqe, 0, sizeof(*sqe));
+    ++m_sq_tail;
+    return sqe;
+}
+
+io_ring_sqe* IORing::enqueue(u8 opcode, int fd, u64 user_data)
+{
+    auto* sqe = next_submission();
+    if (!sqe)
+        return nullptr;
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->user_data = user_data;
+    return sqe;
+}
+
+bool IORing::enqueue_read(int fd, Bytes buffer, u64 user_data)
+{
+    auto* sqe = enqueue(IO_RING_OP_READ, fd, user_data);
+    if (!sqe)
+        return false;
+    sqe->addr = reinterpret_cast<FlatPtr>(buffer.data());
+    sqe->len = buffer.size();
+    return true;
+}
+
+bool IORing::enqueue_pread(int fd, Bytes buffer, u64 offset, u64 user_data)
+{
+    auto* sqe = enqueue(IO_RING_OP_PREAD, fd, user_data);
+    if (!sqe)
+        return false;
+    sqe->addr = reinterpret_cast<FlatPtr>(buffer.data());
+    sqe->len = buffer.size();
+    sqe->offset = offset;
+    return true;
+}
+
+bool IORing::enqueue_write(int fd, ReadonlyBytes buffer, u64 user_data)
+{
+    auto* sqe = enqueue(IO_RING_OP_WRITE, fd, user_data);
+    if (!sqe)
+        return false;
+    sqe->addr = reinterpret_cast<FlatPtr>(buffer.data());
+    sqe->len = buffer.size();
+    return true;
+}
+
+bool IORing::enqueue_pwrite(int fd, ReadonlyBytes buffer, u64 offset, u64 user_data)
+{
+    auto* sqe = enqueue(IO_RING_OP_PWRITE, fd, user_data);
+    if (!sqe)
+        return false;
+    sqe->addr = reinterpret_cast<FlatPtr>(buffer.data());
+    sqe->len = buffer.size();
+    sqe->offset = offset;
+    return true;
+}
+
+bool IORing::enqueue_fsync(int fd, u64 user_data)
+{
+    return enqueue(IO_RING_OP_FSYNC, fd, user_data) != nullptr;
+}
+
+bool IORing::enqueue_accept(int fd, int flags, u64 user_data)
+{
+    auto* sqe = enqueue(IO_RING_OP_ACCEPT, fd, user_data);
+    if (!sqe)
+        return false;
+    sqe->op_flags = flags;
+    return true;
+}
+
+bool IORing::enqueue_recv(int fd, Bytes buffer, int flags, u64 user_data)
+{
+    auto* sqe = enqueue(IO_RING_OP_RECV, fd, user_data);
+    if (!sqe)
+        return false;
+    sqe->addr = reinterpret_cast<FlatPtr>(buffer.data());
+    sqe->len = buffer.size();
+    sqe->op_flags = flags;
+    return true;
+}
+
+bool IORing::enqueue_send(int fd, ReadonlyBytes buffer, int flags, u64 user_data)
+{
+    auto* sqe = enqueue(IO_RING_OP_SEND, fd, user_data);
+    if (!sqe)
+        return false;
+    sqe->addr = reinterpret_cast<FlatPtr>(buffer.data());
+    sqe->len = buffer.size();
+    sqe->op_flags = flags;
+    return true;
+}
+
+bool IORing::enqueue_poll(int fd, short events, u64 user_data)
+{
+    auto* sqe = enqueue(IO_RING_OP_POLL, fd, user_data);
+    if (!sqe)
+        return false;
+    sqe->poll_events = events;
+    return true;
+}
+
+ErrorOr<size_t> IORing::submit([[maybe_unused]] size_t min_completions)
+{
+#ifdef AK_OS_SERENITY
+    AK::atomic_store(&m_header->sq_tail, m_sq_tail, AK::memory_order_release);
+    u32 to_submit = m_sq_tail - AK::atomic_load(&m_header->sq_head, AK::memory_order_acquire);
+
+    unsigned flags = 0;
+    if (min_completions > 0)
+        flags |= IO_RING_ENTER_GETEVENTS;
+    if (m_has_submission_poller) {
+        // The poller picks the entries up on its own, unless it has gone to sleep.
+        if (AK::atomic_load(&m_header->sq_flags, AK::memory_order_acquire) & IO_RING_SQ_NEED_WAKEUP)
+            flags |= IO_RING_ENTER_SQ_WAKEUP;
+        if (flags == 0)
+            return to_submit;
+    } else if (to_submit == 0 && flags == 0) {
+        return 0;
+    }
+
+    int rc = io_ring_enter(m_fd, to_submit, min_completions, flags);
+    if (rc < 0)
+        return Error::from_syscall("io_ring_enter"sv, -errno);
+    return static_cast<size_t>(rc);
+#else
+    return Error::from_errno(ENOTSUP);
+#endif
+}
+
+Optional<io_ring_cqe> IORing::next_completion()
+{
+    auto head = m_header->cq_head;
+    if (head == AK::atomic_load(&m_header->cq_tail, AK::memory_order_acquire))
+        return {};
+    auto completion = m_cqes[head & (m_cq_entries - 1)];
+    AK::atomic_store(&m_header->cq_head, head + 1, AK::memory_order_release);
+    return completion;
+}
+
+}
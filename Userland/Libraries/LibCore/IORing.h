@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2022, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Error.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <Kernel/API/POSIX/sys/io_ring.h>
+
+namespace Core {
+
+// A submission and completion ring shared with the kernel. Requests are queued with the enqueue_*()
+// functions (or by filling in next_submission() directly), handed to the kernel all at once with
+// submit(), and their results are picked up with next_completion(), in whatever order they finish.
+class IORing {
+    AK_MAKE_NONCOPYABLE(IORing);
+    AK_MAKE_NONMOVABLE(IORing);
+
+public:
+    struct Options {
+        u32 entries { 64 };
+        // Have a kernel thread pick up submissions, so that submitting usually doesn't need a syscall.
+        bool submission_polling { false };
+        u32 submission_poller_idle_ms { 0 };
+    };
+
+    static ErrorOr<NonnullOwnPtr<IORing>> create(Options);
+    static ErrorOr<NonnullOwnPtr<IORing>> create() { return create(Options {}); }
+    ~IORing();
+
+    int fd() const { return m_fd; }
+    u32 submission_queue_size() const { return m_sq_entries; }
+
+    // Returns a cleared entry to fill in, or nullptr if the submission queue is full.
+    io_ring_sqe* next_submission();
+
+    // These return false if the submission queue is full.
+    bool enqueue_read(int fd, Bytes, u64 user_data);
+    bool enqueue_pread(int fd, Bytes, u64 offset, u64 user_data);
+    bool enqueue_write(int fd, ReadonlyBytes, u64 user_data);
+    bool enqueue_pwrite(int fd, ReadonlyBytes, u64 offset, u64 user_data);
+    bool enqueue_fsync(int fd, u64 user_data);
+    bool enqueue_accept(int fd, int flags, u64 user_data);
+    bool enqueue_recv(int fd, Bytes, int flags, u64 user_data);
+    bool enqueue_send(int fd, ReadonlyBytes, int flags, u64 user_data);
+    bool enqueue_poll(int fd, short events, u64 user_data);
+
+    // Hands everything queued so far to the kernel, then waits until at least `min_completions`
+    // results are there to be picked up. Returns how many entries the kernel took.
+    ErrorOr<size_t> submit(size_t min_completions = 0);
+
+    Optional<io_ring_cqe> next_completion();
+
+private:
+    IORing(int fd, io_ring_params const&, u8* mapping, bool has_submission_poller);
+
+    io_ring_sqe* enqueue(u8 opcode, int fd, u64 user_data);
+
+    int m_fd { -1 };
+    u8* m_mapping { nullptr };
+    size_t m_mapping_size { 0 };
+    io_ring_header* m_header { nullptr };
+    io_ring_sqe* m_sqes { nullptr };
+    io_ring_cqe* m_cqes { nullptr };
+    u32 m_sq_entries { 0 };
+    u32 m_cq_entries { 0 };
+    bool m_has_submission_poller { false };
+    // Entries up to here have been filled in, but not necessarily handed to the kernel yet.
+    u32 m_sq_tail { 0 };
+};
+
+}
@@ -541,6 +541,13 @@ ErrorOr<NonnullOwnPtr<TCPSocket>> TCPSocket::adopt_fd(int fd)
     return socket;
 }
 
+Optional<int> TCPSocket::fd() const
+{
+    if (!is_open())
+        return {};
+    return m_helper.fd();
+}
+
 ErrorOr<size_t> PosixSocketHelper::pending_bytes() const
 {
     if (!is_open()) {
@@ -574,6 +581,82 @@ ErrorOr<NonnullOwnPtr<UDPSocket>> UDPSocket::connect(SocketAddress const& addres
     return socket;
 }
 
+ErrorOr<size_t> UDPSocket::read_datagrams(Span<Bytes> buffers)
+{
+    if (buffers.is_empty())
+        return 0;
+
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+    Vector<iovec> iovs;
+    Vector<mmsghdr> messages;
+    TRY(iovs.try_resize(buffers.size()));
+    TRY(messages.try_resize(buffers.size()));
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        iovs[i] = { buffers[i].data(), buffers[i].size() };
+        messages[i] = {};
+        messages[i].msg_hdr.msg_iov = &iovs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t datagram_count = TRY(System::recvmmsg(m_helper.fd(), messages.data(), messages.size(), MSG_WAITFORONE, nullptr));
+    for (size_t i = 0; i < datagram_count; ++i)
+        buffers[i] = buffers[i].trim(messages[i].msg_len);
+    return datagram_count;
+#else
+    size_t datagram_count = 0;
+    for (; datagram_count < buffers.size(); ++datagram_count) {
+        auto& buffer = buffers[datagram_count];
+        auto received_or_error = System::recv(m_helper.fd(), buffer.data(), buffer.size(), datagram_count == 0 ? 0 : MSG_DONTWAIT);
+        if (received_or_error.is_error()) {
+            if (datagram_count == 0)
+                return received_or_error.release_error();
+            break;
+        }
+        buffer = buffer.trim(received_or_error.value());
+    }
+    return datagram_count;
+#endif
+}
+
+ErrorOr<size_t> UDPSocket::write_datagrams(Span<ReadonlyBytes> datagrams)
+{
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+    Vector<iovec> iovs;
+    Vector<mmsghdr> messages;
+    TRY(iovs.try_resize(datagrams.size()));
+    TRY(messages.try_resize(datagrams.size()));
+    for (size_t i = 0; i < datagrams.size(); ++i) {
+        iovs[i] = { const_cast<u8*>(datagrams[i].data()), datagrams[i].size() };
+        messages[i] = {};
+        messages[i].msg_hdr.msg_iov = &iovs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t datagram_count = 0;
+    while (datagram_count < datagrams.size()) {
+        auto sent_or_error = System::sendmmsg(m_helper.fd(), messages.data() + datagram_count, messages.size() - datagram_count, 0);
+        if (sent_or_error.is_error()) {
+            if (datagram_count == 0)
+                return sent_or_error.release_error();
+            break;
+        }
+        datagram_count += sent_or_error.value();
+    }
+    return datagram_count;
+#else
+    size_t datagram_count = 0;
+    for (; datagram_count < datagrams.size(); ++datagram_count) {
+        auto sent_or_error = System::send(m_helper.fd(), datagrams[datagram_count].data(), datagrams[datagram_count].size(), 0);
+        if (sent_or_error.is_error()) {
+            if (datagram_count == 0)
+                return sent_or_error.release_error();
+            break;
+        }
+    }
+    return datagram_count;
+#endif
+}
+
 ErrorOr<NonnullOwnPtr<LocalSocket>> LocalSocket::connect(String const& path)
 {
     auto socket = TRY(adopt_nonnull_own_or_enomem(new (nothrow) LocalSocket()));
@@ -344,6 +344,8 @@ public:
     ErrorOr<void> set_blocking(bool enabled) override { return m_helper.set_blocking(enabled); }
     ErrorOr<void> set_close_on_exec(bool enabled) override { return m_helper.set_close_on_exec(enabled); }
 
+    Optional<int> fd() const;
+
     virtual ~TCPSocket() override { close(); }
 
 private:
@@ -403,6 +405,12 @@ public:
         return m_helper.read(buffer);
     }
 
+    // Reads one datagram into each buffer, and returns how many were read. Only the first
+    // read waits for data; the buffers are shrunk to the size of the datagram they got.
+    ErrorOr<size_t> read_datagrams(Span<Bytes> buffers);
+    // Writes each buffer as its own datagram, and returns how many of them were written.
+    ErrorOr<size_t> write_datagrams(Span<ReadonlyBytes> datagrams);
+
     virtual bool is_readable() const override { return is_open(); }
     virtual bool is_writable() const override { return is_open(); }
     virtual ErrorOr<size_t> write(ReadonlyBytes buffer) override { return m_helper.write(buffer); }
@@ -887,6 +895,10 @@ public:
 
     virtual size_t buffer_size() const override { return m_helper.buffer_size(); }
 
+    // Note: Writes aren't buffered, so this can be used to write to the socket directly.
+    //       Reading from it directly would skip over whatever has been buffered already.
+    Optional<int> fd() const { return m_helper.stream().fd(); }
+
     virtual ~BufferedSocket() override = default;
 
 private:
@@ -30,6 +30,7 @@
 #    include <LibSystem/syscall.h>
 #    include <serenity.h>
 #    include <sys/ptrace.h>
+#    include <sys/sendfile.h>
 #endif
 
 #if defined(AK_OS_LINUX) && !defined(MFD_CLOEXEC)
@@ -140,6 +141,14 @@ ErrorOr<void> sendfd(int sockfd, int fd)
     return {};
 }
 
+ErrorOr<size_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+{
+    auto rc = ::sendfile(out_fd, in_fd, offset, count);
+    if (rc < 0)
+        return Error::from_syscall("sendfile"sv, -errno);
+    return static_cast<size_t>(rc);
+}
+
 ErrorOr<int> recvfd(int sockfd, int options)
 {
     auto fd = ::recvfd(sockfd, options);
@@ -1234,6 +1243,24 @@ ErrorOr<ssize_t> recvfrom(int sockfd, void* buffer, size_t buffer_length, int fl
     return received;
 }
 
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+ErrorOr<int> sendmmsg(int sockfd, struct mmsghdr* messages, unsigned int message_count, int flags)
+{
+    auto sent = ::sendmmsg(sockfd, messages, message_count, flags);
+    if (sent < 0)
+        return Error::from_syscall("sendmmsg"sv, -errno);
+    return sent;
+}
+
+ErrorOr<int> recvmmsg(int sockfd, struct mmsghdr* messages, unsigned int message_count, int flags, struct timespec* timeout)
+{
+    auto received = ::recvmmsg(sockfd, messages, message_count, flags, timeout);
+    if (received < 0)
+        return Error::from_syscall("recvmmsg"sv, -errno);
+    return received;
+}
+#endif
+
 ErrorOr<void> getsockopt(int sockfd, int level, int option, void* value, socklen_t* value_size)
 {
     if (::getsockopt(sockfd, level, option, value, value_size) < 0)
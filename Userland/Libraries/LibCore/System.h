@@ -38,6 +38,7 @@ ErrorOr<void> pledge(StringView promises, StringView execpromises = {});
 ErrorOr<void> unveil(StringView path, StringView permissions);
 ErrorOr<void> unveil_after_exec(StringView path, StringView permissions);
 ErrorOr<void> sendfd(int sockfd, int fd);
+ErrorOr<size_t> sendfile(int out_fd, int in_fd, off_t* offset, size_t count);
 ErrorOr<int> recvfd(int sockfd, int options);
 ErrorOr<void> ptrace_peekbuf(pid_t tid, void const* tracee_addr, Bytes destination_buf);
 ErrorOr<void> mount(int source_fd, StringView target, StringView fs_type, int flags);
@@ -190,6 +191,10 @@ ErrorOr<ssize_t> sendto(int sockfd, void const*, size_t, int flags, struct socka
 ErrorOr<ssize_t> recv(int sockfd, void*, size_t, int flags);
 ErrorOr<ssize_t> recvmsg(int sockfd, struct msghdr*, int flags);
 ErrorOr<ssize_t> recvfrom(int sockfd, void*, size_t, int flags, struct sockaddr*, socklen_t*);
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+ErrorOr<int> sendmmsg(int sockfd, struct mmsghdr*, unsigned int vlen, int flags);
+ErrorOr<int> recvmmsg(int sockfd, struct mmsghdr*, unsigned int vlen, int flags, struct timespec* timeout);
+#endif
 ErrorOr<void> getsockopt(int sockfd, int level, int option, void* value, socklen_t* value_size);
 ErrorOr<void> setsockopt(int sockfd, int level, int option, void const* value, socklen_t value_size);
 ErrorOr<void> getsockname(int sockfd, struct sockaddr*, socklen_t*);
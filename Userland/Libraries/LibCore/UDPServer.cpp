@@ -7,6 +7,7 @@
 #include <AK/IPv4Address.h>
 #include <AK/Types.h>
 #include <LibCore/Notifier.h>
+#include <LibCore/System.h>
 #include <LibCore/UDPServer.h>
 #include <errno.h>
 #include <stdio.h>
@@ -116,4 +117,119 @@ ErrorOr<size_t> UDPServer::send(ReadonlyBytes buffer, sockaddr_in const& to)
     return result;
 }
 
+struct UDPServer::ReceiveBuffers {
+    size_t buffer_size { 0 };
+    Vector<ByteBuffer> buffers;
+    Vector<ReceivedDatagram> datagrams;
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+    Vector<iovec> iovs;
+    Vector<mmsghdr> messages;
+#endif
+};
+
+ErrorOr<Span<UDPServer::ReceivedDatagram const>> UDPServer::receive_batch(size_t max_count, size_t max_size)
+{
+    if (m_fd < 0)
+        return Error::from_errno(EBADF);
+
+    if (!m_receive_buffers)
+        m_receive_buffers = TRY(adopt_nonnull_own_or_enomem(new (nothrow) ReceiveBuffers));
+    auto& receive_buffers = *m_receive_buffers;
+    if (receive_buffers.buffer_size != max_size) {
+        receive_buffers.buffers.clear();
+        receive_buffers.buffer_size = max_size;
+    }
+    TRY(receive_buffers.buffers.try_ensure_capacity(max_count));
+    while (receive_buffers.buffers.size() < max_count)
+        receive_buffers.buffers.unchecked_append(TRY(ByteBuffer::create_uninitialized(max_size)));
+    auto& datagrams = receive_buffers.datagrams;
+    TRY(datagrams.try_resize(max_count));
+
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+    auto& iovs = receive_buffers.iovs;
+    auto& messages = receive_buffers.messages;
+    TRY(iovs.try_resize(max_count));
+    TRY(messages.try_resize(max_count));
+    for (size_t i = 0; i < max_count; ++i) {
+        iovs[i] = { receive_buffers.buffers[i].data(), max_size };
+        messages[i] = {};
+        messages[i].msg_hdr.msg_name = &datagrams[i].address;
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        messages[i].msg_hdr.msg_iov = &iovs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    auto received_or_error = System::recvmmsg(m_fd, messages.data(), max_count, MSG_DONTWAIT, nullptr);
+    if (received_or_error.is_error()) {
+        if (received_or_error.error().code() == EAGAIN)
+            return Span<ReceivedDatagram const> {};
+        return received_or_error.release_error();
+    }
+    size_t datagram_count = received_or_error.value();
+    for (size_t i = 0; i < datagram_count; ++i)
+        datagrams[i].data = receive_buffers.buffers[i].bytes().trim(min(static_cast<size_t>(messages[i].msg_len), max_size));
+#else
+    size_t datagram_count = 0;
+    for (; datagram_count < max_count; ++datagram_count) {
+        auto& datagram = datagrams[datagram_count];
+        auto& buffer = receive_buffers.buffers[datagram_count];
+        socklen_t address_length = sizeof(sockaddr_in);
+        auto received_or_error = System::recvfrom(m_fd, buffer.data(), max_size, MSG_DONTWAIT, (sockaddr*)&datagram.address, &address_length);
+        if (received_or_error.is_error()) {
+            if (datagram_count == 0 && received_or_error.error().code() != EAGAIN)
+                return received_or_error.release_error();
+            break;
+        }
+        datagram.data = buffer.bytes().trim(received_or_error.value());
+    }
+#endif
+
+    return datagrams.span().trim(datagram_count);
+}
+
+ErrorOr<size_t> UDPServer::send_batch(Span<Datagram const> datagrams)
+{
+    if (m_fd < 0)
+        return Error::from_errno(EBADF);
+
+#if defined(AK_OS_SERENITY) || defined(AK_OS_LINUX)
+    Vector<iovec> iovs;
+    Vector<mmsghdr> messages;
+    TRY(iovs.try_resize(datagrams.size()));
+    TRY(messages.try_resize(datagrams.size()));
+    for (size_t i = 0; i < datagrams.size(); ++i) {
+        iovs[i] = { const_cast<u8*>(datagrams[i].data.data()), datagrams[i].data.size() };
+        messages[i] = {};
+        messages[i].msg_hdr.msg_name = const_cast<sockaddr_in*>(&datagrams[i].address);
+        messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        messages[i].msg_hdr.msg_iov = &iovs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t datagram_count = 0;
+    while (datagram_count < datagrams.size()) {
+        auto sent_or_error = System::sendmmsg(m_fd, messages.data() + datagram_count, messages.size() - datagram_count, 0);
+        if (sent_or_error.is_error()) {
+            if (datagram_count == 0)
+                return sent_or_error.release_error();
+            break;
+        }
+        datagram_count += sent_or_error.value();
+    }
+    return datagram_count;
+#else
+    size_t datagram_count = 0;
+    for (; datagram_count < datagrams.size(); ++datagram_count) {
+        auto& datagram = datagrams[datagram_count];
+        auto sent_or_error = System::sendto(m_fd, datagram.data.data(), datagram.data.size(), 0, (sockaddr const*)&datagram.address, sizeof(datagram.address));
+        if (sent_or_error.is_error()) {
+            if (datagram_count == 0)
+                return sent_or_error.release_error();
+            break;
+        }
+    }
+    return datagram_count;
+#endif
+}
+
 }
@@ -9,6 +9,8 @@
 #include <AK/ByteBuffer.h>
 #include <AK/Forward.h>
 #include <AK/Function.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
 #include <LibCore/Forward.h>
 #include <LibCore/Object.h>
 #include <LibCore/SocketAddress.h>
@@ -32,6 +34,22 @@ public:
 
     ErrorOr<size_t> send(ReadonlyBytes, sockaddr_in const& to);
 
+    struct Datagram {
+        ByteBuffer data;
+        sockaddr_in address {};
+    };
+
+    struct ReceivedDatagram {
+        ReadonlyBytes data;
+        sockaddr_in address {};
+    };
+
+    // Receives the datagrams that are already queued, up to max_count of them, in as few system calls as possible.
+    // The datagrams live in buffers owned by the server, and are only valid until the next call.
+    ErrorOr<Span<ReceivedDatagram const>> receive_batch(size_t max_count, size_t max_size);
+    // Sends the datagrams in order, and returns how many of them were sent.
+    ErrorOr<size_t> send_batch(Span<Datagram const>);
+
     Optional<IPv4Address> local_address() const;
     Optional<u16> local_port() const;
 
@@ -43,9 +61,12 @@ protected:
     explicit UDPServer(Object* parent = nullptr);
 
 private:
+    struct ReceiveBuffers;
+
     int m_fd { -1 };
     bool m_bound { false };
     RefPtr<Notifier> m_notifier;
+    OwnPtr<ReceiveBuffers> m_receive_buffers;
 };
 
 }
@@ -13,32 +13,55 @@ namespace LookupServer {
 
 using namespace DNS;
 
+// The most requests answered per wakeup; the rest are picked up when the socket notifies us again.
+static constexpr size_t max_requests_per_batch = 32;
+
 DNSServer::DNSServer(Object* parent)
     : Core::UDPServer(parent)
 {
     bind(IPv4Address(), 53);
     on_ready_to_receive = [this]() {
-        auto result = handle_client();
+        auto result = handle_clients();
         if (result.is_error()) {
-            dbgln("DNSServer: Failed to handle client: {}", result.error());
+            dbgln("DNSServer: Failed to handle clients: {}", result.error());
         }
     };
 }
 
-ErrorOr<void> DNSServer::handle_client()
+ErrorOr<void> DNSServer::handle_clients()
+{
+    auto requests = TRY(receive_batch(max_requests_per_batch, 1024));
+
+    Vector<Datagram> responses;
+    TRY(responses.try_ensure_capacity(requests.size()));
+    for (auto& request : requests) {
+        auto response_or_error = handle_request(request.data);
+        if (response_or_error.is_error()) {
+            dbgln("DNSServer: Failed to handle client: {}", response_or_error.error());
+            continue;
+        }
+        auto response = response_or_error.release_value();
+        if (response.has_value())
+            responses.unchecked_append({ response.release_value(), request.address });
+    }
+
+    if (!responses.is_empty())
+        TRY(send_batch(responses));
+    return {};
+}
+
+ErrorOr<Optional<ByteBuffer>> DNSServer::handle_request(ReadonlyBytes buffer)
 {
-    sockaddr_in client_address;
-    auto buffer = receive(1024, client_address);
     auto optional_request = Packet::from_raw_packet(buffer.data(), buffer.size());
     if (!optional_request.has_value()) {
         dbgln("Got an invalid DNS packet");
-        return {};
+        return Optional<ByteBuffer> {};
     }
     auto& request = optional_request.value();
 
     if (!request.is_query()) {
         dbgln("It's not a request");
-        return {};
+        return Optional<ByteBuffer> {};
     }
 
     LookupServer& lookup_server = LookupServer::the();
@@ -62,10 +85,7 @@ ErrorOr<void> DNSServer::handle_client()
     else
         response.set_code(Packet::Code::NOERROR);
 
-    buffer = response.to_byte_buffer();
-
-    TRY(send(buffer, client_address));
-    return {};
+    return response.to_byte_buffer();
 }
 
 }
@@ -16,7 +16,8 @@ class DNSServer : public Core::UDPServer {
 private:
     explicit DNSServer(Object* parent = nullptr);
 
-    ErrorOr<void> handle_client();
+    ErrorOr<void> handle_clients();
+    ErrorOr<Optional<ByteBuffer>> handle_request(ReadonlyBytes);
 };
 
 }
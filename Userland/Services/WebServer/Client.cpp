@@ -15,9 +15,9 @@
 #include <LibCore/DateTime.h>
 #include <LibCore/DirIterator.h>
 #include <LibCore/File.h>
-#include <LibCore/FileStream.h>
 #include <LibCore/MappedFile.h>
 #include <LibCore/MimeData.h>
+#include <LibCore/System.h>
 #include <LibHTTP/HttpRequest.h>
 #include <LibHTTP/HttpResponse.h>
 #include <WebServer/Client.h>
@@ -163,13 +163,11 @@ ErrorOr<bool> Client::handle_request(ReadonlyBytes raw_request)
         return false;
     }
 
-    Core::InputFileStream stream { file };
-
-    TRY(send_response(stream, request, { .type = Core::guess_mime_type_based_on_filename(real_path), .length = TRY(Core::File::size(real_path)) }));
+    TRY(send_response(*file, request, { .type = Core::guess_mime_type_based_on_filename(real_path), .length = TRY(Core::File::size(real_path)) }));
     return true;
 }
 
-ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest const& request, ContentInfo content_info)
+ErrorOr<void> Client::send_response_header(HTTP::HttpRequest const& request, ContentInfo const& content_info)
 {
     StringBuilder builder;
     builder.append("HTTP/1.0 200 OK\r\n"sv);
@@ -187,6 +185,12 @@ ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest con
     auto builder_contents = builder.to_byte_buffer();
     TRY(m_socket->write(builder_contents));
     log_response(200, request);
+    return {};
+}
+
+ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest const& request, ContentInfo content_info)
+{
+    TRY(send_response_header(request, content_info));
 
     char buffer[PAGE_SIZE];
     do {
@@ -206,6 +210,32 @@ ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest con
         }
     } while (true);
 
+    finish_response(request);
+    return {};
+}
+
+ErrorOr<void> Client::send_response(Core::File& file, HTTP::HttpRequest const& request, ContentInfo content_info)
+{
+    TRY(send_response_header(request, content_info));
+
+    // Have the kernel hand the file over to the socket, instead of copying it through a buffer of ours.
+    auto socket_fd = m_socket->fd();
+    if (!socket_fd.has_value())
+        return Error::from_errno(ENOTCONN);
+    off_t offset = 0;
+    while (static_cast<size_t>(offset) < content_info.length) {
+        auto nsent = TRY(Core::System::sendfile(*socket_fd, file.fd(), &offset, content_info.length - offset));
+        // The file got shorter since we looked at its size.
+        if (nsent == 0)
+            break;
+    }
+
+    finish_response(request);
+    return {};
+}
+
+void Client::finish_response(HTTP::HttpRequest const& request)
+{
     auto keep_alive = false;
     if (auto it = request.headers().find_if([](auto& header) { return header.name.equals_ignoring_case("Connection"sv); }); !it.is_end()) {
         if (it->value.trim_whitespace().equals_ignoring_case("keep-alive"sv))
@@ -213,8 +243,6 @@ ErrorOr<void> Client::send_response(InputStream& response, HTTP::HttpRequest con
     }
     if (!keep_alive)
         m_socket->close();
-
-    return {};
 }
 
 ErrorOr<void> Client::send_redirect(StringView redirect_path, HTTP::HttpRequest const& request)
@@ -32,6 +32,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     bool flag_numeric = false;
     bool flag_program = false;
     bool flag_wide = false;
+    bool flag_extend = false;
 
     Core::ArgsParser args_parser;
     args_parser.set_general_help("Display network connections");
@@ -42,6 +43,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(flag_numeric, "Display numerical addresses", "numeric", 'n');
     args_parser.add_option(flag_program, "Show the PID and name of the program to which each socket belongs", "program", 'p');
     args_parser.add_option(flag_wide, "Do not truncate IP addresses by printing out the whole symbolic host", "wide", 'W');
+    args_parser.add_option(flag_extend, "Display queue sizes and retransmissions of TCP connections", "extend", 'e');
     args_parser.parse(arguments);
 
     TRY(Core::System::unveil("/sys/kernel/net", "r"));
@@ -87,6 +89,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     int local_address_column = -1;
     int peer_address_column = -1;
     int state_column = -1;
+    int receive_queue_column = -1;
+    int send_queue_column = -1;
+    int retransmitted_column = -1;
     int program_column = -1;
 
     auto add_column = [&](auto title, auto alignment, auto width) {
@@ -100,6 +105,11 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     local_address_column = add_column("Local Address", Alignment::Left, 22);
     peer_address_column = add_column("Peer Address", Alignment::Left, 22);
     state_column = add_column("State", Alignment::Left, 11);
+    if (flag_extend) {
+        receive_queue_column = add_column("Recv-Q", Alignment::Right, 6);
+        send_queue_column = add_column("Send-Q", Alignment::Right, 6);
+        retransmitted_column = add_column("Retrans", Alignment::Right, 7);
+    }
     program_column = flag_program ? add_column("PID/Program", Alignment::Left, 11) : -1;
 
     auto print_column = [](auto& column, auto& string) {
@@ -236,6 +246,12 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
                 columns[peer_address_column].buffer = get_formatted_address(peer_address, peer_port);
             if (state_column != -1)
                 columns[state_column].buffer = state;
+            if (receive_queue_column != -1)
+                columns[receive_queue_column].buffer = if_object.get("receive_queue_size"sv).to_string();
+            if (send_queue_column != -1)
+                columns[send_queue_column].buffer = if_object.get("send_queue_size"sv).to_string();
+            if (retransmitted_column != -1)
+                columns[retransmitted_column].buffer = if_object.get("packets_retransmitted"sv).to_string();
             if (flag_program && program_column != -1)
                 columns[program_column].buffer = get_formatted_program(origin_pid);
 
@@ -316,6 +332,12 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
                 columns[peer_address_column].buffer = get_formatted_address(peer_address, peer_port);
             if (state_column != -1)
                 columns[state_column].buffer = "-";
+            if (receive_queue_column != -1)
+                columns[receive_queue_column].buffer = "-";
+            if (send_queue_column != -1)
+                columns[send_queue_column].buffer = "-";
+            if (retransmitted_column != -1)
+                columns[retransmitted_column].buffer = "-";
             if (flag_program && program_column != -1)
                 columns[program_column].buffer = get_formatted_program(origin_pid);
 